@@ -8,8 +8,12 @@ attribute vec3 s_position;
 attribute vec2 s_texcoord0;
 attribute vec3 s_normal;
 attribute vec4 s_color;
+attribute mat4 s_instance_transformation;
 
 uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
+uniform float s_octahedral_normals;
 uniform mat4 s_base_color_map_matrix;
 
 varying vec2 frag_texcoord0;
@@ -17,10 +21,27 @@ varying vec4 frag_color;
 varying vec4 frag_position;
 varying vec3 frag_normal;
 
+/* Compact vertex data stores an octahedral encoded normal in xy */
+vec3 decode_normal(vec3 n) {
+    if(s_octahedral_normals == 0.0) {
+        return n;
+    }
+
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if(v.z < 0.0) {
+        v.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(v);
+}
+
 void main() {
+    vec4 position = s_instance_transformation * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+    vec3 normal = (s_instance_transformation * vec4(decode_normal(s_normal), 0.0)).xyz;
+
     frag_texcoord0 = (s_base_color_map_matrix * vec4(s_texcoord0, 0, 1)).st;
     frag_color = s_color;
-    frag_normal = s_normal;
-    frag_position = vec4(s_position, 1.0);
-    gl_Position = (s_modelview_projection * vec4(s_position, 1.0));
+    frag_normal = normal;
+    frag_position = position;
+    gl_Position = (s_modelview_projection * position);
 }
@@ -7,19 +7,40 @@ precision mediump float;
 attribute vec3 s_position;
 attribute vec2 s_texcoord0;
 attribute vec3 s_normal;
+attribute mat4 s_instance_transformation;
 
 uniform mat4 s_model;
 uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
+uniform float s_octahedral_normals;
 uniform mat4 s_base_color_map_matrix;
 
 varying vec2 frag_texcoord0;
 varying vec3 frag_position;                       // Fragment position in world space
 varying vec3 frag_normal;                         // Fragment normal in world space
 
+/* Compact vertex data stores an octahedral encoded normal in xy */
+vec3 decode_normal(vec3 n) {
+    if(s_octahedral_normals == 0.0) {
+        return n;
+    }
+
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if(v.z < 0.0) {
+        v.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(v);
+}
+
 void main() {
-    frag_position = vec3(s_model * vec4(s_position, 1.0));
-    frag_normal = normalize(mat3(s_model) * s_normal);
+    vec4 position = s_instance_transformation * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+    vec3 normal = (s_instance_transformation * vec4(decode_normal(s_normal), 0.0)).xyz;
+
+    frag_position = vec3(s_model * position);
+    frag_normal = normalize(mat3(s_model) * normal);
     frag_texcoord0 = (s_base_color_map_matrix * vec4(s_texcoord0, 0, 1)).st;
 
-    gl_Position = (s_modelview_projection * vec4(s_position, 1.0));
+    gl_Position = (s_modelview_projection * position);
 }
@@ -6,15 +6,20 @@ precision mediump float;
 
 attribute vec3 s_position;
 attribute vec4 s_color;
+attribute mat4 s_instance_transformation;
 
 uniform vec4 s_material_base_color;
 uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
 uniform float s_point_size;
 
 varying vec4 diffuse;
 
 void main() {
+    vec4 position = s_instance_transformation * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+
     diffuse = s_color * s_material_base_color;
-    gl_Position = (s_modelview_projection * vec4(s_position, 1.0));
+    gl_Position = (s_modelview_projection * position);
     gl_PointSize = s_point_size;
 }
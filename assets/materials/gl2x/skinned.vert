@@ -0,0 +1,69 @@
+#version {0}
+
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+#define MAX_JOINTS 64
+
+attribute vec3 s_position;
+attribute vec2 s_texcoord0;
+attribute vec3 s_normal;
+attribute vec4 s_color;
+attribute vec4 s_joints;
+attribute vec4 s_weights;
+attribute mat4 s_instance_transformation;
+
+uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
+uniform float s_octahedral_normals;
+uniform mat4 s_base_color_map_matrix;
+uniform mat4 s_joint_palette[MAX_JOINTS];
+
+varying vec2 frag_texcoord0;
+varying vec4 frag_color;
+varying vec4 frag_position;
+varying vec3 frag_normal;
+
+/* Compact vertex data stores an octahedral encoded normal in xy */
+vec3 decode_normal(vec3 n) {
+    if(s_octahedral_normals == 0.0) {
+        return n;
+    }
+
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if(v.z < 0.0) {
+        v.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(v);
+}
+
+mat4 skin_matrix() {
+    vec4 weights = s_weights;
+    float total = weights.x + weights.y + weights.z + weights.w;
+    if(total < 0.0001) {
+        return mat4(1.0);
+    } else if(total > 1.01) {
+        weights /= total;
+    }
+
+    return s_joint_palette[int(s_joints.x)] * weights.x +
+        s_joint_palette[int(s_joints.y)] * weights.y +
+        s_joint_palette[int(s_joints.z)] * weights.z +
+        s_joint_palette[int(s_joints.w)] * weights.w;
+}
+
+void main() {
+    mat4 skin = s_instance_transformation * skin_matrix();
+
+    vec4 position = skin * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+    vec3 normal = normalize((skin * vec4(decode_normal(s_normal), 0.0)).xyz);
+
+    frag_texcoord0 = (s_base_color_map_matrix * vec4(s_texcoord0, 0, 1)).st;
+    frag_color = s_color;
+    frag_normal = normal;
+    frag_position = position;
+    gl_Position = (s_modelview_projection * position);
+}
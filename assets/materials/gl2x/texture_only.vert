@@ -7,15 +7,20 @@ precision mediump float;
 attribute vec3 s_position;
 attribute vec2 s_texcoord0;
 attribute vec4 s_color;
+attribute mat4 s_instance_transformation;
 
 uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
 uniform mat4 s_base_color_map_matrix;
 
 varying vec2 frag_texcoord0;
 varying vec4 frag_diffuse;
 
 void main() {
+    vec4 position = s_instance_transformation * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+
     frag_diffuse = s_color;
     frag_texcoord0 = (s_base_color_map_matrix * vec4(s_texcoord0, 0, 1)).st;
-    gl_Position = (s_modelview_projection * vec4(s_position, 1.0));
+    gl_Position = (s_modelview_projection * position);
 }
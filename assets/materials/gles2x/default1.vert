@@ -7,9 +7,13 @@ precision mediump float;
 attribute vec3 s_position;
 attribute vec2 s_texcoord0;
 attribute vec3 s_normal;
+attribute mat4 s_instance_transformation;
 
 uniform mat4 s_modelview;
 uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
+uniform float s_octahedral_normals;
 uniform mat4 s_view;
 uniform mat3 s_inverse_transpose_modelview;
 uniform vec4 s_light_position;
@@ -20,12 +24,29 @@ varying vec4 vertex_normal_eye;
 varying vec4 light_position_eye;
 varying vec2 frag_texcoord0;
 
+/* Compact vertex data stores an octahedral encoded normal in xy */
+vec3 decode_normal(vec3 n) {
+    if(s_octahedral_normals == 0.0) {
+        return n;
+    }
+
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if(v.z < 0.0) {
+        v.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(v);
+}
+
 void main() {
-    vertex_normal_eye = vec4(normalize(s_inverse_transpose_modelview * s_normal), 0); //Calculate the normal
-    vertex_position_eye = (s_modelview * vec4(s_position, 1.0));
+    vec4 position = s_instance_transformation * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+    vec3 normal = (s_instance_transformation * vec4(decode_normal(s_normal), 0.0)).xyz;
+
+    vertex_normal_eye = vec4(normalize(s_inverse_transpose_modelview * normal), 0); //Calculate the normal
+    vertex_position_eye = (s_modelview * position);
     light_position_eye = (s_view * s_light_position);
 
     frag_texcoord0 = (s_diffuse_map_matrix * vec4(s_texcoord0, 0, 1)).st;
 
-    gl_Position = (s_modelview_projection * vec4(s_position, 1.0));
+    gl_Position = (s_modelview_projection * position);
 }
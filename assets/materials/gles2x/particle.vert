@@ -0,0 +1,43 @@
+#version {0}
+
+#ifdef GL_ES
+precision highp float;
+#endif
+
+/* Particle billboards are expanded here rather than on the CPU. When
+ * instanced, each particle's centre, size and color arrive in the
+ * s_instance_* attributes and the vertices are a shared quad, with the
+ * corner given by the sign of s_texcoord0. Otherwise each corner of a
+ * particle has the particle centre as its position, and the particle size
+ * in s_texcoord0 with its sign giving the corner. */
+
+attribute vec3 s_position;
+attribute vec2 s_texcoord0;
+attribute vec4 s_diffuse;
+
+attribute vec3 s_instance_position;
+attribute vec2 s_instance_texcoord0;
+attribute vec4 s_instance_color;
+
+uniform mat4 s_view;
+uniform mat4 s_modelview_projection;
+uniform mat4 s_diffuse_map_matrix;
+
+varying vec2 frag_texcoord0;
+varying vec4 frag_diffuse;
+
+void main() {
+    /* The rows of the view rotation are the camera axes */
+    vec3 right = vec3(s_view[0][0], s_view[1][0], s_view[2][0]);
+    vec3 up = vec3(s_view[0][1], s_view[1][1], s_view[2][1]);
+
+    vec3 centre = s_position + s_instance_position;
+    vec2 size = s_texcoord0 * s_instance_texcoord0;
+
+    vec3 position = centre + (right * size.x + up * size.y) * 0.5;
+    vec2 uv = step(vec2(0.0), s_texcoord0);
+
+    frag_diffuse = s_diffuse * s_instance_color;
+    frag_texcoord0 = (s_diffuse_map_matrix * vec4(uv, 0, 1)).st;
+    gl_Position = (s_modelview_projection * vec4(position, 1.0));
+}
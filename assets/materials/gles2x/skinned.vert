@@ -0,0 +1,52 @@
+#version {0}
+
+#ifdef GL_ES
+precision highp float;
+#endif
+
+#define MAX_JOINTS 24
+
+attribute vec3 s_position;
+attribute vec2 s_texcoord0;
+attribute vec2 s_texcoord1;
+attribute vec4 s_diffuse;
+attribute vec4 s_joints;
+attribute vec4 s_weights;
+attribute mat4 s_instance_transformation;
+
+uniform mat4 s_modelview_projection;
+uniform vec4 s_position_scale;
+uniform vec4 s_position_offset;
+uniform float s_point_size;
+uniform mat4 s_diffuse_map_matrix;
+uniform mat4 s_light_map_matrix;
+uniform mat4 s_joint_palette[MAX_JOINTS];
+
+varying vec2 frag_texcoord0;
+varying vec2 frag_texcoord1;
+varying vec4 frag_diffuse;
+
+mat4 skin_matrix() {
+    vec4 weights = s_weights;
+    float total = weights.x + weights.y + weights.z + weights.w;
+    if(total < 0.0001) {
+        return mat4(1.0);
+    } else if(total > 1.01) {
+        weights /= total;
+    }
+
+    return s_joint_palette[int(s_joints.x)] * weights.x +
+        s_joint_palette[int(s_joints.y)] * weights.y +
+        s_joint_palette[int(s_joints.z)] * weights.z +
+        s_joint_palette[int(s_joints.w)] * weights.w;
+}
+
+void main() {
+    vec4 position = s_instance_transformation * skin_matrix() * vec4(s_position * s_position_scale.xyz + s_position_offset.xyz, 1.0);
+
+    frag_texcoord0 = (s_diffuse_map_matrix * vec4(s_texcoord0, 0, 1)).st;
+    frag_texcoord1 = (s_light_map_matrix * vec4(s_texcoord1, 0, 1)).st;
+    frag_diffuse = s_diffuse;
+    gl_Position = (s_modelview_projection * position);
+    gl_PointSize = s_point_size;
+}
@@ -86,6 +86,7 @@ namespace smlt { typedef SDL2Window SysWindow; }
 #include "platform.h"
 #include "scenes/scene.h"
 #include "scenes/scene_manager.h"
+#include "services/job_system.h"
 #include "time_keeper.h"
 #include "tools/profiler.h"
 #include "utils/gl_error.h"
@@ -137,6 +138,10 @@ Application::Application(const AppConfig& config, void* platform_state) :
     time_keeper_(
         TimeKeeper::create(1.0f / float(config.target_fixed_step_rate))),
     stats_(StatsRecorder::create()),
+    job_system_(std::make_shared<JobSystem>(
+        (config.general.job_worker_count < 0) ?
+            JobSystem::default_worker_count() :
+            uint32_t(config.general.job_worker_count))),
     pool_(std::make_shared<MaterialValuePool>()),
     config_(config) {
 
@@ -157,6 +162,8 @@ Application::Application(const AppConfig& config, void* platform_state) :
 
     args->define_arg("--help", ARG_TYPE_BOOLEAN, "display this help and exit");
 
+    cort::set_stack_size(config_.general.coroutine_stack_size);
+
     /* Set the global app instance
      * We do this twice, here and at the start of run(), just in case
      * someone constructs two, but only calls run on one or something. */
@@ -231,6 +238,8 @@ Application::~Application() {
      * touch any slab-allocated node memory. */
     interpreters_.clear();
 
+    cort::release_pooled_stacks();
+
     asset_manager_.reset();
 
     pool_->clear();
@@ -306,9 +315,17 @@ bool Application::construct_window(const AppConfig& config) {
     smlt::get_logger("/")->set_level(config_copy.log_level);
 
     if(!config_copy.development.log_file.empty()) {
-        smlt::get_logger("/")->add_handler(
+        /* The file handler flushes every line, so keep that off the
+         * calling thread */
+        auto handler = std::make_shared<smlt::AsyncHandler>(
             smlt::Handler::ptr(new smlt::FileHandler(config_copy.development.log_file))
         );
+
+        smlt::get_logger("/")->add_handler(handler);
+
+        signal_shutdown().connect([handler]() {
+            handler->flush();
+        });
     }
 
     S_DEBUG("Constructing the window");
@@ -780,6 +797,10 @@ void Application::shutdown() {
     signal_shutdown_();
     _call_clean_up();
 
+    /* Anything still queued is finished before the rest of the app goes
+     * away, from here on jobs run inline */
+    job_system_->stop();
+
     if(sound_driver_) {
         sound_driver_->shutdown();
         sound_driver_.reset();
@@ -863,6 +884,8 @@ void Application::on_render_context_created() {
     /* We can't do this in the initialiser as we need a valid
      * window before doing things like creating textures */
     asset_manager_ = SharedAssetManager::create();
+    asset_manager_->set_async_load_budget(config_.general.async_load_budget_us);
+    asset_manager_->set_memory_budget(config_.general.asset_memory_budget);
     preload_default_font();
 
     class OverlayScene : public Scene {
@@ -1014,13 +1037,16 @@ LoaderPtr Application::loader_for(const Path &filename, LoaderHint hint) {
     }
 
     Path final_file = p.value();
+    return loader_for(final_file, vfs->open_file(final_file), hint);
+}
 
+LoaderPtr Application::loader_for(const Path& filename, std::shared_ptr<std::istream> data, LoaderHint hint) {
     std::vector<std::pair<LoaderTypePtr, LoaderPtr>> possible_loaders;
 
     for(LoaderTypePtr loader_type: loaders_) {
-        if(loader_type->supports(final_file)) {
+        if(loader_type->supports(filename)) {
             S_DEBUG("Found possible loader: {0}", loader_type->name());
-            auto new_loader = loader_type->loader_for(final_file, vfs->open_file(final_file));
+            auto new_loader = loader_type->loader_for(filename, data);
             new_loader->set_vfs(vfs_.get());
 
             possible_loaders.push_back(
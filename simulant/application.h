@@ -25,6 +25,7 @@
 #include <iosfwd>
 
 #include "arg_parser.h"
+#include "coroutines/coroutine.h"
 #include "generic/data_carrier.h"
 #include "generic/property.h"
 #include "keycodes.h"
@@ -50,6 +51,7 @@ class TimeKeeper;
 class StatsRecorder;
 class VirtualFileSystem;
 class SoundDriver;
+class JobSystem;
 
 class BackgroundLoadException : public std::runtime_error {
 public:
@@ -87,7 +89,34 @@ struct AppConfig {
     std::string source_language_code = DEFAULT_LANGUAGE_CODE;
 
     struct General {
+        /* The minimum number of stage nodes of each size in a slab of
+         * node storage, and the number of empty slabs each size keeps
+         * back for reuse rather than freeing */
+#if defined(__DREAMCAST__) || defined(__PSP__)
+        uint32_t stage_node_pool_size = 16;
+        uint32_t stage_node_spare_slabs = 0;
+#else
         uint32_t stage_node_pool_size = 64;
+        uint32_t stage_node_spare_slabs = 1;
+#endif
+
+        /* The stack size of each coroutine. Stacks are pooled and
+         * reused where coroutines run as fibers. */
+        uint32_t coroutine_stack_size = cort::DEFAULT_COROUTINE_STACK_SIZE;
+
+        /* The number of worker threads in the job system. Zero runs
+         * jobs inline on the calling thread, -1 picks one per spare core
+         * (which is zero on the Dreamcast and PSP) */
+        int32_t job_worker_count = -1;
+
+        /* Microseconds per frame spent on the main thread finishing
+         * asynchronous asset loads (see AssetManager::load_texture_async) */
+        uint32_t async_load_budget_us = 2000;
+
+        /* Bytes of texture, mesh and sound data that loaded assets can
+         * hold before the least recently used are evicted, zero for no
+         * limit (see AssetManager::set_memory_budget) */
+        std::size_t asset_memory_budget = 0;
     } general;
 
     struct UI {
@@ -240,6 +269,12 @@ public:
     /* Loader things */
     LoaderPtr loader_for(const Path &filename, LoaderHint hint=LOADER_HINT_NONE);
     LoaderPtr loader_for(const std::string& loader_name, const Path& filename);
+
+    /* As above, but the loader reads from `data` rather than opening the
+     * file. `filename` is used to pick the loader and to find any files
+     * it refers to. */
+    LoaderPtr loader_for(const Path& filename, std::shared_ptr<std::istream> data,
+                         LoaderHint hint=LOADER_HINT_NONE);
     LoaderTypePtr loader_type(const std::string& loader_name) const;
 
     void register_loader(LoaderTypePtr loader_type);
@@ -338,6 +373,7 @@ private:
     std::shared_ptr<SharedAssetManager> asset_manager_;
     std::shared_ptr<TimeKeeper> time_keeper_;
     std::shared_ptr<StatsRecorder> stats_;
+    std::shared_ptr<JobSystem> job_system_;
     std::shared_ptr<VirtualFileSystem> vfs_;
     std::shared_ptr<SoundDriver> sound_driver_;
     std::shared_ptr<MaterialValuePool> pool_;
@@ -421,6 +457,7 @@ public:
     S_DEFINE_PROPERTY(shared_assets, &Application::asset_manager_);
     S_DEFINE_PROPERTY(time_keeper, &Application::time_keeper_);
     S_DEFINE_PROPERTY(stats, &Application::stats_);
+    S_DEFINE_PROPERTY(jobs, &Application::job_system_);
     S_DEFINE_PROPERTY(vfs, &Application::vfs_);
     S_DEFINE_PROPERTY(sound_driver, &Application::sound_driver_);
     S_DEFINE_PROPERTY(material_value_pool, &Application::pool_);
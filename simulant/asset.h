@@ -50,6 +50,13 @@ public:
 
     void set_garbage_collection_method(GarbageCollectMethod method);
 
+    /* Roughly how many bytes of data the asset is holding on to. This is
+     * what counts against the asset manager's memory budget. Buffers
+     * shared between assets are counted for each of them. */
+    virtual std::size_t memory_usage() const {
+        return 0;
+    }
+
     Property<generic::DataCarrier Asset::*> data = {this, &Asset::data_};
 
 protected:
@@ -24,10 +24,13 @@
 #include "loader.h"
 #include "loaders/heightmap_loader.h"
 #include "procedural/mesh.h"
+#include "time_keeper.h"
 #include "utils/gl_thread_check.h"
 #include "utils/simple_memstream.h"
 #include "vfs.h"
+#include <algorithm>
 #include <iterator>
+#include <sstream>
 
 /** FIXME
  *
@@ -49,6 +52,9 @@ AssetManager::AssetManager(AssetManager* parent):
 }
 
 AssetManager::~AssetManager() {
+    /* Don't leave anything waiting on a load that will never finish */
+    cancel_all_async_loads();
+
     if(parent_) {
         S_DEBUG("Unregistering resource manager: {0}", this);
         base_manager()->unregister_child(this);
@@ -74,11 +80,184 @@ void AssetManager::destroy_all() {
     font_manager_.destroy_all();
     particle_script_manager_.destroy_all();
     binary_manager_.destroy_all();
+
+    /* Evicted assets are gone too */
+    texture_sources_.clear();
+    mesh_sources_.clear();
+    sound_sources_.clear();
+
     run_garbage_collection();
 }
 
 void AssetManager::update(float dt) {
     _S_UNUSED(dt);
+
+    update_async_loads(TimeKeeper::now_in_us() + async_load_budget_us_);
+}
+
+void AssetManager::queue_async_load(const AsyncLoadPtr& load) {
+    load->order = async_load_order_++;
+    async_queued_.push_back(load);
+}
+
+void AssetManager::discard_async_load(const AsyncLoadPtr& load) {
+    if(load->discard) {
+        load->discard();
+    }
+}
+
+void AssetManager::update_async_loads(uint64_t deadline) {
+    auto before = [](const AsyncLoadPtr& lhs, const AsyncLoadPtr& rhs) {
+        return (lhs->priority != rhs->priority) ?
+            lhs->priority > rhs->priority :
+            lhs->order < rhs->order;
+    };
+
+    auto jobs = get_app()->jobs.get();
+    const std::size_t max_running = std::max(jobs->worker_count(), 1u);
+
+    /* Start decoding the most important requests. Without workers the
+     * decode runs inline, so beyond the first it has to fit in the budget
+     * too. */
+    std::sort(async_queued_.begin(), async_queued_.end(), before);
+
+    std::size_t started = 0;
+    while(started < async_queued_.size() && async_running_.size() < max_running) {
+        if(!jobs->worker_count() && started && TimeKeeper::now_in_us() >= deadline) {
+            break;
+        }
+
+        auto load = async_queued_[started++];
+        load->counter = jobs->run([load]() {
+            /* A decode that throws is a failed load, not an error for
+             * whoever ends up waiting on the counter */
+            try {
+                load->decoded = load->decode();
+            } catch(std::exception& e) {
+                S_ERROR("Decoding {0} threw an exception: {1}", load->path, e.what());
+            }
+        }, "async_load");
+
+        async_running_.push_back(load);
+    }
+
+    async_queued_.erase(async_queued_.begin(), async_queued_.begin() + started);
+
+    /* Finish the decoded ones on this thread, always managing at least one
+     * a frame so that a small budget can't stall loading entirely */
+    std::vector<AsyncLoadPtr> decoded;
+    for(auto& load: async_running_) {
+        if(load->counter->is_done()) {
+            decoded.push_back(load);
+        }
+    }
+
+    std::sort(decoded.begin(), decoded.end(), before);
+
+    bool finished_one = false;
+    for(auto& load: decoded) {
+        if(finished_one && TimeKeeper::now_in_us() >= deadline) {
+            break;
+        }
+
+        async_running_.erase(
+            std::remove(async_running_.begin(), async_running_.end(), load),
+            async_running_.end()
+        );
+
+        /* Cancelled loads were failed when they were cancelled, but the
+         * worker might have been using them until now */
+        if(load->cancelled) {
+            discard_async_load(load);
+            continue;
+        }
+
+        if(load->decoded) {
+            load->finish();
+        } else {
+            S_WARN("Async load of {0} failed", load->path);
+            load->fail();
+            discard_async_load(load);
+        }
+
+        finished_one = true;
+    }
+
+    for(auto child: children_) {
+        child->update_async_loads(deadline);
+    }
+}
+
+std::size_t AssetManager::cancel_async_load(const Path& path) {
+    std::size_t cancelled = 0;
+
+    auto cancel = [&](const AsyncLoadPtr& load) -> bool {
+        if(load->cancelled || !(load->path == path)) {
+            return false;
+        }
+
+        load->cancelled = true;
+        load->fail();
+        ++cancelled;
+        return true;
+    };
+
+    /* Queued loads can be dropped now, running ones are discarded by
+     * update() once the worker is done with them */
+    async_queued_.erase(
+        std::remove_if(async_queued_.begin(), async_queued_.end(), [&](const AsyncLoadPtr& load) {
+            if(!cancel(load)) {
+                return false;
+            }
+
+            discard_async_load(load);
+            return true;
+        }),
+        async_queued_.end()
+    );
+
+    for(auto& load: async_running_) {
+        cancel(load);
+    }
+
+    return cancelled;
+}
+
+void AssetManager::cancel_all_async_loads() {
+    for(auto& load: async_queued_) {
+        load->fail();
+        discard_async_load(load);
+    }
+
+    async_queued_.clear();
+
+    /* Nothing can be released while a worker is still decoding into it */
+    auto app = get_app();
+    for(auto& load: async_running_) {
+        if(app && app->jobs && !load->counter->is_done()) {
+            app->jobs->wait(load->counter);
+        }
+
+        if(!load->cancelled) {
+            load->cancelled = true;
+            load->fail();
+        }
+
+        discard_async_load(load);
+    }
+
+    async_running_.clear();
+}
+
+std::size_t AssetManager::async_load_count() const {
+    std::size_t count = async_queued_.size();
+    for(auto& load: async_running_) {
+        if(!load->cancelled) {
+            ++count;
+        }
+    }
+
+    return count;
 }
 
 void SharedAssetManager::set_default_material_filename(const Path& filename) {
@@ -163,6 +342,206 @@ void AssetManager::run_garbage_collection() {
     font_manager_.update();
     particle_script_manager_.update();
     binary_manager_.update();
+
+    if(is_base_manager()) {
+        enforce_memory_budget();
+    }
+}
+
+void AssetManager::track_source(AssetSources& sources, AssetID id,
+                                std::function<bool ()> reload) {
+    AssetSource source;
+    source.reload = reload;
+    source.last_used = base_manager()->residency_frame_;
+    sources[id] = source;
+}
+
+template<typename Manager>
+void AssetManager::use_asset(Manager& manager, AssetSources& sources,
+                             AssetMemoryStats& stats, AssetID id) {
+    auto it = sources.find(id);
+    if(it == sources.end()) {
+        return;
+    }
+
+    auto& source = it->second;
+    source.last_used = base_manager()->residency_frame_;
+
+    if(!source.evicted) {
+        return;
+    }
+
+    S_DEBUG("Reloading evicted asset {0}", id);
+
+    if(!source.reload()) {
+        S_ERROR("Unable to reload evicted asset {0}", id);
+        sources.erase(it);
+        return;
+    }
+
+    source.evicted = false;
+    manager.set_garbage_collection_method(id, source.garbage_collect);
+    manager.get(id)->set_name(source.name);
+    ++stats.reloads;
+}
+
+template<typename Manager>
+std::size_t AssetManager::find_evictable(Manager& manager, AssetSources& sources,
+                                         AssetMemoryStats& stats,
+                                         std::vector<EvictionCandidate>* candidates) {
+    const auto frame = base_manager()->residency_frame_;
+
+    for(auto it = sources.begin(); it != sources.end();) {
+        auto id = it->first;
+        auto& source = it->second;
+
+        if(source.evicted) {
+            ++it;
+            continue;
+        }
+
+        /* Destroyed or collected, there's nothing to reload */
+        if(!manager.contains(id)) {
+            it = sources.erase(it);
+            continue;
+        }
+
+        if(manager.is_referenced(id)) {
+            source.last_used = frame;
+        } else if(candidates) {
+            EvictionCandidate candidate;
+            candidate.bytes = manager.get(id)->memory_usage();
+            candidate.last_used = source.last_used;
+            candidate.evict = [&manager, &source, &stats, id]() {
+                source.name = manager.get(id)->name();
+                source.garbage_collect = manager.garbage_collection_method(id);
+                source.evicted = true;
+                manager.destroy(id);
+                ++stats.evictions;
+            };
+
+            candidates->push_back(candidate);
+        }
+
+        ++it;
+    }
+
+    if(!candidates) {
+        return 0;
+    }
+
+    std::size_t total = 0;
+    manager.each([&total](uint32_t, const typename Manager::ObjectTypePtr asset) {
+        total += asset->memory_usage();
+    });
+
+    return total;
+}
+
+void AssetManager::enforce_memory_budget() {
+    ++residency_frame_;
+
+    std::vector<EvictionCandidate> candidates;
+    auto out = (memory_budget_) ? &candidates : nullptr;
+
+    std::size_t total = 0;
+    auto scan = [&](AssetManager* manager) {
+        total += manager->find_evictable(manager->texture_manager_, manager->texture_sources_, manager->texture_stats_, out);
+        total += manager->find_evictable(manager->mesh_manager_, manager->mesh_sources_, manager->mesh_stats_, out);
+        total += manager->find_evictable(manager->sound_manager_, manager->sound_sources_, manager->sound_stats_, out);
+    };
+
+    scan(this);
+    for(auto child: children_) {
+        scan(child);
+    }
+
+    if(!memory_budget_ || total <= memory_budget_) {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const EvictionCandidate& lhs, const EvictionCandidate& rhs) {
+            return lhs.last_used < rhs.last_used;
+        }
+    );
+
+    for(auto& candidate: candidates) {
+        if(total <= memory_budget_) {
+            break;
+        }
+
+        candidate.evict();
+        total -= std::min(total, candidate.bytes);
+    }
+
+    if(total > memory_budget_) {
+        S_DEBUG("Assets in use exceed the memory budget: {0} > {1}", total, memory_budget_);
+    }
+}
+
+template<typename Manager>
+void AssetManager::add_residency(const Manager& manager, const AssetSources& sources,
+                                 const AssetMemoryStats& stats,
+                                 AssetMemoryStats& out) const {
+    manager.each([&out](uint32_t, const typename Manager::ObjectTypePtr asset) {
+        ++out.resident_count;
+        out.resident_bytes += asset->memory_usage();
+    });
+
+    for(auto& source: sources) {
+        if(source.second.evicted) {
+            ++out.evicted_count;
+        }
+    }
+
+    out.evictions += stats.evictions;
+    out.reloads += stats.reloads;
+}
+
+AssetResidency AssetManager::residency() const {
+    AssetResidency result;
+    result.budget = base_manager()->memory_budget_;
+
+    auto add = [&](const AssetManager* manager) {
+        manager->add_residency(manager->texture_manager_, manager->texture_sources_, manager->texture_stats_, result.textures);
+        manager->add_residency(manager->mesh_manager_, manager->mesh_sources_, manager->mesh_stats_, result.meshes);
+        manager->add_residency(manager->sound_manager_, manager->sound_sources_, manager->sound_stats_, result.sounds);
+    };
+
+    add(this);
+    for(auto child: children_) {
+        add(child);
+    }
+
+    return result;
+}
+
+/* The ID of an evicted asset with this name, or zero */
+template<typename Sources>
+static AssetID find_evicted(const Sources& sources, const std::string& name) {
+    for(auto& p: sources) {
+        if(p.second.evicted && p.second.name == name) {
+            return p.first;
+        }
+    }
+
+    return 0;
+}
+
+bool AssetManager::is_texture_evicted(AssetID id) const {
+    auto it = texture_sources_.find(id);
+    return it != texture_sources_.end() && it->second.evicted;
+}
+
+bool AssetManager::is_mesh_evicted(AssetID id) const {
+    auto it = mesh_sources_.find(id);
+    return it != mesh_sources_.end() && it->second.evicted;
+}
+
+bool AssetManager::is_sound_evicted(AssetID id) const {
+    auto it = sound_sources_.find(id);
+    return it != sound_sources_.end() && it->second.evicted;
 }
 
 bool AssetManager::is_base_manager() const {
@@ -204,10 +583,14 @@ MeshPtr AssetManager::create_mesh(VertexDataPtr vertex_data, GarbageCollectMetho
 }
 
 MeshPtr AssetManager::mesh(AssetID id) {
+    use_asset(mesh_manager_, mesh_sources_, mesh_stats_, id);
     GET_X(Mesh, mesh, mesh_manager_);
 }
 
 const MeshPtr AssetManager::mesh(AssetID id) const {
+    /* Reloading an evicted asset doesn't change what the caller can see */
+    auto self = const_cast<AssetManager*>(this);
+    self->use_asset(self->mesh_manager_, self->mesh_sources_, self->mesh_stats_, id);
     GET_X(Mesh, mesh, mesh_manager_);
 }
 
@@ -255,6 +638,39 @@ MeshPtr AssetManager::create_mesh_from_submesh(SubMesh* submesh, GarbageCollectM
     return mesh;
 }
 
+static bool load_mesh_with(LoaderPtr loader, MeshPtr mesh, const MeshLoadOptions& options) {
+    LoaderOptions loader_options;
+    loader_options[MESH_LOAD_OPTIONS_KEY] = options;
+
+    if(!loader->into(mesh, loader_options)) {
+        return false;
+    }
+
+    if(options.generate_lods) {
+        mesh->generate_lods();
+    }
+
+    /* After generating detail levels, so they're optimized too */
+    if(options.optimize) {
+        mesh->optimize();
+    }
+
+    return true;
+}
+
+/* Locates and opens `path` for an async load, returning the stream and the
+ * located path. The stream is null if the file doesn't exist. */
+static std::pair<std::shared_ptr<std::istream>, Path> open_for_async_load(const Path& path) {
+    auto vfs = get_app()->vfs.get();
+    auto located = vfs->locate_file(path);
+    if(!located) {
+        S_ERROR("Unable to load {0} as it doesn't exist", path);
+        return std::make_pair(std::shared_ptr<std::istream>(), path);
+    }
+
+    return std::make_pair(vfs->open_file(located.value()), located.value());
+}
+
 MeshPtr AssetManager::load_mesh(const Path& path,
     const VertexSpecification& desired_specification,
     const MeshLoadOptions& options,
@@ -270,16 +686,82 @@ MeshPtr AssetManager::load_mesh(const Path& path,
         return MeshPtr();
     }
 
-    LoaderOptions loader_options;
-    loader_options[MESH_LOAD_OPTIONS_KEY] = options;
-
-    if(!loader->into(mesh, loader_options)) {
+    if(!load_mesh_with(loader, mesh, options)) {
         return nullptr;
     }
 
+    track_mesh_source(mesh->id(), path, desired_specification, options);
     return mesh;
 }
 
+void AssetManager::track_mesh_source(AssetID id, const Path& path,
+                                     const VertexSpecification& desired_specification,
+                                     const MeshLoadOptions& options) {
+    track_source(mesh_sources_, id, [=]() -> bool {
+        auto mesh = mesh_manager_.make_with_id(id, this, desired_specification);
+        auto loader = get_app()->loader_for(path);
+        if(!loader || !load_mesh_with(loader, mesh, options)) {
+            mesh_manager_.destroy(id);
+            return false;
+        }
+
+        return true;
+    });
+}
+
+Promise<MeshPtr> AssetManager::load_mesh_async(const Path& path,
+    const VertexSpecification& desired_specification,
+    const MeshLoadOptions& options,
+    AssetLoadPriority priority,
+    GarbageCollectMethod garbage_collect) {
+
+    auto promise = Promise<MeshPtr>::create();
+
+    auto stream = open_for_async_load(path);
+    if(!stream.first) {
+        promise.fulfill(nullptr);
+        return promise;
+    }
+
+    /* The mesh loaders create materials and textures, so only the reading
+     * happens on the worker */
+    auto data = std::make_shared<std::stringstream>();
+
+    auto load = std::make_shared<AsyncLoad>();
+    load->path = path;
+    load->priority = priority;
+    load->decode = [stream, data]() -> bool {
+        (*data) << stream.first->rdbuf();
+        return bool(*data);
+    };
+
+    load->finish = [=]() mutable {
+        auto loader = get_app()->loader_for(stream.second, data, LOADER_HINT_MESH);
+        if(!loader) {
+            promise.fulfill(nullptr);
+            return;
+        }
+
+        auto mesh = create_mesh(desired_specification, GARBAGE_COLLECT_NEVER);
+        if(!load_mesh_with(loader, mesh, options)) {
+            destroy_mesh(mesh->id());
+            promise.fulfill(nullptr);
+            return;
+        }
+
+        mesh_manager_.set_garbage_collection_method(mesh->id(), garbage_collect);
+        track_mesh_source(mesh->id(), path, desired_specification, options);
+        promise.fulfill(std::move(mesh));
+    };
+
+    load->fail = [promise]() mutable {
+        promise.fulfill(nullptr);
+    };
+
+    queue_async_load(load);
+    return promise;
+}
+
 MeshPtr AssetManager::create_mesh_from_heightmap(const Path& image_file, const HeightmapSpecification& spec, GarbageCollectMethod garbage_collect) {
     auto loader = get_app()->loader_for("heightmap_loader", image_file);
 
@@ -324,7 +806,13 @@ MeshPtr AssetManager::create_mesh_as_cube_with_submesh_per_face(float width, Gar
 }
 
 MeshPtr AssetManager::find_mesh(const std::string& name) {
-    return mesh_manager_.find_object(name);
+    auto mesh = mesh_manager_.find_object(name);
+    auto evicted = find_evicted(mesh_sources_, name);
+    if(!mesh && evicted) {
+        mesh = this->mesh(evicted);
+    }
+
+    return mesh;
 }
 
 void AssetManager::destroy_mesh(AssetID m) {
@@ -332,7 +820,7 @@ void AssetManager::destroy_mesh(AssetID m) {
 }
 
 bool AssetManager::has_mesh(AssetID m) const {
-    return mesh_manager_.contains(m);
+    return mesh_manager_.contains(m) || is_mesh_evicted(m);
 }
 
 std::size_t AssetManager::mesh_count() const {
@@ -401,37 +889,129 @@ TexturePtr AssetManager::load_texture(const Path& path, GarbageCollectMethod gar
     return load_texture(path, TextureFlags(), garbage_collect);
 }
 
+static bool load_texture_into(const TexturePtr& tex, const Path& path, TextureFlags flags) {
+    S_DEBUG("Finding loader for: {0}", path);
+    auto loader = get_app()->loader_for(path, LOADER_HINT_TEXTURE);
+    if(!loader) {
+        S_WARN("Couldn't find loader for texture");
+        return false;
+    }
+
+    S_DEBUG("Loader found, loading...");
+    if(!loader->into(tex)) {
+        return false;
+    }
+
+    if(flags.flip_vertically) {
+        S_DEBUG("Flipping texture vertically");
+        tex->flip_vertically();
+    }
+
+    tex->set_mipmap_generation(flags.mipmap);
+    tex->set_texture_wrap(flags.wrap, flags.wrap, flags.wrap);
+    tex->set_texture_filter(flags.filter);
+    tex->set_auto_upload(flags.auto_upload);
+    return true;
+}
+
+void AssetManager::track_texture_source(AssetID id, const Path& path, TextureFlags flags) {
+    track_source(texture_sources_, id, [this, id, path, flags]() -> bool {
+        auto tex = texture_manager_.make_with_id(id, this, 8, 8, TEXTURE_FORMAT_RGBA_4UB_8888);
+        if(!load_texture_into(tex, path, flags)) {
+            texture_manager_.destroy(id);
+            return false;
+        }
+
+        return true;
+    });
+}
+
 TexturePtr AssetManager::load_texture(const Path& path, TextureFlags flags, GarbageCollectMethod garbage_collect) {
     //Load the texture
     S_DEBUG("Loading texture from file: {0}", path);
     smlt::TexturePtr tex = create_texture(8, 8, TEXTURE_FORMAT_RGBA_4UB_8888, garbage_collect);
 
-    {
-        S_DEBUG("Finding loader for: {0}", path);
-        auto loader = get_app()->loader_for(path, LOADER_HINT_TEXTURE);
-        if(!loader) {
-            S_WARN("Couldn't find loader for texture");
-            return smlt::TexturePtr();
-        }
+    if(!load_texture_into(tex, path, flags)) {
+        return nullptr;
+    }
 
-        S_DEBUG("Loader found, loading...");
-        if(!loader->into(tex)) {
-            return nullptr;
+    track_texture_source(tex->id(), path, flags);
+
+    S_DEBUG("Texture loaded");
+    return tex;
+}
+
+/* The renderer looks at every registered texture each frame, so async
+ * loads decode into one of these on the worker and the pixels are copied
+ * into a real texture once it's done */
+class StagingTexture : public Texture {
+public:
+    StagingTexture(AssetManager* manager):
+        Texture(0, manager, 8, 8, TEXTURE_FORMAT_RGBA_4UB_8888) {}
+
+private:
+    bool on_init() override {
+        return true;
+    }
+
+    void on_clean_up() override {}
+};
+
+Promise<TexturePtr> AssetManager::load_texture_async(const Path& path, TextureFlags flags,
+                                                     AssetLoadPriority priority,
+                                                     GarbageCollectMethod garbage_collect) {
+    auto promise = Promise<TexturePtr>::create();
+
+    auto loader = get_app()->loader_for(path, LOADER_HINT_TEXTURE);
+    if(!loader) {
+        S_WARN("Couldn't find loader for texture");
+        promise.fulfill(nullptr);
+        return promise;
+    }
+
+    std::shared_ptr<Texture> staging(
+        new StagingTexture(this),
+        std::bind(&deleter<Texture>, std::placeholders::_1)
+    );
+    staging->init();
+
+    auto load = std::make_shared<AsyncLoad>();
+    load->path = path;
+    load->priority = priority;
+    load->decode = [loader, staging, flags]() -> bool {
+        if(!loader->into(staging.get(), {{"auto_upload", false}})) {
+            return false;
         }
 
         if(flags.flip_vertically) {
-            S_DEBUG("Flipping texture vertically");
-            tex->flip_vertically();
+            staging->flip_vertically();
         }
 
+        return true;
+    };
+
+    load->finish = [=]() mutable {
+        auto tex = create_texture(
+            staging->width(), staging->height(), staging->format(),
+            garbage_collect
+        );
+
+        tex->set_data(staging->data(), staging->data_size());
         tex->set_mipmap_generation(flags.mipmap);
         tex->set_texture_wrap(flags.wrap, flags.wrap, flags.wrap);
         tex->set_texture_filter(flags.filter);
         tex->set_auto_upload(flags.auto_upload);
-    }
 
-    S_DEBUG("Texture loaded");
-    return tex;
+        track_texture_source(tex->id(), path, flags);
+        promise.fulfill(std::move(tex));
+    };
+
+    load->fail = [promise]() mutable {
+        promise.fulfill(nullptr);
+    };
+
+    queue_async_load(load);
+    return promise;
 }
 
 void AssetManager::destroy_texture(AssetID t) {
@@ -439,19 +1019,29 @@ void AssetManager::destroy_texture(AssetID t) {
 }
 
 TexturePtr AssetManager::find_texture(const std::string& name) {
-    return texture_manager_.find_object(name);
+    auto tex = texture_manager_.find_object(name);
+    auto evicted = find_evicted(texture_sources_, name);
+    if(!tex && evicted) {
+        tex = texture(evicted);
+    }
+
+    return tex;
 }
 
 TexturePtr AssetManager::texture(AssetID id) {
+    use_asset(texture_manager_, texture_sources_, texture_stats_, id);
     GET_X(Texture, texture, texture_manager_);
 }
 
 const TexturePtr AssetManager::texture(AssetID id) const {
+    /* Reloading an evicted asset doesn't change what the caller can see */
+    auto self = const_cast<AssetManager*>(this);
+    self->use_asset(self->texture_manager_, self->texture_sources_, self->texture_stats_, id);
     GET_X(Texture, texture, texture_manager_);
 }
 
 bool AssetManager::has_texture(AssetID t) const {
-    return texture_manager_.contains(t);
+    return texture_manager_.contains(t) || is_texture_evicted(t);
 }
 
 std::size_t AssetManager::texture_count() const {
@@ -478,18 +1068,95 @@ SoundPtr AssetManager::load_sound(const Path& path, const SoundFlags &flags, Gar
 
     sound_manager_.set_garbage_collection_method(snd->id(), garbage_collect);
 
+    if(loader) {
+        track_sound_source(snd->id(), path, flags);
+    }
+
     return snd;
 }
 
+void AssetManager::track_sound_source(AssetID id, const Path& path, const SoundFlags& flags) {
+    track_source(sound_sources_, id, [this, id, path, flags]() -> bool {
+        auto snd = sound_manager_.make_with_id(id, this, get_app()->sound_driver);
+        auto loader = get_app()->loader_for(path);
+
+        LoaderOptions opts;
+        opts["stream"] = flags.stream_audio;
+
+        if(!loader || !loader->into(snd, opts)) {
+            sound_manager_.destroy(id);
+            return false;
+        }
+
+        return true;
+    });
+}
+
+Promise<SoundPtr> AssetManager::load_sound_async(const Path& path, const SoundFlags& flags,
+                                                 AssetLoadPriority priority,
+                                                 GarbageCollectMethod garbage_collect) {
+    auto promise = Promise<SoundPtr>::create();
+
+    auto loader = get_app()->loader_for(path);
+    if(!loader) {
+        S_ERROR("Unsupported file type: ", path);
+        promise.fulfill(nullptr);
+        return promise;
+    }
+
+    /* Nothing else looks at a sound until it's played, so the worker can
+     * load straight into it. It's kept alive until the load finishes. */
+    auto snd = sound_manager_.make(this, get_app()->sound_driver);
+    sound_manager_.set_garbage_collection_method(snd->id(), GARBAGE_COLLECT_NEVER);
+
+    auto load = std::make_shared<AsyncLoad>();
+    load->path = path;
+    load->priority = priority;
+    load->decode = [loader, snd, flags]() -> bool {
+        LoaderOptions opts;
+        opts["stream"] = flags.stream_audio;
+        return loader->into(snd, opts);
+    };
+
+    load->finish = [=]() mutable {
+        sound_manager_.set_garbage_collection_method(snd->id(), garbage_collect);
+        track_sound_source(snd->id(), path, flags);
+        promise.fulfill(SoundPtr(snd));
+    };
+
+    load->fail = [promise]() mutable {
+        promise.fulfill(nullptr);
+    };
+
+    /* The worker loads straight into the sound, so it can't be collected
+     * until it's done */
+    load->discard = [this, snd]() {
+        sound_manager_.set_garbage_collection_method(snd->id(), GARBAGE_COLLECT_PERIODIC);
+    };
+
+    queue_async_load(load);
+    return promise;
+}
+
 SoundPtr AssetManager::find_sound(const std::string &name) {
-    return sound_manager_.find_object(name);
+    auto snd = sound_manager_.find_object(name);
+    auto evicted = find_evicted(sound_sources_, name);
+    if(!snd && evicted) {
+        snd = sound(evicted);
+    }
+
+    return snd;
 }
 
 SoundPtr AssetManager::sound(AssetID id) {
+    use_asset(sound_manager_, sound_sources_, sound_stats_, id);
     GET_X(Sound, sound, sound_manager_);
 }
 
 const SoundPtr AssetManager::sound(AssetID id) const {
+    /* Reloading an evicted asset doesn't change what the caller can see */
+    auto self = const_cast<AssetManager*>(this);
+    self->use_asset(self->sound_manager_, self->sound_sources_, self->sound_stats_, id);
     GET_X(Sound, sound, sound_manager_);
 }
 
@@ -498,7 +1165,7 @@ std::size_t AssetManager::sound_count() const {
 }
 
 bool AssetManager::has_sound(AssetID s) const {
-    return sound_manager_.contains(s);
+    return sound_manager_.contains(s) || is_sound_evicted(s);
 }
 
 void AssetManager::destroy_sound(AssetID t) {
@@ -702,6 +1369,55 @@ PrefabPtr AssetManager::load_prefab(const Path& filename,
     return prefab;
 }
 
+Promise<PrefabPtr> AssetManager::load_prefab_async(const Path& path,
+                                                   AssetLoadPriority priority,
+                                                   GarbageCollectMethod garbage_collect) {
+    auto promise = Promise<PrefabPtr>::create();
+
+    auto stream = open_for_async_load(path);
+    if(!stream.first) {
+        promise.fulfill(nullptr);
+        return promise;
+    }
+
+    /* As with meshes, the glTF loader creates assets while it parses so
+     * only the reading happens on the worker */
+    auto data = std::make_shared<std::stringstream>();
+
+    auto load = std::make_shared<AsyncLoad>();
+    load->path = path;
+    load->priority = priority;
+    load->decode = [stream, data]() -> bool {
+        (*data) << stream.first->rdbuf();
+        return bool(*data);
+    };
+
+    load->finish = [=]() mutable {
+        auto loader = get_app()->loader_for(stream.second, data);
+        if(!loader) {
+            promise.fulfill(nullptr);
+            return;
+        }
+
+        auto prefab = prefab_manager_.make(this);
+        if(!loader->into(prefab.get(), LoaderOptions())) {
+            prefab_manager_.set_garbage_collection_method(prefab->id(), GARBAGE_COLLECT_PERIODIC);
+            promise.fulfill(nullptr);
+            return;
+        }
+
+        prefab_manager_.set_garbage_collection_method(prefab->id(), garbage_collect);
+        promise.fulfill(std::move(prefab));
+    };
+
+    load->fail = [promise]() mutable {
+        promise.fulfill(nullptr);
+    };
+
+    queue_async_load(load);
+    return promise;
+}
+
 PrefabPtr AssetManager::prefab(AssetID id) {
     GET_X(Prefab, prefab, prefab_manager_);
 }
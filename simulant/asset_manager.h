@@ -18,14 +18,17 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include "assets/binary_data.h"
 #include "assets/material.h"
 #include "assets/particle_script.h"
 #include "assets/prefab.h"
 #include "assets/texture_flags.h"
+#include "coroutines/helpers.h"
 
 #include "font.h"
 #include "generic/lru_cache.h"
@@ -35,6 +38,7 @@
 #include "managers/window_holder.h"
 #include "meshes/mesh.h"
 #include "path.h"
+#include "services/job_system.h"
 #include "sound.h"
 #include "texture.h"
 
@@ -67,6 +71,40 @@ struct SoundFlags {
     bool stream_audio = true;
 };
 
+/* Asynchronous loads with a higher priority are started, and finished,
+ * before those with a lower one. Loads of the same priority run in the
+ * order they were requested. */
+enum AssetLoadPriority {
+    ASSET_LOAD_PRIORITY_LOW = 0,
+    ASSET_LOAD_PRIORITY_NORMAL,
+    ASSET_LOAD_PRIORITY_HIGH
+};
+
+struct AssetMemoryStats {
+    /* Assets which are loaded, and the bytes they're holding */
+    std::size_t resident_count = 0;
+    std::size_t resident_bytes = 0;
+
+    /* Assets which have been evicted to stay within the memory budget */
+    std::size_t evicted_count = 0;
+
+    /* Running totals */
+    std::size_t evictions = 0;
+    std::size_t reloads = 0;
+};
+
+struct AssetResidency {
+    AssetMemoryStats textures;
+    AssetMemoryStats meshes;
+    AssetMemoryStats sounds;
+
+    std::size_t budget = 0;
+
+    std::size_t resident_bytes() const {
+        return textures.resident_bytes + meshes.resident_bytes + sounds.resident_bytes;
+    }
+};
+
 /* Majority of the API definitions have been generated using this Python code:
  *
  * TEMPLATE="""
@@ -257,6 +295,94 @@ public:
         TexturePtr texture,
         GarbageCollectMethod garbage_collect = GARBAGE_COLLECT_PERIODIC);
 
+    /*
+     * Asynchronous loading
+     *
+     * These return straight away with a Promise which is fulfilled with the
+     * asset once it's ready, or with null if the load failed or was
+     * cancelled.
+     *
+     * Reading and decoding run on the job system. Anything that touches
+     * the asset managers or the renderer is finished on the main thread
+     * by update(), which stops once the async load budget for the frame
+     * is used up. Higher priority loads are started and finished first.
+     *
+     * Textures and sounds are decoded entirely on the workers. Meshes and
+     * prefabs are read into memory on the workers, but their loaders
+     * create materials and textures as they go so they're parsed on the
+     * main thread.
+     */
+    Promise<TexturePtr> load_texture_async(
+        const Path& path, TextureFlags flags = TextureFlags(),
+        AssetLoadPriority priority = ASSET_LOAD_PRIORITY_NORMAL,
+        GarbageCollectMethod garbage_collect = GARBAGE_COLLECT_PERIODIC);
+
+    Promise<MeshPtr> load_mesh_async(
+        const Path& path,
+        const VertexSpecification& desired_specification =
+            VertexSpecification::DEFAULT,
+        const MeshLoadOptions& options = MeshLoadOptions(),
+        AssetLoadPriority priority = ASSET_LOAD_PRIORITY_NORMAL,
+        GarbageCollectMethod garbage_collect = GARBAGE_COLLECT_PERIODIC);
+
+    Promise<SoundPtr> load_sound_async(
+        const Path& path, const SoundFlags& flags = SoundFlags(),
+        AssetLoadPriority priority = ASSET_LOAD_PRIORITY_NORMAL,
+        GarbageCollectMethod garbage_collect = GARBAGE_COLLECT_PERIODIC);
+
+    Promise<PrefabPtr> load_prefab_async(
+        const Path& path,
+        AssetLoadPriority priority = ASSET_LOAD_PRIORITY_NORMAL,
+        GarbageCollectMethod garbage_collect = GARBAGE_COLLECT_PERIODIC);
+
+    /* Cancels any unfinished async loads of `path` made through this
+     * manager, fulfilling their promises with null. Returns the number
+     * cancelled. */
+    std::size_t cancel_async_load(const Path& path);
+    void cancel_all_async_loads();
+
+    /* The number of async loads made through this manager which haven't
+     * finished yet */
+    std::size_t async_load_count() const;
+
+    /* Microseconds per frame spent finishing async loads. The base
+     * manager's budget is shared with its children. */
+    void set_async_load_budget(uint32_t budget_us) {
+        async_load_budget_us_ = budget_us;
+    }
+
+    uint32_t async_load_budget() const {
+        return async_load_budget_us_;
+    }
+
+    /*
+     * Memory budget
+     *
+     * When the textures, meshes and sounds of a manager and its children
+     * hold more than the budget, the least recently used ones which were
+     * loaded from a file are evicted until they fit. Only assets that
+     * nothing else holds a pointer to are evicted, and they keep their
+     * ID: accessing one through texture(id), find_texture(name) and so on
+     * reloads it from the file.
+     *
+     * The budget is checked during garbage collection. The base manager's
+     * budget covers its children, and zero (the default) means no limit.
+     */
+    void set_memory_budget(std::size_t bytes) {
+        memory_budget_ = bytes;
+    }
+
+    std::size_t memory_budget() const {
+        return memory_budget_;
+    }
+
+    /* Byte counts and eviction stats for this manager and its children */
+    AssetResidency residency() const;
+
+    bool is_texture_evicted(AssetID id) const;
+    bool is_mesh_evicted(AssetID id) const;
+    bool is_sound_evicted(AssetID id) const;
+
     void update(float dt);
 
     virtual MaterialPtr default_material() const;
@@ -295,6 +421,105 @@ private:
     PrefabManager prefab_manager_;
 
     std::vector<AssetManager*> children_;
+
+    struct AsyncLoad {
+        Path path;
+        AssetLoadPriority priority = ASSET_LOAD_PRIORITY_NORMAL;
+        uint64_t order = 0;
+
+        /* Runs on a worker, returns false if the load failed */
+        std::function<bool ()> decode;
+
+        /* Run on the main thread once the decode has finished. Exactly one
+         * of these is called, and it must fulfil the promise. */
+        std::function<void ()> finish;
+        std::function<void ()> fail;
+
+        /* Optional, run on the main thread after fail() once no worker is
+         * using the load any more. Anything the decode writes into must
+         * only be released from here. */
+        std::function<void ()> discard;
+
+        /* Written by the worker, only read once the counter is done */
+        bool decoded = false;
+        JobCounterPtr counter;
+
+        bool cancelled = false;
+    };
+
+    typedef std::shared_ptr<AsyncLoad> AsyncLoadPtr;
+
+    /* Waiting for a worker, in priority order */
+    std::vector<AsyncLoadPtr> async_queued_;
+
+    /* Decoding, or decoded and waiting to be finished */
+    std::vector<AsyncLoadPtr> async_running_;
+
+    uint64_t async_load_order_ = 0;
+    uint32_t async_load_budget_us_ = 2000;
+
+    void queue_async_load(const AsyncLoadPtr& load);
+    void discard_async_load(const AsyncLoadPtr& load);
+    void update_async_loads(uint64_t deadline);
+
+    /* How to get an evictable asset back, keyed by asset ID */
+    struct AssetSource {
+        /* Recreates the asset, with the same ID, from its file */
+        std::function<bool ()> reload;
+
+        std::string name;
+        GarbageCollectMethod garbage_collect = GARBAGE_COLLECT_PERIODIC;
+        uint64_t last_used = 0;
+        bool evicted = false;
+    };
+
+    typedef std::unordered_map<AssetID, AssetSource> AssetSources;
+
+    struct EvictionCandidate {
+        std::function<void ()> evict;
+        std::size_t bytes = 0;
+        uint64_t last_used = 0;
+    };
+
+    AssetSources texture_sources_;
+    AssetSources mesh_sources_;
+    AssetSources sound_sources_;
+
+    /* Only the eviction and reload totals are kept up to date */
+    AssetMemoryStats texture_stats_;
+    AssetMemoryStats mesh_stats_;
+    AssetMemoryStats sound_stats_;
+
+    std::size_t memory_budget_ = 0;
+
+    /* Incremented by each garbage collection of the base manager, this is
+     * the clock for least recently used */
+    uint64_t residency_frame_ = 0;
+
+    void track_source(AssetSources& sources, AssetID id,
+                      std::function<bool ()> reload);
+    void track_texture_source(AssetID id, const Path& path, TextureFlags flags);
+    void track_mesh_source(AssetID id, const Path& path,
+                           const VertexSpecification& desired_specification,
+                           const MeshLoadOptions& options);
+    void track_sound_source(AssetID id, const Path& path, const SoundFlags& flags);
+
+    template<typename Manager>
+    void use_asset(Manager& manager, AssetSources& sources,
+                   AssetMemoryStats& stats, AssetID id);
+
+    template<typename Manager>
+    std::size_t find_evictable(Manager& manager, AssetSources& sources,
+                               AssetMemoryStats& stats,
+                               std::vector<EvictionCandidate>* candidates);
+
+    template<typename Manager>
+    void add_residency(const Manager& manager, const AssetSources& sources,
+                       const AssetMemoryStats& stats,
+                       AssetMemoryStats& out) const;
+
+    void enforce_memory_budget();
+
     void register_child(AssetManager* child) {
         children_.push_back(child);
     }
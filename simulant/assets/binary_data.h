@@ -26,6 +26,10 @@ public:
         return data_.size();
     }
 
+    std::size_t memory_usage() const override {
+        return data_.size();
+    }
+
 private:
     std::vector<uint8_t> data_;
 };
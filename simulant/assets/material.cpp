@@ -34,6 +34,8 @@ namespace smlt {
 const std::string Material::BuiltIns::DEFAULT = "materials/${RENDERER}/default.smat";
 const std::string Material::BuiltIns::TEXTURE_ONLY = "materials/${RENDERER}/texture_only.smat";
 const std::string Material::BuiltIns::DIFFUSE_ONLY = "materials/${RENDERER}/diffuse_only.smat";
+const std::string Material::BuiltIns::SKINNED = "materials/${RENDERER}/skinned.smat";
+const std::string Material::BuiltIns::PARTICLE = "materials/${RENDERER}/particle.smat";
 
 /* This list is used by the particle script loader to determine if a specified material
  * is a built-in or not. Please keep this up-to-date when changing the above materials!
@@ -42,6 +44,8 @@ const std::unordered_map<std::string, std::string> Material::BUILT_IN_NAMES = {
     {"DEFAULT", Material::BuiltIns::DEFAULT},
     {"TEXTURE_ONLY", Material::BuiltIns::TEXTURE_ONLY},
     {"DIFFUSE_ONLY", Material::BuiltIns::DIFFUSE_ONLY},
+    {"SKINNED", Material::BuiltIns::SKINNED},
+    {"PARTICLE", Material::BuiltIns::PARTICLE},
 };
 
 Material::Material(AssetID id, AssetManager* asset_manager):
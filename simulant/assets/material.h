@@ -206,6 +206,16 @@ public:
         static const std::string DEFAULT;
         static const std::string TEXTURE_ONLY;
         static const std::string DIFFUSE_ONLY;
+
+        /* Skins vertices with the joint palette of a GPU-skinned Mesh
+         * (see Mesh::set_skinning_mode). Only available with the GL2x
+         * renderer. */
+        static const std::string SKINNED;
+
+        /* Expands particle billboards in the vertex shader, for particle
+         * scripts with gpu_billboarding set. Renderers which can't do that
+         * get a plain textured material instead. */
+        static const std::string PARTICLE;
     };
 
     static const std::unordered_map<std::string, std::string> BUILT_IN_NAMES;
@@ -66,6 +66,10 @@ bool ParticleScript::cull_each() const {
     return cull_each_;
 }
 
+bool ParticleScript::gpu_billboarding() const {
+    return gpu_billboarding_;
+}
+
 MaterialPtr ParticleScript::material() const {
     return material_;
 }
@@ -108,6 +112,10 @@ void ParticleScript::set_cull_each(bool v) {
     cull_each_ = v;
 }
 
+void ParticleScript::set_gpu_billboarding(bool v) {
+    gpu_billboarding_ = v;
+}
+
 void ParticleScript::set_material(MaterialPtr material) {
     material_ = material;
 }
@@ -32,7 +32,7 @@ struct Emitter {
 };
 
 
-struct Particle;
+struct ParticleSpan;
 class ParticleScript;
 
 class Manipulator {
@@ -43,8 +43,10 @@ public:
 
     virtual ~Manipulator() {}
 
-    void manipulate(ParticleSystem* system, Particle* particles, std::size_t particle_count, float dt) const {
-        do_manipulate(system, particles, particle_count, dt);
+    /* Manipulators are handed all the live particles at once, a field
+     * at a time, so that they can process them in bulk */
+    void manipulate(ParticleSystem* system, const ParticleSpan& particles, float dt) const {
+        do_manipulate(system, particles, dt);
     }
 
     virtual void set_linear_curve(float rate);
@@ -53,7 +55,7 @@ public:
 
 private:
     std::string name_;
-    virtual void do_manipulate(ParticleSystem* system, Particle* particles, std::size_t particle_count, float dt) const = 0;
+    virtual void do_manipulate(ParticleSystem* system, const ParticleSpan& particles, float dt) const = 0;
 
 protected:
     typedef std::function<float (float, float, float)> CurveFunc;
@@ -96,6 +98,13 @@ public:
     float particle_height() const;
 
     bool cull_each() const;
+
+    /* If true, and the renderer supports it, particle systems only upload
+     * the centre, size and colour of each particle and leave the material
+     * to expand them into quads. The material must be one which does that,
+     * like Material::BuiltIns::PARTICLE. */
+    bool gpu_billboarding() const;
+
     MaterialPtr material() const;
     bool has_repeating_emitters() const;
 
@@ -110,6 +119,7 @@ public:
     void set_particle_width(float w);
     void set_particle_height(float h);
     void set_cull_each(bool v);
+    void set_gpu_billboarding(bool v);
     void set_material(MaterialPtr material);
 
 private:
@@ -119,6 +129,7 @@ private:
     float particle_width_ = 100.0f;
     float particle_height_ = 100.0f;
     bool cull_each_ = false;
+    bool gpu_billboarding_ = false;
 
     std::array<Emitter, ParticleScript::MAX_EMITTER_COUNT> emitters_;
     uint16_t emitter_count_ = 0;
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "../particle_script.h"
-#include "../../nodes/particles/particle.h"
+#include "../../nodes/particles/particle_storage.h"
 
 #include "curves.h"
 
@@ -16,23 +16,28 @@ public:
         interpolate_(interpolate) {}
 
 private:
-    void do_manipulate(ParticleSystem*, Particle* particles, std::size_t particle_count, float) const {
-        auto size = (float) alphas_.size();
-        float fsize = float(size);
-        Particle* particle = particles;
-        for(auto i = 0u; i < particle_count; ++i, ++particle) {
-            const float e = (particle->lifetime - particle->ttl);
-            const float n = smlt::fast_divide(e, particle->lifetime);
-            const float fsizen = fsize * n;
-
-            uint8_t color = smlt::clamp(fsizen, 0.0f, fsize);
-
-            particle->color.a = alphas_[color];
-
-            if(interpolate_) {
-                const float f = fsizen - std::floor(fsizen);
-                auto next_alpha = alphas_[std::min((uint32_t) color + 1, (uint32_t) size - 1)];
-                particle->color.a = (particle->color.a * (1.0f - f)) + (next_alpha * f);
+    void do_manipulate(ParticleSystem*, const ParticleSpan& particles, float) const {
+        const float fsize = float(alphas_.size());
+        const float last = fsize - 1.0f;
+
+        float age[PARTICLE_CHUNK_SIZE];
+        for(std::size_t first = 0; first < particles.count; first += PARTICLE_CHUNK_SIZE) {
+            auto count = std::min(particles.count - first, PARTICLE_CHUNK_SIZE);
+            particle_normalised_age(age, particles.ttl + first, particles.lifetime + first, count);
+
+            float* alpha = particles.a + first;
+            for(auto i = 0u; i < count; ++i) {
+                const float fsizen = fsize * age[i];
+
+                uint8_t index = smlt::clamp(fsizen, 0.0f, last);
+
+                alpha[i] = alphas_[index];
+
+                if(interpolate_) {
+                    const float f = fsizen - std::floor(fsizen);
+                    auto next_alpha = alphas_[std::min((uint32_t) index + 1, (uint32_t) last)];
+                    alpha[i] = (alpha[i] * (1.0f - f)) + (next_alpha * f);
+                }
             }
         }
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../particle_script.h"
+#include "../../nodes/particles/particle_storage.h"
 #include "curves.h"
 
 namespace smlt {
@@ -14,23 +15,32 @@ public:
         interpolate_(interpolate) {}
 
 private:
-    void do_manipulate(ParticleSystem*, Particle* particles, std::size_t particle_count, float) const {
-        auto size = (float) colors_.size();
-        float fsize = float(size);
-        auto particle = particles;
-        for(auto i = 0u; i < particle_count; ++i, ++particle) {
-            const float e = (particle->lifetime - particle->ttl);
-            const float n = smlt::fast_divide(e, particle->lifetime);
-            const float fsizen = fsize * n;
-
-            uint8_t color = smlt::clamp(fsizen, 0.0f, fsize);
-
-            particle->color = colors_[color];
-
-            if(interpolate_) {
-                const float f = fsizen - std::floor(fsizen);
-                auto next_color = colors_[std::min((uint32_t) color + 1, (uint32_t) size - 1)];
-                particle->color = (particle->color * (1.0f - f)) + (next_color * f);
+    void do_manipulate(ParticleSystem*, const ParticleSpan& particles, float) const {
+        const float fsize = float(colors_.size());
+        const float last = fsize - 1.0f;
+
+        float age[PARTICLE_CHUNK_SIZE];
+        for(std::size_t first = 0; first < particles.count; first += PARTICLE_CHUNK_SIZE) {
+            auto count = std::min(particles.count - first, PARTICLE_CHUNK_SIZE);
+            particle_normalised_age(age, particles.ttl + first, particles.lifetime + first, count);
+
+            for(auto i = first; i < first + count; ++i) {
+                const float fsizen = fsize * age[i - first];
+
+                uint8_t index = smlt::clamp(fsizen, 0.0f, last);
+
+                Color color = colors_[index];
+
+                if(interpolate_) {
+                    const float f = fsizen - std::floor(fsizen);
+                    auto next_color = colors_[std::min((uint32_t) index + 1, (uint32_t) last)];
+                    color = (color * (1.0f - f)) + (next_color * f);
+                }
+
+                particles.r[i] = color.r;
+                particles.g[i] = color.g;
+                particles.b[i] = color.b;
+                particles.a[i] = color.a;
             }
         }
     }
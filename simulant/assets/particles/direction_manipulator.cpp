@@ -3,14 +3,12 @@
 
 namespace smlt {
 
-void DirectionManipulator::do_manipulate(ParticleSystem *system, Particle *particles, std::size_t particle_count, float dt) const {
+void DirectionManipulator::do_manipulate(ParticleSystem *system, const ParticleSpan& particles, float dt) const {
     _S_UNUSED(system);
 
-    Particle* it = particles;
-    while(particle_count--) {
-        it->position += dir_ * dt;
-        ++it;
-    }
+    particle_add(particles.position_x, dir_.x * dt, particles.count);
+    particle_add(particles.position_y, dir_.y * dt, particles.count);
+    particle_add(particles.position_z, dir_.z * dt, particles.count);
 }
 
 }
@@ -5,13 +5,12 @@
 
 namespace smlt {
 
-void DirectionNoiseRandomManipulator::do_manipulate(ParticleSystem *system, Particle *particles, std::size_t particle_count, float dt) const {
+void DirectionNoiseRandomManipulator::do_manipulate(ParticleSystem *system, const ParticleSpan& particles, float dt) const {
     _S_UNUSED(system);
 
     auto& rgen = RandomGenerator::instance();
 
-    Particle* it = particles;
-    while(particle_count--) {
+    for(std::size_t i = 0; i < particles.count; ++i) {
         Vec3 noise = Vec3(
             rgen.float_in_range(-50, 50) * noise_amount_.x,
             rgen.float_in_range(-50, 50) * noise_amount_.y,
@@ -19,11 +18,9 @@ void DirectionNoiseRandomManipulator::do_manipulate(ParticleSystem *system, Part
         );
 
         auto final_dir = dir_ + noise;
-        it->position += final_dir * dt;
-
-        /* Make sure the particles are rotated properly according to their direction */
-
-        ++it;
+        particles.position_x[i] += final_dir.x * dt;
+        particles.position_y[i] += final_dir.y * dt;
+        particles.position_z[i] += final_dir.z * dt;
     }
 }
 
@@ -14,8 +14,8 @@ public:
 private:
     void do_manipulate(
         ParticleSystem* system,
-        Particle* particles,
-        std::size_t particle_count, float dt) const override;
+        const ParticleSpan& particles,
+        float dt) const override;
 
     Vec3 dir_;
     Vec3 noise_amount_;
@@ -6,35 +6,35 @@
 
 namespace smlt {
 
-void SizeManipulator::do_manipulate(ParticleSystem* system, Particle* particles, std::size_t particle_count, float dt) const {
+void SizeManipulator::do_manipulate(ParticleSystem* system, const ParticleSpan& particles, float dt) const {
     _S_UNUSED(dt);
 
-    /* We always have to set the curve before manipulation to take into
-         * account any scaling of the particle system */
+    /* We always have to scale the curve at manipulation time to take into
+     * account any scaling of the particle system. We have to only respect X
+     * scale here, no other option! */
+    const float size = system->transform->scale_factor().x;
 
-    auto create_scaled_curve = [this](float size) -> CurveFunc {
-        using namespace std::placeholders;
-
-        if(is_bell_curve_) {
-            return std::bind(&bell_curve, _1, _2, _3, peak_ * size, deviation_);
-        } else {
-            assert(is_linear_curve_);
-            return std::bind(&linear_curve, _1, _2, _3, rate_ * size);
-        }
-    };
+    if(is_linear_curve_) {
+        particle_grow_linear(particles.width, particles.initial_width, particles.ttl, particles.lifetime, rate_ * size, particles.count);
+        particle_grow_linear(particles.height, particles.initial_height, particles.ttl, particles.lifetime, rate_ * size, particles.count);
+        return;
+    }
 
+    assert(is_bell_curve_);
 
-    /* We have to only respect X scale here, no other option! */
-    auto curve = create_scaled_curve(system->transform->scale_factor().x);
+    const float peak = peak_ * size;
 
-    Particle* particle = particles;
-    for(auto i = 0u; i < particle_count; ++i) {
-        float e = (particle->lifetime - particle->ttl);
-        float n =  smlt::fast_divide(e, particle->lifetime);
-        particle->dimensions.x = curve(particle->initial_dimensions.x, n, e);
-        particle->dimensions.y = curve(particle->initial_dimensions.y, n, e);
+    float age[PARTICLE_CHUNK_SIZE];
+    for(std::size_t first = 0; first < particles.count; first += PARTICLE_CHUNK_SIZE) {
+        auto count = std::min(particles.count - first, PARTICLE_CHUNK_SIZE);
+        particle_normalised_age(age, particles.ttl + first, particles.lifetime + first, count);
 
-        ++particle;
+        for(auto i = first; i < first + count; ++i) {
+            float n = age[i - first];
+            float e = particles.lifetime[i] - particles.ttl[i];
+            particles.width[i] = bell_curve(particles.initial_width[i], n, e, peak, deviation_);
+            particles.height[i] = bell_curve(particles.initial_height[i], n, e, peak, deviation_);
+        }
     }
 }
 
@@ -359,11 +359,17 @@ void Compositor::run_layer(LayerPtr pipeline_stage, int &actors_rendered) {
     render_queue_.reset(stage_node, window->renderer.get(), camera);
 
     _S_PROFILE_SUBSECTION("build-renderables");
-    StageNodeVisitorBFS node_finder(
-        stage_node, std::bind(build_renderables, lights_visible, &render_queue_,
-                              camera, pipeline_stage, std::placeholders::_1));
 
-    while(node_finder.call_next()) {}
+    /* Subtrees outside the camera's view are skipped as a whole, using the
+     * cached subtree bounds which are refreshed when moves are delivered */
+    stage_node->scene->flush_transform_changes();
+
+    StageNodeVisitorFrustum node_finder(
+        stage_node, camera->frustum(),
+        std::bind(build_renderables, std::ref(lights_visible), &render_queue_,
+                  camera, pipeline_stage, std::placeholders::_1));
+
+    node_finder.run();
 
     actors_rendered += render_queue_.renderable_count();
 
@@ -13,7 +13,8 @@ void* smlt::aligned_alloc(std::size_t alignment, std::size_t size) {
 #elif defined(__PSP__) || defined(__ANDROID__)
     p = memalign(alignment, size);
 #else
-    p = ::aligned_alloc(alignment, size);
+    /* C11 requires the size to be a multiple of the alignment */
+    p = ::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
 #endif
 
     return p;
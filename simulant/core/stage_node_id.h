@@ -6,7 +6,38 @@ namespace smlt {
 
 typedef uint32_t StageNodeID;
 
-bool stage_node_id_matches_type(StageNodeID id, uint16_t node_type);
+/* Stage nodes created by a scene have IDs which encode their slot in the
+ * scene's node table, along with the generation of the slot. Looking a node
+ * up is then an index, and the ID of a destroyed node won't match whatever
+ * reuses its slot (until the generation wraps around).
+ *
+ * IDs with the top bit set are not slot IDs (e.g. the scene's own ID). */
+const uint32_t STAGE_NODE_ID_SLOT_BITS = 20;
+const uint32_t STAGE_NODE_ID_GENERATION_BITS = 11;
+
+const uint32_t STAGE_NODE_ID_MAX_SLOTS = 1u << STAGE_NODE_ID_SLOT_BITS;
+const uint32_t STAGE_NODE_ID_MAX_GENERATION =
+    (1u << STAGE_NODE_ID_GENERATION_BITS) - 1;
+
+const StageNodeID STAGE_NODE_ID_UNSLOTTED = 1u << 31;
+
+inline StageNodeID make_stage_node_id(uint32_t slot, uint32_t generation) {
+    return (generation << STAGE_NODE_ID_SLOT_BITS) | slot;
+}
+
+inline bool stage_node_id_is_slotted(StageNodeID id) {
+    return !(id & STAGE_NODE_ID_UNSLOTTED);
+}
+
+inline uint32_t stage_node_id_slot(StageNodeID id) {
+    return id & (STAGE_NODE_ID_MAX_SLOTS - 1);
+}
+
+inline uint32_t stage_node_id_generation(StageNodeID id) {
+    return (id >> STAGE_NODE_ID_SLOT_BITS) & STAGE_NODE_ID_MAX_GENERATION;
+}
+
+/* An unslotted ID, used until a node is given its slot */
 StageNodeID new_stage_node_id(uint16_t node_type);
 
 }
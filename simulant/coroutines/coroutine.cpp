@@ -1,5 +1,6 @@
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include "coroutine.h"
 #include "../threads/thread.h"
 #include "../threads/mutex.h"
@@ -7,9 +8,140 @@
 #include "../application.h"
 #include "../time_keeper.h"
 
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+#include <exception>
+#include <sys/mman.h>
+#include <unistd.h>
+
+extern "C" {
+
+/* Pushes the callee-saved registers onto the current stack, stores the
+ * stack pointer in *from, then switches to the stack at to and pops the
+ * registers that were saved there. Unlike swapcontext() this doesn't
+ * touch the signal mask, so no syscalls are made. */
+__attribute__((visibility("hidden"))) void simulant_fiber_switch(void** from, void* to);
+
+/* First return address of a new fiber, calls simulant_fiber_main */
+__attribute__((visibility("hidden"))) void simulant_fiber_entry();
+__attribute__((visibility("hidden"))) void simulant_fiber_main(void* context);
+
+}
+
+#if defined(__x86_64__)
+asm(R"(
+    .text
+    .globl simulant_fiber_switch
+    .hidden simulant_fiber_switch
+    .type simulant_fiber_switch, @function
+    .p2align 4
+simulant_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size simulant_fiber_switch, .-simulant_fiber_switch
+
+    .globl simulant_fiber_entry
+    .hidden simulant_fiber_entry
+    .type simulant_fiber_entry, @function
+    .p2align 4
+simulant_fiber_entry:
+    movq %r12, %rdi
+    call simulant_fiber_main
+    ud2
+    .size simulant_fiber_entry, .-simulant_fiber_entry
+)");
+#elif defined(__aarch64__)
+asm(R"(
+    .text
+    .globl simulant_fiber_switch
+    .hidden simulant_fiber_switch
+    .type simulant_fiber_switch, %function
+    .p2align 4
+simulant_fiber_switch:
+    sub sp, sp, #160
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x2, sp
+    str x2, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #160
+    ret
+    .size simulant_fiber_switch, .-simulant_fiber_switch
+
+    .globl simulant_fiber_entry
+    .hidden simulant_fiber_entry
+    .type simulant_fiber_entry, %function
+    .p2align 4
+simulant_fiber_entry:
+    mov x0, x19
+    bl simulant_fiber_main
+    brk #0
+    .size simulant_fiber_entry, .-simulant_fiber_entry
+)");
+#endif
+
+#endif
+
 namespace smlt {
 namespace cort {
 
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+
+struct Stack {
+    uint8_t* memory = nullptr;
+
+    /* The usable size that was requested, and the size of the
+     * whole mapping (including the guard page) */
+    std::size_t size = 0;
+    std::size_t mapped_size = 0;
+};
+
+/* Thrown inside a fiber by yield_coroutine() when stop_coroutine()
+ * has been called, so that the coroutine's stack is unwound */
+struct CoroutineTerminated {};
+
+/* How many times stop_coroutine() resumes a fiber which keeps
+ * catching CoroutineTerminated before giving up on it */
+static const int MAX_TERMINATE_ATTEMPTS = 16;
+
+#endif
+
 struct Context {
     CoroutineID id;
     bool is_running = false;
@@ -17,21 +149,30 @@ struct Context {
     bool is_finished = false;
     bool is_terminating = false;
 
-    std::shared_ptr<thread::Thread> thread;
     std::function<void ()> func;
 
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+    /* Saved stack pointers of the fiber, and of whoever resumed it */
+    void* sp = nullptr;
+    void* caller_sp = nullptr;
+    Stack stack;
+
+    /* Any exception which escapes the coroutine function is
+     * rethrown by resume_coroutine() on the caller's stack */
+    std::exception_ptr exception;
+#else
+    std::shared_ptr<thread::Thread> thread;
+
     thread::Mutex mutex;
     thread::Condition cond;
+#endif
 
     /* If non-zero then the coroutine won't resume until this time
      * has passed */
     uint64_t resume = 0;
-
-    Context* next = nullptr;
-    Context* prev = nullptr;
 };
 
-static Context* CONTEXTS = nullptr;
+static std::unordered_map<CoroutineID, Context*> CONTEXTS;
 static CoroutineID ID_COUNTER = 0;
 
 #if defined(__PSP__) || defined(__DREAMCAST__)
@@ -68,39 +209,148 @@ static void set_current_context(Context* context) {
 
 #endif
 
-CoroutineID start_coroutine(std::function<void ()> f) {
-    S_DEBUG("Starting new coroutine: {0}", ID_COUNTER + 1);
+static std::size_t STACK_SIZE = DEFAULT_COROUTINE_STACK_SIZE;
 
-    if(!CONTEXTS) {
-        CONTEXTS = new Context();
-        CONTEXTS->id = ++ID_COUNTER;
-        CONTEXTS->func = f;
-    } else {
-        auto prev_root = CONTEXTS;
-        CONTEXTS = new Context();
-        CONTEXTS->next = prev_root;
+void set_stack_size(std::size_t bytes) {
+    STACK_SIZE = bytes;
+}
+
+std::size_t stack_size() {
+    return STACK_SIZE;
+}
+
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+
+/* Stacks of finished coroutines are kept around for reuse, up to this many */
+static const std::size_t MAX_POOLED_STACKS = 256;
+static std::vector<Stack> STACK_POOL;
+
+static void free_stack(Stack& stack) {
+    if(stack.memory) {
+        munmap(stack.memory, stack.mapped_size);
+        stack = Stack();
+    }
+}
 
-        if(prev_root) {
-            prev_root->prev = CONTEXTS;
+static Stack acquire_stack() {
+    while(!STACK_POOL.empty()) {
+        Stack stack = STACK_POOL.back();
+        STACK_POOL.pop_back();
+
+        if(stack.size == STACK_SIZE) {
+            return stack;
         }
 
-        CONTEXTS->id = ++ID_COUNTER;
-        CONTEXTS->func = f;
+        /* The stack size was changed since this was pooled */
+        free_stack(stack);
     }
 
-    return CONTEXTS->id;
+    const std::size_t page_size = sysconf(_SC_PAGESIZE);
+    const std::size_t usable = ((STACK_SIZE + page_size - 1) / page_size) * page_size;
+
+    Stack stack;
+    stack.size = STACK_SIZE;
+    stack.mapped_size = usable + page_size;
+
+    void* memory = mmap(
+        nullptr, stack.mapped_size,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+        -1, 0
+    );
+
+    if(memory == MAP_FAILED) {
+        FATAL_ERROR(ERROR_CODE_THREAD_SPAWN_FAILED, "Unable to allocate coroutine stack");
+    }
+
+    /* Stacks grow downwards, so the lowest page is a guard page which
+     * turns a stack overflow into a segfault rather than corruption */
+    mprotect(memory, page_size, PROT_NONE);
+
+    stack.memory = (uint8_t*) memory;
+    return stack;
 }
 
-static Context* find_coroutine(CoroutineID id) {
-    for(auto c = CONTEXTS; c; c = c->next) {
-        if(c->id == id) {
-            return c;
-        }
+static void release_stack(Stack& stack) {
+    if(!stack.memory) {
+        return;
     }
 
-    return nullptr;
+    if(stack.size == STACK_SIZE && STACK_POOL.size() < MAX_POOLED_STACKS) {
+        STACK_POOL.push_back(stack);
+        stack = Stack();
+    } else {
+        free_stack(stack);
+    }
+}
+
+void release_pooled_stacks() {
+    for(auto& stack: STACK_POOL) {
+        free_stack(stack);
+    }
+
+    STACK_POOL.clear();
+}
+
+static void start_fiber(Context* context) {
+    context->stack = acquire_stack();
+
+    /* Build the frame that simulant_fiber_switch expects to pop, with
+     * simulant_fiber_entry as the return address */
+    uintptr_t top = uintptr_t(context->stack.memory + context->stack.mapped_size) & ~uintptr_t(15);
+
+#if defined(__x86_64__)
+    uint64_t* frame = (uint64_t*) (top - 64);
+    uint32_t* control = (uint32_t*) &frame[0];
+
+    /* Inherit the floating point control state of the resumer */
+    asm volatile("stmxcsr %0" : "=m"(control[0]));
+    asm volatile("fnstcw %0" : "=m"(control[1]));
+
+    frame[1] = 0;  /* r15 */
+    frame[2] = 0;  /* r14 */
+    frame[3] = 0;  /* r13 */
+    frame[4] = (uint64_t) context;  /* r12 */
+    frame[5] = 0;  /* rbx */
+    frame[6] = 0;  /* rbp */
+    frame[7] = (uint64_t) &simulant_fiber_entry;
+#elif defined(__aarch64__)
+    uint64_t* frame = (uint64_t*) (top - 160);
+    for(int i = 0; i < 20; ++i) {
+        frame[i] = 0;
+    }
+
+    frame[0] = (uint64_t) context;  /* x19 */
+    frame[11] = (uint64_t) &simulant_fiber_entry;  /* x30 */
+#endif
+
+    context->sp = frame;
+    context->is_started = true;
+}
+
+#else
+
+void release_pooled_stacks() {}
+
+#endif
+
+CoroutineID start_coroutine(std::function<void ()> f) {
+    S_DEBUG("Starting new coroutine: {0}", ID_COUNTER + 1);
+
+    Context* context = new Context();
+    context->id = ++ID_COUNTER;
+    context->func = f;
+
+    CONTEXTS.insert(std::make_pair(context->id, context));
+
+    return context->id;
+}
+
+static Context* find_coroutine(CoroutineID id) {
+    auto it = CONTEXTS.find(id);
+    return (it == CONTEXTS.end()) ? nullptr : it->second;
 }
 
+#ifndef SIMULANT_COROUTINES_USE_FIBERS
 static void run_coroutine(Context* context) {
     set_current_context(context);
 
@@ -112,6 +362,7 @@ static void run_coroutine(Context* context) {
     context->cond.notify_one();
     context->mutex.unlock();
 }
+#endif
 
 COResult resume_coroutine(CoroutineID id) {
     assert(!current_context());
@@ -121,6 +372,44 @@ COResult resume_coroutine(CoroutineID id) {
         return CO_RESULT_INVALID;
     }
 
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+    /* We've finished, do nothing */
+    if(routine->is_finished) {
+        return CO_RESULT_FINISHED;
+    }
+
+    /* Don't resume the coroutine if we're not ready yet */
+    if(routine->resume) {
+        auto now = get_app()->time_keeper->now_in_us();
+        if(routine->resume > now) {
+            return CO_RESULT_RUNNING;
+        } else {
+            /* Reset, we can run now */
+            routine->resume = 0;
+        }
+    }
+
+    if(!routine->is_started) {
+        start_fiber(routine);
+    }
+
+    routine->is_running = true;
+
+    set_current_context(routine);
+    simulant_fiber_switch(&routine->caller_sp, routine->sp);
+    set_current_context(nullptr);
+
+    if(routine->is_finished) {
+        /* We're off the fiber's stack now, so it can be reused */
+        release_stack(routine->stack);
+
+        if(routine->exception) {
+            auto e = routine->exception;
+            routine->exception = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+#else
     routine->mutex.lock();
 
     /* We've finished, do nothing */
@@ -161,6 +450,7 @@ COResult resume_coroutine(CoroutineID id) {
         }
         routine->mutex.unlock();
     }
+#endif
 
     return (routine->is_finished) ? CO_RESULT_FINISHED : CO_RESULT_RUNNING;
 }
@@ -174,6 +464,23 @@ void yield_coroutine(const smlt::Seconds& from_now) {
 
     auto current = current_context();
 
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+    current->is_running = false;
+
+    /* Set the timeout if necessary */
+    if(from_now > 0.0f) {
+        float offset = from_now.to_float() * 1000 * 1000;
+        current->resume = get_app()->time_keeper->now_in_us() + (uint64_t(offset));
+    }
+
+    simulant_fiber_switch(&current->sp, current->caller_sp);
+
+    if(current->is_terminating) {
+        /* This forces an incomplete coroutine to
+         * end if stop_coroutine has been called */
+        throw CoroutineTerminated();
+    }
+#else
     current->mutex.lock();
     current->is_running = false;
 
@@ -200,6 +507,7 @@ void yield_coroutine(const smlt::Seconds& from_now) {
     }
 
     current->mutex.unlock();
+#endif
 }
 
 bool within_coroutine() {
@@ -213,7 +521,39 @@ void stop_coroutine(CoroutineID id) {
 
     if(routine) {
         auto& context = *routine;
+
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+        /* Anything the coroutine throws while it's being stopped is
+         * passed on once the context has been cleaned up */
+        std::exception_ptr exception;
+#endif
+
         if(context.is_started) {
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+            context.is_terminating = true;
+
+            /* Each resume throws CoroutineTerminated from the fiber's
+             * current yield, which unwinds its stack. A coroutine which
+             * swallows that (e.g. with catch(...)) gets another one on its
+             * next yield, but we don't spin forever if it keeps doing it */
+            for(int i = 0; i < MAX_TERMINATE_ATTEMPTS && !context.is_finished; ++i) {
+                context.resume = 0;  /* Disable any delay */
+
+                try {
+                    resume_coroutine(id);
+                } catch(...) {
+                    exception = std::current_exception();
+                }
+            }
+
+            if(!context.is_finished) {
+                /* Nothing will switch to the fiber again, so its stack can
+                 * go, but whatever is still alive on it is leaked */
+                S_ERROR("Coroutine {0} didn't exit after being stopped, abandoning it", id);
+            }
+
+            release_stack(context.stack);
+#else
             context.mutex.lock();
             context.is_terminating = true;
             context.resume = 0;  /* Disable any delay */
@@ -225,19 +565,46 @@ void stop_coroutine(CoroutineID id) {
             context.thread->join();
 
             context.thread.reset();
+#endif
             S_DEBUG("Coroutine {0} destroyed", id);
         }
 
-        if(CONTEXTS == routine) {
-            CONTEXTS = routine->next;
-        }
-
-        if(routine->next) routine->next->prev = routine->prev;
-        if(routine->prev) routine->prev->next = routine->next;
-
+        CONTEXTS.erase(id);
         delete routine;
+
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+        if(exception) {
+            std::rethrow_exception(exception);
+        }
+#endif
     }
 }
 
 }
 }
+
+#ifdef SIMULANT_COROUTINES_USE_FIBERS
+
+void simulant_fiber_main(void* ptr) {
+    using namespace smlt::cort;
+
+    Context* context = (Context*) ptr;
+
+    try {
+        context->func();
+    } catch(CoroutineTerminated&) {
+        /* stop_coroutine() was called */
+    } catch(...) {
+        context->exception = std::current_exception();
+    }
+
+    context->is_running = false;
+    context->is_finished = true;
+
+    /* Switch back to the resumer for the last time, this fiber
+     * is never switched to again */
+    void* unused = nullptr;
+    simulant_fiber_switch(&unused, context->caller_sp);
+}
+
+#endif
@@ -1,11 +1,20 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 #include <functional>
 
 #include "../generic/optional.h"
 #include "../types.h"
 
+/* On desktop Linux coroutines are implemented as user-space fibers
+ * which run on the thread that resumes them. Everywhere else each
+ * coroutine gets its own thread and control is handed back and forth
+ * with a mutex/condition pair. */
+#if defined(__linux__) && !defined(__ANDROID__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SIMULANT_COROUTINES_USE_FIBERS 1
+#endif
+
 namespace smlt {
 namespace cort {
 
@@ -18,7 +27,7 @@ enum COResult {
     CO_RESULT_INVALID
 };
 
-
+const std::size_t DEFAULT_COROUTINE_STACK_SIZE = 256 * 1024;
 
 CoroutineID start_coroutine(std::function<void ()> func);
 void stop_coroutine(CoroutineID id);
@@ -26,5 +35,14 @@ COResult resume_coroutine(CoroutineID id);
 void yield_coroutine(const smlt::Seconds& from_now=smlt::Seconds());
 bool within_coroutine();
 
+/* Sets the stack size used for coroutines started after this call.
+ * Only applies to the fiber backend; stacks are pooled and reused
+ * between coroutines of the same size. */
+void set_stack_size(std::size_t bytes);
+std::size_t stack_size();
+
+/* Releases any stacks held in the pool which aren't in use */
+void release_pooled_stacks();
+
 }
 }
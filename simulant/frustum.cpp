@@ -95,6 +95,46 @@ bool Frustum::intersects_aabb(const AABB& aabb) const {
     return true;
 }
 
+FrustumClassification Frustum::classify_aabb(const AABB& aabb, uint8_t& plane_mask) const {
+    auto min = aabb.min();
+    auto max = aabb.max();
+
+    for(std::size_t i = 0; i < planes_.size(); ++i) {
+        const uint8_t bit = (1 << i);
+        if(!(plane_mask & bit)) {
+            continue;
+        }
+
+        const Plane& p = planes_[i];
+        bool nx = p.n.x > 0;
+        bool ny = p.n.y > 0;
+        bool nz = p.n.z > 0;
+
+        /* The corners furthest along, and furthest against, the normal */
+        Vec3 pv(
+            (nx) ? max.x : min.x,
+            (ny) ? max.y : min.y,
+            (nz) ? max.z : min.z
+        );
+
+        if(p.n.dot(pv) < -p.d) {
+            return FRUSTUM_CONTAINS_NONE;
+        }
+
+        Vec3 nv(
+            (nx) ? min.x : max.x,
+            (ny) ? min.y : max.y,
+            (nz) ? min.z : max.z
+        );
+
+        if(p.n.dot(nv) >= -p.d) {
+            plane_mask &= ~bit;
+        }
+    }
+
+    return (plane_mask) ? FRUSTUM_CONTAINS_PARTIAL : FRUSTUM_CONTAINS_ALL;
+}
+
 Vec3 Frustum::direction() const {
     Vec3 far = Vec3::find_average(far_corners());
     Vec3 near = Vec3::find_average(near_corners());
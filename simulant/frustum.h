@@ -40,6 +40,9 @@ enum FrustumClassification {
     FRUSTUM_CONTAINS_ALL
 };
 
+/* One bit per FrustumPlane, see Frustum::classify_aabb */
+const uint8_t FRUSTUM_PLANE_MASK_ALL = (1 << FRUSTUM_PLANE_MAX) - 1;
+
 class Frustum {
 public:
     Frustum();
@@ -55,6 +58,11 @@ public:
     bool intersects_aabb(const AABB &box) const;
     bool intersects_cube(const Vec3& center, float size) const;
 
+    /* Classifies the box against the planes whose bits are set in
+     * plane_mask. The bits of any planes which the box is completely inside
+     * are cleared, so anything contained by the box can skip testing them */
+    FrustumClassification classify_aabb(const AABB& box, uint8_t& plane_mask) const;
+
     bool initialized() const { return initialized_; }
 
     float near_height() const {
@@ -47,6 +47,13 @@ public:
         return id() < rhs.id();
     }
 
+protected:
+    /* For owners which only know the final ID after construction */
+    void set_id(IDType id) {
+        assert(id > 0);
+        id_ = id;
+    }
+
 private:
     IDType id_ = 0;
 };
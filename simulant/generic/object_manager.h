@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <chrono>
 #include <unordered_map>
 #include <unordered_set>
@@ -65,13 +66,15 @@ public:
     template<typename T, typename... Args>
     ObjectTypePtrType make_as(Args&&... args) {
         IDType new_id(next_id()); // Unbound
+        return make_as_with_id<T>(new_id, std::forward<Args>(args)...);
+    }
 
-        S_DEBUG("Creating a new object with ID: {0}", new_id);
-        auto obj = T::create(new_id, std::forward<Args>(args)...);
-        objects_.insert(std::make_pair(obj->id(), obj));
-        on_make(obj->id());
-
-        return SmartPointerConverter::convert(obj);
+    /* Recreates an object with an ID that was previously handed out, and
+     * isn't in use. Used to reload evicted assets. */
+    template<typename... Args>
+    ObjectTypePtrType make_with_id(IDType id, Args&&... args) {
+        assert(!contains(id));
+        return make_as_with_id<ObjectType>(id, std::forward<Args>(args)...);
     }
 
     void destroy(IDType id) {
@@ -131,6 +134,16 @@ protected:
         return IDCounter<ObjectType>::next_id();
     }
 
+    template<typename T, typename... Args>
+    ObjectTypePtrType make_as_with_id(IDType id, Args&&... args) {
+        S_DEBUG("Creating a new object with ID: {0}", id);
+        auto obj = T::create(id, std::forward<Args>(args)...);
+        objects_.insert(std::make_pair(obj->id(), obj));
+        on_make(obj->id());
+
+        return SmartPointerConverter::convert(obj);
+    }
+
     typedef std::shared_ptr<ObjectType> ObjectTypeInternalPtrType;
 
     std::unordered_map<
@@ -227,6 +240,16 @@ public:
         }
     }
 
+    /* True if something other than the manager holds the object */
+    bool is_referenced(IDType id) const {
+        auto it = this->objects_.find(id);
+        return it != this->objects_.end() && it->second.use_count() > 1;
+    }
+
+    GarbageCollectMethod garbage_collection_method(IDType id) const {
+        return object_metas_.at(id).collection_method;
+    }
+
     void set_garbage_collection_method(IDType id, GarbageCollectMethod method) {
         auto& meta = object_metas_.at(id);
         meta.collection_method = method;
@@ -90,6 +90,8 @@ void Transform::rotate(const Degrees& x, const Degrees& y, const Degrees& z) {
 }
 
 Mat4 Transform::world_space_matrix() const {
+    resolve_if_dirty();
+
     if(!absolute_transformation_is_dirty_) {
         return absolute_transformation_;
     }
@@ -111,7 +113,7 @@ void Transform::set_translation_2d(const Vec2& trans) {
 }
 
 Vec2 Transform::position_2d() const {
-    return position_.xy();
+    return position().xy();
 }
 
 Vec2 Transform::translation_2d() const {
@@ -120,7 +122,7 @@ Vec2 Transform::translation_2d() const {
 
 smlt::Degrees Transform::orientation_2d() const {
     // In 2D (X-Y plane) the orientation is the roll — rotation around Z.
-    return orientation_.roll();
+    return orientation().roll();
 }
 
 smlt::Degrees Transform::rotation_2d() const {
@@ -178,6 +180,14 @@ bool Transform::remove_listener(TransformListener* listener) {
 }
 
 void Transform::update_transformation_from_parent() {
+    if(parent_) {
+        parent_->resolve_if_dirty();
+    }
+
+    calculate_from_parent();
+}
+
+void Transform::calculate_from_parent() const {
     Transform* parent = parent_;
 
     if(!parent) {
@@ -185,9 +195,9 @@ void Transform::update_transformation_from_parent() {
         position_ = translation_;
         scale_ = scale_factor_;
     } else {
-        auto parent_pos = parent->position();
-        auto parent_rot = parent->orientation();
-        auto parent_scale = parent->scale();
+        auto parent_pos = parent->position_;
+        auto parent_rot = parent->orientation_;
+        auto parent_scale = parent->scale_;
 
         orientation_ = parent_rot * rotation_;
         scale_ = parent_scale * scale_factor_;
@@ -195,6 +205,58 @@ void Transform::update_transformation_from_parent() {
     }
 
     absolute_transformation_is_dirty_ = true;
+    dirty_ = false;
+    ++version_;
+}
+
+void Transform::resolve() const {
+    /* Another thread might be resolving the same ancestors */
+    if(queue_ && queue_->concurrent_) {
+        thread::Lock<thread::Mutex> lock(queue_->resolve_mutex_);
+        resolve_chain();
+    } else {
+        resolve_chain();
+    }
+}
+
+void Transform::resolve_chain() const {
+    /* Work down from the top-most dirty ancestor so that each parent is
+     * up to date before its children read it. A dirty transform's
+     * descendents are always dirty, so the dirty ancestors form an
+     * unbroken chain. Walking back up for each step needs no scratch
+     * storage or recursion, and dirty chains are short. */
+    while(dirty_) {
+        const Transform* top = this;
+        while(top->parent_ && top->parent_->dirty_) {
+            top = top->parent_;
+        }
+
+        top->calculate_from_parent();
+    }
+}
+
+void Transform::resolve_subtree() const {
+    resolve_if_dirty();
+
+    /* Parents are visited before their children, so each dirty child only
+     * has to look one level up */
+    const Transform* node = first_child_;
+    while(node) {
+        if(node->dirty_) {
+            node->calculate_from_parent();
+        }
+
+        if(node->first_child_) {
+            node = node->first_child_;
+            continue;
+        }
+
+        while(node != this && !node->next_sibling_) {
+            node = node->parent_;
+        }
+
+        node = (node == this) ? nullptr : node->next_sibling_;
+    }
 }
 
 void Transform::sync(const Transform* other) {
@@ -205,7 +267,7 @@ void Transform::sync(const Transform* other) {
 
 void Transform::look_at(const Vec3& target, const Vec3& up) {
     set_orientation(
-        Quaternion::look_rotation((target - position_).normalized(), up));
+        Quaternion::look_rotation((target - position()).normalized(), up));
 }
 
 void Transform::set_parent(Transform* new_parent,
@@ -218,18 +280,100 @@ void Transform::set_parent(Transform* new_parent,
 
     /* When we set the parent, we want to keep our existing position so
      * we update our translation and rotation to be relative to the parent */
+    if(new_parent && retain_mode == TRANSFORM_RETAIN_MODE_KEEP) {
+        translation_ = (position() - new_parent->position());
+        rotation_ = (orientation() * new_parent->orientation().inversed());
+    }
+
+    if(parent_) {
+        if(prev_sibling_) {
+            prev_sibling_->next_sibling_ = next_sibling_;
+        } else {
+            parent_->first_child_ = next_sibling_;
+        }
+
+        if(next_sibling_) {
+            next_sibling_->prev_sibling_ = prev_sibling_;
+        }
+
+        prev_sibling_ = next_sibling_ = nullptr;
+    }
 
     parent_ = new_parent;
 
-    if(parent_ && retain_mode == TRANSFORM_RETAIN_MODE_KEEP) {
-        translation_ = (position_ - new_parent->position_);
-        rotation_ = (orientation_ * new_parent->orientation_.inversed());
-        scale_ = scale_factor_ / new_parent->scale_;
+    if(parent_) {
+        next_sibling_ = parent_->first_child_;
+        if(next_sibling_) {
+            next_sibling_->prev_sibling_ = this;
+        }
+        parent_->first_child_ = this;
+
+        if(parent_->queue_) {
+            set_change_queue(parent_->queue_);
+        }
     }
 
     signal_change();
 }
 
+void Transform::set_change_queue(TransformChangeQueue* queue) {
+    /* The whole subtree shares the queue */
+    Transform* node = this;
+    while(node) {
+        if(node->queue_ != queue) {
+            bool queued = node->queue_index_ >= 0;
+            if(queued) {
+                node->queue_->changed_[node->queue_index_] = nullptr;
+                node->queue_index_ = -1;
+            }
+
+            node->queue_ = queue;
+
+            if(queued && queue) {
+                node->queue_change();
+            }
+        }
+
+        if(node->first_child_) {
+            node = node->first_child_;
+            continue;
+        }
+
+        while(node != this && !node->next_sibling_) {
+            node = node->parent_;
+        }
+
+        node = (node == this) ? nullptr : node->next_sibling_;
+    }
+}
+
+Transform::~Transform() {
+    if(queue_ && queue_index_ >= 0) {
+        queue_->changed_[queue_index_] = nullptr;
+    }
+
+    if(parent_) {
+        if(prev_sibling_) {
+            prev_sibling_->next_sibling_ = next_sibling_;
+        } else {
+            parent_->first_child_ = next_sibling_;
+        }
+
+        if(next_sibling_) {
+            next_sibling_->prev_sibling_ = prev_sibling_;
+        }
+    }
+
+    /* Orphan any children, they keep their last world state */
+    for(auto child = first_child_; child;) {
+        auto next = child->next_sibling_;
+        child->resolve_if_dirty();
+        child->parent_ = nullptr;
+        child->prev_sibling_ = child->next_sibling_ = nullptr;
+        child = next;
+    }
+}
+
 void Transform::signal_change_attempted() {
     for(auto& listener: listeners_) {
         listener->on_transformation_change_attempted();
@@ -237,11 +381,131 @@ void Transform::signal_change_attempted() {
 }
 
 void Transform::signal_change() {
-    update_transformation_from_parent();
-    absolute_transformation_is_dirty_ = true;
+    /* Transforms without a queue are notified straight away, but only
+     * once the whole subtree has been marked */
+    std::vector<Transform*> unqueued;
+
+    /* Don't let another thread resolve part of the subtree while it's
+     * being marked */
+    if(queue_ && queue_->concurrent_) {
+        thread::Lock<thread::Mutex> lock(queue_->resolve_mutex_);
+        mark_dirty(unqueued);
+    } else {
+        mark_dirty(unqueued);
+    }
+
+    for(auto transform: unqueued) {
+        transform->notify_listeners();
+    }
+}
+
+void Transform::mark_dirty(std::vector<Transform*>& unqueued) {
+    auto mark = [&unqueued](Transform* transform) {
+        if(transform->queue_) {
+            transform->queue_change();
+        } else {
+            unqueued.push_back(transform);
+        }
+    };
+
+    mark(this);
+
+    /* If we were already dirty, then so are all our descendents */
+    if(!dirty_) {
+        dirty_ = true;
+
+        /* Mark the subtree, skipping any branches which are already dirty */
+        Transform* node = first_child_;
+        while(node) {
+            if(!node->dirty_) {
+                node->dirty_ = true;
+                mark(node);
+
+                if(node->first_child_) {
+                    node = node->first_child_;
+                    continue;
+                }
+            }
+
+            while(node != this && !node->next_sibling_) {
+                node = node->parent_;
+            }
+
+            node = (node == this) ? nullptr : node->next_sibling_;
+        }
+    }
+}
+
+void Transform::queue_change() {
+    if(queue_index_ >= 0) {
+        return;
+    }
+
+    if(queue_->concurrent_) {
+        thread::Lock<thread::Mutex> lock(queue_->mutex_);
+        queue_index_ = int32_t(queue_->changed_.size());
+        queue_->changed_.push_back(this);
+    } else {
+        queue_index_ = int32_t(queue_->changed_.size());
+        queue_->changed_.push_back(this);
+    }
+}
+
+void Transform::notify_listeners() {
     for(auto& listener: listeners_) {
         listener->on_transformation_changed();
     }
 }
 
+void TransformChangeQueue::flush() {
+    if(flushing_) {
+        return;
+    }
+
+    const std::size_t count = changed_.size();
+    if(!count) {
+        return;
+    }
+
+    flushing_ = true;
+
+    /* Resolve everything first so listeners see a consistent world */
+    for(std::size_t i = 0; i < count; ++i) {
+        if(changed_[i]) {
+            changed_[i]->resolve_if_dirty();
+        }
+    }
+
+    for(std::size_t i = 0; i < count; ++i) {
+        auto transform = changed_[i];
+        if(!transform) {
+            continue;
+        }
+
+        changed_[i] = nullptr;
+        transform->queue_index_ = -1;
+        transform->notify_listeners();
+    }
+
+    /* Anything changed by a listener waits for the next flush */
+    changed_.erase(changed_.begin(), changed_.begin() + count);
+    for(std::size_t i = 0; i < changed_.size(); ++i) {
+        if(changed_[i]) {
+            changed_[i]->queue_index_ = int32_t(i);
+        }
+    }
+
+    flushing_ = false;
+}
+
+void TransformChangeQueue::clear() {
+    for(auto transform: changed_) {
+        if(transform) {
+            transform->queue_index_ = -1;
+        }
+    }
+
+    changed_.clear();
+}
+
 } // namespace smlt
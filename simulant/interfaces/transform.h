@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include "../threads/mutex.h"
 #include "../types.h"
 
 namespace smlt {
@@ -34,17 +36,70 @@ private:
     std::shared_ptr<bool> alive_check_ = std::make_shared<bool>();
 };
 
+class Transform;
+
+/* Transforms which have changed since the last flush. Changing a transform
+ * only marks it (and its descendents) dirty and queues it here, the world
+ * state is worked out when it's next read or when the queue is flushed.
+ * Flushing notifies the listeners of each changed transform once, however
+ * many times it changed. */
+class TransformChangeQueue {
+public:
+    TransformChangeQueue() = default;
+    TransformChangeQueue(const TransformChangeQueue&) = delete;
+    TransformChangeQueue& operator=(const TransformChangeQueue&) = delete;
+
+    ~TransformChangeQueue() {
+        clear();
+    }
+
+    void flush();
+
+    /* Forget the queued transforms without notifying anyone */
+    void clear();
+
+    /* While set, transforms can be queued and resolved from several threads
+     * at once. Resolving is serialised, so a transform which another thread
+     * is moving reads as either its old or its new state. */
+    void set_concurrent(bool concurrent) {
+        concurrent_ = concurrent;
+    }
+
+    std::size_t size() const {
+        return changed_.size();
+    }
+
+private:
+    friend class Transform;
+
+    std::vector<Transform*> changed_;
+    bool flushing_ = false;
+
+    thread::Mutex mutex_;
+    thread::Mutex resolve_mutex_;
+    bool concurrent_ = false;
+};
+
 class Transform {
 public:
+    Transform() = default;
+    Transform(const Transform&) = delete;
+    Transform& operator=(const Transform&) = delete;
+
+    ~Transform();
+
     const Vec3& position() const {
+        resolve_if_dirty();
         return position_;
     }
 
     const Quaternion& orientation() const {
+        resolve_if_dirty();
         return orientation_;
     }
 
     const Vec3& scale() const {
+        resolve_if_dirty();
         return scale_;
     }
 
@@ -120,15 +175,15 @@ public:
     void rotate_2d(const smlt::Degrees& rot);
 
     Vec3 forward() const {
-        return orientation_.forward();
+        return orientation().forward();
     }
 
     Vec3 up() const {
-        return orientation_.up();
+        return orientation().up();
     }
 
     Vec3 right() const {
-        return orientation_.right();
+        return orientation().right();
     }
 
     Vec2 up_2d() const {
@@ -164,9 +219,32 @@ public:
     void sync(const Transform* other);
     void look_at(const Vec3& target, const Vec3& up = Vec3::up());
 
+    /* Changes whenever the world position, orientation or scale is
+     * recalculated. Anything caching values derived from the world
+     * transform can compare this rather than listening for changes. */
+    uint32_t version() const {
+        resolve_if_dirty();
+        return version_;
+    }
+
+    /* Changes are queued here rather than being signalled immediately.
+     * Transforms take the queue of the parent they're attached to, without
+     * one listeners are notified as soon as anything changes. */
+    void set_change_queue(TransformChangeQueue* queue);
+
+    TransformChangeQueue* change_queue() const {
+        return queue_;
+    }
+
+    /* Works out the world state of this transform and every one of its
+     * descendents, without notifying anyone. Anything queued stays queued
+     * for the next flush. */
+    void resolve_subtree() const;
+
 private:
     /* THis is for access to set_parent primarily */
     friend class StageNode;
+    friend class TransformChangeQueue;
 
     bool has_parent() const { return parent_ != nullptr; }
     void set_parent(Transform* new_parent, TransformRetainMode retain_mode=TRANSFORM_RETAIN_MODE_LOSE);
@@ -176,14 +254,38 @@ private:
     void signal_change_attempted();
 
     void signal_change();
+    void mark_dirty(std::vector<Transform*>& unqueued);
+
+    void queue_change();
+    void notify_listeners();
+
+    void resolve_if_dirty() const {
+        if(dirty_) {
+            resolve();
+        }
+    }
+
+    void resolve() const;
+    void resolve_chain() const;
+    void calculate_from_parent() const;
 
     Transform* parent_ = nullptr;
+    Transform* first_child_ = nullptr;
+    Transform* next_sibling_ = nullptr;
+    Transform* prev_sibling_ = nullptr;
+
+    TransformChangeQueue* queue_ = nullptr;
+    int32_t queue_index_ = -1;
 
     TransformSmoothing smoothing_ = TRANSFORM_SMOOTHING_NONE;
 
-    Vec3 position_;
-    Quaternion orientation_;
-    Vec3 scale_ = Vec3(1, 1, 1);
+    /* World state, calculated on demand from the local state and the
+     * parent. If a transform is dirty, so are all of its descendents */
+    mutable Vec3 position_;
+    mutable Quaternion orientation_;
+    mutable Vec3 scale_ = Vec3(1, 1, 1);
+    mutable bool dirty_ = false;
+    mutable uint32_t version_ = 0;
 
     Vec3 translation_;
     Quaternion rotation_;
@@ -181,6 +181,15 @@ struct MeshLoadOptions {
      * of the one provided by the mesh. Should be the extension excluding the leading
      * dot. (e.g. "dtex") */
     std::string override_texture_extension = "";
+
+    /* If set, simplified copies of the mesh are generated for the lower
+     * detail levels once it's loaded (see Mesh::generate_lods). Actors
+     * using the mesh switch to them with distance */
+    bool generate_lods = false;
+
+    /* If set, the index and vertex order is optimized for the vertex cache
+     * and overdraw once the mesh is loaded (see Mesh::optimize) */
+    bool optimize = false;
 };
 
 #define MESH_LOAD_OPTIONS_KEY "mesh_options"
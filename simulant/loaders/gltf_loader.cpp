@@ -13,53 +13,53 @@
 namespace smlt {
 namespace loaders {
 
-static smlt::Vec3 parse_pos(JSONIterator it) {
-    return smlt::Vec3(it[0]->to_float().value_or(0.0f),
-                      it[1]->to_float().value_or(0.0f),
-                      it[2]->to_float().value_or(0.0f));
+static smlt::Vec3 parse_pos(JSONValue it) {
+    return smlt::Vec3(it[0].to_float().value_or(0.0f),
+                      it[1].to_float().value_or(0.0f),
+                      it[2].to_float().value_or(0.0f));
 }
 
-static smlt::Vec3 parse_scale(JSONIterator it) {
-    return smlt::Vec3(it[0]->to_float().value_or(1.0f),
-                      it[1]->to_float().value_or(1.0f),
-                      it[2]->to_float().value_or(1.0f));
+static smlt::Vec3 parse_scale(JSONValue it) {
+    return smlt::Vec3(it[0].to_float().value_or(1.0f),
+                      it[1].to_float().value_or(1.0f),
+                      it[2].to_float().value_or(1.0f));
 }
 
-static smlt::Color parse_color3(JSONIterator it) {
-    return smlt::Color(it[0]->to_float().value_or(1.0f),
-                       it[1]->to_float().value_or(1.0f),
-                       it[2]->to_float().value_or(1.0f), 1.0f);
+static smlt::Color parse_color3(JSONValue it) {
+    return smlt::Color(it[0].to_float().value_or(1.0f),
+                       it[1].to_float().value_or(1.0f),
+                       it[2].to_float().value_or(1.0f), 1.0f);
 }
 
-static smlt::Color parse_color4(JSONIterator it) {
-    float r = it[0]->to_float().value_or(1.0f);
-    float g = it[1]->to_float().value_or(1.0f);
-    float b = it[2]->to_float().value_or(1.0f);
-    float a = it[3]->to_float().value_or(1.0f);
+static smlt::Color parse_color4(JSONValue it) {
+    float r = it[0].to_float().value_or(1.0f);
+    float g = it[1].to_float().value_or(1.0f);
+    float b = it[2].to_float().value_or(1.0f);
+    float a = it[3].to_float().value_or(1.0f);
 
     return smlt::Color(r, g, b, a);
 }
 
-static smlt::Quaternion parse_quaternion(JSONIterator it) {
-    float x = it[0]->to_float().value_or(0.0f);
-    float y = it[1]->to_float().value_or(0.0f);
-    float z = it[2]->to_float().value_or(0.0f);
-    float w = it[3]->to_float().value_or(1.0f);
+static smlt::Quaternion parse_quaternion(JSONValue it) {
+    float x = it[0].to_float().value_or(0.0f);
+    float y = it[1].to_float().value_or(0.0f);
+    float z = it[2].to_float().value_or(0.0f);
+    float w = it[3].to_float().value_or(1.0f);
 
     return smlt::Quaternion(x, y, z, w);
 }
 
-bool check_gltf_version(JSONIterator& js) {
-    if(!js->has_key("asset") || !js["asset"]->has_key("version")) {
+bool check_gltf_version(const JSONValue& js) {
+    if(!js.has_key("asset") || !js["asset"].has_key("version")) {
         S_ERROR("Invalid gltf file");
         return false;
     }
 
-    return js["asset"]["version"]->to_str().value_or("0.0") == "2.0";
+    return js["asset"]["version"].to_str().value_or("0.0") == "2.0";
 }
 
-optional<JSONIterator> find_scene(JSONIterator& js) {
-    auto id = js["scene"]->to_int().value_or(0);
+optional<JSONValue> find_scene(const JSONValue& js) {
+    auto id = js["scene"].to_int().value_or(0);
     return js["scenes"][id];
 }
 
@@ -209,7 +209,7 @@ struct Accessor {
     int buffer_view_id;
 };
 
-static auto process_buffer(JSONIterator& js, const Accessor& accessor,
+static auto process_buffer(const JSONValue& js, const Accessor& accessor,
                            std::istream* bin) -> BufferInfo {
 
     auto accessor_component_type = accessor.component_type;
@@ -218,11 +218,11 @@ static auto process_buffer(JSONIterator& js, const Accessor& accessor,
 
     assert(buffer_view_id >= 0);
     auto buffer_view = js["bufferViews"][buffer_view_id];
-    auto buffer_id = buffer_view["buffer"]->to_int().value_or(-1);
+    auto buffer_id = buffer_view["buffer"].to_int().value_or(-1);
     assert(buffer_id >= 0);
 
     auto buffer = js["buffers"][buffer_id];
-    auto uri = buffer["uri"]->to_str().value_or("");
+    auto uri = buffer["uri"].to_str().value_or("");
     if(uri.empty() && !bin) {
         S_ERROR("Buffer has no uri");
         return BufferInfo();
@@ -232,9 +232,9 @@ static auto process_buffer(JSONIterator& js, const Accessor& accessor,
 
     const char* b64_marker = "data:application/octet-stream;base64,";
 
-    auto byte_offset = buffer_view["byteOffset"]->to_int().value_or(0);
-    auto byte_length = buffer_view["byteLength"]->to_int().value_or(0);
-    auto byte_stride = buffer_view["byteStride"]->to_int().value_or(0);
+    auto byte_offset = buffer_view["byteOffset"].to_int().value_or(0);
+    auto byte_length = buffer_view["byteLength"].to_int().value_or(0);
+    auto byte_stride = buffer_view["byteStride"].to_int().value_or(0);
 
     if(uri.empty()) {
         // We need to seek and read from bin
@@ -272,7 +272,7 @@ static auto process_buffer(JSONIterator& js, const Accessor& accessor,
     return result;
 }
 
-void process_joints(const BufferInfo& buffer_info, JSONIterator&,
+void process_joints(const BufferInfo& buffer_info, const JSONValue&,
     smlt::MeshPtr& final_mesh, const VertexSpecification& spec) {
     const uint8_t* d = buffer_info.data.data();
     auto start = final_mesh->vertex_data->cursor_position();
@@ -307,7 +307,7 @@ void process_joints(const BufferInfo& buffer_info, JSONIterator&,
 
 }
 
-void process_weights(const BufferInfo& buffer_info, JSONIterator&,
+void process_weights(const BufferInfo& buffer_info, const JSONValue&,
     smlt::MeshPtr& final_mesh, const VertexSpecification& spec) {
     // Usually floats, sometimes uint8_t
     const uint8_t* d = buffer_info.data.data();
@@ -355,7 +355,7 @@ void process_weights(const BufferInfo& buffer_info, JSONIterator&,
 }
 
 
-void process_positions(const BufferInfo& buffer_info, JSONIterator&,
+void process_positions(const BufferInfo& buffer_info, const JSONValue&,
                        smlt::MeshPtr& final_mesh, VertexSpecification& spec) {
 
     auto start = final_mesh->vertex_data->cursor_position();
@@ -410,7 +410,7 @@ void process_positions(const BufferInfo& buffer_info, JSONIterator&,
     final_mesh->vertex_data->move_to(start);
 }
 
-void process_colors(const BufferInfo& buffer_info, JSONIterator& js,
+void process_colors(const BufferInfo& buffer_info, const JSONValue& js,
                     smlt::MeshPtr& final_mesh, VertexAttribute attr) {
 
     _S_UNUSED(js);
@@ -465,7 +465,7 @@ void process_colors(const BufferInfo& buffer_info, JSONIterator& js,
     final_mesh->vertex_data->move_to(start);
 }
 
-void process_normals(const BufferInfo& buffer_info, JSONIterator& js,
+void process_normals(const BufferInfo& buffer_info, const JSONValue& js,
                      smlt::MeshPtr& final_mesh, VertexSpecification& spec) {
 
     _S_UNUSED(js);
@@ -505,7 +505,7 @@ void process_normals(const BufferInfo& buffer_info, JSONIterator& js,
     final_mesh->vertex_data->move_to(start);
 }
 
-void process_texcoord0s(const BufferInfo& buffer_info, JSONIterator& js,
+void process_texcoord0s(const BufferInfo& buffer_info, const JSONValue& js,
                         smlt::MeshPtr& final_mesh, VertexSpecification& spec) {
 
     _S_UNUSED(js);
@@ -578,15 +578,15 @@ public:
     }
 };
 
-static smlt::TexturePtr load_texture(AssetManager* assets, JSONIterator& js,
-                                     JSONIterator& texture, int texture_id,
+static smlt::TexturePtr load_texture(AssetManager* assets, const JSONValue& js,
+                                     const JSONValue& texture, int texture_id,
                                      std::istream* bin_chunk,
                                      const std::string& ext = "") {
 
     _S_UNUSED(texture_id);
 
-    int sampler_id = texture["sampler"]->to_int().value_or(-1);
-    int source_id = texture["source"]->to_int().value_or(-1);
+    int sampler_id = texture["sampler"].to_int().value_or(-1);
+    int source_id = texture["source"].to_int().value_or(-1);
     if(source_id < 0 || sampler_id < 0) {
         return smlt::TexturePtr();
     }
@@ -596,18 +596,18 @@ static smlt::TexturePtr load_texture(AssetManager* assets, JSONIterator& js,
     if(!sampler.is_valid() || !image.is_valid()) {
         return smlt::TexturePtr();
     }
-    auto keys = image->keys();
-    smlt::Path uri = image["uri"]->to_str().value_or("");
+    auto keys = image.keys();
+    smlt::Path uri = image["uri"].to_str().value_or("");
     if(!uri.str().empty()) {
         if(!ext.empty()) {
             uri = uri.replace_ext(ext);
         }
         auto tex = assets->load_texture(uri);
 
-        auto wrapS = sampler["wrapS"]->to_int().value_or(10497);
-        auto wrapT = sampler["wrapT"]->to_int().value_or(10497);
-        auto magFilter = sampler["magFilter"]->to_int().value_or(9729);
-        auto minFilter = sampler["minFilter"]->to_int().value_or(9987);
+        auto wrapS = sampler["wrapS"].to_int().value_or(10497);
+        auto wrapT = sampler["wrapT"].to_int().value_or(10497);
+        auto magFilter = sampler["magFilter"].to_int().value_or(9729);
+        auto minFilter = sampler["minFilter"].to_int().value_or(9987);
 
         TextureWrap u = TEXTURE_WRAP_REPEAT, v = TEXTURE_WRAP_REPEAT;
 
@@ -641,10 +641,10 @@ static smlt::TexturePtr load_texture(AssetManager* assets, JSONIterator& js,
         Accessor acc;
         acc.component_type = BYTE;
         acc.type = "SCALAR";
-        acc.buffer_view_id = image["bufferView"]->to_int().value_or(-1);
+        acc.buffer_view_id = image["bufferView"].to_int().value_or(-1);
         if(acc.buffer_view_id != -1) {
             auto buff = process_buffer(js, acc, bin_chunk);
-            auto mime = image["mimeType"]->to_str().value_or("");
+            auto mime = image["mimeType"].to_str().value_or("");
 
             VectorStreamBuf buffer(buff.data);
             auto is = std::make_shared<std::istream>(&buffer);
@@ -679,29 +679,26 @@ static smlt::MaterialPtr create_default_material(AssetManager* assets) {
     return mat;
 }
 
-smlt::MaterialPtr load_material(AssetManager* assets, JSONIterator& js,
-                                JSONIterator& material, int material_id,
+smlt::MaterialPtr load_material(AssetManager* assets, const JSONValue& js,
+                                const JSONValue& material, int material_id,
                                 const std::vector<smlt::TexturePtr>& textures) {
 
     _S_UNUSED(material_id);
     _S_UNUSED(js);
 
     auto base_texture_id =
-        material["pbrMetallicRoughness"]["baseColorTexture"]["index"]
-            ->to_int()
+        material["pbrMetallicRoughness"]["baseColorTexture"]["index"].to_int()
             .value_or(-1);
 
     auto metallic_roughness_texture_id =
-        material["pbrMetallicRoughness"]["metallicRoughnessTexture"]["index"]
-            ->to_int()
+        material["pbrMetallicRoughness"]["metallicRoughnessTexture"]["index"].to_int()
             .value_or(-1);
 
     auto metallic =
-        material["pbrMetallicRoughness"]["metallicFactor"]->to_float().value_or(
+        material["pbrMetallicRoughness"]["metallicFactor"].to_float().value_or(
             1.0f);
 
-    auto roughness = material["pbrMetallicRoughness"]["roughnessFactor"]
-                         ->to_float()
+    auto roughness = material["pbrMetallicRoughness"]["roughnessFactor"].to_float()
                          .value_or(1.0f);
 
     auto emissive = Color(0, 0, 0, 1);
@@ -710,10 +707,10 @@ smlt::MaterialPtr load_material(AssetManager* assets, JSONIterator& js,
     }
 
     auto normal_texture_id =
-        material["normalTexture"]["index"]->to_int().value_or(-1);
+        material["normalTexture"]["index"].to_int().value_or(-1);
 
     auto occ_texture_id =
-        material["occlusionTexture"]["index"]->to_int().value_or(-1);
+        material["occlusionTexture"]["index"].to_int().value_or(-1);
 
     smlt::EnabledTextureMask enabled = 0;
     smlt::MaterialPtr ret = assets->clone_default_material();
@@ -744,22 +741,22 @@ smlt::MaterialPtr load_material(AssetManager* assets, JSONIterator& js,
         color = parse_color4(base_color);
     }
 
-    auto double_sided = material["doubleSided"]->to_bool().value_or(false);
+    auto double_sided = material["doubleSided"].to_bool().value_or(false);
     if(double_sided) {
         ret->set_cull_mode(smlt::CULL_MODE_NONE);
     } else {
         ret->set_cull_mode(smlt::CULL_MODE_BACK_FACE);
     }
-    ret->set_name(material["name"]->to_str().value_or(""));
+    ret->set_name(material["name"].to_str().value_or(""));
     ret->set_textures_enabled(enabled);
     ret->set_lighting_enabled(true);
 
     auto alpha_mode = material["alphaMode"].is_valid()
-                          ? material["alphaMode"]->to_str().value_or("OPAQUE")
+                          ? material["alphaMode"].to_str().value_or("OPAQUE")
                           : "OPAQUE";
 
     auto cutoff = material["alphaCutoff"].is_valid()
-                      ? material["alphaCutoff"]->to_float().value_or(0.5f)
+                      ? material["alphaCutoff"].to_float().value_or(0.5f)
                       : 0.5f;
 
     ret->set_blend_func((alpha_mode == "OPAQUE") ? smlt::BLEND_NONE
@@ -771,9 +768,9 @@ smlt::MaterialPtr load_material(AssetManager* assets, JSONIterator& js,
     ret->set_base_color(color);
 
     // Look for the unlit extension, if it's there then disable lighting
-    if(material->has_key("extensions")) {
+    if(material.has_key("extensions")) {
         auto ext = material["extensions"];
-        if(ext->has_key("KHR_materials_unlit")) {
+        if(ext.has_key("KHR_materials_unlit")) {
             ret->set_lighting_enabled(false);
         }
     }
@@ -781,8 +778,8 @@ smlt::MaterialPtr load_material(AssetManager* assets, JSONIterator& js,
     return ret;
 }
 
-static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
-                               JSONIterator& mesh, int mesh_id,
+static smlt::MeshPtr load_mesh(AssetManager* assets, const JSONValue& js,
+                               const JSONValue& mesh, int mesh_id,
                                const std::vector<Accessor>& accessors,
                                const std::vector<smlt::MaterialPtr>& materials,
                                std::istream* bin_chunk,
@@ -790,9 +787,9 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
     _S_UNUSED(mesh_id);
 
     struct MeshPrimitive {
-        MeshPrimitive(const smlt::JSONIterator& attrs) :
+        MeshPrimitive(const smlt::JSONValue& attrs) :
             attrs(attrs) {}
-        const smlt::JSONIterator& attrs;
+        smlt::JSONValue attrs;
         int material_id = -1;
         int indexes_id = -1;
 
@@ -833,20 +830,18 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
         return smlt::VERTEX_ATTRIBUTE_NONE;
     };
 
-    for(auto& primitive_node: mesh["primitives"]) {
-        auto primitive = primitive_node.to_iterator();
-
+    for(auto primitive: mesh["primitives"]) {
         MeshPrimitive mp(primitive["attributes"]);
-        mp.material_id = primitive["material"]->to_int().value_or(-1);
+        mp.material_id = primitive["material"].to_int().value_or(-1);
         mp.position_id =
-            primitive["attributes"]["POSITION"]->to_int().value_or(-1);
-        mp.normal_id = primitive["attributes"]["NORMAL"]->to_int().value_or(-1);
-        mp.color_id = primitive["attributes"]["COLOR_0"]->to_int().value_or(-1);
+            primitive["attributes"]["POSITION"].to_int().value_or(-1);
+        mp.normal_id = primitive["attributes"]["NORMAL"].to_int().value_or(-1);
+        mp.color_id = primitive["attributes"]["COLOR_0"].to_int().value_or(-1);
         mp.texcoord_id =
-            primitive["attributes"]["TEXCOORD_0"]->to_int().value_or(-1);
-        mp.indexes_id = primitive["indices"]->to_int().value_or(-1);
-        mp.joints_id = primitive["attributes"]["JOINTS_0"]->to_int().value_or(-1);
-        mp.weights_id = primitive["attributes"]["WEIGHTS_0"]->to_int().value_or(-1);
+            primitive["attributes"]["TEXCOORD_0"].to_int().value_or(-1);
+        mp.indexes_id = primitive["indices"].to_int().value_or(-1);
+        mp.joints_id = primitive["attributes"]["JOINTS_0"].to_int().value_or(-1);
+        mp.weights_id = primitive["attributes"]["WEIGHTS_0"].to_int().value_or(-1);
 
         S_DEBUG("Joint on primitive: {0}", mp.joints_id);
 
@@ -883,7 +878,7 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
                     "currently unsupported");
         }
 
-        auto mode = mesh["mode"]->to_int().value_or(TRIANGLES);
+        auto mode = mesh["mode"].to_int().value_or(TRIANGLES);
         if(mode != TRIANGLES && mode != TRIANGLE_STRIP) {
             S_ERROR("Mesh with unsupported mode: {0}", mode);
             continue;
@@ -980,7 +975,7 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
             auto joints_json = skin_node["joints"];
             skin->joint_indices.clear();
 
-            for (auto& j : joints_json) {
+            for(auto j: joints_json) {
                 // Not making this an int8_t for the rare event the nmb. of joints go > 127
                 int16_t node_index = j.to_int().value_or(-1);
                 if (node_index < 0) {
@@ -992,10 +987,10 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
             S_DEBUG("Loaded {0} joint indices", skin->joint_indices.size());
 
             // Setting the skeleton root node, to be able to offset from center
-            skin->skeleton_root_node = skin_node["skeleton"]->to_int().value_or(-1);
+            skin->skeleton_root_node = skin_node["skeleton"].to_int().value_or(-1);
             S_DEBUG("Skeleton root node: {0}", skin->skeleton_root_node);
 
-            int ibm_accessor_idx = skin_node["inverseBindMatrices"]->to_int().value_or(-1);
+            int ibm_accessor_idx = skin_node["inverseBindMatrices"].to_int().value_or(-1);
             if(ibm_accessor_idx < 0) {
                 S_WARN("Skin has no inverse bind matrices.");
                 continue;
@@ -1003,7 +998,7 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
             auto ibm = accessors[ibm_accessor_idx];
             auto buffer_info = process_buffer(js, ibm, bin_chunk);
 
-            size_t ibm_count = js["accessors"][ibm_accessor_idx]["count"]->to_int().value_or(0);
+            size_t ibm_count = js["accessors"][ibm_accessor_idx]["count"].to_int().value_or(0);
             skin->inverse_bind_matrices.reserve(ibm_count);
 
             const float* data = reinterpret_cast<const float*>(buffer_info.data.data());
@@ -1049,7 +1044,7 @@ static smlt::MeshPtr load_mesh(AssetManager* assets, JSONIterator& js,
 }
 
 static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
-                                   JSONIterator& js,
+                                   const JSONValue& js,
                                    const std::vector<smlt::MeshPtr>& meshes) {
     auto nodes = js["nodes"];
     auto node = nodes[node_id];
@@ -1058,34 +1053,34 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
     prefab_node.id = node_id;
 
     auto light_id =
-        node["extensions"]["KHR_lights_punctual"]["light"]->to_int().value_or(
+        node["extensions"]["KHR_lights_punctual"]["light"].to_int().value_or(
             -1);
 
-    if(node->has_key("mesh") && !meshes.empty()) {
+    if(node.has_key("mesh") && !meshes.empty()) {
         prefab_node.node_type_name = "actor";
         prefab_node.params.set("mesh",
-                               meshes[node["mesh"]->to_int().value_or(0)]);
-    } else if(node->has_key("camera")) {
-        auto camera_id = node["camera"]->to_int().value_or(-1);
+                               meshes[node["mesh"].to_int().value_or(0)]);
+    } else if(node.has_key("camera")) {
+        auto camera_id = node["camera"].to_int().value_or(-1);
         if(camera_id >= 0) {
             prefab_node.node_type_name = "camera";
 
             auto cam_node = js["cameras"][camera_id];
             auto persp_node = cam_node["perspective"];
-            auto type = cam_node["type"]->to_str().value_or("perspective");
+            auto type = cam_node["type"].to_str().value_or("perspective");
             if(type == "perspective") {
                 prefab_node.params.set(
                     "aspect",
-                    persp_node["aspectRatio"]->to_float().value_or(1.777f));
+                    persp_node["aspectRatio"].to_float().value_or(1.777f));
                 prefab_node.params.set(
-                    "yfov", persp_node["yfov"]->to_float().value_or(60.0f));
+                    "yfov", persp_node["yfov"].to_float().value_or(60.0f));
                 prefab_node.params.set(
-                    "znear", persp_node["znear"]->to_float().value_or(1.0f));
+                    "znear", persp_node["znear"].to_float().value_or(1.0f));
 
                 if(persp_node["zfar"].is_valid()) {
                     prefab_node.params.set(
                         "zfar",
-                        persp_node["zfar"]->to_float().value_or(1000.0f));
+                        persp_node["zfar"].to_float().value_or(1000.0f));
                 }
             }
         }
@@ -1096,11 +1091,11 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
             prefab_node.node_type_name = "light";
             prefab_node.params.set("color", parse_color3(light["color"]));
             prefab_node.params.set(
-                "intensity", light["intensity"]->to_float().value_or(1.0f));
+                "intensity", light["intensity"].to_float().value_or(1.0f));
             prefab_node.params.set("range",
-                                   light["range"]->to_float().value_or(100.0f));
+                                   light["range"].to_float().value_or(100.0f));
             prefab_node.params.set(
-                "type", light["type"]->to_str().value_or("directional"));
+                "type", light["type"].to_str().value_or("directional"));
         }
     } else {
         prefab_node.node_type_name = "stage";
@@ -1109,28 +1104,28 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
     GLTFLoader::NodeFactoryInput input;
 
     if(node["extras"].is_valid()) {
-        for(auto& k: node["extras"]->keys()) {
-            auto it = node["extras"];
-            if(it[k]->is_str()) {
-                prefab_node.params.set(k.c_str(), it[k]->to_str().value_or(""));
-            } else if(it[k]->is_number()) {
-                if(it[k]->is_float()) {
+        for(auto value: node["extras"]) {
+            auto k = std::string(value.key());
+            if(value.is_str()) {
+                prefab_node.params.set(k.c_str(), value.to_str().value_or(""));
+            } else if(value.is_number()) {
+                if(value.is_float()) {
                     prefab_node.params.set(k.c_str(),
-                                           it[k]->to_float().value_or(0.0f));
+                                           value.to_float().value_or(0.0f));
                 } else {
                     prefab_node.params.set(k.c_str(),
-                                           (int)it[k]->to_int().value_or(0));
+                                           (int)value.to_int().value_or(0));
                 }
 
-            } else if(it[k]->is_bool()) {
+            } else if(value.is_bool()) {
                 prefab_node.params.set(k.c_str(),
-                                       it[k]->to_bool().value_or(false));
-            } else if(it[k]->is_array()) {
+                                       value.to_bool().value_or(false));
+            } else if(value.is_array()) {
                 std::vector<float> farr;
                 std::vector<int> iarr;
                 std::vector<bool> barr;
 
-                for(auto& v: it[k]) {
+                for(auto v: value) {
                     if(v.is_bool()) {
                         barr.push_back(v.to_bool().value_or(false));
                     } else if(v.is_number()) {
@@ -1154,9 +1149,9 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
     }
 
     auto extract_transform =
-        [](JSONIterator& node) -> std::tuple<Vec3, Quaternion, Vec3> {
+        [](const JSONValue& node) -> std::tuple<Vec3, Quaternion, Vec3> {
         auto trn = parse_pos(node["translation"]);
-        auto rot = (node->has_key("rotation"))
+        auto rot = (node.has_key("rotation"))
                        ? parse_quaternion(node["rotation"])
                        : smlt::Quaternion();
         auto sf = parse_scale(node["scale"]);
@@ -1164,7 +1159,7 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
         if(node["matrix"]) {
             auto mat = Mat4();
             for(int i = 0; i < 16; ++i) {
-                mat[i] = node["matrix"][i]->to_float().value_or(0.0f);
+                mat[i] = node["matrix"][i].to_float().value_or(0.0f);
             }
 
             mat.extract_rotation_and_translation(rot, trn);
@@ -1178,7 +1173,7 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
         return std::make_tuple(trn, rot, sf);
     };
 
-    prefab_node.name = node["name"]->to_str().value_or("");
+    prefab_node.name = node["name"].to_str().value_or("");
     // FIXME: Additional properties!
 
     auto trn = extract_transform(node);
@@ -1188,8 +1183,8 @@ static bool spawn_node_recursively(Prefab& prefab, int32_t parent, int node_id,
 
     prefab.push_node(prefab_node, parent);
 
-    if(node->has_key("children")) {
-        for(auto& child: node["children"]) {
+    if(node.has_key("children")) {
+        for(auto child: node["children"]) {
             spawn_node_recursively(prefab, prefab_node.id,
                                    child.to_int().value_or(0), js, meshes);
         }
@@ -1202,6 +1197,9 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
     auto prefab = loadable_to<Prefab>(resource);
     std::shared_ptr<std::istream> bin_chunk;
 
+    /* For glb files we know exactly how much JSON there is */
+    uint32_t json_length = 0;
+
     uint32_t magic;
     data_->read((char*)&magic, sizeof(magic));
     if(magic == 0x46546C67) {
@@ -1228,6 +1226,7 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
         }
 
         uint32_t here = data_->tellg();
+        json_length = chunk_length;
 
         uint32_t json_end = here + chunk_length;
 
@@ -1252,7 +1251,23 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
         data_->seekg(0, std::ios::beg);
     }
 
-    auto js = json_read(this->data_);
+    /* The document owns the storage that every JSONValue below points
+     * into, so it must outlive them all */
+    JSONDocument::ptr document;
+    if(json_length) {
+        std::string json(json_length, '\0');
+        data_->read(&json[0], json_length);
+        document = JSONDocument::parse(std::move(json));
+    } else {
+        document = JSONDocument::read(*data_);
+    }
+
+    if(!document->is_valid()) {
+        S_ERROR("Unable to parse gltf file: {0}", filename_);
+        return false;
+    }
+
+    auto js = document->root();
 
     if(!check_gltf_version(js)) {
         return false;
@@ -1289,11 +1304,9 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
     std::unordered_map<int, int> mesh_to_skin;
 
     // Looping through all the nodes for skin association
-    for (auto &node_it : js["nodes"]) {
-        auto node = node_it.to_iterator();
-
-        int mesh_id = node["mesh"]->to_int().value_or(-1);
-        int skin_id = node["skin"]->to_int().value_or(-1);
+    for(auto node: js["nodes"]) {
+        int mesh_id = node["mesh"].to_int().value_or(-1);
+        int skin_id = node["skin"].to_int().value_or(-1);
 
         if (mesh_id >= 0 && skin_id >= 0) {
             mesh_to_skin[mesh_id] = skin_id;
@@ -1303,20 +1316,18 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
 
     /* This is the most complicated part of the loader. A GLTF file has a
        heirarchy of: mesh/animation -> accessor -> bufferView -> buffer */
-    for(auto& acc_node: js["accessors"]) {
-        auto acc = acc_node.to_iterator();
+    for(auto acc: js["accessors"]) {
         Accessor accessor;
-        accessor.type = acc["type"]->to_str().value_or("SCALAR");
+        accessor.type = acc["type"].to_str().value_or("SCALAR");
         accessor.component_type =
-            (ComponentType)acc["componentType"]->to_int().value_or(5121);
-        accessor.buffer_view_id = acc["bufferView"]->to_int().value_or(-1);
+            (ComponentType)acc["componentType"].to_int().value_or(5121);
+        accessor.buffer_view_id = acc["bufferView"].to_int().value_or(-1);
         accessors.push_back(accessor);
     }
 
     int j = 0;
     auto textures_it = js["textures"];
-    for(auto& node: textures_it) {
-        auto tex_it = node.to_iterator();
+    for(auto tex_it: textures_it) {
         auto tex = load_texture(&prefab->asset_manager(), js, tex_it, j++,
                                 bin_chunk.get(), ext);
         textures.push_back(tex);
@@ -1325,8 +1336,7 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
 
     auto materials_it = js["materials"];
     j = 0;
-    for(auto& node: materials_it) {
-        auto mat_it = node.to_iterator();
+    for(auto mat_it: materials_it) {
         auto mat =
             load_material(&prefab->asset_manager(), js, mat_it, j++, textures);
         prefab->push_material(mat);
@@ -1340,8 +1350,7 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
 
     auto meshes_it = js["meshes"];
     j = 0;
-    for(auto& node: meshes_it) {
-        auto mesh_it = node.to_iterator();
+    for(auto mesh_it: meshes_it) {
         int mesh_id = j;
         int skin_id = -1;
 
@@ -1362,12 +1371,11 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
         auto nodes_it = js["nodes"];
         auto root_name = smlt::any_cast<std::string>(options.at("root_name"));
         int i = -1;
-        for(auto& node: nodes_it) {
+        for(auto node: nodes_it) {
             ++i;
 
-            auto it = node.to_iterator();
-            if(it->has_key("name")) {
-                auto name_maybe = it["name"]->to_str();
+            if(node.has_key("name")) {
+                auto name_maybe = node["name"].to_str();
                 if(name_maybe && name_maybe.value() == root_name) {
                     spawn_node_recursively(*prefab, -1, i, js, meshes);
                     return true;
@@ -1381,9 +1389,8 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
     }
 
     auto scene_it = maybe_scene_it.value();
-    for(auto& node: scene_it["nodes"]) {
-        auto node_it = node.to_iterator();
-        auto maybe_id = node_it->to_int();
+    for(auto node_it: scene_it["nodes"]) {
+        auto maybe_id = node_it.to_int();
         if(!maybe_id) {
             S_WARN("Node id was an unexpected type");
             continue;
@@ -1393,25 +1400,27 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
         spawn_node_recursively(*prefab, -1, node_id, js, meshes);
     }
 
-    auto animations_it = js["animations"];
-    for(auto& node: animations_it) {
-        auto node_it = node.to_iterator();
+    /* Samplers commonly share their input accessor (e.g. every joint
+     * keyed at the same times) so share the times too. This lets the
+     * AnimationController look up the keys once for all of them */
+    std::unordered_map<int, AnimationTimesPtr> times_by_accessor;
 
+    auto animations_it = js["animations"];
+    for(auto node_it: animations_it) {
         std::string name = "anim";
         if(node_it["name"]) {
-            name = node_it["name"]->to_str().value();
+            name = node_it["name"].to_str().value();
         }
 
-        for(auto& ch_node: node_it["channels"]) {
-            auto ch_node_it = ch_node.to_iterator();
+        for(auto ch_node_it: node_it["channels"]) {
             auto target = ch_node_it["target"];
-            auto target_node = target["node"]->to_int();
+            auto target_node = target["node"].to_int();
             if(!target_node) {
                 continue;
             }
             auto target_node_id = target_node.value();
 
-            auto path_str = target["path"]->to_str().value_or("translation");
+            auto path_str = target["path"].to_str().value_or("translation");
             auto path = (path_str == "translation") ? ANIMATION_PATH_TRANSLATION
                         : (path_str == "rotation")  ? ANIMATION_PATH_ROTATION
                         : (path_str == "scale")     ? ANIMATION_PATH_SCALE
@@ -1423,16 +1432,16 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
                 continue;
             }
 
-            auto sampler_id = ch_node_it["sampler"]->to_int();
+            auto sampler_id = ch_node_it["sampler"].to_int();
             if(!sampler_id) {
                 continue;
             }
 
             auto sampler = node_it["samplers"][sampler_id.value()];
             auto interpolation_name =
-                sampler["interpolation"]->to_str().value_or("LINEAR");
-            auto input_id = sampler["input"]->to_int();
-            auto output_id = sampler["output"]->to_int();
+                sampler["interpolation"].to_str().value_or("LINEAR");
+            auto input_id = sampler["input"].to_int();
+            auto output_id = sampler["output"].to_int();
             if(!input_id || !output_id) {
                 continue;
             }
@@ -1452,11 +1461,16 @@ bool GLTFLoader::into(Loadable& resource, const LoaderOptions& options) {
              * vector as it goes. It would be better if process_buffer returned
              * a vector that could be cleared as we convert it into a typed
              * array */
-            auto times_buffer = process_buffer(js, accessors[input_id.value()],
-                                               bin_chunk.get());
-
-            std::vector<float> times;
-            times_buffer.to_typed_array(times);
+            auto& times = times_by_accessor[input_id.value()];
+            if(!times) {
+                auto times_buffer = process_buffer(
+                    js, accessors[input_id.value()], bin_chunk.get());
+
+                std::vector<float> typed_times;
+                times_buffer.to_typed_array(typed_times);
+                times = std::make_shared<const std::vector<float>>(
+                    std::move(typed_times));
+            }
 
             auto output_buffer = process_buffer(
                 js, accessors[output_id.value()], bin_chunk.get());
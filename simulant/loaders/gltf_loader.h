@@ -11,7 +11,7 @@
 #include "../nodes/stage_node.h"
 #include "../scenes/scene.h"
 #include "../stage.h"
-#include "../utils/json.h"
+#include "../utils/json_reader.h"
 #include "../utils/limited_string.h"
 #include "../utils/params.h"
 
@@ -29,7 +29,7 @@
 #include "../window.h"
 #include "../application.h"
 #include "../vfs.h"
-#include "../utils/json.h"
+#include "../utils/json_reader.h"
 
 #if !defined(__DREAMCAST__) && !defined(__PSP__)
 #include "../renderers/gl2x/gpu_program.h"
@@ -44,10 +44,10 @@ MaterialScript::MaterialScript(std::shared_ptr<std::istream> data, const Path& f
 }
 
 template<MaterialPropertyType MT, typename T>
-static void define_property(Material& material, JSONIterator prop) {
-    std::string name = prop["name"]->to_str().value(); // FIXME: Sanitize!
+static void define_property(Material& material, JSONValue prop) {
+    std::string name = prop["name"].to_str().value(); // FIXME: Sanitize!
 
-    if(!prop["default"]->is_null()) {
+    if(!prop["default"].is_null()) {
         auto def = (T) json_auto_cast<T>(prop["default"]).value();
 
         material.set_property_value(name, def);
@@ -57,11 +57,11 @@ static void define_property(Material& material, JSONIterator prop) {
 }
 
 template<>
-void define_property<MATERIAL_PROPERTY_TYPE_TEXTURE, TexturePtr>(Material& material, JSONIterator prop) {
-    std::string name = prop["name"]->to_str().value(); // FIXME: Sanitize!
+void define_property<MATERIAL_PROPERTY_TYPE_TEXTURE, TexturePtr>(Material& material, JSONValue prop) {
+    std::string name = prop["name"].to_str().value(); // FIXME: Sanitize!
 
-    if(prop->has_key("default") && !prop["default"]->is_null()) {
-        std::string def = prop["default"]->to_str().value();
+    if(prop.has_key("default") && !prop["default"].is_null()) {
+        std::string def = prop["default"].to_str().value();
 
         auto texture = material.asset_manager().load_texture(def);
         material.set_property_value(name, texture);
@@ -70,10 +70,10 @@ void define_property<MATERIAL_PROPERTY_TYPE_TEXTURE, TexturePtr>(Material& mater
     }
 }
 
-static void read_property_values(Material& mat, MaterialObject& holder, JSONIterator json) {
-    if(json->has_key("property_values")) {
-        for(auto& key: json["property_values"]->keys()) {
-            auto value = json["property_values"][key];
+static void read_property_values(Material& mat, MaterialObject& holder, JSONValue json) {
+    if(json.has_key("property_values")) {
+        for(auto value: json["property_values"]) {
+            std::string key(value.key());
 
             MaterialPropertyType property_type;
             if(!mat.property_type(key.c_str(), &property_type)) {
@@ -81,19 +81,19 @@ static void read_property_values(Material& mat, MaterialObject& holder, JSONIter
                 continue;
             }
             if(property_type == MATERIAL_PROPERTY_TYPE_BOOL) {
-                if(!value->is_bool()) {
+                if(!value.is_bool()) {
                     S_ERROR("Invalid property value for: {0}", key);
                     continue;
                 }
 
-                holder.set_property_value(key.c_str(), value->to_bool().value());
+                holder.set_property_value(key.c_str(), value.to_bool().value());
             } else if(property_type == MATERIAL_PROPERTY_TYPE_VEC3) {
-                if(!value->is_str()) {
+                if(!value.is_str()) {
                     S_ERROR("Invalid property value for: {0}", key);
                     continue;
                 }
 
-                auto parts = unicode(value->to_str().value()).split(" ");
+                auto parts = unicode(value.to_str().value()).split(" ");
 
                 if(parts.size() != 3) {
                     S_ERROR(_F("Invalid value for property: {0}").format(key));
@@ -106,12 +106,12 @@ static void read_property_values(Material& mat, MaterialObject& holder, JSONIter
 
                 holder.set_property_value(key.c_str(), Vec3(x, y, z));
             } else if(property_type == MATERIAL_PROPERTY_TYPE_VEC4) {
-                if(!value->is_str()) {
+                if(!value.is_str()) {
                     S_ERROR("Invalid property value for: {0}", key);
                     continue;
                 }
 
-                auto parts = unicode(value->to_str().value()).split(" ");
+                auto parts = unicode(value.to_str().value()).split(" ");
 
                 if(parts.size() != 4) {
                     S_ERROR("Invalid value for property: {0}", key);
@@ -126,27 +126,27 @@ static void read_property_values(Material& mat, MaterialObject& holder, JSONIter
                 holder.set_property_value(key.c_str(), Vec4(x, y, z, w));
             } else if(property_type == MATERIAL_PROPERTY_TYPE_FLOAT || property_type == MATERIAL_PROPERTY_TYPE_INT) {
                 if(property_type == MATERIAL_PROPERTY_TYPE_FLOAT) {
-                    holder.set_property_value(key.c_str(), value->to_float().value());
+                    holder.set_property_value(key.c_str(), value.to_float().value());
                 } else {
-                    if(value->is_str()) {
+                    if(value.is_str()) {
                         /* Special cases for enums - need a better way to handle this */
                         if(key == BLEND_FUNC_PROPERTY_NAME) {
-                            std::string v = value->to_str().value();
+                            std::string v = value.to_str().value();
                             BlendType type = blend_type_from_name(v.c_str());
                             holder.set_blend_func(type);
                         } else if(key == SHADE_MODEL_PROPERTY_NAME) {
-                            std::string v = value->to_str().value();
+                            std::string v = value.to_str().value();
                             holder.set_shade_model(shade_model_from_name(v.c_str()));
                         } else if(key == CULL_MODE_PROPERTY_NAME) {
-                            std::string v = value->to_str().value();
+                            std::string v = value.to_str().value();
                             holder.set_cull_mode(cull_mode_from_name(v.c_str()));
                         }
                     } else {
-                        holder.set_property_value(key.c_str(), (int32_t) value->to_int().value());
+                        holder.set_property_value(key.c_str(), (int32_t) value.to_int().value());
                     }
                 }
             } else if(property_type == MATERIAL_PROPERTY_TYPE_TEXTURE) {
-                std::string path = value->to_str().value();
+                std::string path = value.to_str().value();
                 auto tex = mat.asset_manager().load_texture(path);
                 holder.set_property_value(key.c_str(), tex);
             } else {
@@ -178,23 +178,27 @@ bool MaterialScript::generate(Material& material) {
         }
     };
 
-    auto json = json_read(data_);
+    auto document = JSONDocument::read(*data_);
+    if(!document->is_valid()) {
+        S_ERROR("Unable to parse material: {0}", filename_);
+        return false;
+    }
 
-    if(!json->has_key("passes")) {
+    auto json = document->root();
+
+    if(!json.has_key("passes")) {
         S_ERROR("Material is missing the passes key");
         return false;
     }
 
     /* Load any custom properties */
-    if(json->has_key("custom_properties")) {
+    if(json.has_key("custom_properties")) {
         auto custom_props = json["custom_properties"];
 
-        for(auto& node: custom_props) {
-            auto prop = node.to_iterator();
-
-            assert(prop->has_key("type"));
+        for(auto prop: custom_props) {
+            assert(prop.has_key("type"));
 
-            std::string kind = prop["type"]->to_str().value();
+            std::string kind = prop["type"].to_str().value();
             auto prop_type = lookup_material_property_type(kind);
 
             switch(prop_type) {
@@ -218,16 +222,16 @@ bool MaterialScript::generate(Material& material) {
 
     read_property_values(material, material, json);
 
-    material.set_pass_count(json["passes"]->size());
+    material.set_pass_count(json["passes"].size());
 
     Renderer* renderer = get_app()->window->renderer;
 
-    assert(json->has_key("passes"));
+    assert(json.has_key("passes"));
 
-    for(uint32_t i = 0u; i < json["passes"]->size(); ++i) {
+    for(uint32_t i = 0u; i < json["passes"].size(); ++i) {
         auto pass = json["passes"][i];
 
-        std::string iteration = (pass->has_key("iteration")) ? pass["iteration"]->to_str().value() : "once";
+        std::string iteration = (pass.has_key("iteration")) ? pass["iteration"].to_str().value() : "once";
 
         if(iteration == "once") {
             material.pass(i)->set_iteration_type(ITERATION_TYPE_ONCE);
@@ -240,9 +244,9 @@ bool MaterialScript::generate(Material& material) {
         read_property_values(material, *material.pass(i), pass);
 
         /* If we support gpu programs, then load any shaders */
-        if(renderer->supports_gpu_programs() && pass->has_key("vertex_shader") && pass->has_key("fragment_shader")) {
-            std::string vertex_shader_path = pass["vertex_shader"]->to_str().value();
-            std::string fragment_shader_path = pass["fragment_shader"]->to_str().value();
+        if(renderer->supports_gpu_programs() && pass.has_key("vertex_shader") && pass.has_key("fragment_shader")) {
+            std::string vertex_shader_path = pass["vertex_shader"].to_str().value();
+            std::string fragment_shader_path = pass["fragment_shader"].to_str().value();
 
             auto parent_dir = Path(kfs::path::dir_name(filename_.str()));
             S_INFO("Parent: {0}", parent_dir.str());
@@ -51,36 +51,29 @@ private:
     std::shared_ptr<std::vector<uint8_t>> data_;
 };
 
-int32_t queue_buffer(std::weak_ptr<Sound> sound, StreamWrapper::ptr stream, AudioBufferID buffer) {
+int32_t decode_buffer(std::weak_ptr<Sound> sound, StreamWrapper::ptr stream, uint8_t* out, std::size_t max_bytes) {
     std::shared_ptr<Sound> self = sound.lock();
     if(!self) {
         // The sound was destroyed, we can't stream without a sound so just bail
         return -1;
     }
 
-    auto buffer_size = self->buffer_size();
-    std::vector<int16_t> pcm(buffer_size, 0);
+    int shorts_required = max_bytes / sizeof(int16_t);
 
-    int shorts_required = buffer_size / 2;
+    thread::Lock<thread::Mutex> lock(self->_stream_mutex());
 
     // 'result' is the total number of samples per channel
     int result = stb_vorbis_get_samples_short_interleaved(
         stream->get(),
         self->channels(),
-        &pcm[0],
+        (short*) out,
         shorts_required
     );
 
     if(result > 0)  {
         // samples-per-channel * channels * size of each sample
         // so this is the total bytes we just read
-        int byte_size = result * self->channels() * sizeof(int16_t);
-        self->_driver()->upload_buffer_data(
-            buffer, self->format(),
-            (uint8_t*) &pcm[0], byte_size, self->sample_rate()
-        );
-
-        return byte_size;
+        return result * self->channels() * sizeof(int16_t);
     } else {
         S_INFO("No more samples available");
         return 0;
@@ -99,7 +92,7 @@ static void init_source(Sound* self, PlayingSound& source) {
 
     /* Set the stream func to nothing - this will give any captured smart pointers
      * the opportunity to unload before we do anything else */
-    source.set_stream_func(StreamFunc());
+    source.set_decode_func(DecodeFunc());
 
     auto fstream = std::dynamic_pointer_cast<FileIfstream>(self->input_stream());
     fstream->seekg(0);
@@ -110,13 +103,13 @@ static void init_source(Sound* self, PlayingSound& source) {
     /* Using a weak_ptr is important, otherwise the shared_ptr will be bound to the function
      * object even though the argument is a weak_ptr */
     std::weak_ptr<Sound> wptr = self->shared_from_this();
-    source.set_stream_func(std::bind(&queue_buffer, wptr, stream, std::placeholders::_1));
+    source.set_decode_func(std::bind(&decode_buffer, wptr, stream, std::placeholders::_1, std::placeholders::_2));
 }
 
 static void init_source_memory(Sound* self, PlayingSound& source) {
     /* Set the stream func to nothing - this will give any captured smart pointers
      * the opportunity to unload before we do anything else */
-    source.set_stream_func(StreamFunc());
+    source.set_decode_func(DecodeFunc());
 
     auto fstream = std::dynamic_pointer_cast<FileIfstream>(self->input_stream());
     fstream->seekg(0);
@@ -132,7 +125,7 @@ static void init_source_memory(Sound* self, PlayingSound& source) {
     /* Using a weak_ptr is important, otherwise the shared_ptr will be bound to the function
      * object even though the argument is a weak_ptr */
     std::weak_ptr<Sound> wptr = self->shared_from_this();
-    source.set_stream_func(std::bind(&queue_buffer, wptr, stream, std::placeholders::_1));
+    source.set_decode_func(std::bind(&decode_buffer, wptr, stream, std::placeholders::_1, std::placeholders::_2));
 }
 
 bool OGGLoader::into(Loadable& resource, const LoaderOptions& options) {
@@ -183,6 +183,10 @@ bool ParticleScriptLoader::into(Loadable& resource,
         ps->set_cull_each(js["cull_each"]->to_bool().value_or(false));
     }
 
+    if(js->has_key("gpu_billboarding")) {
+        ps->set_gpu_billboarding(js["gpu_billboarding"]->to_bool().value_or(false));
+    }
+
     if(js->has_key("material")) {
         std::string material = js["material"]->to_str().value();
 
@@ -156,7 +156,7 @@ bool WAVLoader::into(Loadable& resource, const LoaderOptions& options) {
     std::weak_ptr<Sound> wptr = sound->shared_from_this();
 
     sound->set_playing_sound_init_function([wptr](PlayingSound& source) {
-        source.set_stream_func(StreamFunc());
+        source.set_decode_func(DecodeFunc());
 
         struct SourcePlayState {
             int offset = 0;
@@ -182,37 +182,28 @@ bool WAVLoader::into(Loadable& resource, const LoaderOptions& options) {
 
         auto stream = std::make_shared<StreamView>(sound_ptr->input_stream());
 
-        S_DEBUG("Initialized stream_func for source instance {0}", &source);
+        S_DEBUG("Initialized decode_func for source instance {0}", &source);
 
-        source.set_stream_func([state, stream](AudioBufferID id) -> int32_t {
+        source.set_decode_func([state, stream](uint8_t* out, std::size_t max_bytes) -> int32_t {
             auto sound = state->sound_ptr.lock();
 
             if(sound) {
-                const uint32_t buffer_size = sound->buffer_size();
                 const uint32_t remaining_in_bytes = sound->stream_length() - state->offset;
+                const uint32_t bytes = std::min<uint32_t>(remaining_in_bytes, max_bytes);
 
-                //assert((buffer_size % audio_data_format_byte_size(sound->format())) == 0);
-
-                std::vector<uint8_t> buffer;
-                stream->seekg(state->offset, std::ios_base::beg);
-
-                if(remaining_in_bytes == 0) {
+                if(bytes == 0) {
                     return 0;
-                } else if(remaining_in_bytes < buffer_size) {
-                    buffer.resize(remaining_in_bytes);
-                    stream->read((char*) &buffer[0], remaining_in_bytes);
-                } else {
-                    buffer.resize(buffer_size);
-                    stream->read((char*) &buffer[0], buffer_size);
                 }
 
-                state->offset += buffer.size();
+                {
+                    thread::Lock<thread::Mutex> lock(sound->_stream_mutex());
+                    stream->seekg(state->offset, std::ios_base::beg);
+                    stream->read((char*) out, bytes);
+                }
 
-                sound->_driver()->upload_buffer_data(
-                    id, sound->format(), &buffer[0], buffer.size(), sound->sample_rate()
-                );
+                state->offset += bytes;
 
-                return buffer.size();
+                return bytes;
             } else {
                 S_WARN("Sound was destroyed while playing, stopping playback");
                 return -1;
@@ -1,5 +1,8 @@
 #include <unordered_map>
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include "logging.h"
 
@@ -20,11 +23,12 @@ std::string to_string(const DateTime& time) {
 
 void Handler::write_message(Logger* logger,
                    const DateTime& time,
-                   const std::string& level,
-                   const std::string& message) {
+                   const char* level,
+                   const char* message,
+                   std::size_t length) {
 
     assert(logger);
-    do_write_message(logger, time, level, message);
+    do_write_message(logger, time, level, message, length);
 }
 
 FileHandler::FileHandler(const std::string& filename):
@@ -39,13 +43,16 @@ FileHandler::FileHandler(const std::string& filename):
 
 void FileHandler::do_write_message(Logger*,
                    const DateTime& time,
-                   const std::string& level,
-                   const std::string &message) {
+                   const char* level,
+                   const char* message,
+                   std::size_t length) {
 
     if(!stream_.good()) {
         throw std::runtime_error("Error writing to log file");
     }
-    stream_ << to_string(time) << " " << level << " " << message << std::endl;
+    stream_ << to_string(time) << " " << level << " ";
+    stream_.write(message, length);
+    stream_ << std::endl;
     stream_.flush();
 }
 
@@ -59,28 +66,243 @@ StdIOHandler::~StdIOHandler() {
 
 void StdIOHandler::do_write_message(Logger*,
                                     const DateTime& time,
-                       const std::string& level,
-                       const std::string& message) {
+                       const char* level,
+                       const char* message,
+                       std::size_t length) {
 
     // We lock so that we don't get interleaved logging
     thread::Lock<thread::Mutex> g(lock_);
 
-    if(level == "ERROR") {
+    if(std::strcmp(level, "ERROR") == 0) {
 #ifndef __ANDROID__
-        std::cerr << to_string(time) << " ERROR " << message << std::endl;
+        std::cerr << to_string(time) << " ERROR ";
+        std::cerr.write(message, length);
+        std::cerr << std::endl;
 #else
-        __android_log_write(ANDROID_LOG_ERROR, "SIMULANT", message.c_str());
+        __android_log_print(ANDROID_LOG_ERROR, "SIMULANT", "%.*s", (int) length, message);
 #endif
     } else {
 #ifndef __ANDROID__
-        std::cout << to_string(time) << " " << level << " " << message << std::endl;
+        std::cout << to_string(time) << " " << level << " ";
+        std::cout.write(message, length);
+        std::cout << std::endl;
         std::cout.flush();
 #else
-        __android_log_write(ANDROID_LOG_INFO, "SIMULANT", message.c_str());
+        __android_log_print(ANDROID_LOG_INFO, "SIMULANT", "%.*s", (int) length, message);
 #endif
     }
 }
 
+AsyncHandler::AsyncHandler(Handler::ptr target, std::size_t capacity):
+    target_(target),
+    records_(std::max<std::size_t>(capacity, 1)) {
+
+    thread_ = std::make_shared<thread::Thread>(&AsyncHandler::run, this);
+}
+
+AsyncHandler::~AsyncHandler() {
+    {
+        thread::Lock<thread::Mutex> g(mutex_);
+        stop_ = true;
+    }
+
+    wake_.notify_one();
+
+    /* Whatever is still queued is written before the thread exits */
+    thread_->join();
+}
+
+void AsyncHandler::flush() {
+    thread::Lock<thread::Mutex> g(mutex_);
+    while(count_ || writing_) {
+        drained_.wait(mutex_);
+    }
+}
+
+std::size_t AsyncHandler::dropped_count() {
+    thread::Lock<thread::Mutex> g(mutex_);
+    return dropped_;
+}
+
+void AsyncHandler::do_write_message(Logger* logger,
+                                    const DateTime& time,
+                                    const char* level,
+                                    const char* message,
+                                    std::size_t length) {
+    {
+        thread::Lock<thread::Mutex> g(mutex_);
+
+        if(count_ == records_.size()) {
+            ++dropped_;
+            return;
+        }
+
+        auto& record = records_[(head_ + count_) % records_.size()];
+        record.logger = logger;
+        record.time = time;
+
+        auto level_length = std::min(std::strlen(level), sizeof(record.level) - 1);
+        std::memcpy(record.level, level, level_length);
+        record.level[level_length] = '\0';
+
+        record.length = std::min(length, LOG_MESSAGE_MAX);
+        std::memcpy(record.message, message, record.length);
+
+        ++count_;
+    }
+
+    wake_.notify_one();
+}
+
+void AsyncHandler::run() {
+    std::size_t reported = 0;
+
+    while(true) {
+        Record record;
+        std::size_t dropped = 0;
+
+        {
+            thread::Lock<thread::Mutex> g(mutex_);
+            while(!stop_ && !count_) {
+                wake_.wait(mutex_);
+            }
+
+            if(!count_) {
+                /* Stopped, and nothing left to write */
+                return;
+            }
+
+            record = records_[head_];
+            head_ = (head_ + 1) % records_.size();
+            --count_;
+
+            dropped = dropped_ - reported;
+            reported = dropped_;
+            writing_ = true;
+        }
+
+        /* There's nowhere to report errors from here, the handler would
+         * only end up back in this queue */
+        try {
+            if(dropped) {
+                char note[64];
+                auto length = Formatter::format_into(
+                    note, sizeof(note), "{0} log messages were dropped", dropped
+                );
+
+                target_->write_message(
+                    record.logger, record.time, "WARN", note, length
+                );
+            }
+
+            target_->write_message(
+                record.logger, record.time, record.level,
+                record.message, record.length
+            );
+        } catch(std::exception& e) {
+            std::cerr << "Error writing log message: " << e.what() << std::endl;
+        }
+
+        {
+            thread::Lock<thread::Mutex> g(mutex_);
+            writing_ = false;
+            if(!count_) {
+                drained_.notify_all();
+            }
+        }
+    }
+}
+
+static const char* level_name(LogLevel level) {
+    switch(level) {
+        case LOG_LEVEL_VERBOSE: return "VERBOSE";
+        case LOG_LEVEL_DEBUG: return "DEBUG";
+        case LOG_LEVEL_INFO: return "INFO";
+        case LOG_LEVEL_WARN: return "WARN";
+        case LOG_LEVEL_ERROR: return "ERROR";
+        default: return "NONE";
+    }
+}
+
+static const char* level_colour(LogLevel level) {
+    switch(level) {
+        case LOG_LEVEL_VERBOSE: return "\x1b[97m";
+        case LOG_LEVEL_INFO: return "\x1b[36m";
+        case LOG_LEVEL_WARN: return "\x1b[33m";
+        case LOG_LEVEL_ERROR: return "\x1b[31m";
+        default: return "";
+    }
+}
+
+void Logger::log(LogLevel level, const std::string& text,
+                 const std::string& file, int32_t line) {
+    log(level, text.c_str(), text.size(), file.c_str(), line);
+}
+
+void Logger::log(LogLevel level, const char* text, std::size_t length,
+                 const char* file, int32_t line) {
+
+    if(!is_enabled_for(level) || level == LOG_LEVEL_NONE) {
+        return;
+    }
+
+    char buffer[LOG_MESSAGE_MAX];
+    length = std::min(length, LOG_MESSAGE_MAX - LOG_PREFIX_MAX - 1);
+    std::memcpy(buffer + LOG_PREFIX_MAX, text, length);
+    log_in_place(level, buffer, length, file, line);
+}
+
+void Logger::log_in_place(LogLevel level, char* buffer, std::size_t length,
+                          const char* file, int32_t line) {
+
+    if(!is_enabled_for(level) || level == LOG_LEVEL_NONE) {
+        return;
+    }
+
+    char* text = buffer + LOG_PREFIX_MAX;
+    const std::size_t room = LOG_MESSAGE_MAX - LOG_PREFIX_MAX - 1;
+
+    const char* colour = level_colour(level);
+    const char* reset = (*colour) ? "\x1b[0m" : "";
+
+    char prefix[LOG_PREFIX_MAX];
+    int prefix_length = snprintf(
+        prefix, sizeof(prefix), "%llu: %s",
+        (unsigned long long) thread::this_thread_id(), colour
+    );
+
+    /* The reset and the source location are written after the text, but
+     * room is made for them first so that a long message can't cut the
+     * reset off and leave the terminal coloured */
+    char suffix[256];
+    int suffix_length = (line > -1) ?
+        snprintf(suffix, sizeof(suffix), "%s (%s:%d)", reset, file, (int) line) :
+        snprintf(suffix, sizeof(suffix), "%s", reset);
+
+    if(suffix_length < 0 || prefix_length < 0) {
+        return;
+    }
+
+    std::size_t head = std::min<std::size_t>(prefix_length, sizeof(prefix) - 1);
+    std::size_t tail = std::min<std::size_t>(suffix_length, sizeof(suffix) - 1);
+
+    length = std::min(length, room - tail);
+
+    char* start = text - head;
+    std::memcpy(start, prefix, head);
+    std::memcpy(text + length, suffix, tail);
+
+    std::size_t total = head + length + tail;
+    start[total] = '\0';
+
+    const char* name = level_name(level);
+    const auto now = std::chrono::system_clock::now();
+
+    for(uint32_t i = 0; i < handlers_.size(); ++i) {
+        handlers_[i]->write_message(this, now, name, start, total);
+    }
+}
+
 void verbose(const std::string& text, const std::string& file, int32_t line) {
     get_logger("/")->verbose(text, file, line);
 }
@@ -101,6 +323,17 @@ void error(const std::string& text, const std::string& file, int32_t line) {
     get_logger("/")->error(text, file, line);
 }
 
+bool log_enabled(LogLevel level) {
+    static Logger* root = get_logger("/");
+    return root->is_enabled_for(level);
+}
+
+void log_message(LogLevel level, char* buffer, std::size_t length,
+                 const char* file, int32_t line) {
+    static Logger* root = get_logger("/");
+    root->log_in_place(level, buffer, length, file, line);
+}
+
 Logger* get_logger(const std::string& name) {
     typedef std::unordered_map<std::string, Logger::ptr> LoggerMap;
 
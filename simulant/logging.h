@@ -14,6 +14,7 @@
 #include "utils/string.h"
 #include "utils/formatter.h"
 #include "threads/mutex.h"
+#include "threads/condition.h"
 #include "threads/thread.h"
 
 #include "compat.h"
@@ -31,6 +32,15 @@ enum LogLevel {
 
 class Logger;
 
+/* Log lines longer than this (including the thread id and source location)
+ * are truncated. Lines are formatted into a buffer of this size. */
+const std::size_t LOG_MESSAGE_MAX = 1024;
+
+/* The text of a line is formatted this far into the buffer, the space in
+ * front is kept for the thread id and colour so that they can be added
+ * without moving the text */
+const std::size_t LOG_PREFIX_MAX = 32;
+
 typedef std::chrono::time_point<std::chrono::system_clock> DateTime;
 
 class Handler {
@@ -38,16 +48,20 @@ public:
     typedef std::shared_ptr<Handler> ptr;
 
     virtual ~Handler() {}
+
+    /* message is length bytes long, and isn't always null terminated */
     void write_message(Logger* logger,
                        const DateTime& time,
-                       const std::string& level,
-                       const std::string& message);
+                       const char* level,
+                       const char* message,
+                       std::size_t length);
 
 private:
     virtual void do_write_message(Logger* logger,
                        const DateTime& time,
-                       const std::string& level,
-                       const std::string& message) = 0;
+                       const char* level,
+                       const char* message,
+                       std::size_t length) = 0;
 };
 
 class StdIOHandler : public Handler {
@@ -59,8 +73,9 @@ private:
 
     void do_write_message(Logger* logger,
                        const DateTime& time,
-                       const std::string& level,
-                       const std::string& message) override;
+                       const char* level,
+                       const char* message,
+                       std::size_t length) override;
 
     thread::Mutex lock_;
 };
@@ -72,12 +87,62 @@ public:
 private:
     void do_write_message(Logger* logger,
                        const DateTime& time,
-                       const std::string& level,
-                       const std::string& message);
+                       const char* level,
+                       const char* message,
+                       std::size_t length);
     std::string filename_;
     std::ofstream stream_;
 };
 
+/* Queues messages into a fixed ring and writes them to another handler
+ * from a background thread, so that logging doesn't stall on slow IO.
+ *
+ * If the ring fills up new messages are dropped rather than blocking the
+ * caller, the number dropped is reported with the next message written. */
+class AsyncHandler : public Handler {
+public:
+    static const std::size_t DEFAULT_CAPACITY = 64;
+
+    AsyncHandler(Handler::ptr target, std::size_t capacity=DEFAULT_CAPACITY);
+    ~AsyncHandler();
+
+    /* Blocks until everything queued so far has been written */
+    void flush();
+
+    std::size_t dropped_count();
+
+private:
+    struct Record {
+        Logger* logger = nullptr;
+        DateTime time;
+        char level[8];
+        std::size_t length = 0;
+        char message[LOG_MESSAGE_MAX];
+    };
+
+    void do_write_message(Logger* logger,
+                       const DateTime& time,
+                       const char* level,
+                       const char* message,
+                       std::size_t length) override;
+
+    void run();
+
+    Handler::ptr target_;
+
+    std::vector<Record> records_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    std::size_t dropped_ = 0;
+    bool writing_ = false;
+    bool stop_ = false;
+
+    thread::Mutex mutex_;
+    thread::Condition wake_;
+    thread::Condition drained_;
+    std::shared_ptr<thread::Thread> thread_;
+};
+
 class Logger {
 public:
     typedef std::shared_ptr<Logger> ptr;
@@ -95,34 +160,44 @@ public:
         handlers_.push_back(handler);
     }
 
-    void verbose(const std::string& text, const std::string& file="None", int32_t line=-1) {
-        if(level_ < LOG_LEVEL_VERBOSE) return;
+    /* Cheap enough to call before doing any formatting */
+    bool is_enabled_for(LogLevel level) const {
+        return level_ >= level;
+    }
+
+    void log(LogLevel level, const std::string& text, const std::string& file="None", int32_t line=-1);
+
+    /* As above, without needing the text in a std::string. If the line
+     * is too long the text is truncated, never the colour reset or the
+     * source location. */
+    void log(LogLevel level, const char* text, std::size_t length,
+             const char* file, int32_t line=-1);
 
-        write_message("VERBOSE", "\x1b[97m" + text + "\x1b[0m", file, line);
+    /* Writes a line whose text has already been formatted into buffer, a
+     * buffer of LOG_MESSAGE_MAX bytes, starting at LOG_PREFIX_MAX. The
+     * prefix and suffix are added around the text in place, and the
+     * handlers are given a view of the buffer. */
+    void log_in_place(LogLevel level, char* buffer, std::size_t length,
+                      const char* file, int32_t line=-1);
+
+    void verbose(const std::string& text, const std::string& file="None", int32_t line=-1) {
+        log(LOG_LEVEL_VERBOSE, text, file, line);
     }
 
     void debug(const std::string& text, const std::string& file="None", int32_t line=-1) {
-        if(level_ < LOG_LEVEL_DEBUG) return;
-
-        write_message("DEBUG", text, file, line);
+        log(LOG_LEVEL_DEBUG, text, file, line);
     }
 
     void info(const std::string& text, const std::string& file="None", int32_t line=-1) {
-        if(level_ < LOG_LEVEL_INFO) return;
-
-        write_message("INFO", "\x1b[36m" + text + "\x1b[0m", file, line);
+        log(LOG_LEVEL_INFO, text, file, line);
     }
 
     void warn(const std::string& text, const std::string& file="None", int32_t line=-1) {
-        if(level_ < LOG_LEVEL_WARN) return;
-
-        write_message("WARN", "\x1b[33m" + text + "\x1b[0m", file, line);
+        log(LOG_LEVEL_WARN, text, file, line);
     }
 
     void error(const std::string& text, const std::string& file="None", int32_t line=-1) {
-        if(level_ < LOG_LEVEL_ERROR) return;
-
-        write_message("ERROR", "\x1b[31m" + text + "\x1b[0m", file, line);
+        log(LOG_LEVEL_ERROR, text, file, line);
     }
 
     void set_level(LogLevel level) {
@@ -134,23 +209,6 @@ public:
     }
 
 private:
-    void write_message(const std::string& level, const std::string& text,
-                       const std::string& file, int32_t line) {
-
-        std::stringstream s;
-        s << thread::this_thread_id() << ": ";
-
-        if(line > -1) {
-            s << text << " (" << file << ":" << line << ")";
-        } else {
-            s << text;
-        }
-
-        for(uint32_t i = 0; i < handlers_.size(); ++i) {
-            handlers_[i]->write_message(this, std::chrono::system_clock::now(), level, s.str());
-        }
-    }
-
     std::string name_;
     std::vector<Handler::ptr> handlers_;
 
@@ -159,6 +217,14 @@ private:
 
 Logger* get_logger(const std::string& name);
 
+/* Whether the root logger would write a message at this level */
+bool log_enabled(LogLevel level);
+
+/* Writes a line built by the S_* macros to the root logger, see
+ * Logger::log_in_place */
+void log_message(LogLevel level, char* buffer, std::size_t length,
+                 const char* file, int32_t line);
+
 void verbose(const std::string& text, const std::string& file="None", int32_t line=-1);
 void debug(const std::string& text, const std::string& file="None", int32_t line=-1);
 void info(const std::string& text, const std::string& file="None", int32_t line=-1);
@@ -184,15 +250,30 @@ private:
 
 }
 
-template<typename T, typename... Args>
-void _s_log(T&& func, const char* file, int line, const std::string& fmt,
-            Args&&... args) {
-    func(_F(fmt).format(std::forward<Args>(args)...), file, line);
+/* The level is checked before formatting so that disabled log lines
+ * cost a single comparison. Enabled ones are formatted straight into a
+ * fixed buffer rather than building strings. */
+template<typename F, typename... Args>
+void _s_log(smlt::LogLevel level, const char* file, int line,
+            const F& fmt, const Args&... args) {
+    if(!smlt::log_enabled(level)) {
+        return;
+    }
+
+    /* The caller's stack rather than thread-local storage, which isn't
+     * available on all of the console toolchains */
+    char buffer[smlt::LOG_MESSAGE_MAX];
+    auto length = smlt::Formatter::format_into(
+        buffer + smlt::LOG_PREFIX_MAX,
+        smlt::LOG_MESSAGE_MAX - smlt::LOG_PREFIX_MAX, fmt, args...
+    );
+
+    smlt::log_message(level, buffer, length, file, line);
 }
 
 #ifndef NDEBUG
-#define S_VERBOSE(...) _s_log(::smlt::verbose, __FILE__, __LINE__, __VA_ARGS__)
-#define S_DEBUG(...) _s_log(::smlt::debug, __FILE__, __LINE__, __VA_ARGS__)
+#define S_VERBOSE(...) _s_log(::smlt::LOG_LEVEL_VERBOSE, __FILE__, __LINE__, __VA_ARGS__)
+#define S_DEBUG(...) _s_log(::smlt::LOG_LEVEL_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
 #else
 // Don't log S_VERBOSE or S_DEBUG in release builds
 #define S_VERBOSE(...)                                                         \
@@ -203,34 +284,38 @@ void _s_log(T&& func, const char* file, int line, const std::string& fmt,
     } while(0)
 #endif
 
-#define S_INFO(...) _s_log(::smlt::info, __FILE__, __LINE__, __VA_ARGS__)
-#define S_WARN(...) _s_log(::smlt::warn, __FILE__, __LINE__, __VA_ARGS__)
-#define S_ERROR(...) _s_log(::smlt::error, __FILE__, __LINE__, __VA_ARGS__)
+#define S_INFO(...) _s_log(::smlt::LOG_LEVEL_INFO, __FILE__, __LINE__, __VA_ARGS__)
+#define S_WARN(...) _s_log(::smlt::LOG_LEVEL_WARN, __FILE__, __LINE__, __VA_ARGS__)
+#define S_ERROR(...) _s_log(::smlt::LOG_LEVEL_ERROR, __FILE__, __LINE__, __VA_ARGS__)
 
 #define S_DEBUG_ONCE(...)                                                      \
     do {                                                                       \
         static char _done = 0;                                                 \
         if(!_done++)                                                           \
-            _s_log(::smlt::debug, __FILE__, __LINE__, __VA_ARGS__);            \
+            _s_log(::smlt::LOG_LEVEL_DEBUG, __FILE__, __LINE__,                \
+                   __VA_ARGS__);                                               \
     } while(0)
 
 #define S_INFO_ONCE(...)                                                       \
     do {                                                                       \
         static char _done = 0;                                                 \
         if(!_done++)                                                           \
-            _s_log(::smlt::info, __FILE__, __LINE__, __VA_ARGS__);             \
+            _s_log(::smlt::LOG_LEVEL_INFO, __FILE__, __LINE__,                 \
+                   __VA_ARGS__);                                               \
     } while(0)
 
 #define S_WARN_ONCE(...)                                                       \
     do {                                                                       \
         static char _done = 0;                                                 \
         if(!_done++)                                                           \
-            _s_log(::smlt::warn, __FILE__, __LINE__, __VA_ARGS__);             \
+            _s_log(::smlt::LOG_LEVEL_WARN, __FILE__, __LINE__,                 \
+                   __VA_ARGS__);                                               \
     } while(0)
 
 #define S_ERROR_ONCE(...)                                                      \
     do {                                                                       \
         static char _done = 0;                                                 \
         if(!_done++)                                                           \
-            _s_log(::smlt::error, __FILE__, __LINE__, __VA_ARGS__);            \
+            _s_log(::smlt::LOG_LEVEL_ERROR, __FILE__, __LINE__,                \
+                   __VA_ARGS__);                                               \
     } while(0)
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <limits>
 #include "aabb.h"
 
@@ -30,6 +31,18 @@ AABB::AABB(const VertexData& vertex_data) {
     float maxy = std::numeric_limits<float>::lowest();
     float maxz = std::numeric_limits<float>::lowest();
 
+    if(vertex_data.vertex_specification().position_attribute == VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+        Vec3 min(minx, miny, minz), max(maxx, maxy, maxz);
+        for(std::size_t i = 0; i < vertex_data.count(); ++i) {
+            auto p = vertex_data.position_nd_at(i).xyz();
+            min = Vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+            max = Vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+        }
+
+        set_min_max(min, max);
+        return;
+    }
+
     const uint8_t* p = vertex_data.data() + vertex_data.vertex_specification().position_offset();
     bool twod = vertex_data.vertex_specification().position_attribute == VERTEX_ATTRIBUTE_2F;
 
@@ -22,8 +22,10 @@
 
 #include "mesh.h"
 #include "adjacency_info.h"
+#include "skinning.h"
 #include "../assets/meshes/skeleton.h"
 
+#include "../application.h"
 #include "../window.h"
 #include "../asset_manager.h"
 #include "../loader.h"
@@ -32,6 +34,8 @@
 #include "private.h"
 
 #include "../procedural/mesh.h"
+#include "../utils/mesh/optimize.h"
+#include "../utils/mesh/simplify.h"
 
 #include "simulant/nodes/actor.h"
 
@@ -60,6 +64,7 @@ Mesh::Mesh(AssetID id,
 void Mesh::reset(VertexDataPtr vertex_data) {
     adjacency_.reset();
     submeshes_.clear();
+    clear_lods();
 
     animation_type_ = MESH_ANIMATION_TYPE_NONE;
     animation_frames_ = 0;
@@ -80,6 +85,7 @@ void Mesh::reset(VertexDataPtr vertex_data) {
 void Mesh::reset(VertexSpecification vertex_specification) {
     adjacency_.reset();
     submeshes_.clear();
+    clear_lods();
 
     animation_type_ = MESH_ANIMATION_TYPE_NONE;
     animation_frames_ = 0;
@@ -193,15 +199,18 @@ void Mesh::enable_animation(MeshAnimationType animation_type, uint32_t animation
 }
 
 void Mesh::rebuild_aabb() {
-    aabb_ = AABB();
+    auto old_min = aabb_.min();
+    auto old_max = aabb_.max();
 
-    if(!this->submesh_count()) {    
-        return;
-    }
+    aabb_ = AABB();
 
     for(auto& sm: submeshes_) {
         aabb_.encapsulate(sm->bounds_);
     }
+
+    if(aabb_.min() != old_min || aabb_.max() != old_max) {
+        signal_bounds_changed_(aabb_);
+    }
 }
 
 void Mesh::vertex_data_updated() {
@@ -756,23 +765,120 @@ void Mesh::normalize() {
     transform_vertices(scale_matrix);
 }
 
-void Mesh::update_skinning() {
-    if(!skin) return;
+/* Positions in any of these formats can be decoded and re-encoded through
+ * VertexData, so they can be skinned. Quantized positions are clamped to
+ * the range they were quantized with. */
+static bool can_skin_positions(VertexAttribute attr) {
+    return attr == VERTEX_ATTRIBUTE_2F ||
+           attr == VERTEX_ATTRIBUTE_3F ||
+           attr == VERTEX_ATTRIBUTE_4F ||
+           attr == VERTEX_ATTRIBUTE_3S_NORMALIZED;
+}
+
+static void write_skinned_position(VertexData* vertex_data, VertexAttribute attr,
+                                   const Vec3& position) {
+    if(attr == VERTEX_ATTRIBUTE_2F) {
+        vertex_data->position(position.x, position.y);
+    } else {
+        vertex_data->position(position);
+    }
+}
+
+void Mesh::prepare_skinning() {
+    const auto count = vertex_data_->count();
+    const auto& spec = vertex_data_->vertex_specification();
 
     // Keeping in mind the rest pose to avoid skinning on top of already transformed vertices
-    if (rest_positions_.empty()) {
-        rest_positions_.reserve(vertex_data_->count());
-        rest_normals_.reserve(vertex_data_->count());
+    rest_positions_.clear();
+    rest_normals_.clear();
+    rest_positions_.reserve(count);
+    rest_normals_.reserve(count);
+
+    VertexAttribute position_attr = spec.position_attribute;
+    const bool skin_positions = can_skin_positions(position_attr);
+    if(spec.has_positions() && !skin_positions) {
+        S_WARN_ONCE("Skinned meshes need 2F, 3F, 4F or 3S_NORMALIZED positions, positions won't be skinned");
+    }
+
+    for(uint32_t i = 0; i < count; ++i) {
+        if(skin_positions) {
+            rest_positions_.push_back(vertex_data_->position_nd_at(i).xyz());
+        }
+        if(spec.has_normals()) {
+            rest_normals_.push_back(*vertex_data_->normal_at<Vec3>(i));
+        }
+    }
+
+    /* Unpack the joints and weights so the kernel doesn't have to care
+     * about the attribute format. Anything pointing outside the skin
+     * gets a zero weight */
+    const auto joint_count = skin->node_indices.size();
+
+    skin_joints_.assign(count * 4, 0);
+    skin_weights_.assign(count * 4, 0.0f);
+
+    for(uint32_t i = 0; i < count; ++i) {
+        uint16_t* joints = &skin_joints_[i * 4];
+        float* weights = &skin_weights_[i * 4];
 
-        for (uint32_t i = 0; i < vertex_data_->count(); ++i) {
-            if (vertex_data_->vertex_specification().has_positions()) {
-                rest_positions_.push_back(*vertex_data_->position_at<Vec3>(i));
+        if(spec.joint_attribute == VERTEX_ATTRIBUTE_4UB) {
+            const auto* joints_acc = vertex_data_->joints_at<uint8_t>(i);
+            for(int j = 0; j < 4; ++j) joints[j] = joints_acc[j];
+        } else if(spec.joint_attribute == VERTEX_ATTRIBUTE_4US) {
+            const auto* joints_acc = vertex_data_->joints_at<uint16_t>(i);
+            for(int j = 0; j < 4; ++j) joints[j] = joints_acc[j];
+        }
+
+        const Vec4* weights_acc = vertex_data_->weights_at<Vec4>(i);
+        weights[0] = weights_acc->x;
+        weights[1] = weights_acc->y;
+        weights[2] = weights_acc->z;
+        weights[3] = weights_acc->w;
+
+        float sum = weights[0] + weights[1] + weights[2] + weights[3];
+        if(sum > 1.01f) {
+            for(int j = 0; j < 4; ++j) {
+                weights[j] /= sum;
             }
-            if (vertex_data_->vertex_specification().has_normals()) {
-                rest_normals_.push_back(*vertex_data_->normal_at<Vec3>(i));
+        }
+
+        for(int j = 0; j < 4; ++j) {
+            if(joints[j] >= joint_count) {
+                joints[j] = 0;
+                weights[j] = 0.0f;
             }
         }
     }
+}
+
+void Mesh::restore_rest_pose() {
+    const auto& spec = vertex_data_->vertex_specification();
+    VertexAttribute position_attr = spec.position_attribute;
+    const bool has_rest_positions = !rest_positions_.empty();
+
+    vertex_data_->move_to_start();
+    for(uint32_t i = 0; i < vertex_data_->count(); ++i) {
+        if(has_rest_positions) {
+            write_skinned_position(vertex_data_.get(), position_attr, rest_positions_[i]);
+        }
+
+        if(spec.has_normals()) {
+            vertex_data_->normal(rest_normals_[i]);
+        }
+        vertex_data_->move_next();
+    }
+    vertex_data_->done();
+}
+
+void Mesh::update_skinning() {
+    if(!skin) return;
+
+    const auto count = vertex_data_->count();
+    const auto& spec = vertex_data_->vertex_specification();
+
+    if(skin_weights_.size() != count * 4) {
+        prepare_skinning();
+    }
 
     Mat4 mesh_world_inverse;
     if (skin->bound_actor) {
@@ -781,88 +887,98 @@ void Mesh::update_skinning() {
         mesh_world_inverse = Mat4();
     }
 
-    vertex_data_->move_to_start();
+    /* Build the palette once per update. Missing joints contribute
+     * nothing, the same as if the vertex weren't bound to them */
+    joint_palette_.resize(skin->node_indices.size());
 
-    static std::vector<Mat4, aligned_allocator<Mat4, 32>> pre_joint_matrices;
-    pre_joint_matrices.clear();
-    pre_joint_matrices.resize(skin->node_indices.size(), Mat4());
-
-    // Actually pre-allocating the transforms
     for(size_t h = 0; h < skin->node_indices.size(); ++h) {
         StageNodePtr joint_node = skin->node_indices[h];
-        if (!joint_node) continue;
+        if(!joint_node) {
+            joint_palette_[h] = Mat4::zero();
+            continue;
+        }
 
         const Mat4& joint_matrix = joint_node->transform->world_space_matrix();
-
-        alignas(32) Mat4 temp;
-        temp = mesh_world_inverse * joint_matrix;
-        pre_joint_matrices[h] = temp * skin->inverse_bind_matrices[h];
+        joint_palette_[h] = (mesh_world_inverse * joint_matrix) * skin->inverse_bind_matrices[h];
     }
 
-    for (uint32_t i = 0; i < vertex_data_->count(); ++i) {
-        // Starting from a clean 0 Mat4, NOT identity!
-        alignas(32) Mat4 skin_matrix = Mat4::zero();
-
-        const Vec4* weights_acc = vertex_data_->weights_at<Vec4>(i);
-        float weights[4] = { weights_acc->x, weights_acc->y, weights_acc->z, weights_acc->w };
-
-        // Starting with an aligned block to branch depending on joint data signature
-        uint16_t joints[4];
-        if (vertex_data_->vertex_specification().joint_attribute == VERTEX_ATTRIBUTE_4UB) {
-            const auto* joints_acc = vertex_data_->joints_at<uint8_t>(i);
-            for (int j = 0; j < 4; ++j) joints[j] = joints_acc[j];
-        } else if (vertex_data_->vertex_specification().joint_attribute == VERTEX_ATTRIBUTE_4US) {
-            const auto* joints_acc = vertex_data_->joints_at<uint16_t>(i);
-            for (int j = 0; j < 4; ++j) joints[j] = joints_acc[j];
-        }
-
-        float sum = weights[0] + weights[1] + weights[2] + weights[3];
-        if (sum > 1.01f) {
-            for (float & weight : weights) {
-                weight /= sum;
+    if(skinning_mode_ == SKINNING_MODE_GPU) {
+        auto app = get_app();
+        uint32_t max_joints = (app && app->window)
+                                  ? app->window->renderer->max_gpu_skinning_joints()
+                                  : 0;
+
+        if(joint_palette_.size() <= max_joints) {
+            if(!gpu_skinned_) {
+                /* We may have been CPU skinned before, put things back
+                 * so the shader starts from the bind pose */
+                restore_rest_pose();
+                gpu_skinned_ = true;
             }
+            return;
         }
+    }
 
-        for (int j = 0; j < 4; ++j) {
-            float weight = weights[j];
-            if (weight == 0.0f) continue;
-
-            auto joint_index = joints[j];
-            if(joint_index >= skin->node_indices.size()) continue;
-
-            StageNodePtr joint_node = skin->node_indices[joint_index];
-            if (!joint_node) continue;
+    gpu_skinned_ = false;
 
-            // We're reusing the matrices that we pre-computed earlier
-            const Mat4& joint_matrix = pre_joint_matrices[joint_index];
+    if(!count) {
+        return;
+    }
 
-            // Going by the engine: mapping across all 16 floats of the matrix
-            // Hot path, and the Vec4 reinterpreting assumes 32B alignment!
-            Vec4* skin_rows = reinterpret_cast<Vec4*>(skin_matrix.data());
-            const Vec4* joint_rows = reinterpret_cast<const Vec4*>(&joint_matrix);
+    SkinningJob job;
+    job.palette = joint_palette_.data();
+    job.joints = skin_joints_.data();
+    job.weights = skin_weights_.data();
+    job.vertex_count = count;
+
+    /* Only float positions and normals are skinned in place. Anything else
+     * is skinned into a scratch buffer and encoded afterwards */
+    VertexAttribute position_attr = spec.position_attribute;
+    bool pack_positions = false;
+    if(position_attr == VERTEX_ATTRIBUTE_3F || position_attr == VERTEX_ATTRIBUTE_4F) {
+        job.rest_positions = rest_positions_.data();
+        job.positions_out = vertex_data_->data() + spec.position_offset(false);
+        job.positions_stride = spec.stride();
+    } else if(!rest_positions_.empty()) {
+        skinned_positions_.resize(count);
+        job.rest_positions = rest_positions_.data();
+        job.positions_out = (uint8_t*) skinned_positions_.data();
+        job.positions_stride = sizeof(Vec3);
+        pack_positions = true;
+    }
 
-            skin_rows[0] = skin_rows[0] + joint_rows[0] * weight;
-            skin_rows[1] = skin_rows[1] + joint_rows[1] * weight;
-            skin_rows[2] = skin_rows[2] + joint_rows[2] * weight;
-            skin_rows[3] = skin_rows[3] + joint_rows[3] * weight;
+    bool pack_normals = false;
+    if(spec.has_normals()) {
+        job.rest_normals = rest_normals_.data();
 
+        if(spec.normal_attribute == VERTEX_ATTRIBUTE_3F) {
+            job.normals_out = vertex_data_->data() + spec.normal_offset(false);
+            job.normals_stride = spec.stride();
+        } else {
+            skinned_normals_.resize(count);
+            job.normals_out = (uint8_t*) skinned_normals_.data();
+            job.normals_stride = sizeof(Vec3);
+            pack_normals = true;
         }
+    }
 
-        // Transform vertex position
-        if (vertex_data_->vertex_specification().has_positions()) {
-            const Vec3& v = rest_positions_[i];
-            vertex_data_->position(v.transformed_by(skin_matrix));
-        }
+    run_skinning_job(job);
 
+    if(pack_positions || pack_normals) {
+        vertex_data_->move_to_start();
+        for(uint32_t i = 0; i < count; ++i) {
+            if(pack_positions) {
+                write_skinned_position(vertex_data_.get(), position_attr, skinned_positions_[i]);
+            }
 
-        alignas(32) Mat4 rot(skin_matrix);
-        // Transform vertex normal
-        if (vertex_data_->vertex_specification().has_normals()) {
-            const Vec3& n = rest_normals_[i];
-            vertex_data_->normal(n.rotated_by(rot).normalized());
+            if(pack_normals) {
+                vertex_data_->normal(skinned_normals_[i]);
+            }
+
+            vertex_data_->move_next();
         }
-        vertex_data_->move_next();
     }
+
     vertex_data_->done();
 }
 
@@ -921,4 +1037,294 @@ void Mesh::generate_adjacency_info() {
     adjacency_->rebuild();
 }
 
+std::size_t Mesh::generate_lods(float ratio) {
+    clear_lods();
+
+    if(is_animated()) {
+        S_WARN("Not generating detail levels for animated mesh {0}", id());
+        return 0;
+    }
+
+    ratio = clamp(ratio, 0.0f, 1.0f);
+
+    /* Triangle submeshes are simplified together, so they stay joined at
+     * material boundaries. Anything else (lines etc.) is shared as-is */
+    std::vector<SubMesh*> sources;
+    std::vector<std::vector<uint32_t>> triangles;
+    std::size_t triangle_count = 0;
+
+    for(auto& sm: submeshes_) {
+        auto arrangement = sm->arrangement();
+        if(arrangement != MESH_ARRANGEMENT_TRIANGLES &&
+           arrangement != MESH_ARRANGEMENT_TRIANGLE_STRIP &&
+           arrangement != MESH_ARRANGEMENT_TRIANGLE_FAN) {
+            continue;
+        }
+
+        sources.push_back(sm.get());
+        triangles.push_back(std::vector<uint32_t>());
+
+        auto& out = triangles.back();
+        sm->each_triangle([&out](uint32_t a, uint32_t b, uint32_t c) {
+            out.push_back(a);
+            out.push_back(b);
+            out.push_back(c);
+        });
+
+        triangle_count += out.size() / 3;
+    }
+
+    if(!triangle_count) {
+        return 0;
+    }
+
+    std::size_t generated = 0;
+
+    for(int level = DETAIL_LEVEL_NEAR; level < DETAIL_LEVEL_MAX; ++level) {
+        auto target = std::size_t(triangle_count * ratio);
+        utils::simplify_triangles(*vertex_data_, triangles, target);
+
+        std::size_t remaining = 0;
+        uint32_t max_index = 0;
+        for(auto& list: triangles) {
+            remaining += list.size() / 3;
+            for(auto i: list) {
+                max_index = std::max(max_index, i);
+            }
+        }
+
+        /* Not worth another mesh if it barely simplified */
+        if(!remaining || remaining > triangle_count - (triangle_count / 10)) {
+            break;
+        }
+
+        auto index_type = (max_index > std::numeric_limits<uint16_t>::max()) ?
+            INDEX_TYPE_32_BIT : INDEX_TYPE_16_BIT;
+
+        auto lod = asset_manager().create_mesh(vertex_data_);
+
+        for(auto& sm: submeshes_) {
+            SubMeshPtr target_sm = nullptr;
+
+            auto it = std::find(sources.begin(), sources.end(), sm.get());
+            if(it != sources.end()) {
+                auto& list = triangles[it - sources.begin()];
+                if(list.empty()) {
+                    continue;
+                }
+
+                target_sm = lod->create_submesh(sm->name(), sm->material(), index_type);
+                target_sm->index_data->index(&list[0], list.size());
+                target_sm->index_data->done();
+            } else if(sm->type() == SUBMESH_TYPE_INDEXED) {
+                target_sm = lod->create_submesh(
+                    sm->name(), sm->material(), sm->index_data_, sm->arrangement()
+                );
+            } else {
+                target_sm = lod->create_submesh(sm->name(), sm->material(), sm->arrangement());
+                for(std::size_t i = 0; i < sm->vertex_range_count(); ++i) {
+                    auto& range = sm->vertex_ranges()[i];
+                    target_sm->add_vertex_range(range.start, range.count);
+                }
+            }
+
+            for(uint8_t slot = MATERIAL_SLOT1; slot < MATERIAL_SLOT_MAX; ++slot) {
+                auto& material = sm->material_at_slot((MaterialSlot) slot);
+                if(material) {
+                    target_sm->set_material_at_slot((MaterialSlot) slot, material);
+                }
+            }
+        }
+
+        lods_[level] = lod;
+        triangle_count = remaining;
+        ++generated;
+    }
+
+    return generated;
+}
+
+void Mesh::clear_lods() {
+    for(auto& lod: lods_) {
+        lod.reset();
+    }
+}
+
+std::size_t Mesh::memory_usage() const {
+    std::size_t total = (vertex_data_) ? vertex_data_->data_size() : 0;
+    for(auto& sm: submeshes_) {
+        if(sm->index_data_) {
+            total += sm->index_data_->data_size();
+        }
+    }
+
+    return total;
+}
+
+MeshOptimizeStats Mesh::optimize() {
+    MeshOptimizeStats stats;
+
+    uint32_t vertex_count = vertex_data_->count();
+    if(!vertex_count) {
+        return stats;
+    }
+
+    std::vector<Mesh*> meshes = {this};
+    for(auto& lod: lods_) {
+        if(lod) {
+            meshes.push_back(lod.get());
+        }
+    }
+
+    /* Loaders which write a vertex per face corner (like OBJ) produce
+     * ranged submeshes, which can't reuse anything. Index those over
+     * the first copy of each identical vertex */
+    std::vector<uint32_t> weld;
+    for(auto& sm: submeshes_) {
+        auto arrangement = sm->arrangement();
+        if(sm->type() != SUBMESH_TYPE_RANGED ||
+           (arrangement != MESH_ARRANGEMENT_TRIANGLES &&
+            arrangement != MESH_ARRANGEMENT_TRIANGLE_STRIP &&
+            arrangement != MESH_ARRANGEMENT_TRIANGLE_FAN)) {
+            continue;
+        }
+
+        if(weld.empty()) {
+            weld = utils::build_weld_remap(*vertex_data_);
+        }
+
+        std::vector<uint32_t> triangles;
+        sm->each_triangle([&](uint32_t a, uint32_t b, uint32_t c) {
+            triangles.push_back(weld[a]);
+            triangles.push_back(weld[b]);
+            triangles.push_back(weld[c]);
+        });
+
+        sm->_convert_to_indexed(
+            triangles,
+            (vertex_count > 65536) ? INDEX_TYPE_32_BIT : INDEX_TYPE_16_BIT
+        );
+    }
+
+    std::size_t triangle_count = 0;
+    float misses_before = 0.0f;
+    float misses_after = 0.0f;
+
+    for(auto mesh: meshes) {
+        for(auto& sm: mesh->submeshes_) {
+            if(sm->type() != SUBMESH_TYPE_INDEXED ||
+               sm->arrangement() != MESH_ARRANGEMENT_TRIANGLES) {
+                continue;
+            }
+
+            auto& index_data = sm->index_data_;
+            auto indices = index_data->all();
+            if(indices.size() < 3) {
+                continue;
+            }
+
+            const std::size_t count = indices.size();
+            const std::size_t triangles = count / 3;
+
+            float before = utils::calculate_acmr(&indices[0], count, vertex_count);
+
+            utils::optimize_vertex_cache(&indices[0], count, vertex_count);
+            utils::optimize_overdraw(&indices[0], count, *vertex_data_);
+
+            float after = utils::calculate_acmr(&indices[0], count, vertex_count);
+
+            /* Some exporters already do a better job, leave those be */
+            if(after < before) {
+                index_data->clear();
+                index_data->index(&indices[0], count);
+                index_data->done();
+            } else {
+                after = before;
+            }
+
+            if(mesh == this) {
+                misses_before += before * triangles;
+                misses_after += after * triangles;
+                triangle_count += triangles;
+            }
+        }
+    }
+
+    if(triangle_count) {
+        stats.acmr_before = misses_before / triangle_count;
+        stats.acmr_after = misses_after / triangle_count;
+    }
+
+    /* Reordering the vertices means rewriting every index which refers to
+     * them, so only do it if we can see all of those */
+    bool can_reorder = !is_animated() && !skeleton_ && !skin && !is_skinned &&
+        vertex_data_.use_count() == long(meshes.size());
+
+    std::vector<IndexData*> index_datas;
+    for(auto mesh: meshes) {
+        for(auto& sm: mesh->submeshes_) {
+            if(sm->type() != SUBMESH_TYPE_INDEXED) {
+                can_reorder = false;
+                break;
+            }
+
+            auto index_data = sm->index_data_.get();
+
+            /* Remapped indices could overflow a small index type */
+            if((index_data->index_type() == INDEX_TYPE_8_BIT && vertex_count > 256) ||
+               (index_data->index_type() == INDEX_TYPE_16_BIT && vertex_count > 65536)) {
+                can_reorder = false;
+                break;
+            }
+
+            if(std::find(index_datas.begin(), index_datas.end(), index_data) == index_datas.end()) {
+                index_datas.push_back(index_data);
+            }
+        }
+    }
+
+    if(can_reorder && !index_datas.empty()) {
+        std::vector<std::vector<uint32_t>> lists;
+        for(auto index_data: index_datas) {
+            lists.push_back(index_data->all());
+        }
+
+        uint32_t used = 0;
+        auto remap = utils::build_vertex_fetch_remap(lists, vertex_count, &used);
+
+        for(std::size_t i = 0; i < index_datas.size(); ++i) {
+            auto& list = lists[i];
+            for(auto& index: list) {
+                index = remap[index];
+            }
+
+            index_datas[i]->clear();
+            if(!list.empty()) {
+                index_datas[i]->index(&list[0], list.size());
+            }
+            index_datas[i]->done();
+        }
+
+        utils::remap_vertex_data(*vertex_data_, remap);
+
+        /* Anything unused (like the copies left behind by welding) is at
+         * the end now, and nothing refers to it */
+        if(used < vertex_count) {
+            vertex_data_->resize(used);
+        }
+
+        vertex_data_->done();
+
+        stats.vertices_reordered = true;
+    }
+
+    S_INFO(
+        "Optimized mesh {0}: ACMR {1} -> {2} over {3} triangles, {4} -> {5} vertices",
+        id(), stats.acmr_before, stats.acmr_after, triangle_count,
+        vertex_count, vertex_data_->count()
+    );
+
+    return stats;
+}
+
 }
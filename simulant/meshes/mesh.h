@@ -60,6 +60,11 @@ enum MeshAnimationType {
 
 typedef sig::signal<void (Mesh*, MeshAnimationType, uint32_t)> SignalAnimationEnabled;
 
+enum SkinningMode {
+    SKINNING_MODE_CPU,  /* Vertices are rewritten each frame by update_skinning() */
+    SKINNING_MODE_GPU   /* Only the joint palette is updated, the vertex shader does the rest */
+};
+
 
 /* When enabling animations you must pass MeshFrameData which holds all the data necessary to
  * produce a frame
@@ -94,6 +99,16 @@ public:
 
 typedef std::shared_ptr<FrameUnpacker> FrameUnpackerPtr;
 
+/* Returned by Mesh::optimize(). The ACMR (average cache miss ratio) is the
+ * number of vertices transformed per triangle, lower is better */
+struct MeshOptimizeStats {
+    float acmr_before = 0.0f;
+    float acmr_after = 0.0f;
+
+    /* False if the vertex data couldn't safely be reordered */
+    bool vertices_reordered = false;
+};
+
 
 class SubMeshIteratorPair {
 public:
@@ -296,6 +311,10 @@ public:
     optional<std::size_t> submesh_index(const SubMeshPtr& submesh) const;
 
     std::size_t submesh_count() const { return submeshes_.size(); }
+
+    /* The size of the vertex data and the index data of the submeshes. Any
+     * generated detail levels are meshes of their own. */
+    std::size_t memory_usage() const override;
     bool has_submesh(const std::string& name) const;
     SubMeshPtr find_submesh(const std::string& name) const;
     SubMeshPtr find_submesh_with_material(const MaterialPtr& mat) const;
@@ -314,6 +333,21 @@ public:
 
     void update_skinning(); ///< Run the animation skinning logic on the mesh
 
+    /* GPU skinning requires a renderer which supports it, and a material
+     * which uses a skinning shader (e.g. Material::BuiltIns::SKINNED).
+     * If the renderer can't handle the number of joints in the skin then
+     * the mesh falls back to CPU skinning. */
+    void set_skinning_mode(SkinningMode mode) { skinning_mode_ = mode; }
+    SkinningMode skinning_mode() const { return skinning_mode_; }
+
+    /* Returns true if the last call to update_skinning() left the vertices
+     * in the rest pose and expects the renderer to apply the palette */
+    bool is_gpu_skinned() const { return gpu_skinned_; }
+
+    /* The per-joint matrices calculated by the last update_skinning() */
+    const Mat4* joint_palette() const { return joint_palette_.data(); }
+    std::size_t joint_palette_size() const { return joint_palette_.size(); }
+
     const AABB& aabb() const;
     void normalize(); //Scales the mesh so it has a radius of 1.0
     void transform_vertices(const smlt::Mat4& transform);
@@ -330,6 +364,36 @@ public:
     void generate_adjacency_info();
     bool has_adjacency_info() const { return bool(adjacency_); }
 
+    /* Generates simplified versions of this mesh for the detail levels
+     * beyond DETAIL_LEVEL_NEAREST, each with roughly `ratio` times the
+     * triangles of the level before. They share this mesh's vertex data
+     * and materials, only the indices differ. Generation stops early once
+     * the mesh won't simplify any further.
+     *
+     * Actors fall back to these for any detail level they haven't been
+     * given a mesh for, so generate them before assigning the mesh. They
+     * aren't kept up to date if the mesh changes afterwards, and animated
+     * meshes are skipped.
+     *
+     * Returns the number of levels generated. */
+    std::size_t generate_lods(float ratio=0.5f);
+    void clear_lods();
+
+    /* Reorders the indexed triangle submeshes (and any generated detail
+     * levels) to make better use of the post-transform vertex cache and
+     * to reduce overdraw, then puts the vertex data in the order it's
+     * first used. What's drawn doesn't change.
+     *
+     * The vertex data is left alone if anything else might depend on its
+     * order: animation, skinning, ranged submeshes, or other meshes
+     * sharing it. */
+    MeshOptimizeStats optimize();
+
+    /* The generated mesh for this detail level, or null if there isn't
+     * one. There never is for DETAIL_LEVEL_NEAREST, that's this mesh */
+    const MeshPtr& lod(DetailLevel level) const { return lods_[level]; }
+    bool has_lods() const { return bool(lods_[DETAIL_LEVEL_NEAR]); }
+
 public:
     // Signals
 
@@ -337,7 +401,10 @@ public:
     typedef sig::signal<void (AssetID, SubMeshPtr)> SubMeshCreatedCallback;
     typedef sig::signal<void (AssetID, SubMeshPtr)> SubMeshDestroyedCallback;
     typedef sig::signal<void (AssetID, SubMeshPtr, MaterialSlot, AssetID, AssetID)> SubMeshMaterialChangedCallback;
+    typedef sig::signal<void (const AABB&)> BoundsChangedSignal;
 
+    /* Fired when editing the vertices or indexes changes aabb() */
+    DEFINE_SIGNAL(BoundsChangedSignal, signal_bounds_changed);
     DEFINE_SIGNAL(SkeletonAddedSignal, signal_skeleton_added);
 
     SubMeshCreatedCallback& signal_submesh_created() { return signal_submesh_created_; }
@@ -352,6 +419,20 @@ private:
     std::vector<Vec3> rest_positions_;
     std::vector<Vec3> rest_normals_;
 
+    /* Joints and weights are unpacked once, with out of range joints
+     * zero-weighted, so the skinning kernels don't need to branch */
+    std::vector<uint16_t> skin_joints_;
+    std::vector<float> skin_weights_;
+    std::vector<Vec3> skinned_positions_;
+    std::vector<Vec3> skinned_normals_;
+    std::vector<Mat4, aligned_allocator<Mat4, 32>> joint_palette_;
+
+    SkinningMode skinning_mode_ = SKINNING_MODE_CPU;
+    bool gpu_skinned_ = false;
+
+    void prepare_skinning();
+    void restore_rest_pose();
+
     VertexDataPtr vertex_data_;
     MeshAnimationType animation_type_ = MESH_ANIMATION_TYPE_NONE;
     uint32_t animation_frames_ = 0;
@@ -366,6 +447,8 @@ private:
     void rebuild_aabb();
     AABB aabb_;
 
+    MeshPtr lods_[DETAIL_LEVEL_MAX];
+
     /* Automatically maintain adjacency info for submeshes or not */
     bool maintain_adjacency_info_ = true;
     std::unique_ptr<AdjacencyInfo> adjacency_;
@@ -0,0 +1,218 @@
+/* *   Copyright (c) 2011-2017 Luke Benstead https://simulant-engine.appspot.com
+ *
+ *     This file is part of Simulant.
+ *
+ *     Simulant is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     Simulant is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with Simulant.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "skinning.h"
+#include "../application.h"
+#include "../math/mat4.h"
+#include "../math/vec3.h"
+#include "../services/job_system.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SIMULANT_SKINNING_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMULANT_SKINNING_NEON 1
+#endif
+
+namespace smlt {
+
+static inline void write_vec3(uint8_t* out, float x, float y, float z) {
+    float* f = (float*) out;
+    f[0] = x;
+    f[1] = y;
+    f[2] = z;
+}
+
+#if defined(SIMULANT_SKINNING_SSE)
+
+void skin_vertex_range(const SkinningJob& job, uint32_t first, uint32_t count) {
+    const uint32_t last = first + count;
+
+    for(uint32_t i = first; i < last; ++i) {
+        const float* w = job.weights + (i * 4);
+        const uint16_t* j = job.joints + (i * 4);
+
+        /* Blend the columns of the (up to) 4 joint matrices */
+        __m128 c0 = _mm_setzero_ps();
+        __m128 c1 = _mm_setzero_ps();
+        __m128 c2 = _mm_setzero_ps();
+        __m128 c3 = _mm_setzero_ps();
+
+        for(int k = 0; k < 4; ++k) {
+            if(w[k] == 0.0f) {
+                continue;
+            }
+
+            const float* m = job.palette[j[k]].data();
+            const __m128 wk = _mm_set1_ps(w[k]);
+
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m + 0), wk));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), wk));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), wk));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), wk));
+        }
+
+        alignas(16) float out[4];
+
+        if(job.positions_out) {
+            const Vec3& p = job.rest_positions[i];
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)),
+                           _mm_mul_ps(c1, _mm_set1_ps(p.y))),
+                _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p.z)), c3));
+
+            _mm_store_ps(out, r);
+            write_vec3(job.positions_out + (i * job.positions_stride), out[0],
+                       out[1], out[2]);
+        }
+
+        if(job.normals_out) {
+            const Vec3& n = job.rest_normals[i];
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(n.x)),
+                           _mm_mul_ps(c1, _mm_set1_ps(n.y))),
+                _mm_mul_ps(c2, _mm_set1_ps(n.z)));
+
+            _mm_store_ps(out, r);
+            Vec3 normal = Vec3(out[0], out[1], out[2]).normalized();
+            write_vec3(job.normals_out + (i * job.normals_stride), normal.x,
+                       normal.y, normal.z);
+        }
+    }
+}
+
+#elif defined(SIMULANT_SKINNING_NEON)
+
+void skin_vertex_range(const SkinningJob& job, uint32_t first, uint32_t count) {
+    const uint32_t last = first + count;
+
+    for(uint32_t i = first; i < last; ++i) {
+        const float* w = job.weights + (i * 4);
+        const uint16_t* j = job.joints + (i * 4);
+
+        float32x4_t c0 = vdupq_n_f32(0.0f);
+        float32x4_t c1 = c0;
+        float32x4_t c2 = c0;
+        float32x4_t c3 = c0;
+
+        for(int k = 0; k < 4; ++k) {
+            if(w[k] == 0.0f) {
+                continue;
+            }
+
+            const float* m = job.palette[j[k]].data();
+
+            c0 = vmlaq_n_f32(c0, vld1q_f32(m + 0), w[k]);
+            c1 = vmlaq_n_f32(c1, vld1q_f32(m + 4), w[k]);
+            c2 = vmlaq_n_f32(c2, vld1q_f32(m + 8), w[k]);
+            c3 = vmlaq_n_f32(c3, vld1q_f32(m + 12), w[k]);
+        }
+
+        float out[4];
+
+        if(job.positions_out) {
+            const Vec3& p = job.rest_positions[i];
+            float32x4_t r = vmlaq_n_f32(c3, c0, p.x);
+            r = vmlaq_n_f32(r, c1, p.y);
+            r = vmlaq_n_f32(r, c2, p.z);
+
+            vst1q_f32(out, r);
+            write_vec3(job.positions_out + (i * job.positions_stride), out[0],
+                       out[1], out[2]);
+        }
+
+        if(job.normals_out) {
+            const Vec3& n = job.rest_normals[i];
+            float32x4_t r = vmulq_n_f32(c0, n.x);
+            r = vmlaq_n_f32(r, c1, n.y);
+            r = vmlaq_n_f32(r, c2, n.z);
+
+            vst1q_f32(out, r);
+            Vec3 normal = Vec3(out[0], out[1], out[2]).normalized();
+            write_vec3(job.normals_out + (i * job.normals_stride), normal.x,
+                       normal.y, normal.z);
+        }
+    }
+}
+
+#else
+
+void skin_vertex_range(const SkinningJob& job, uint32_t first, uint32_t count) {
+    const uint32_t last = first + count;
+
+    for(uint32_t i = first; i < last; ++i) {
+        const float* w = job.weights + (i * 4);
+        const uint16_t* j = job.joints + (i * 4);
+
+        // Starting from a clean 0 Mat4, NOT identity!
+        float c[16] = {0};
+
+        for(int k = 0; k < 4; ++k) {
+            const float wk = w[k];
+            if(wk == 0.0f) {
+                continue;
+            }
+
+            const float* m = job.palette[j[k]].data();
+            for(int e = 0; e < 16; ++e) {
+                c[e] += m[e] * wk;
+            }
+        }
+
+        if(job.positions_out) {
+            const Vec3& p = job.rest_positions[i];
+            write_vec3(job.positions_out + (i * job.positions_stride),
+                       p.x * c[0] + p.y * c[4] + p.z * c[8] + c[12],
+                       p.x * c[1] + p.y * c[5] + p.z * c[9] + c[13],
+                       p.x * c[2] + p.y * c[6] + p.z * c[10] + c[14]);
+        }
+
+        if(job.normals_out) {
+            const Vec3& n = job.rest_normals[i];
+            Vec3 normal = Vec3(n.x * c[0] + n.y * c[4] + n.z * c[8],
+                               n.x * c[1] + n.y * c[5] + n.z * c[9],
+                               n.x * c[2] + n.y * c[6] + n.z * c[10])
+                              .normalized();
+
+            write_vec3(job.normals_out + (i * job.normals_stride), normal.x,
+                       normal.y, normal.z);
+        }
+    }
+}
+
+#endif
+
+void run_skinning_job(const SkinningJob& job) {
+    auto app = get_app();
+    if(app && job.vertex_count >= SKINNING_PARALLEL_THRESHOLD) {
+        app->jobs->parallel_for(0, job.vertex_count, [&job](uint32_t first, uint32_t last) {
+            skin_vertex_range(job, first, last - first);
+        }, SKINNING_BATCH_SIZE, "skinning");
+        return;
+    }
+
+    skin_vertex_range(job, 0, job.vertex_count);
+}
+
+}
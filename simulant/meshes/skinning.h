@@ -0,0 +1,72 @@
+/* *   Copyright (c) 2011-2017 Luke Benstead https://simulant-engine.appspot.com
+ *
+ *     This file is part of Simulant.
+ *
+ *     Simulant is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     Simulant is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with Simulant.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace smlt {
+
+struct Mat4;
+struct Vec3;
+
+/* Number of vertices handed to a worker at a time */
+const uint32_t SKINNING_BATCH_SIZE = 1024;
+
+/* Meshes with fewer vertices than this are always skinned on the
+ * calling thread, the handoff would cost more than it saves */
+const uint32_t SKINNING_PARALLEL_THRESHOLD = 4096;
+
+/*
+ * Everything needed to skin a range of vertices.
+ *
+ * The joints and weights are expected to be prepared ahead of time
+ * (see Mesh::update_skinning) so the kernel doesn't branch on attribute
+ * formats: there are always 4 joints and 4 weights per vertex, and every
+ * joint indexes into the palette.
+ */
+struct SkinningJob {
+    /* One matrix per joint, already combined with the inverse bind matrix */
+    const Mat4* palette = nullptr;
+
+    const Vec3* rest_positions = nullptr;
+    const Vec3* rest_normals = nullptr;
+
+    const uint16_t* joints = nullptr;
+    const float* weights = nullptr;
+
+    /* Outputs are written as 3 floats every stride bytes. If either is
+     * null then that attribute isn't written. */
+    uint8_t* positions_out = nullptr;
+    uint32_t positions_stride = 0;
+
+    uint8_t* normals_out = nullptr;
+    uint32_t normals_stride = 0;
+
+    uint32_t vertex_count = 0;
+};
+
+/* Skins vertices [first, first + count) on the calling thread */
+void skin_vertex_range(const SkinningJob& job, uint32_t first, uint32_t count);
+
+/* Skins every vertex in the job. Large jobs are split into batches and
+ * spread over a pool of worker threads on platforms which have more
+ * than one core. Returns when every vertex has been written. */
+void run_skinning_job(const SkinningJob& job);
+
+}
@@ -44,6 +44,25 @@ SubMesh::~SubMesh() {
     parent_update_connection_.disconnect();
 }
 
+void SubMesh::_convert_to_indexed(const std::vector<uint32_t>& triangles, IndexType index_type) {
+    assert(type_ == SUBMESH_TYPE_RANGED);
+
+    index_data_ = std::make_shared<IndexData>(index_type);
+    parent_update_connection_ = index_data_->signal_update_complete().connect(
+        std::bind(&Mesh::submesh_index_data_updated, parent_, this)
+    );
+
+    type_ = SUBMESH_TYPE_INDEXED;
+    arrangement_ = MESH_ARRANGEMENT_TRIANGLES;
+    vertex_ranges_.clear();
+
+    if(!triangles.empty()) {
+        index_data_->index((uint32_t*) &triangles[0], triangles.size());
+    }
+
+    index_data_->done();
+}
+
 SubmeshType SubMesh::type() const {
     return type_;
 }
@@ -171,6 +190,18 @@ void SubMesh::_recalc_bounds_ranged(AABB& bounds) {
                 if(pos->z > maxz) maxz = pos->z;
             }
         }
+    } else if(pos_attr == VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+        for(auto& range: vertex_ranges_) {
+            for(uint32_t i = range.start; i < range.start + range.count; ++i) {
+                auto pos = vdata->position_nd_at(i);
+                if(pos.x < minx) minx = pos.x;
+                if(pos.y < miny) miny = pos.y;
+                if(pos.z < minz) minz = pos.z;
+                if(pos.x > maxx) maxx = pos.x;
+                if(pos.y > maxy) maxy = pos.y;
+                if(pos.z > maxz) maxz = pos.z;
+            }
+        }
     } else {
         assert(pos_attr == VERTEX_ATTRIBUTE_4F);
 
@@ -231,6 +262,16 @@ void SubMesh::_recalc_bounds_indexed(AABB& bounds) {
             if(pos->y > maxy) maxy = pos->y;
             if(pos->z > maxz) maxz = pos->z;
         }
+    } else if(pos_attr == VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+        for(auto idx: *index_data_) {
+            auto pos = vdata->position_nd_at(idx);
+            if(pos.x < minx) minx = pos.x;
+            if(pos.y < miny) miny = pos.y;
+            if(pos.z < minz) minz = pos.z;
+            if(pos.x > maxx) maxx = pos.x;
+            if(pos.y > maxy) maxy = pos.y;
+            if(pos.z > maxz) maxz = pos.z;
+        }
     } else {
         assert(pos_attr == VERTEX_ATTRIBUTE_4F);
 
@@ -263,8 +304,8 @@ void SubMesh::_each_triangle_ranged(std::function<void (uint32_t, uint32_t, uint
                 cb(i, i + 1, i + 2);
             }
         } else if(arrangement_ == MESH_ARRANGEMENT_TRIANGLE_FAN) {
-            for(uint32_t i = range.start + 1; i < range.start + range.count; i += 2) {
-                cb(0, i, i + 1);
+            for(uint32_t i = range.start + 2; i < range.start + range.count; ++i) {
+                cb(range.start, i - 1, i);
             }
         } else if(arrangement_ == MESH_ARRANGEMENT_TRIANGLE_STRIP) {
             for(uint32_t i = range.start + 2; i < range.start + range.count; i++) {
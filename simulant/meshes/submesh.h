@@ -143,6 +143,9 @@ private:
     void _each_triangle_indexed(std::function<void (uint32_t, uint32_t, uint32_t)> cb);
     void _each_triangle_ranged(std::function<void (uint32_t, uint32_t, uint32_t)> cb);
 
+    /* Turns a ranged submesh into an indexed triangle list */
+    void _convert_to_indexed(const std::vector<uint32_t>& triangles, IndexType index_type);
+
     MaterialChangedCallback signal_material_changed_;
 
     bool contributes_to_edge_list_ = true;
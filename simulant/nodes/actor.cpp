@@ -35,6 +35,7 @@ Actor::Actor(Scene* owner) :
 
 Actor::~Actor() {
     mesh_skeleton_added_.disconnect();
+    mesh_bounds_changed_.disconnect();
     submesh_created_connection_.disconnect();
     submesh_destroyed_connection_.disconnect();
 }
@@ -87,6 +88,10 @@ void Actor::set_mesh(const MeshPtr& mesh, DetailLevel detail_level) {
             return;
         }
 
+        if(detail_level == DETAIL_LEVEL_NEAREST) {
+            mesh_bounds_changed_.disconnect();
+        }
+
         meshes_[detail_level].reset();
         interpolated_vertex_data_.reset();
         recalc_effective_meshes();
@@ -128,6 +133,12 @@ void Actor::set_mesh(const MeshPtr& mesh, DetailLevel detail_level) {
             meshes_[DETAIL_LEVEL_NEAREST]->signal_skeleton_added().connect(
                 std::bind(&Actor::add_rig, this, std::placeholders::_1));
 
+        /* Our bounds are the mesh's, so they change if it's edited */
+        mesh_bounds_changed_.disconnect();
+        mesh_bounds_changed_ =
+            meshes_[DETAIL_LEVEL_NEAREST]->signal_bounds_changed().connect(
+                [this](const AABB&) { mark_transformed_aabb_dirty(); });
+
         if(meshes_[DETAIL_LEVEL_NEAREST]->has_skeleton()) {
             add_rig(meshes_[DETAIL_LEVEL_NEAREST]->skeleton);
         } else {
@@ -297,6 +308,11 @@ void Actor::do_generate_renderables(batcher::RenderQueue* render_queue,
             submesh->material_at_slot(material_slot_, true).get();
         new_renderable.center = center;
 
+        if(mesh->is_gpu_skinned()) {
+            new_renderable.joint_palette = mesh->joint_palette();
+            new_renderable.joint_count = mesh->joint_palette_size();
+        }
+
         new_renderable.light_count = light_count;
         for(auto i = 0u; i < light_count; ++i) {
             new_renderable.lights_affecting_this_frame[i] = lights[i];
@@ -328,15 +344,19 @@ bool Actor::on_create(Params params) {
 }
 
 void Actor::recalc_effective_meshes() {
-    MeshPtr current = meshes_[0];
-    for(auto i = 0; i < DETAIL_LEVEL_MAX; ++i) {
-        effective_meshes_[i] = current;
+    /* Levels without a mesh of their own use the base mesh's generated
+     * detail levels if it has them, otherwise the nearest level below */
+    const MeshPtr& base = meshes_[DETAIL_LEVEL_NEAREST];
 
-        if(i < DETAIL_LEVEL_MAX - 1) {
-            if(meshes_[i + 1]) {
-                current = meshes_[i + 1];
-            }
+    MeshPtr current = base;
+    for(auto i = 0; i < DETAIL_LEVEL_MAX; ++i) {
+        if(meshes_[i]) {
+            current = meshes_[i];
+        } else if(base && base->lod((DetailLevel) i)) {
+            current = base->lod((DetailLevel) i);
         }
+
+        effective_meshes_[i] = current;
     }
 }
 
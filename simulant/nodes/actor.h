@@ -147,6 +147,7 @@ private:
     std::unique_ptr<Rig> rig_;
     void add_rig(const Skeleton* skeleton);
     sig::connection mesh_skeleton_added_;
+    sig::connection mesh_bounds_changed_;
 
 public:
     S_DEFINE_PROPERTY(animation_state, &Actor::animation_state_);
@@ -1,21 +1,44 @@
+#include <algorithm>
+
 #include "animation_controller.h"
 
 namespace smlt {
 
-std::pair<std::size_t, std::size_t>
-    AnimationData::find_times_indices(float t) const {
-    if(t < 0.0f) {
-        return std::make_pair(0u, 1u);
+/* How many keys the cursor will step over before giving up and doing
+ * a binary search. Playing forward at a sensible frame rate only ever
+ * moves one or two keys. */
+static const std::size_t MAX_CURSOR_STEPS = 4;
+
+KeyframeIndices find_keyframe_indices(const std::vector<float>& times, float t,
+                                      std::size_t& cursor) {
+    if(times.size() < 2) {
+        cursor = 0;
+        return std::make_pair(0u, 0u);
     }
 
-    for(std::size_t i = 0u; i < times_.size(); ++i) {
-        float time = times_[i];
-        if(time > t) {
-            return std::make_pair((i > 0) ? i - 1 : 0, i);
+    const std::size_t last = times.size() - 2;
+
+    if(cursor <= last && times[cursor] <= t) {
+        for(std::size_t i = 0; i < MAX_CURSOR_STEPS; ++i) {
+            if(cursor == last || t < times[cursor + 1]) {
+                return std::make_pair(cursor, cursor + 1);
+            }
+
+            ++cursor;
         }
     }
 
-    return std::make_pair(times_.size() - 2, times_.size() - 1);
+    /* We've seeked, looped, or jumped a long way forward */
+    auto it = std::upper_bound(times.begin(), times.end(), t);
+    std::size_t i = std::distance(times.begin(), it);
+    cursor = (i > 0) ? std::min(i - 1, last) : 0;
+
+    return std::make_pair(cursor, cursor + 1);
+}
+
+KeyframeIndices AnimationData::find_times_indices(float t) const {
+    std::size_t cursor = 0;
+    return find_keyframe_indices(*times_, t, cursor);
 }
 
 } // namespace smlt
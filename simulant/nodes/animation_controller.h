@@ -39,8 +39,9 @@ private:
     T t1;
 };
 
-/* This does a transformation element by element so as not to increase
- * ram usage. */
+/* Flattens the input into scalars, releasing the input as soon as it's
+ * been copied. (Erasing element by element from the front didn't save any
+ * memory, as vectors don't shrink, and was quadratic in the key count) */
 template<typename T>
 inline void transform_to_scalars(std::vector<T>&& input,
                                  std::vector<float>& output);
@@ -48,24 +49,28 @@ inline void transform_to_scalars(std::vector<T>&& input,
 template<>
 inline void transform_to_scalars<Vec3>(std::vector<Vec3>&& input,
                                        std::vector<float>& output) {
-    while(!input.empty()) {
-        output.push_back(input[0].x);
-        output.push_back(input[0].y);
-        output.push_back(input[0].z);
-        input.erase(input.begin());
+    output.reserve(output.size() + input.size() * 3);
+    for(auto& v: input) {
+        output.push_back(v.x);
+        output.push_back(v.y);
+        output.push_back(v.z);
     }
+
+    std::vector<Vec3>().swap(input);
 }
 
 template<>
 inline void transform_to_scalars<Quaternion>(std::vector<Quaternion>&& input,
                                              std::vector<float>& output) {
-    while(!input.empty()) {
-        output.push_back(input[0].x);
-        output.push_back(input[0].y);
-        output.push_back(input[0].z);
-        output.push_back(input[0].w);
-        input.erase(input.begin());
+    output.reserve(output.size() + input.size() * 4);
+    for(auto& q: input) {
+        output.push_back(q.x);
+        output.push_back(q.y);
+        output.push_back(q.z);
+        output.push_back(q.w);
     }
+
+    std::vector<Quaternion>().swap(input);
 }
 
 template<>
@@ -74,16 +79,44 @@ inline void transform_to_scalars<float>(std::vector<float>&& input,
     output = std::move(input);
 }
 
+typedef std::shared_ptr<const std::vector<float>> AnimationTimesPtr;
+
+/* Pair of key indices which surround a time, see find_keyframe_indices */
+typedef std::pair<std::size_t, std::size_t> KeyframeIndices;
+
+/**
+ * @brief find_keyframe_indices
+ *
+ * Returns the indices (i, i + 1) of the keys either side of `t` so that
+ * times[i] <= t < times[i + 1]. Times outside the range are clamped to
+ * the first or last pair of keys. If there's only a single key then (0, 0)
+ * is returned.
+ *
+ * `cursor` should be kept between calls for the same times. When `t` is
+ * moving forwards (the normal case during playback) the cursor is just
+ * stepped along, otherwise (seeks, loops) it falls back to a binary
+ * search. The cursor is updated to the first index of the result.
+ */
+KeyframeIndices find_keyframe_indices(const std::vector<float>& times, float t,
+                                      std::size_t& cursor);
+
 class AnimationData {
 public:
     template<typename T>
     AnimationData(const std::vector<float>& times, std::vector<T>&& output) :
+        AnimationData(std::make_shared<const std::vector<float>>(times),
+                      std::move(output)) {}
+
+    /* Channels which use the same sampler input should share the times
+     * so the AnimationController only needs to look them up once */
+    template<typename T>
+    AnimationData(AnimationTimesPtr times, std::vector<T>&& output) :
         times_(times) {
 
         transform_to_scalars<T>(std::move(output), output_);
 
-        max_time_ = *std::max_element(times.begin(), times.end());
-        min_time_ = *std::min_element(times.begin(), times.end());
+        max_time_ = *std::max_element(times_->begin(), times_->end());
+        min_time_ = *std::min_element(times_->begin(), times_->end());
     }
 
     float max_time() const {
@@ -94,28 +127,45 @@ public:
         return min_time_;
     }
 
+    const AnimationTimesPtr& times() const {
+        return times_;
+    }
+
     /**
      * @brief find_times_indices
      *
      * Given a global time `t` this returns the indices of the
-     * times before and after. If `t` is less than 0, then 0,0 is returned
-     * and if `t` is greater than the max time, then (max,max)
-     * is returned.
+     * times before and after. If `t` is less than the first time, then
+     * (0, 1) is returned and if `t` is greater than the max time, then
+     * (max - 1, max) is returned.
      * @param t
      * @return The pair of time indices.
      */
-    std::pair<std::size_t, std::size_t> find_times_indices(float t) const;
+    KeyframeIndices find_times_indices(float t) const;
+
+    /* As above, but starting the search from a playback cursor */
+    KeyframeIndices find_times_indices(float t, std::size_t& cursor) const {
+        return find_keyframe_indices(*times_, t, cursor);
+    }
 
     template<typename T>
     T interpolated_value(AnimationInterpolation i, float t) {
-        t = clamp(t, times_[0], times_.back());
+        return interpolated_value<T>(i, t, find_times_indices(t));
+    }
+
+    /* Interpolates between keys that have already been found, either with
+     * find_times_indices or from another channel with the same times */
+    template<typename T>
+    T interpolated_value(AnimationInterpolation i, float t,
+                         const KeyframeIndices& indexes) {
+        const auto& times = *times_;
+        t = clamp(t, times[0], times.back());
 
-        auto indexes = find_times_indices(t);
         auto t0 = *(((const T*)&output_[0]) + indexes.first);
         auto t1 = *(((const T*)&output_[0]) + indexes.second);
 
-        auto nt = (t - times_[indexes.first]) /
-                  (times_[indexes.second] - times_[indexes.first]);
+        auto span = times[indexes.second] - times[indexes.first];
+        auto nt = (span > 0.0f) ? (t - times[indexes.first]) / span : 0.0f;
 
         // FIXME: Only linear interpolation atm
         _S_UNUSED(i);
@@ -130,7 +180,7 @@ private:
     float max_time_ = 0.0f;
     float min_time_ = 0.0f;
 
-    std::vector<float> times_;
+    AnimationTimesPtr times_;
     std::vector<float> output_;
 };
 
@@ -141,11 +191,17 @@ struct Channel {
     AnimationInterpolation interpolation;
     AnimationDataPtr data;
     AnimationPath path;
+
+    /* Index into Animation::timelines, set by push_animation */
+    std::size_t timeline = 0;
 };
 
 struct Animation {
     LimitedString<64> name;
     std::vector<Channel> channels;
+
+    /* The distinct sets of key times used by the channels */
+    std::vector<AnimationTimesPtr> timelines;
 };
 
 enum AnimationState {
@@ -232,6 +288,16 @@ public:
         time_ += dt * animation_speed_;
 
         auto& anim = animations_[current_animation_];
+
+        /* Find the keys once per set of times, rather than once per
+         * channel. The cursors make this O(1) while playing forwards. */
+        timeline_cursors_.resize(anim.timelines.size(), 0);
+        timeline_keys_.resize(anim.timelines.size());
+        for(std::size_t i = 0; i < anim.timelines.size(); ++i) {
+            timeline_keys_[i] = find_keyframe_indices(
+                *anim.timelines[i], time_, timeline_cursors_[i]);
+        }
+
         int unfinished = 0;
         for(auto& channel: anim.channels) {
             if(!channel.target) {
@@ -239,18 +305,19 @@ public:
             }
 
             auto& data = channel.data;
+            auto& keys = timeline_keys_[channel.timeline];
 
             if(channel.path == ANIMATION_PATH_TRANSLATION) {
                 auto interp = data->interpolated_value<Vec3>(
-                    channel.interpolation, time_);
+                    channel.interpolation, time_, keys);
                 channel.target->transform->set_translation(interp);
             } else if(channel.path == ANIMATION_PATH_ROTATION) {
                 auto interp = data->interpolated_value<Quaternion>(
-                    channel.interpolation, time_);
+                    channel.interpolation, time_, keys);
                 channel.target->transform->set_rotation(interp);
             } else if(channel.path == ANIMATION_PATH_SCALE) {
                 auto interp = data->interpolated_value<Vec3>(
-                    channel.interpolation, time_);
+                    channel.interpolation, time_, keys);
                 channel.target->transform->set_scale_factor(interp);
             } else if(channel.path == ANIMATION_PATH_WEIGHTS) {
                 S_WARN_ONCE("Animation of weights is not yet implemented");
@@ -290,6 +357,18 @@ public:
 
     void push_animation(const Animation& a) {
         animations_.push_back(a);
+
+        /* Group the channels by their key times */
+        auto& anim = animations_.back();
+        anim.timelines.clear();
+        for(auto& channel: anim.channels) {
+            auto& times = channel.data->times();
+            auto it = std::find(anim.timelines.begin(), anim.timelines.end(), times);
+            channel.timeline = std::distance(anim.timelines.begin(), it);
+            if(it == anim.timelines.end()) {
+                anim.timelines.push_back(times);
+            }
+        }
     }
 
     std::vector<std::string> animation_names() const {
@@ -328,6 +407,9 @@ private:
     int32_t loop_count_ = 1;
     std::vector<MeshPtr> target_meshes_;
 
+    std::vector<std::size_t> timeline_cursors_;
+    std::vector<KeyframeIndices> timeline_keys_;
+
     // By default, at 1.0f, but to be able to override animation speed at runtime
     float animation_speed_ = 1.0f;
 };
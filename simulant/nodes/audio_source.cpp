@@ -2,12 +2,34 @@
 #include "audio_source.h"
 #include "../application.h"
 #include "../time_keeper.h"
+#include "../threads/condition.h"
 #include "simulant/utils/params.h"
 
 namespace smlt {
 
-static thread::Mutex ACTIVE_SOURCES_MUTEX;
-static std::list<AudioSource*> ACTIVE_SOURCES;
+/* Sources are registered with the audio thread by pushing onto
+ * PENDING_SOURCES. That lock is only ever held for a push or a swap, the
+ * audio thread never holds it while updating, uploading or decoding.
+ *
+ * Each source gets an AudioSourceEntry which outlives it. The audio thread
+ * only holds the entry's lock to update positions and gather the playing
+ * sounds, refilling buffers happens with no source lock held. on_destroy
+ * clears the entry's source pointer and hands over its playing sounds,
+ * the audio thread stops them and drops the entry the next time it sees
+ * it. */
+struct AudioSourceEntry {
+    thread::Mutex mutex;
+    AudioSource* source = nullptr;
+    std::list<PlayingSound::ptr> orphans;
+};
+
+static thread::Mutex PENDING_SOURCES_MUTEX;
+static std::vector<std::shared_ptr<AudioSourceEntry>> PENDING_SOURCES;
+
+static thread::Mutex AUDIO_THREAD_MUTEX;
+static thread::Condition AUDIO_THREAD_WAKE;
+static bool AUDIO_THREAD_STOP = false;
+static bool AUDIO_THREAD_KICK = false;
 static std::shared_ptr<thread::Thread> SOURCE_UPDATE_THREAD;
 
 AudioSource::~AudioSource() {
@@ -21,72 +43,168 @@ bool AudioSource::on_create(Params params) {
 
     _S_UNUSED(params);
 
-    thread::Lock<thread::Mutex> glock(ACTIVE_SOURCES_MUTEX);
+    {
+        thread::Lock<thread::Mutex> lock(AUDIO_THREAD_MUTEX);
+
+        /* Start the source update thread if we didn't already */
+        if(!SOURCE_UPDATE_THREAD) {
+            AUDIO_THREAD_STOP = false;
+            SOURCE_UPDATE_THREAD =
+                std::make_shared<thread::Thread>(&source_update_thread);
+
+            /* When the app shuts down, wake the thread and wait for it
+             * to finish before continuing with the shutdown process */
+            get_app()->signal_shutdown().connect([&]() {
+                {
+                    thread::Lock<thread::Mutex> lock(AUDIO_THREAD_MUTEX);
+                    AUDIO_THREAD_STOP = true;
+                }
+
+                AUDIO_THREAD_WAKE.notify_all();
+                SOURCE_UPDATE_THREAD->join();
+                SOURCE_UPDATE_THREAD.reset();
+            });
+        }
+    }
 
-    /* Start the source update thread if we didn't already */
-    if(!SOURCE_UPDATE_THREAD) {
-        SOURCE_UPDATE_THREAD =
-            std::make_shared<thread::Thread>(&source_update_thread);
+    entry_ = std::make_shared<AudioSourceEntry>();
+    entry_->source = this;
 
-        /* When the app shuts down, wait for the thread to finish before
-         * continuing with the shutdown process */
-        get_app()->signal_shutdown().connect([&]() {
-            SOURCE_UPDATE_THREAD->join();
-            SOURCE_UPDATE_THREAD.reset();
-        });
+    {
+        thread::Lock<thread::Mutex> lock(PENDING_SOURCES_MUTEX);
+        PENDING_SOURCES.push_back(entry_);
     }
 
-    ACTIVE_SOURCES.push_back(this);
-
     return StageNode::on_create(params);
 }
 
 bool AudioSource::on_destroy() {
-    /* If the source is destroyed we should stop all playing instances
-     * immediately */
-    thread::Lock<thread::Mutex> glock(ACTIVE_SOURCES_MUTEX);
-    ACTIVE_SOURCES.remove(this);
-
-    thread::Lock<thread::Mutex> lock(mutex_);
-    auto driver = get_app() ? get_app()->sound_driver.get() : nullptr;
+    /* Once the entry is cleared the audio thread won't touch this source
+     * again. The entry lock is only held briefly by the audio thread, so
+     * this doesn't wait for buffers to be refilled. */
+    if(entry_) {
+        thread::Lock<thread::Mutex> elock(entry_->mutex);
+        entry_->source = nullptr;
+
+        thread::Lock<thread::Mutex> lock(mutex_);
+        entry_->orphans.swap(instances_);
+    }
 
-    if(driver) {
-        for(auto& instance: instances_) {
-            driver->stop_source(instance->source_);
-        }
+    /* The playing sounds might be mid-refill, so the audio thread stops
+     * them. Wake it rather than waiting for the next tick. */
+    {
+        thread::Lock<thread::Mutex> lock(AUDIO_THREAD_MUTEX);
+        AUDIO_THREAD_KICK = true;
     }
 
+    AUDIO_THREAD_WAKE.notify_all();
+
     return true;
 }
 
 void AudioSource::source_update_thread() {
-    static auto update_rate = 1.0f / 20.0f;
-    static auto last_time = get_app()->time_keeper->now_in_us();
+    const uint64_t update_rate_us = 1000000 / 20;
+    uint64_t last_time = get_app()->time_keeper->now_in_us();
+
+    /* Only ever touched by this thread */
+    std::vector<std::shared_ptr<AudioSourceEntry>> sources;
+    std::vector<std::shared_ptr<AudioSourceEntry>> pending;
+    std::vector<PlayingSound::ptr> streaming;
+    std::vector<AudioSourceEntry*> owners;
 
     S_INFO("Starting source update thread");
 
     while(true) {
+        /* Sleep until the next update is due, or until we're told to stop */
+        {
+            thread::Lock<thread::Mutex> lock(AUDIO_THREAD_MUTEX);
+            while(!AUDIO_THREAD_STOP && !AUDIO_THREAD_KICK) {
+                auto elapsed = get_app()->time_keeper->now_in_us() - last_time;
+                if(elapsed >= update_rate_us) {
+                    break;
+                }
+
+                AUDIO_THREAD_WAKE.wait_for(AUDIO_THREAD_MUTEX,
+                                           update_rate_us - elapsed);
+            }
+
+            if(AUDIO_THREAD_STOP) {
+                break;
+            }
+
+            AUDIO_THREAD_KICK = false;
+        }
+
         if(get_app() && get_app()->is_shutting_down()) {
             break;
         }
 
         auto now = get_app()->time_keeper->now_in_us();
-        auto diff = now - last_time;
-        auto dt = float(diff) * 0.000001f;
+        auto dt = float(now - last_time) * 0.000001f;
+        last_time = now;
 
-        if(dt < update_rate) {
-            thread::yield();
-            continue;
+        {
+            thread::Lock<thread::Mutex> lock(PENDING_SOURCES_MUTEX);
+            std::swap(pending, PENDING_SOURCES);
         }
 
-        {
-            thread::Lock<thread::Mutex> glock(ACTIVE_SOURCES_MUTEX);
-            for(auto src: ACTIVE_SOURCES) {
-                src->update_source(dt * get_app()->time_keeper->time_scale());
+        sources.insert(sources.end(), pending.begin(), pending.end());
+        pending.clear();
+
+        const float scaled_dt = dt * get_app()->time_keeper->time_scale();
+
+        /* Update positions, this is all that happens with a source
+         * locked */
+        streaming.clear();
+        owners.clear();
+        for(auto& entry: sources) {
+            thread::Lock<thread::Mutex> lock(entry->mutex);
+            if(!entry->source) {
+                continue;
             }
+
+            entry->source->update_source(scaled_dt);
+            entry->source->gather_instances(streaming);
+            owners.resize(streaming.size(), entry.get());
         }
 
-        last_time = now;
+        /* Requeue buffers. This is cheap as long as decode_ahead has kept
+         * up. The entries outlive this loop even if their source is
+         * destroyed meanwhile. */
+        for(std::size_t i = 0; i < streaming.size(); ++i) {
+            if(!streaming[i]->update_buffers()) {
+                continue;
+            }
+
+            thread::Lock<thread::Mutex> lock(owners[i]->mutex);
+            if(owners[i]->source) {
+                owners[i]->source->signal_stream_finished_();
+            }
+        }
+
+        /* Stop whatever destroyed sources were playing, and forget them */
+        sources.erase(std::remove_if(sources.begin(), sources.end(),
+                                     [](const std::shared_ptr<AudioSourceEntry>& e) {
+            thread::Lock<thread::Mutex> lock(e->mutex);
+            if(e->source) {
+                return false;
+            }
+
+            for(auto& instance: e->orphans) {
+                instance->do_stop();
+            }
+
+            e->orphans.clear();
+            return true;
+        }), sources.end());
+
+        /* Then decode the next buffers with no source locks held */
+        for(auto& instance: streaming) {
+            instance->decode_ahead();
+        }
+
+        streaming.clear();
+        owners.clear();
     }
 
     S_INFO("Stopping audio thread");
@@ -142,11 +260,17 @@ void AudioSource::update_source(float dt) {
                                               std::placeholders::_1)),
                      instances_.end());
 
+    /* Buffers are refilled by the audio thread without the lock held */
     for(auto instance: instances_) {
-        instance->update(dt);
+        instance->update_position(dt);
     }
 }
 
+void AudioSource::gather_instances(std::vector<PlayingSound::ptr>& out) const {
+    thread::Lock<thread::Mutex> lock(mutex_);
+    out.insert(out.end(), instances_.begin(), instances_.end());
+}
+
 uint8_t AudioSource::playing_sound_count() const {
     thread::Lock<thread::Mutex> lock(mutex_);
 
@@ -5,6 +5,8 @@
 
 namespace smlt {
 
+struct AudioSourceEntry;
+
 typedef sig::signal<void(SoundPtr, AudioRepeat, DistanceModel)>
     SoundPlayedSignal;
 typedef sig::signal<void()> StreamFinishedSignal;
@@ -51,6 +53,9 @@ public:
     friend class PlayingSound;
 
     mutable thread::Mutex mutex_;
+    std::shared_ptr<AudioSourceEntry> entry_;
+
+    void gather_instances(std::vector<PlayingSound::ptr>& out) const;
     static void source_update_thread();
 };
 
@@ -25,18 +25,15 @@ Camera::Camera(Scene* owner) :
 
 Camera::~Camera() {}
 
-void Camera::on_transformation_changed() {
-    StageNode::on_transformation_changed();
-    update_frustum();
-}
-
-void Camera::update_frustum() {
+void Camera::update_frustum() const {
     // Recalculate the view matrix
     // view_matrix_ = Mat4::as_look_at(transform->position(),
     //                                 transform->position() +
     //                                     transform->orientation().forward(),
     //                                 transform->orientation().up());
 
+    frustum_version_ = transform->version();
+
     auto rot = smlt::Mat4::as_rotation(transform->orientation());
     auto irot = rot.inversed();
     auto trns = smlt::Mat4::as_translation(-transform->position());
@@ -49,6 +49,7 @@ public:
                                          const Vec3& win_point);
 
     const Mat4& view_matrix() const {
+        update_frustum_if_necessary();
         return view_matrix_;
     }
 
@@ -57,9 +58,11 @@ public:
     }
 
     Frustum& frustum() {
+        update_frustum_if_necessary();
         return frustum_;
     }
     const Frustum& frustum() const {
+        update_frustum_if_necessary();
         return frustum_;
     }
 
@@ -84,14 +87,21 @@ public:
 
 private:
     AABB bounds_;
-    Frustum frustum_;
 
-    Mat4 view_matrix_;
+    /* Rebuilt on access if the transform has moved since */
+    mutable Frustum frustum_;
+    mutable Mat4 view_matrix_;
+    mutable uint32_t frustum_version_ = 0;
+
     Mat4 projection_matrix_;
 
-    void update_frustum();
+    void update_frustum() const;
 
-    void on_transformation_changed() override;
+    void update_frustum_if_necessary() const {
+        if(transform->version() != frustum_version_) {
+            update_frustum();
+        }
+    }
 };
 
 class Camera2D: public Camera {
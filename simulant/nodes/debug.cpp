@@ -37,6 +37,9 @@ Debug::Debug(Scene* owner) :
         std::bind(&Debug::reset, this));
 
     set_render_priority(RENDER_PRIORITY_ABSOLUTE_FOREGROUND);
+
+    /* Lines can be drawn anywhere, we don't have meaningful bounds */
+    set_cullable(false);
 }
 
 Debug::~Debug() {
@@ -24,6 +24,8 @@
 #include "../nodes/light.h"
 #include "../nodes/particle_system.h"
 #include "../nodes/stage_node_iterators.h"
+#include "../nodes/stage_node_visitors.h"
+#include "../scenes/scene.h"
 #include "../stage.h"
 
 namespace smlt {
@@ -35,22 +37,23 @@ void FrustumCuller::do_generate_renderables(batcher::RenderQueue* render_queue,
                                             Light** lights,
                                             const std::size_t light_count) {
 
+    /* Subtree bounds are invalidated when moves are delivered */
+    scene->flush_transform_changes();
     _apply_writes();
 
-    auto& frustum = camera->frustum();
+    StageNodeVisitorFrustum visitor(this, camera->frustum(), [&](StageNode* node) -> bool {
+        if(node == this) {
+            return true;
+        }
 
-    for(StageNode& node: each_descendent()) {
-        /* Check that the node is supposed to
-         * be visible (otherwise we could end up doing work for nothing) */
-        if(node.is_visible() && !node.is_destroyed()) {
-            auto aabb = node.transformed_aabb();
+        node->generate_renderables(render_queue, camera, viewport,
+                                   detail_level, lights, light_count);
 
-            if(!node.is_cullable() || frustum.intersects_aabb(aabb)) {
-                node.generate_renderables(render_queue, camera, viewport,
-                                          detail_level, lights, light_count);
-            }
-        }
-    }
+        /* Nested partitioners look after their own descendents */
+        return !node->generates_renderables_for_descendents();
+    });
+
+    visitor.run();
 }
 
 void FrustumCuller::apply_staged_write(const StagedWrite& write) {
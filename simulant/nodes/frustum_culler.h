@@ -38,6 +38,12 @@ public:
         return aabb;
     }
 
+    /* We walk the descendents each frame, skipping any subtrees outside
+     * the frustum, so there's nothing to track */
+    bool tracks_stage_nodes() const override {
+        return false;
+    }
+
 private:
     bool on_create(Params) override {
         return true;
@@ -46,10 +46,12 @@ bool Geom::on_create(Params params) {
 
     if(opts.type == GEOM_CULLER_TYPE_QUADTREE) {
         culler_.reset(
-            new QuadtreeCuller(this, mesh_ptr, opts.quadtree_max_depth));
+            new QuadtreeCuller(this, mesh_ptr, opts.quadtree_max_depth,
+                               opts.merge_index_buffers));
     } else {
         assert(opts.type == GEOM_CULLER_TYPE_OCTREE);
-        culler_.reset(new OctreeCuller(this, mesh_ptr, opts.octree_max_depth));
+        culler_.reset(new OctreeCuller(this, mesh_ptr, opts.octree_max_depth,
+                                       opts.merge_index_buffers));
     }
 
     /* FIXME: Transform and recalc */
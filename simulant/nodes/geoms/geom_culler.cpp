@@ -1,4 +1,8 @@
+#include <limits>
+
 #include "geom_culler.h"
+#include "../geom.h"
+#include "../../vertex_data.h"
 #include "../../meshes/mesh.h"
 #include "../../asset_manager.h"
 #include "../../renderers/batching/render_queue.h"
@@ -41,4 +45,79 @@ void GeomCuller::compile(const Vec3 &pos, const Quaternion &rot, const Vec3& sca
 void GeomCuller::renderables_visible(const Frustum& frustum, batcher::RenderQueue* render_queue) {
     _gather_renderables(frustum, render_queue);
 }
+
+IndexType GeomCuller::index_type_for(const MeshPtr& mesh) {
+    auto count = mesh->vertex_data->count();
+    if(count >= std::numeric_limits<uint16_t>::max()) {
+        return INDEX_TYPE_32_BIT;
+    } else if(count >= std::numeric_limits<uint8_t>::max()) {
+        return INDEX_TYPE_16_BIT;
+    }
+
+    return INDEX_TYPE_8_BIT;
+}
+
+void GeomCuller::insert_renderable(batcher::RenderQueue* render_queue,
+                                   const VertexData* vertices,
+                                   const IndexData* indexes, Material* material,
+                                   std::size_t offset, std::size_t count) {
+    Renderable new_renderable;
+
+    new_renderable.arrangement = smlt::MESH_ARRANGEMENT_TRIANGLES;
+    new_renderable.final_transformation = Mat4();
+    new_renderable.index_data = indexes;
+    new_renderable.index_offset = offset;
+    new_renderable.index_element_count = count;
+    new_renderable.vertex_data = vertices;
+    new_renderable.render_priority = geom()->render_priority();
+    new_renderable.is_visible = geom()->is_visible();
+    new_renderable.material = material;
+
+    render_queue->insert_renderable(std::move(new_renderable));
+}
+
+MergedIndexBuffers::Range MergedIndexBuffers::append(Material* material, const std::vector<uint32_t>& indexes) {
+    uint32_t i = 0;
+    for(; i < buffers_.size(); ++i) {
+        if(buffers_[i].material == material) {
+            break;
+        }
+    }
+
+    if(i == buffers_.size()) {
+        Buffer buffer;
+        buffer.material = material;
+        buffer.indexes = std::make_shared<IndexData>(index_type_);
+        buffers_.push_back(buffer);
+    }
+
+    auto& data = *buffers_[i].indexes;
+
+    Range range;
+    range.buffer = i;
+    range.start = data.count();
+    range.count = (uint32_t) indexes.size();
+
+    if(!indexes.empty()) {
+        data.index((uint32_t*) &indexes[0], indexes.size());
+    }
+
+    return range;
+}
+
+void MergedIndexBuffers::done() {
+    for(auto& buffer: buffers_) {
+        buffer.indexes->done();
+    }
+}
+
+void MergedIndexBuffers::each_visible(const RangeCallback& cb) {
+    for(auto& buffer: buffers_) {
+        for(auto& range: buffer.visible) {
+            cb(buffer.material, buffer.indexes.get(), range);
+        }
+
+        buffer.visible.clear();
+    }
+}
 }
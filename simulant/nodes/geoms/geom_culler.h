@@ -13,6 +13,8 @@ class RenderQueue;
 }
 
 struct Renderable;
+class IndexData;
+class VertexData;
 
 /*
  * A GeomCuller is a class which compiles a mesh into some kind of internal representation
@@ -29,6 +31,61 @@ typedef std::function<void (Renderable*)> EachRenderableCallback;
 
 class Renderer;
 
+/*
+ * The triangles of each material laid out in one index buffer, in the order
+ * that a culler traverses its tree. Each tree node keeps the ranges of its
+ * triangles, and when a frame's visible ranges are added any which follow
+ * on from the previous range of the same material are merged, so that a
+ * visible subtree is a single draw.
+ */
+class MergedIndexBuffers {
+public:
+    struct Range {
+        uint32_t buffer = 0;
+        uint32_t start = 0;
+        uint32_t count = 0;
+    };
+
+    typedef std::function<void (Material*, const IndexData*, const Range&)> RangeCallback;
+
+    MergedIndexBuffers(IndexType type):
+        index_type_(type) {}
+
+    /* Appends the indexes to the buffer for the material and returns
+     * where they were put */
+    Range append(Material* material, const std::vector<uint32_t>& indexes);
+
+    /* Finishes the index data once everything has been appended */
+    void done();
+
+    void add_visible(const Range& range) {
+        auto& visible = buffers_[range.buffer].visible;
+        if(!visible.empty() && visible.back().start + visible.back().count == range.start) {
+            visible.back().count += range.count;
+        } else {
+            visible.push_back(range);
+        }
+    }
+
+    /* Calls the callback for each merged range added since the last
+     * call, then forgets them */
+    void each_visible(const RangeCallback& cb);
+
+    std::size_t buffer_count() const {
+        return buffers_.size();
+    }
+
+private:
+    struct Buffer {
+        Material* material = nullptr;
+        std::shared_ptr<IndexData> indexes;
+        std::vector<Range> visible;
+    };
+
+    IndexType index_type_;
+    std::vector<Buffer> buffers_;
+};
+
 class GeomCuller {
 public:
     GeomCuller(Geom* geom, const MeshPtr mesh);
@@ -44,6 +101,14 @@ protected:
     Geom* geom_ = nullptr;
     MeshPtr mesh_;
 
+    /* The smallest index type which can index all of the mesh's vertices */
+    static IndexType index_type_for(const MeshPtr& mesh);
+
+    void insert_renderable(batcher::RenderQueue* render_queue,
+                           const VertexData* vertices,
+                           const IndexData* indexes, Material* material,
+                           std::size_t offset, std::size_t count);
+
 private:
     bool compiled_ = false;
 
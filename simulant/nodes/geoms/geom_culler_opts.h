@@ -13,6 +13,12 @@ struct GeomCullerOptions {
     GeomCullerType type = GEOM_CULLER_TYPE_OCTREE;
     uint8_t octree_max_depth = 4;
     uint8_t quadtree_max_depth = 4;
+
+    /* If true, the triangles of each material are compiled into a single
+     * index buffer in tree order, and visible tree nodes whose triangles
+     * are next to each other are drawn together. Otherwise each visible
+     * node draws its own index buffer for each material. */
+    bool merge_index_buffers = false;
 };
 
 } // namespace smlt
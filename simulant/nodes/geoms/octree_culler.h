@@ -12,7 +12,7 @@ struct _OctreeCullerImpl;
 
 class OctreeCuller : public GeomCuller {
 public:
-    OctreeCuller(Geom* geom, const MeshPtr mesh, uint8_t max_depth);
+    OctreeCuller(Geom* geom, const MeshPtr mesh, uint8_t max_depth, bool merge_index_buffers=false);
 
     AABB octree_bounds() const;
 
@@ -25,6 +25,7 @@ private:
 
     IndexType index_type_ = INDEX_TYPE_16_BIT;
     uint8_t max_depth_;
+    bool merge_index_buffers_ = false;
 };
 
 }
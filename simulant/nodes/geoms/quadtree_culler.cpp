@@ -14,6 +14,9 @@ namespace smlt {
 
 struct CullerTreeData {
     std::unique_ptr<VertexData> vertices;
+
+    /* Only set when the index buffers are merged */
+    std::unique_ptr<MergedIndexBuffers> merged;
 };
 
 struct TriangleData {
@@ -24,8 +27,18 @@ struct TriangleData {
     IndexData::ptr indexes;
 };
 
+struct PendingTriangles {
+    Material* material = nullptr;
+    std::vector<uint32_t> indexes;
+};
+
 struct CullerNodeData {
     std::unordered_map<AssetID, TriangleData> triangles;
+
+    /* When the index buffers are merged, the node's triangles are gathered
+     * here while compiling and then replaced by their ranges */
+    std::unordered_map<AssetID, PendingTriangles> pending;
+    std::vector<MergedIndexBuffers::Range> ranges;
 };
 
 
@@ -36,28 +49,23 @@ struct _QuadtreeCullerImpl {
     std::shared_ptr<CullerQuadtree> quadtree;
 };
 
-QuadtreeCuller::QuadtreeCuller(Geom *geom, const MeshPtr mesh, uint8_t max_depth):
+QuadtreeCuller::QuadtreeCuller(Geom *geom, const MeshPtr mesh, uint8_t max_depth, bool merge_index_buffers):
     GeomCuller(geom, mesh),
     pimpl_(new _QuadtreeCullerImpl()),
-    max_depth_(max_depth) {
-
-    /* Find the size of index we need to store all indices */
-    IndexType type = INDEX_TYPE_8_BIT;
-    if(mesh->vertex_data->count() >= std::numeric_limits<uint8_t>::max()) {
-        type = INDEX_TYPE_16_BIT;
-    } else if(mesh->vertex_data->count() >= std::numeric_limits<uint16_t>::max()) {
-        type = INDEX_TYPE_32_BIT;
-    }
+    index_type_(index_type_for(mesh)),
+    max_depth_(max_depth),
+    merge_index_buffers_(merge_index_buffers) {
 
-    index_type_ = type;
 }
 
-void QuadtreeCuller::_compile(const Vec3& pos, const Quaternion& rot, const Vec3& scale) {
+void QuadtreeCuller::_compile(const Vec3 &pos, const Quaternion &rot, const Vec3 &scale) {
     auto data = std::make_shared<CullerTreeData>();
 
+    /* Copy the vertex data as the mesh will be released */
     data->vertices.reset(new VertexData(mesh_->vertex_data->vertex_specification()));
     mesh_->vertex_data->clone_into(*data->vertices);
 
+    /* Transform the vertices by the passed in transformation */
     Mat4 transform = Mat4::as_transform(pos, rot, scale);
     data->vertices->transform_by(transform);
 
@@ -76,12 +84,21 @@ void QuadtreeCuller::_compile(const Vec3& pos, const Quaternion& rot, const Vec3
 
             auto node = pimpl_->quadtree->find_destination_for_triangle(stash);
 
+            if(merge_index_buffers_) {
+                auto& pending = node->data->pending[material->id()];
+                pending.material = material.get();
+                pending.indexes.push_back(a);
+                pending.indexes.push_back(b);
+                pending.indexes.push_back(c);
+                return;
+            }
+
             auto it = node->data->triangles.find(material->id());
             if(it == node->data->triangles.end()) {
                 it = node->data->triangles.emplace(
                     material->id(),
-                    TriangleData(material.get(), std::make_shared<IndexData>(index_type_)
-                )).first;
+                    TriangleData(material.get(), std::make_shared<IndexData>(index_type_))
+                ).first;
             }
 
             auto& indexes = *it->second.indexes;
@@ -90,44 +107,78 @@ void QuadtreeCuller::_compile(const Vec3& pos, const Quaternion& rot, const Vec3
             indexes.index(c);
         });
     }
+
+    if(merge_index_buffers_) {
+        /* Lay the triangles out in the order the quadtree is traversed, so
+         * that the nodes of any subtree are next to each other */
+        data->merged.reset(new MergedIndexBuffers(index_type_));
+
+        pimpl_->quadtree->traverse([&](CullerQuadtree::Node* node) {
+            for(auto& p: node->data->pending) {
+                node->data->ranges.push_back(
+                    data->merged->append(p.second.material, p.second.indexes)
+                );
+            }
+
+            node->data->pending.clear();
+        });
+
+        data->merged->done();
+    }
 }
 
 void QuadtreeCuller::_gather_renderables(const Frustum &frustum, batcher::RenderQueue* render_queue) {
-    auto cb = [this, render_queue](CullerQuadtree::Node* node) {
+    auto vertices = pimpl_->quadtree->data()->vertices.get();
+
+    if(merge_index_buffers_) {
+        auto merged = pimpl_->quadtree->data()->merged.get();
+
+        pimpl_->quadtree->traverse_visible(frustum, [merged](CullerQuadtree::Node* node) {
+            for(auto& range: node->data->ranges) {
+                merged->add_visible(range);
+            }
+        });
+
+        merged->each_visible([&](Material* material, const IndexData* indexes, const MergedIndexBuffers::Range& range) {
+            insert_renderable(render_queue, vertices, indexes, material, range.start, range.count);
+        });
+
+        return;
+    }
+
+    auto cb = [&](CullerQuadtree::Node* node) {
         for(auto& p: node->data->triangles) {
-            Renderable new_renderable;
-
-            new_renderable.arrangement = smlt::MESH_ARRANGEMENT_TRIANGLES;
-            new_renderable.final_transformation = Mat4();
-            new_renderable.index_data = p.second.indexes.get();
-            new_renderable.vertex_data = pimpl_->quadtree->data()->vertices.get();
-            new_renderable.render_priority = this->geom()->render_priority();
-            new_renderable.index_element_count = new_renderable.index_data->count();
-            new_renderable.is_visible = this->geom()->is_visible();
-            new_renderable.material = p.second.material;
-
-            render_queue->insert_renderable(std::move(new_renderable));
+            auto indexes = p.second.indexes.get();
+            insert_renderable(render_queue, vertices, indexes, p.second.material, 0, indexes->count());
         }
     };
 
     pimpl_->quadtree->traverse_visible(frustum, cb);
 }
 
-void QuadtreeCuller::_all_renderables(batcher::RenderQueue* render_queue) {
-    auto cb = [this, render_queue](CullerQuadtree::Node* node) {
+void QuadtreeCuller::_all_renderables(batcher::RenderQueue* queue) {
+    auto vertices = pimpl_->quadtree->data()->vertices.get();
+
+    if(merge_index_buffers_) {
+        auto merged = pimpl_->quadtree->data()->merged.get();
+
+        pimpl_->quadtree->traverse([merged](CullerQuadtree::Node* node) {
+            for(auto& range: node->data->ranges) {
+                merged->add_visible(range);
+            }
+        });
+
+        merged->each_visible([&](Material* material, const IndexData* indexes, const MergedIndexBuffers::Range& range) {
+            insert_renderable(queue, vertices, indexes, material, range.start, range.count);
+        });
+
+        return;
+    }
+
+    auto cb = [&](CullerQuadtree::Node* node) {
         for(auto& p: node->data->triangles) {
-            Renderable new_renderable;
-
-            new_renderable.arrangement = smlt::MESH_ARRANGEMENT_TRIANGLES;
-            new_renderable.final_transformation = Mat4();
-            new_renderable.index_data = p.second.indexes.get();
-            new_renderable.vertex_data = pimpl_->quadtree->data()->vertices.get();
-            new_renderable.render_priority = this->geom()->render_priority();
-            new_renderable.index_element_count = new_renderable.index_data->count();
-            new_renderable.is_visible = this->geom()->is_visible();
-            new_renderable.material = p.second.material;
-
-            render_queue->insert_renderable(std::move(new_renderable));
+            auto indexes = p.second.indexes.get();
+            insert_renderable(queue, vertices, indexes, p.second.material, 0, indexes->count());
         }
     };
 
@@ -12,7 +12,7 @@ struct _QuadtreeCullerImpl;
 
 class QuadtreeCuller : public GeomCuller {
 public:
-    QuadtreeCuller(Geom* geom, const MeshPtr mesh, uint8_t max_depth);
+    QuadtreeCuller(Geom* geom, const MeshPtr mesh, uint8_t max_depth, bool merge_index_buffers=false);
 
     AABB Quadtree_bounds() const;
 
@@ -25,6 +25,7 @@ private:
 
     IndexType index_type_ = INDEX_TYPE_16_BIT;
     uint8_t max_depth_;
+    bool merge_index_buffers_ = false;
 };
 
 }
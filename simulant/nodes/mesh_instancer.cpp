@@ -1,6 +1,10 @@
 #include "mesh_instancer.h"
+#include "../application.h"
 #include "../meshes/mesh.h"
+#include "../renderers/renderer.h"
 #include "../stage.h"
+#include "../window.h"
+#include "camera.h"
 #include "simulant/types.h"
 #include "simulant/utils/params.h"
 
@@ -23,6 +27,7 @@ void MeshInstancer::set_mesh(MeshPtr mesh) {
     /* Recalc the local AABBs for the new mesh */
     for(auto& i: instances_) {
         i.second.recalc_aabb(mesh_);
+        i.second.recalc_abs_aabb(transform->world_space_matrix());
     }
 
     /* recalc as a whole */
@@ -40,6 +45,7 @@ MeshInstanceID MeshInstancer::create_mesh_instance(const Vec3& position,
     i.transformation = Mat4::as_transform(position, rotation, Vec3(1));
     i.abs_transformation = transform->world_space_matrix() * i.transformation;
     i.recalc_aabb(mesh_);
+    i.recalc_abs_aabb(transform->world_space_matrix());
 
     instances_.insert(std::make_pair(i.id, i));
 
@@ -102,15 +108,21 @@ bool MeshInstancer::on_create(Params params) {
     return StageNode::on_create(params);
 }
 
-void MeshInstancer::on_transformation_changed() {
-    StageNode::on_transformation_changed();
-
+void MeshInstancer::update_instances_if_necessary() {
     /* When the transformation changes, we need
      * to update all instances */
+    auto version = transform->version();
+    if(version == instances_version_) {
+        return;
+    }
+
+    instances_version_ = version;
 
+    const auto& world = transform->world_space_matrix();
     for(auto& instance: instances_) {
         instance.second.abs_transformation =
-            (transform->world_space_matrix() * instance.second.transformation);
+            (world * instance.second.transformation);
+        instance.second.recalc_abs_aabb(world);
     }
 }
 
@@ -126,9 +138,50 @@ void MeshInstancer::do_generate_renderables(batcher::RenderQueue* render_queue,
         return;
     }
 
-    _S_UNUSED(camera);
     _S_UNUSED(detail_level); // FIXME: Support detail levels like actors?
 
+    update_instances_if_necessary();
+
+    const Frustum* frustum = (camera && camera->frustum().initialized())
+                                 ? &camera->frustum()
+                                 : nullptr;
+
+    visible_instances_.clear();
+    AABB visible_bounds;
+
+    for(auto& mesh_instance: instances_) {
+        const MeshInstance& instance = mesh_instance.second;
+        if(!instance.is_visible) {
+            continue;
+        }
+
+        if(frustum && !frustum->intersects_aabb(instance.abs_aabb)) {
+            continue;
+        }
+
+        if(visible_instances_.empty()) {
+            visible_bounds = instance.abs_aabb;
+        } else {
+            visible_bounds.encapsulate(instance.abs_aabb);
+        }
+
+        visible_instances_.push_back(&instance);
+    }
+
+    if(visible_instances_.empty()) {
+        return;
+    }
+
+    auto& renderer = get_app()->window->renderer;
+    const bool use_instancing = renderer && renderer->supports_instancing();
+
+    if(use_instancing) {
+        visible_transformations_.clear();
+        for(auto instance: visible_instances_) {
+            visible_transformations_.push_back(instance->transformation);
+        }
+    }
+
     for(auto submesh: mesh_->each_submesh()) {
         Renderable new_renderable;
 
@@ -151,12 +204,23 @@ void MeshInstancer::do_generate_renderables(batcher::RenderQueue* render_queue,
         new_renderable.material =
             submesh->material_at_slot(MATERIAL_SLOT0, true).get();
 
-        for(auto& mesh_instance: instances_) {
+        if(use_instancing) {
+            /* One renderable for every visible instance, the instance
+             * transformations are relative to the instancer */
+            new_renderable.final_transformation =
+                transform->world_space_matrix();
+            new_renderable.center = visible_bounds.center();
+            new_renderable.instance_transformations =
+                visible_transformations_.data();
+            new_renderable.instance_count = visible_transformations_.size();
+            render_queue->insert_renderable(std::move(new_renderable));
+            continue;
+        }
+
+        for(auto instance: visible_instances_) {
             auto to_insert = new_renderable; // Create a copy
-            to_insert.final_transformation =
-                mesh_instance.second.abs_transformation;
-            to_insert.is_visible = mesh_instance.second.is_visible;
-            to_insert.center = mesh_instance.second.aabb.center();
+            to_insert.final_transformation = instance->abs_transformation;
+            to_insert.center = instance->abs_aabb.center();
             render_queue->insert_renderable(std::move(to_insert));
         }
     }
@@ -179,4 +243,13 @@ void MeshInstancer::MeshInstance::recalc_aabb(smlt::MeshPtr mesh) {
     aabb = AABB(corners.data(), corners.size());
 }
 
+void MeshInstancer::MeshInstance::recalc_abs_aabb(const Mat4& world) {
+    auto corners = aabb.corners();
+    for(auto& corner: corners) {
+        corner = corner.transformed_by(world);
+    }
+
+    abs_aabb = AABB(corners.data(), corners.size());
+}
+
 } // namespace smlt
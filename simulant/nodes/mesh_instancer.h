@@ -32,6 +32,11 @@ typedef std::size_t MeshInstanceID;
  *
  * The bounds of a MeshInstancer are the sum bounds of all its instances.
  *
+ * Instances outside the camera frustum are skipped each frame. If the
+ * renderer supports instancing, the remaining instances of each submesh
+ * are submitted as a single instanced renderable rather than one
+ * renderable per instance.
+ *
  * Spawning animated meshes is currently unsupported.
  */
 class MeshInstancer:
@@ -98,7 +103,10 @@ private:
 
     bool on_create(Params params) override;
 
-    void on_transformation_changed() override;
+    /* Instance transformations are brought up to date lazily, when
+     * renderables are generated */
+    void update_instances_if_necessary();
+    uint32_t instances_version_ = 0;
 
     struct MeshInstance {
         uint32_t id = 0;
@@ -106,15 +114,26 @@ private:
         Mat4 transformation;
         Mat4 abs_transformation;
         AABB aabb;
+        AABB abs_aabb;
 
         /* Recalc the aabb from the transformation */
         void recalc_aabb(MeshPtr mesh);
+
+        /* Recalc the abs_aabb from the aabb and the instancer's
+         * world space matrix */
+        void recalc_abs_aabb(const Mat4& world);
     };
 
     static uint32_t id_counter_;
 
     /* FIXME: Convert to ContiguousMap when it has erase... */
     std::unordered_map<uint32_t, MeshInstance> instances_;
+
+    /* Rebuilt each time renderables are generated. The transformations
+     * are referenced by the instanced renderables so must stay alive
+     * until the render queue has been traversed */
+    std::vector<const MeshInstance*> visible_instances_;
+    std::vector<Mat4> visible_transformations_;
 };
 
 } // namespace smlt
@@ -1,9 +1,13 @@
+#include <cstring>
+
 #include "particle_system.h"
 
+#include "../application.h"
 #include "../frustum.h"
 #include "../meshes/submesh.h"
 #include "../stage.h"
 #include "../types.h"
+#include "../window.h"
 #include "camera.h"
 
 namespace smlt {
@@ -23,6 +27,21 @@ const static VertexSpecification
 #endif
     );
 
+/* For GPU billboarding, each corner carries the particle centre and its
+ * size, signed to say which corner it is. When instanced, each particle
+ * has one of these with an unsigned size, and the shared quad has the
+ * signs. */
+const static VertexSpecification
+    PS_BILLBOARD_VERTEX_SPEC(smlt::VERTEX_ATTRIBUTE_3F, // Centre
+                             smlt::VERTEX_ATTRIBUTE_NONE,
+                             smlt::VERTEX_ATTRIBUTE_2F, // Signed size
+                             smlt::VERTEX_ATTRIBUTE_NONE, smlt::VERTEX_ATTRIBUTE_NONE,
+                             smlt::VERTEX_ATTRIBUTE_NONE, smlt::VERTEX_ATTRIBUTE_NONE,
+                             smlt::VERTEX_ATTRIBUTE_NONE, smlt::VERTEX_ATTRIBUTE_NONE,
+                             smlt::VERTEX_ATTRIBUTE_NONE,
+                             smlt::VERTEX_ATTRIBUTE_4UB_RGBA // Diffuse
+    );
+
 ParticleSystem::ParticleSystem(Scene* owner) :
     StageNode(owner, Meta::node_type),
     vertex_data_(new VertexData(PS_VERTEX_SPEC)) {}
@@ -122,18 +141,50 @@ void ParticleSystem::do_generate_renderables(batcher::RenderQueue* render_queue,
         return;
     }
 
-    /* Rebuild the vertex data with the current camera direction */
-    rebuild_vertex_data(camera->transform->up(), camera->transform->right());
+    auto& renderer = get_app()->window->renderer;
+    gpu_billboarded_ = script_->gpu_billboarding() && renderer &&
+                       renderer->supports_gpu_billboards();
 
     Renderable new_renderable;
-    new_renderable.arrangement = MESH_ARRANGEMENT_TRIANGLE_STRIP;
     new_renderable.render_priority = render_priority();
     new_renderable.final_transformation = Mat4();
-    new_renderable.index_data = nullptr;
-    new_renderable.index_element_count = 0;
-    new_renderable.vertex_range_count = vertex_ranges_.size();
-    new_renderable.vertex_ranges = vertex_ranges_.data();
-    new_renderable.vertex_data = vertex_data_;
+
+    if(gpu_billboarded_ && renderer->supports_instance_attributes()) {
+        /* One record per particle, the vertex shader expands the shared
+         * quad around each one and faces it towards the camera */
+        rebuild_billboard_data(true);
+
+        new_renderable.arrangement = MESH_ARRANGEMENT_TRIANGLE_STRIP;
+        new_renderable.index_data = nullptr;
+        new_renderable.index_element_count = 0;
+        new_renderable.vertex_range_count = 1;
+        new_renderable.vertex_ranges = &billboard_quad_range_;
+        new_renderable.vertex_data = billboard_quad_.get();
+        new_renderable.instance_data = billboard_vertex_data_.get();
+        new_renderable.instance_count = particle_count();
+    } else if(gpu_billboarded_) {
+        /* The vertex shader faces the particles towards the camera */
+        rebuild_billboard_data(false);
+
+        new_renderable.arrangement = MESH_ARRANGEMENT_TRIANGLES;
+        new_renderable.index_data = billboard_index_data_.get();
+        new_renderable.index_element_count = particle_count() * 6;
+        new_renderable.vertex_range_count = 0;
+        new_renderable.vertex_ranges = nullptr;
+        new_renderable.vertex_data = billboard_vertex_data_.get();
+    } else {
+        /* Rebuild the vertex data with the current camera direction */
+        rebuild_vertex_data(camera->transform->up(),
+                            camera->transform->right());
+
+        new_renderable.arrangement = MESH_ARRANGEMENT_TRIANGLE_STRIP;
+        new_renderable.index_data = nullptr;
+        new_renderable.index_element_count = 0;
+        new_renderable.vertex_range_count = vertex_ranges_.size();
+        new_renderable.vertex_ranges = vertex_ranges_.data();
+        new_renderable.vertex_data = vertex_data_;
+    }
+
     new_renderable.is_visible = true;
     new_renderable.material = script_->material().get();
     new_renderable.center = transformed_aabb().center();
@@ -148,53 +199,64 @@ void ParticleSystem::do_generate_renderables(batcher::RenderQueue* render_queue,
 
 void ParticleSystem::rebuild_vertex_data(const smlt::Vec3& up,
                                          const smlt::Vec3& right) {
-    vertex_data_->resize(particle_count_ * 4);
+    const auto count = particles_.size();
+
+    vertex_data_->resize(count * 4);
     vertex_data_->move_to_start();
 
-    vertex_ranges_.resize(0);
+    /* Each particle is its own tri-strip, so the ranges only change when
+     * the particle count does */
+    if(vertex_ranges_.size() != count) {
+        auto previous = vertex_ranges_.size();
+        vertex_ranges_.resize(count);
+        for(auto j = previous; j < count; ++j) {
+            vertex_ranges_[j].start = j * 4;
+            vertex_ranges_[j].count = 4;
+        }
+    }
 
-    if(!particle_count_) {
+    if(!count) {
         return;
     }
 
     const auto& spec = vertex_data_->vertex_specification();
+    const auto stride = spec.stride();
 
-    uint8_t* pos_ptr = vertex_data_->data();
-    uint8_t* dif_ptr = pos_ptr + spec.color_offset(false);
-    uint8_t* uv_ptr = pos_ptr + spec.texcoord0_offset(false);
+    uint8_t* data = vertex_data_->data();
 
-    auto stride = spec.stride();
+    EmitterOffsets offsets;
+    auto span = particles_.span();
 
-    for(auto j = 0u; j < particle_count_; ++j) {
-        auto& p = particles_[j];
+    expand_billboards(span, up, right, calc_emitter_offsets(offsets),
+                      data + spec.position_offset(false), stride);
 
-        const auto ppos =
-            (space_ == PARTICLE_SYSTEM_SPACE_WORLD)
-                ? p.position
-                : transform->position() +
-                      script_->emitter(p.emitter_index)->relative_position +
-                      p.position;
+    uint8_t* dif_ptr = data + spec.color_offset(false);
+    uint8_t* uv_ptr = data + spec.texcoord0_offset(false);
 
-        Vec3* pos = (Vec3*)pos_ptr;
-        float* uv = (float*)uv_ptr;
+    const static float uvs[4][2] = {
+        {0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}
+    };
 
+    for(auto j = 0u; j < count; ++j) {
 #ifdef __DREAMCAST__
-        uint8_t* dif = dif_ptr;
-        uint8_t a = smlt::clamp(p.color.a * 255.0f, 0, 255);
-        uint8_t r = smlt::clamp(p.color.r * 255.0f, 0, 255);
-        uint8_t g = smlt::clamp(p.color.g * 255.0f, 0, 255);
-        uint8_t b = smlt::clamp(p.color.b * 255.0f, 0, 255);
+        uint8_t a = smlt::clamp(span.a[j] * 255.0f, 0, 255);
+        uint8_t r = smlt::clamp(span.r[j] * 255.0f, 0, 255);
+        uint8_t g = smlt::clamp(span.g[j] * 255.0f, 0, 255);
+        uint8_t b = smlt::clamp(span.b[j] * 255.0f, 0, 255);
+
+        typedef uint8_t DiffuseType;
 
 #define RIDX 2
 #define GIDX 1
 #define BIDX 0
 #define AIDX 3
 #else
-        float* dif = (float*)dif_ptr;
-        float a = p.color.a;
-        float r = p.color.r;
-        float g = p.color.g;
-        float b = p.color.b;
+        float a = span.a[j];
+        float r = span.r[j];
+        float g = span.g[j];
+        float b = span.b[j];
+
+        typedef float DiffuseType;
 
 #define RIDX 0
 #define GIDX 1
@@ -202,86 +264,144 @@ void ParticleSystem::rebuild_vertex_data(const smlt::Vec3& up,
 #define AIDX 3
 #endif
 
-        *(pos) =
-            ppos + right * p.dimensions.x * -0.5f + up * p.dimensions.y * -0.5f;
+        for(auto k = 0u; k < 4; ++k) {
+            DiffuseType* dif = (DiffuseType*)dif_ptr;
+            float* uv = (float*)uv_ptr;
 
-        dif[BIDX] = b;
-        dif[GIDX] = g;
-        dif[RIDX] = r;
-        dif[AIDX] = a;
+            dif[BIDX] = b;
+            dif[GIDX] = g;
+            dif[RIDX] = r;
+            dif[AIDX] = a;
 
-        uv[0] = 0.0f;
-        uv[1] = 0.0f;
+            uv[0] = uvs[k][0];
+            uv[1] = uvs[k][1];
 
-        pos_ptr += stride;
-        dif_ptr += stride;
-        uv_ptr += stride;
+            dif_ptr += stride;
+            uv_ptr += stride;
+        }
+    }
 
-        pos = (Vec3*)pos_ptr;
-        dif = (decltype(dif))dif_ptr;
-        uv = (float*)uv_ptr;
+    vertex_data_->done();
+}
 
-        *(pos) =
-            ppos + right * p.dimensions.x * +0.5f + up * p.dimensions.y * -0.5f;
+const Vec3* ParticleSystem::calc_emitter_offsets(EmitterOffsets& offsets) const {
+    if(space_ != PARTICLE_SYSTEM_SPACE_LOCAL) {
+        return nullptr;
+    }
 
-        dif[BIDX] = b;
-        dif[GIDX] = g;
-        dif[RIDX] = r;
-        dif[AIDX] = a;
+    /* Local space particles are relative to their emitter */
+    for(auto e = 0u; e < script_->emitter_count(); ++e) {
+        offsets[e] =
+            transform->position() + script_->emitter(e)->relative_position;
+    }
+
+    return offsets.data();
+}
 
-        uv[0] = 1.0f;
-        uv[1] = 0.0f;
+void ParticleSystem::rebuild_billboard_data(bool instanced) {
+    if(!billboard_vertex_data_) {
+        billboard_vertex_data_.reset(new VertexData(PS_BILLBOARD_VERTEX_SPEC));
+        billboard_index_data_.reset(new IndexData(INDEX_TYPE_32_BIT));
+    }
 
-        pos_ptr += stride;
-        dif_ptr += stride;
-        uv_ptr += stride;
+    /* Same corner order as the CPU expanded tri-strips */
+    const static float signs[4][2] = {
+        {-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f}, {1.0f, 1.0f}
+    };
+
+    const static float instance_signs[1][2] = {
+        {1.0f, 1.0f}
+    };
+
+    if(instanced && !billboard_quad_) {
+        billboard_quad_.reset(new VertexData(PS_BILLBOARD_VERTEX_SPEC));
+        for(auto k = 0u; k < 4; ++k) {
+            billboard_quad_->position(0.0f, 0.0f, 0.0f);
+            billboard_quad_->tex_coord0(signs[k][0], signs[k][1]);
+            billboard_quad_->color(uint8_t(255), uint8_t(255), uint8_t(255), uint8_t(255));
+            billboard_quad_->move_next();
+        }
 
-        pos = (Vec3*)pos_ptr;
-        dif = (decltype(dif))dif_ptr;
-        uv = (float*)uv_ptr;
+        billboard_quad_->done();
+    }
 
-        *(pos) =
-            ppos + right * p.dimensions.x * -0.5f + up * p.dimensions.y * +0.5f;
+    /* The indices only depend on how many particles there's room for, so
+     * they're built once for the quota rather than every frame */
+    const uint32_t capacity = particles_.capacity();
+    if(!instanced && billboard_index_data_->count() != capacity * 6) {
+        std::vector<uint32_t> indices(capacity * 6);
+        for(uint32_t j = 0; j < capacity; ++j) {
+            uint32_t* idx = &indices[j * 6];
+            const uint32_t first = j * 4;
+
+            idx[0] = first;
+            idx[1] = first + 1;
+            idx[2] = first + 2;
+            idx[3] = first + 2;
+            idx[4] = first + 1;
+            idx[5] = first + 3;
+        }
 
-        dif[BIDX] = b;
-        dif[GIDX] = g;
-        dif[RIDX] = r;
-        dif[AIDX] = a;
+        billboard_index_data_->clear();
+        billboard_index_data_->index(indices.data(), indices.size());
+        billboard_index_data_->done();
+    }
 
-        uv[0] = 0.0f;
-        uv[1] = 1.0f;
+    const auto count = particles_.size();
+    const uint32_t corners = (instanced) ? 1 : 4;
+    const float (*corner_signs)[2] = (instanced) ? instance_signs : signs;
 
-        pos_ptr += stride;
-        dif_ptr += stride;
-        uv_ptr += stride;
+    billboard_vertex_data_->resize(count * corners);
+    billboard_vertex_data_->move_to_start();
 
-        pos = (Vec3*)pos_ptr;
-        dif = (decltype(dif))dif_ptr;
-        uv = (float*)uv_ptr;
+    if(!count) {
+        return;
+    }
 
-        *(pos) =
-            ppos + right * p.dimensions.x * +0.5f + up * p.dimensions.y * +0.5f;
+    const auto& spec = billboard_vertex_data_->vertex_specification();
+    const auto stride = spec.stride();
 
-        dif[BIDX] = b;
-        dif[GIDX] = g;
-        dif[RIDX] = r;
-        dif[AIDX] = a;
+    uint8_t* pos_ptr = billboard_vertex_data_->data() + spec.position_offset(false);
+    uint8_t* size_ptr = billboard_vertex_data_->data() + spec.texcoord0_offset(false);
+    uint8_t* dif_ptr = billboard_vertex_data_->data() + spec.color_offset(false);
 
-        uv[0] = 1.0f;
-        uv[1] = 1.0f;
+    EmitterOffsets offsets;
+    const Vec3* offsets_ptr = calc_emitter_offsets(offsets);
 
-        pos_ptr += stride;
-        dif_ptr += stride;
-        uv_ptr += stride;
+    auto span = particles_.span();
 
-        /* Add a vertex range for this tri-strip */
-        VertexRange new_range;
-        new_range.start = j * 4;
-        new_range.count = 4;
-        vertex_ranges_.push_back(new_range);
+    for(auto j = 0u; j < count; ++j) {
+        Vec3 centre(span.position_x[j], span.position_y[j], span.position_z[j]);
+        if(offsets_ptr) {
+            centre += offsets_ptr[span.emitter_index[j]];
+        }
+
+        const float w = span.width[j];
+        const float h = span.height[j];
+
+        const uint8_t rgba[4] = {
+            (uint8_t) smlt::clamp(span.r[j] * 255.0f, 0, 255),
+            (uint8_t) smlt::clamp(span.g[j] * 255.0f, 0, 255),
+            (uint8_t) smlt::clamp(span.b[j] * 255.0f, 0, 255),
+            (uint8_t) smlt::clamp(span.a[j] * 255.0f, 0, 255)
+        };
+
+        for(auto k = 0u; k < corners; ++k) {
+            *((Vec3*) pos_ptr) = centre;
+
+            float* size = (float*) size_ptr;
+            size[0] = corner_signs[k][0] * w;
+            size[1] = corner_signs[k][1] * h;
+
+            std::memcpy(dif_ptr, rgba, 4);
+
+            pos_ptr += stride;
+            size_ptr += stride;
+            dif_ptr += stride;
+        }
     }
 
-    vertex_data_->done();
+    billboard_vertex_data_->done();
 }
 
 void ParticleSystem::on_update(float dt) {
@@ -290,37 +410,22 @@ void ParticleSystem::on_update(float dt) {
         return;
     }
 
-    if(particles_.size() != script_->quota()) {
-        particles_.resize(script_->quota());
-        particles_.shrink_to_fit();
-        particle_count_ = std::min(particle_count_, particles_.size());
+    if(particles_.capacity() != script_->quota()) {
+        particles_.set_capacity(script_->quota());
     }
 
-    // Update existing particles, erase any that are dead
-    for(auto i = 0u; i < particle_count_; ++i) {
-        Particle& particle = particles_[i];
-
-        particle.position += particle.velocity * dt;
-        particle.ttl -= dt;
-
-        if(particle.ttl <= 0) {
-            // Swap dead particles to the end of the
-            // vector and decrease the particle count
-            // this means active particles are at the
-            // start of the vector
-            std::swap(particles_[i], particles_[particle_count_ - 1]);
-
-            --particle_count_;
-            assert(particle_count_ < particles_.size());
-        }
-    }
+    // Move the existing particles along, then pack the survivors at the
+    // start of the arrays, oldest first
+    particles_.integrate(dt);
+    particles_.compact();
 
     // Run any manipulations on the particles, we do this before
     // we add new particles - otherwise they get manipulated before they're
     // even displayed!
+    auto span = particles_.span();
     for(auto i = 0u; i < script_->manipulator_count(); ++i) {
         auto manipulator = script_->manipulator(i);
-        manipulator->manipulate(this, &particles_[0], particle_count_, dt);
+        manipulator->manipulate(this, span, dt);
     }
 
     for(auto i = 0u; i < script_->emitter_count(); ++i) {
@@ -332,7 +437,7 @@ void ParticleSystem::on_update(float dt) {
 
         /* FIXME: This always means the first emitter gets all the particles !
          */
-        auto max_can_emit = particles_.size() - particle_count_;
+        auto max_can_emit = particles_.capacity() - particles_.size();
         emit_particles(i, dt, max_can_emit);
 
         // We do this after emission so that we always emit particles
@@ -342,7 +447,7 @@ void ParticleSystem::on_update(float dt) {
 
     /* If we are set to destroy on completion, then we do so even if we're
      * invisible */
-    if(!particle_count_ && !script_->has_repeating_emitters() &&
+    if(!particles_.size() && !script_->has_repeating_emitters() &&
        !has_active_emitters()) {
         // If the particles are gone, and we don't have repeating emitters and
         // all the emitters are inactive Then destroy the particle system if
@@ -439,39 +544,47 @@ void ParticleSystem::emit_particles(uint16_t e, float dt, uint32_t max) {
         1.0f,
         float(emitter->emission_rate)); // Work out how often to emit per second
 
-    auto scale = transform->scale_factor();
+    // Decrement the accumulator while we can to work out how many to emit
+    uint32_t to_emit = 0;
+    while(to_emit < max && state.emission_accumulator >= decrement) {
+        state.emission_accumulator -= decrement;
+        ++to_emit;
+    }
 
-    uint32_t to_emit = max;
-    while(state.emission_accumulator >= decrement) {
-        // EMIT THE PARTICLE!
-        Particle p;
-        p.emitter_index = (uint8_t)e;
+    if(!to_emit) {
+        return;
+    }
 
-        if(emitter->type == PARTICLE_EMITTER_POINT) {
-            p.position =
-                (space_ == PARTICLE_SYSTEM_SPACE_WORLD)
-                    ? transform->position() + emitter->relative_position
-                    : Vec3();
-        } else {
-            p.position =
-                (space_ == PARTICLE_SYSTEM_SPACE_WORLD)
-                    ? transform->position() + emitter->relative_position
-                    : Vec3();
-
-            float hw = emitter->dimensions.x * 0.5f * scale.x;
-            float hh = emitter->dimensions.y * 0.5f * scale.y;
-            float hd = emitter->dimensions.z * 0.5f * scale.z;
-
-            p.position.x += random_.float_in_range(-hw, hw);
-            p.position.y += random_.float_in_range(-hh, hh);
-            p.position.z += random_.float_in_range(-hd, hd);
-        }
+    auto scale = transform->scale_factor();
 
-        // We have to rotate the velocity by the system, because if the particle
-        // system is attached to something (e.g. the back of a spaceship) when
-        // that entity rotates we want the velocity to stay pointing relative to
-        // the entity
-        auto rot = transform->orientation();
+    // We have to rotate the velocity by the system, because if the particle
+    // system is attached to something (e.g. the back of a spaceship) when
+    // that entity rotates we want the velocity to stay pointing relative to
+    // the entity
+    auto rot = transform->orientation();
+
+    const Vec3 origin = (space_ == PARTICLE_SYSTEM_SPACE_WORLD)
+                            ? transform->position() + emitter->relative_position
+                            : Vec3();
+
+    const float hw = emitter->dimensions.x * 0.5f * scale.x;
+    const float hh = emitter->dimensions.y * 0.5f * scale.y;
+    const float hd = emitter->dimensions.z * 0.5f * scale.z;
+
+    const float width = script_->particle_width() * scale.x;
+    const float height = script_->particle_height() * scale.y;
+
+    // The new particles are written straight into the arrays
+    const auto first = particles_.grow(to_emit);
+    auto span = particles_.span();
+
+    for(auto i = first; i < first + to_emit; ++i) {
+        Vec3 position = origin;
+        if(emitter->type != PARTICLE_EMITTER_POINT) {
+            position.x += random_.float_in_range(-hw, hw);
+            position.y += random_.float_in_range(-hh, hh);
+            position.z += random_.float_in_range(-hd, hd);
+        }
 
         Vec3 dir = emitter->direction;
         if(smlt::almost_equal(emitter->angle.to_float(), 360.0f)) {
@@ -486,29 +599,30 @@ void ParticleSystem::emit_particles(uint16_t e, float dt, uint32_t max) {
             dir *= rot;
         }
 
-        p.velocity = dir *
-                     random_.float_in_range(emitter->velocity_range.first,
-                                            emitter->velocity_range.second) *
-                     scale;
-
-        p.lifetime = p.ttl = random_.float_in_range(emitter->ttl_range.first,
-                                                    emitter->ttl_range.second);
-        p.color = random_.choice(emitter->colors);
-        p.initial_dimensions = p.dimensions =
-            smlt::Vec2(script_->particle_width() * scale.x,
-                       script_->particle_height() * scale.y);
-
-        // FIXME: Initialize other properties
-        particles_[particle_count_++] = p;
-
-        assert(particle_count_ <= particles_.size());
-
-        state.emission_accumulator -=
-            decrement; // Decrement the accumulator while we can
-        to_emit--;
-        if(!to_emit) {
-            break;
-        }
+        const Vec3 velocity = dir *
+                              random_.float_in_range(emitter->velocity_range.first,
+                                                     emitter->velocity_range.second) *
+                              scale;
+
+        const float ttl = random_.float_in_range(emitter->ttl_range.first,
+                                                 emitter->ttl_range.second);
+
+        const Color color = random_.choice(emitter->colors);
+
+        span.position_x[i] = position.x;
+        span.position_y[i] = position.y;
+        span.position_z[i] = position.z;
+        span.velocity_x[i] = velocity.x;
+        span.velocity_y[i] = velocity.y;
+        span.velocity_z[i] = velocity.z;
+        span.width[i] = span.initial_width[i] = width;
+        span.height[i] = span.initial_height[i] = height;
+        span.ttl[i] = span.lifetime[i] = ttl;
+        span.r[i] = color.r;
+        span.g[i] = color.g;
+        span.b[i] = color.b;
+        span.a[i] = color.a;
+        span.emitter_index[i] = (uint8_t)e;
     }
 }
 
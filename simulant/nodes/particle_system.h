@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <unordered_map>
 
@@ -10,12 +11,13 @@
 #include "../generic/managed.h"
 #include "../generic/manual_object.h"
 #include "../interfaces.h"
+#include "../meshes/submesh.h"
 #include "../renderers/renderer.h"
 #include "../sound.h"
 #include "../types.h"
 #include "../utils/random.h"
 #include "../vertex_data.h"
-#include "particles/particle.h"
+#include "particles/particle_storage.h"
 
 namespace smlt {
 
@@ -74,6 +76,12 @@ public:
         return vertex_data_;
     }
 
+    /* True if the last renderables were generated for the GPU to expand,
+     * see ParticleScript::gpu_billboarding */
+    bool is_gpu_billboarded() const {
+        return gpu_billboarded_;
+    }
+
     void do_generate_renderables(batcher::RenderQueue* render_queue,
                                  const Camera*, const Viewport* viewport,
                                  const DetailLevel, Light** lights,
@@ -86,11 +94,12 @@ public:
     void on_update(float dt) override;
 
     std::size_t particle_count() const {
-        return particle_count_;
+        return particles_.size();
     }
 
-    const Particle& particle(const std::size_t i) const {
-        return particles_[i];
+    /* Particles are stored a field at a time, so this returns a copy */
+    Particle particle(const std::size_t i) const {
+        return particles_.get(i);
     }
 
     void set_space(ParticleSystemSpace space) {
@@ -124,8 +133,7 @@ private:
 
     ParticleScriptPtr script_;
 
-    std::vector<Particle> particles_;
-    std::size_t particle_count_ = 0;
+    ParticleStorage particles_;
 
     VertexData* vertex_data_ = nullptr;
     std::vector<VertexRange> vertex_ranges_;
@@ -135,6 +143,24 @@ private:
 
     void rebuild_vertex_data(const smlt::Vec3& up, const smlt::Vec3& right);
 
+    /* Used instead of the above when the GPU is expanding the particles.
+     * With hardware instancing there's one record per particle, drawn over
+     * billboard_quad_. Otherwise there are four corners per particle and
+     * the index data draws them all in one call. */
+    std::unique_ptr<VertexData> billboard_vertex_data_;
+    std::unique_ptr<IndexData> billboard_index_data_;
+    std::unique_ptr<VertexData> billboard_quad_;
+    VertexRange billboard_quad_range_ = {0, 4};
+    bool gpu_billboarded_ = false;
+
+    void rebuild_billboard_data(bool instanced);
+
+    typedef std::array<Vec3, ParticleScript::MAX_EMITTER_COUNT> EmitterOffsets;
+
+    /* Returns the offsets to add to each emitter's particles when they're
+     * drawn, or null if there aren't any */
+    const Vec3* calc_emitter_offsets(EmitterOffsets& offsets) const;
+
     bool emitters_active_ = true;
 
     RandomGenerator random_;
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cassert>
+
+#include "particle_storage.h"
+#include "../../math/utils.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SIMULANT_PARTICLES_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMULANT_PARTICLES_NEON 1
+#endif
+
+namespace smlt {
+
+/* The kernels below are written once against these, four particles at a
+ * time, with a scalar loop for whatever is left over */
+#if defined(SIMULANT_PARTICLES_SSE)
+
+#define SIMULANT_PARTICLES_SIMD 1
+
+typedef __m128 float4;
+
+static inline float4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, float4 v) { _mm_storeu_ps(p, v); }
+static inline void store4_aligned(float* p, float4 v) { _mm_store_ps(p, v); }
+static inline float4 splat4(float v) { return _mm_set1_ps(v); }
+static inline float4 set4(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+static inline float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+
+#elif defined(SIMULANT_PARTICLES_NEON)
+
+#define SIMULANT_PARTICLES_SIMD 1
+
+typedef float32x4_t float4;
+
+static inline float4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, float4 v) { vst1q_f32(p, v); }
+static inline void store4_aligned(float* p, float4 v) { vst1q_f32(p, v); }
+static inline float4 splat4(float v) { return vdupq_n_f32(v); }
+static inline float4 set4(float a, float b, float c, float d) {
+    const float v[4] = {a, b, c, d};
+    return vld1q_f32(v);
+}
+static inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+static inline float4 div4(float4 a, float4 b) {
+    /* No divide on 32 bit NEON, refine the reciprocal estimate twice which
+     * is as close as fast_divide gets */
+    float4 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+
+#endif
+
+void ParticleStorage::set_capacity(std::size_t capacity) {
+    for(auto array: {
+        &position_x_, &position_y_, &position_z_,
+        &velocity_x_, &velocity_y_, &velocity_z_,
+        &width_, &height_, &initial_width_, &initial_height_,
+        &ttl_, &lifetime_,
+        &r_, &g_, &b_, &a_
+    }) {
+        array->resize(capacity);
+        array->shrink_to_fit();
+    }
+
+    emitter_index_.resize(capacity);
+    emitter_index_.shrink_to_fit();
+
+    count_ = std::min(count_, capacity);
+}
+
+Particle ParticleStorage::get(std::size_t i) const {
+    assert(i < count_);
+
+    Particle p;
+    p.position = Vec3(position_x_[i], position_y_[i], position_z_[i]);
+    p.velocity = Vec3(velocity_x_[i], velocity_y_[i], velocity_z_[i]);
+    p.dimensions = Vec2(width_[i], height_[i]);
+    p.initial_dimensions = Vec2(initial_width_[i], initial_height_[i]);
+    p.ttl = ttl_[i];
+    p.lifetime = lifetime_[i];
+    p.color = Color(r_[i], g_[i], b_[i], a_[i]);
+    p.emitter_index = emitter_index_[i];
+    return p;
+}
+
+void ParticleStorage::set(std::size_t i, const Particle& p) {
+    assert(i < count_);
+
+    position_x_[i] = p.position.x;
+    position_y_[i] = p.position.y;
+    position_z_[i] = p.position.z;
+    velocity_x_[i] = p.velocity.x;
+    velocity_y_[i] = p.velocity.y;
+    velocity_z_[i] = p.velocity.z;
+    width_[i] = p.dimensions.x;
+    height_[i] = p.dimensions.y;
+    initial_width_[i] = p.initial_dimensions.x;
+    initial_height_[i] = p.initial_dimensions.y;
+    ttl_[i] = p.ttl;
+    lifetime_[i] = p.lifetime;
+    r_[i] = p.color.r;
+    g_[i] = p.color.g;
+    b_[i] = p.color.b;
+    a_[i] = p.color.a;
+    emitter_index_[i] = p.emitter_index;
+}
+
+std::size_t ParticleStorage::grow(std::size_t count) {
+    assert(count_ + count <= capacity());
+
+    auto first = count_;
+    count_ += count;
+    return first;
+}
+
+ParticleSpan ParticleStorage::span() {
+    ParticleSpan span;
+    span.position_x = position_x_.data();
+    span.position_y = position_y_.data();
+    span.position_z = position_z_.data();
+    span.velocity_x = velocity_x_.data();
+    span.velocity_y = velocity_y_.data();
+    span.velocity_z = velocity_z_.data();
+    span.width = width_.data();
+    span.height = height_.data();
+    span.initial_width = initial_width_.data();
+    span.initial_height = initial_height_.data();
+    span.ttl = ttl_.data();
+    span.lifetime = lifetime_.data();
+    span.r = r_.data();
+    span.g = g_.data();
+    span.b = b_.data();
+    span.a = a_.data();
+    span.emitter_index = emitter_index_.data();
+    span.count = count_;
+    return span;
+}
+
+void ParticleStorage::integrate(float dt) {
+    particle_add_scaled(position_x_.data(), velocity_x_.data(), dt, count_);
+    particle_add_scaled(position_y_.data(), velocity_y_.data(), dt, count_);
+    particle_add_scaled(position_z_.data(), velocity_z_.data(), dt, count_);
+    particle_add(ttl_.data(), -dt, count_);
+}
+
+template<typename T>
+static void compact_array(T* values, std::size_t first, const std::vector<uint32_t>& survivors) {
+    for(auto i: survivors) {
+        values[first++] = values[i];
+    }
+}
+
+std::size_t ParticleStorage::compact() {
+    const float* ttl = ttl_.data();
+
+    /* Most frames nothing dies, or only the oldest few do */
+    std::size_t first_dead = 0;
+    while(first_dead < count_ && ttl[first_dead] > 0.0f) {
+        ++first_dead;
+    }
+
+    if(first_dead == count_) {
+        return 0;
+    }
+
+    survivors_.clear();
+    for(auto i = first_dead + 1; i < count_; ++i) {
+        if(ttl[i] > 0.0f) {
+            survivors_.push_back((uint32_t) i);
+        }
+    }
+
+    /* Each array is compacted in turn so that we stream through one at a
+     * time, rather than touching all of them for every particle */
+    for(auto array: {
+        &position_x_, &position_y_, &position_z_,
+        &velocity_x_, &velocity_y_, &velocity_z_,
+        &width_, &height_, &initial_width_, &initial_height_,
+        &ttl_, &lifetime_,
+        &r_, &g_, &b_, &a_
+    }) {
+        compact_array(array->data(), first_dead, survivors_);
+    }
+
+    compact_array(emitter_index_.data(), first_dead, survivors_);
+
+    auto removed = count_ - (first_dead + survivors_.size());
+    count_ = first_dead + survivors_.size();
+    return removed;
+}
+
+void particle_add(float* out, float value, std::size_t count) {
+    std::size_t i = 0;
+
+#if defined(SIMULANT_PARTICLES_SIMD)
+    const float4 v = splat4(value);
+    for(; i + 4 <= count; i += 4) {
+        store4(out + i, add4(load4(out + i), v));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        out[i] += value;
+    }
+}
+
+void particle_add_scaled(float* out, const float* in, float scale, std::size_t count) {
+    std::size_t i = 0;
+
+#if defined(SIMULANT_PARTICLES_SIMD)
+    const float4 s = splat4(scale);
+    for(; i + 4 <= count; i += 4) {
+        store4(out + i, add4(load4(out + i), mul4(load4(in + i), s)));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        out[i] += in[i] * scale;
+    }
+}
+
+void particle_grow_linear(float* out, const float* initial, const float* ttl,
+                          const float* lifetime, float rate, std::size_t count) {
+    std::size_t i = 0;
+
+#if defined(SIMULANT_PARTICLES_SIMD)
+    const float4 r = splat4(rate);
+    for(; i + 4 <= count; i += 4) {
+        float4 elapsed = sub4(load4(lifetime + i), load4(ttl + i));
+        store4(out + i, add4(load4(initial + i), mul4(elapsed, r)));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        out[i] = initial[i] + (lifetime[i] - ttl[i]) * rate;
+    }
+}
+
+void particle_normalised_age(float* out, const float* ttl, const float* lifetime,
+                             std::size_t count) {
+    std::size_t i = 0;
+
+#if defined(SIMULANT_PARTICLES_SIMD)
+    for(; i + 4 <= count; i += 4) {
+        float4 l = load4(lifetime + i);
+        store4(out + i, div4(sub4(l, load4(ttl + i)), l));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        out[i] = smlt::fast_divide(lifetime[i] - ttl[i], lifetime[i]);
+    }
+}
+
+static inline void write_vec3(uint8_t* out, float x, float y, float z) {
+    float* f = (float*) out;
+    f[0] = x;
+    f[1] = y;
+    f[2] = z;
+}
+
+static void expand_billboard(const ParticleSpan& span, std::size_t i,
+                             const Vec3& up, const Vec3& right,
+                             const Vec3* offsets, uint8_t* out,
+                             std::size_t stride) {
+
+    Vec3 c(span.position_x[i], span.position_y[i], span.position_z[i]);
+    if(offsets) {
+        c += offsets[span.emitter_index[i]];
+    }
+
+    const Vec3 rw = right * (span.width[i] * 0.5f);
+    const Vec3 uh = up * (span.height[i] * 0.5f);
+
+    const Vec3 corners[4] = {
+        c - rw - uh,
+        c + rw - uh,
+        c - rw + uh,
+        c + rw + uh
+    };
+
+    out += i * 4 * stride;
+    for(auto& corner: corners) {
+        write_vec3(out, corner.x, corner.y, corner.z);
+        out += stride;
+    }
+}
+
+void expand_billboards(const ParticleSpan& span, const Vec3& up,
+                       const Vec3& right, const Vec3* offsets, uint8_t* out,
+                       std::size_t stride) {
+    std::size_t i = 0;
+
+#if defined(SIMULANT_PARTICLES_SIMD)
+    const float4 rx = splat4(right.x * 0.5f);
+    const float4 ry = splat4(right.y * 0.5f);
+    const float4 rz = splat4(right.z * 0.5f);
+    const float4 ux = splat4(up.x * 0.5f);
+    const float4 uy = splat4(up.y * 0.5f);
+    const float4 uz = splat4(up.z * 0.5f);
+
+    /* x, y and z of each corner, for four particles */
+    alignas(16) float corners[12][4];
+
+    for(; i + 4 <= span.count; i += 4) {
+        float4 cx = load4(span.position_x + i);
+        float4 cy = load4(span.position_y + i);
+        float4 cz = load4(span.position_z + i);
+
+        if(offsets) {
+            const uint8_t* e = span.emitter_index + i;
+            cx = add4(cx, set4(offsets[e[0]].x, offsets[e[1]].x, offsets[e[2]].x, offsets[e[3]].x));
+            cy = add4(cy, set4(offsets[e[0]].y, offsets[e[1]].y, offsets[e[2]].y, offsets[e[3]].y));
+            cz = add4(cz, set4(offsets[e[0]].z, offsets[e[1]].z, offsets[e[2]].z, offsets[e[3]].z));
+        }
+
+        const float4 w = load4(span.width + i);
+        const float4 h = load4(span.height + i);
+
+        const float4 rwx = mul4(rx, w), rwy = mul4(ry, w), rwz = mul4(rz, w);
+        const float4 uhx = mul4(ux, h), uhy = mul4(uy, h), uhz = mul4(uz, h);
+
+        /* Bottom and top edge centres */
+        const float4 bx = sub4(cx, uhx), by = sub4(cy, uhy), bz = sub4(cz, uhz);
+        const float4 tx = add4(cx, uhx), ty = add4(cy, uhy), tz = add4(cz, uhz);
+
+        store4_aligned(corners[0], sub4(bx, rwx));
+        store4_aligned(corners[1], sub4(by, rwy));
+        store4_aligned(corners[2], sub4(bz, rwz));
+        store4_aligned(corners[3], add4(bx, rwx));
+        store4_aligned(corners[4], add4(by, rwy));
+        store4_aligned(corners[5], add4(bz, rwz));
+        store4_aligned(corners[6], sub4(tx, rwx));
+        store4_aligned(corners[7], sub4(ty, rwy));
+        store4_aligned(corners[8], sub4(tz, rwz));
+        store4_aligned(corners[9], add4(tx, rwx));
+        store4_aligned(corners[10], add4(ty, rwy));
+        store4_aligned(corners[11], add4(tz, rwz));
+
+        /* Vertices are interleaved, so this part has to be scattered */
+        uint8_t* dst = out + i * 4 * stride;
+        for(int p = 0; p < 4; ++p) {
+            for(int c = 0; c < 4; ++c) {
+                write_vec3(dst, corners[c * 3][p], corners[c * 3 + 1][p], corners[c * 3 + 2][p]);
+                dst += stride;
+            }
+        }
+    }
+#endif
+
+    for(; i < span.count; ++i) {
+        expand_billboard(span, i, up, right, offsets, out, stride);
+    }
+}
+
+}
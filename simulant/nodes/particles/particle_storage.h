@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../../core/aligned_allocator.h"
+#include "../../math/vec3.h"
+#include "particle.h"
+
+namespace smlt {
+
+typedef std::vector<float, aligned_allocator<float, 16>> ParticleFloatArray;
+
+/*
+ * Pointers to the first of `count` live particles in each of the particle
+ * arrays. Manipulators work on these a field at a time, rather than a
+ * particle at a time, so the loops can be vectorised.
+ */
+struct ParticleSpan {
+    float* position_x = nullptr;
+    float* position_y = nullptr;
+    float* position_z = nullptr;
+
+    float* velocity_x = nullptr;
+    float* velocity_y = nullptr;
+    float* velocity_z = nullptr;
+
+    float* width = nullptr;
+    float* height = nullptr;
+    float* initial_width = nullptr;
+    float* initial_height = nullptr;
+
+    float* ttl = nullptr;
+    float* lifetime = nullptr;
+
+    float* r = nullptr;
+    float* g = nullptr;
+    float* b = nullptr;
+    float* a = nullptr;
+
+    uint8_t* emitter_index = nullptr;
+
+    std::size_t count = 0;
+};
+
+/*
+ * Particle data stored as a structure of arrays. Live particles are packed
+ * at the start of the arrays, oldest first.
+ */
+class ParticleStorage {
+public:
+    std::size_t size() const {
+        return count_;
+    }
+
+    std::size_t capacity() const {
+        return ttl_.size();
+    }
+
+    /* Resizes the arrays, dropping the newest particles if there are more
+     * than will fit */
+    void set_capacity(std::size_t capacity);
+
+    void clear() {
+        count_ = 0;
+    }
+
+    Particle get(std::size_t i) const;
+    void set(std::size_t i, const Particle& particle);
+
+    /* Adds `count` uninitialised particles to the end and returns the index
+     * of the first. There must be room for them. */
+    std::size_t grow(std::size_t count);
+
+    std::size_t push(const Particle& particle) {
+        auto i = grow(1);
+        set(i, particle);
+        return i;
+    }
+
+    ParticleSpan span();
+
+    /* Moves the particles along their velocity and ages them by dt */
+    void integrate(float dt);
+
+    /* Removes particles whose ttl has run out, keeping the rest in order.
+     * Returns the number removed. */
+    std::size_t compact();
+
+private:
+    ParticleFloatArray position_x_;
+    ParticleFloatArray position_y_;
+    ParticleFloatArray position_z_;
+
+    ParticleFloatArray velocity_x_;
+    ParticleFloatArray velocity_y_;
+    ParticleFloatArray velocity_z_;
+
+    ParticleFloatArray width_;
+    ParticleFloatArray height_;
+    ParticleFloatArray initial_width_;
+    ParticleFloatArray initial_height_;
+
+    ParticleFloatArray ttl_;
+    ParticleFloatArray lifetime_;
+
+    ParticleFloatArray r_;
+    ParticleFloatArray g_;
+    ParticleFloatArray b_;
+    ParticleFloatArray a_;
+
+    std::vector<uint8_t> emitter_index_;
+
+    std::size_t count_ = 0;
+
+    /* Indices of the particles which survive a compaction */
+    std::vector<uint32_t> survivors_;
+};
+
+/* Vectorised helpers for manipulators. Where there's no SSE or NEON these
+ * fall back to plain loops. */
+
+/* Manipulators which need scratch space work through a span in chunks of
+ * this many particles, so that the scratch can live on the stack */
+const static std::size_t PARTICLE_CHUNK_SIZE = 256;
+
+/* out[i] += value */
+void particle_add(float* out, float value, std::size_t count);
+
+/* out[i] += in[i] * scale */
+void particle_add_scaled(float* out, const float* in, float scale, std::size_t count);
+
+/* out[i] = initial[i] + (lifetime[i] - ttl[i]) * rate */
+void particle_grow_linear(float* out, const float* initial, const float* ttl,
+                          const float* lifetime, float rate, std::size_t count);
+
+/* out[i] = (lifetime[i] - ttl[i]) / lifetime[i] */
+void particle_normalised_age(float* out, const float* ttl, const float* lifetime,
+                             std::size_t count);
+
+/*
+ * Writes the four corners of a camera facing quad for each particle in the
+ * span, as a triangle strip. Corner positions are written as Vec3s at
+ * `stride` bytes apart, starting at `out`.
+ *
+ * `offsets` is indexed by each particle's emitter_index and is added to the
+ * particle position, it can be null for world space particles.
+ */
+void expand_billboards(const ParticleSpan& span, const Vec3& up,
+                       const Vec3& right, const Vec3* offsets, uint8_t* out,
+                       std::size_t stride);
+
+}
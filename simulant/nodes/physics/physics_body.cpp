@@ -172,6 +172,7 @@ bool PhysicsBody::on_create(Params params) {
         bounce_ = std::make_unique<_impl::BounceData>();
 
         sim->register_body(this, initial_pos, initial_rot);
+        body_transform_version_ = transform->version();
     } else {
         S_ERROR("PhysicsBody added without an active PhysicsService");
     }
@@ -197,10 +198,27 @@ void PhysicsBody::on_transformation_changed() {
 
     // Ignore any signals that we've caused by us setting
     // the transform
-    if(updating_body_ || !bounce_) {
+    if(updating_body_) {
         return;
     }
 
+    push_transform_to_body();
+}
+
+void PhysicsBody::push_transform_to_body() {
+    if(!bounce_) {
+        return;
+    }
+
+    /* on_update stores the version after copying the body into the
+     * transform, so this skips our own changes */
+    auto version = transform->version();
+    if(version == body_transform_version_) {
+        return;
+    }
+
+    body_transform_version_ = version;
+
     // If we're here, then the user called set_position or something
     // so we need to update the rigid body to where it was intended
 
@@ -219,6 +237,8 @@ void PhysicsBody::on_update(float dt) {
     updating_body_ = true;
 
     raii::Finally finally([=]() {
+        /* Don't push our own changes back to the body */
+        body_transform_version_ = transform->version();
         updating_body_ = false;
     });
 
@@ -115,6 +115,10 @@ protected:
 
     void on_transformation_changed() override;
 
+    /* Moves the rigid body to match the transform, if the transform
+     * has been moved by something other than the body */
+    void push_transform_to_body();
+
     std::unique_ptr<_impl::BounceData> bounce_;
 
 private:
@@ -122,6 +126,9 @@ private:
 
     bool updating_body_ = false;
 
+    /* The transform version the rigid body last matched */
+    uint32_t body_transform_version_ = 0;
+
     std::pair<Vec3, Quaternion> last_state_;
     void on_update(float dt) override;
 
@@ -0,0 +1,92 @@
+//
+//   Copyright (c) 2011-2017 Luke Benstead https://simulant-engine.appspot.com
+//
+//     This file is part of Simulant.
+//
+//     Simulant is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Simulant is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Lesser General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with Simulant.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "spatial_hash_partitioner.h"
+#include "../frustum.h"
+#include "../nodes/camera.h"
+#include "../scenes/scene.h"
+
+namespace smlt {
+
+void SpatialHashPartitioner::do_generate_renderables(
+    batcher::RenderQueue* render_queue, const Camera* camera,
+    const Viewport* viewport, const DetailLevel detail_level, Light** lights,
+    const std::size_t light_count) {
+
+    /* Moves are only staged here when transform changes are delivered */
+    scene->flush_transform_changes();
+    _apply_writes();
+
+    auto generate = [&](StageNode* node) {
+        if(node->is_visible() && !node->is_destroyed()) {
+            node->generate_renderables(render_queue, camera, viewport,
+                                       detail_level, lights, light_count);
+        }
+    };
+
+    for(auto entry: hash_.find_objects_within_frustum(camera->frustum())) {
+        generate(static_cast<Entry*>(entry)->node);
+    }
+
+    for(auto node: unculled_) {
+        generate(node);
+    }
+}
+
+void SpatialHashPartitioner::remove_node(StageNode* node) {
+    auto it = entries_.find(node);
+    if(it != entries_.end()) {
+        hash_.remove_object(it->second.get());
+        entries_.erase(it);
+    }
+
+    unculled_.erase(node);
+}
+
+void SpatialHashPartitioner::apply_staged_write(const StagedWrite& write) {
+    StageNode* node = write.node;
+
+    if(write.operation == WRITE_OPERATION_REMOVE) {
+        /* The node may have been freed, so don't touch it */
+        remove_node(node);
+        return;
+    }
+
+    if(!node->is_cullable() || node->generates_renderables_for_descendents()) {
+        remove_node(node);
+        unculled_.insert(node);
+        return;
+    }
+
+    unculled_.erase(node);
+
+    auto bounds = node->transformed_aabb();
+
+    auto it = entries_.find(node);
+    if(it == entries_.end()) {
+        auto entry = std::make_unique<Entry>();
+        entry->node = node;
+        hash_.insert_object_for_box(bounds, entry.get());
+        entries_.insert(std::make_pair(node, std::move(entry)));
+    } else {
+        hash_.update_object_for_box(bounds, it->second.get());
+    }
+}
+
+} // namespace smlt
@@ -0,0 +1,84 @@
+/* *   Copyright (c) 2011-2017 Luke Benstead https://simulant-engine.appspot.com
+ *
+ *     This file is part of Simulant.
+ *
+ *     Simulant is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ *     Simulant is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with Simulant.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../partitioner.h"
+#include "../partitioners/impl/spatial_hash.h"
+#include "simulant/nodes/stage_node.h"
+#include "simulant/utils/params.h"
+
+namespace smlt {
+
+/*
+ * A partitioner which keeps its descendents in a hierarchical spatial hash.
+ *
+ * Unlike the FrustumCuller, which tests every descendent each frame, the
+ * hash is kept up-to-date incrementally from the staged writes (nodes being
+ * added, moved or removed) so rendering only queries the visible cells. This
+ * is best suited to large scenes where most nodes are static.
+ */
+class SpatialHashPartitioner: public Partitioner {
+public:
+    S_DEFINE_STAGE_NODE_META("spatial_hash_partitioner");
+
+    SpatialHashPartitioner(Scene* owner) :
+        Partitioner(owner, Meta::node_type) {}
+
+    const AABB& aabb() const {
+        static AABB aabb;
+        return aabb;
+    }
+
+    /* The number of nodes in the hash, plus those which are always
+     * rendered. Pending writes are not included. */
+    std::size_t tracked_node_count() const {
+        return entries_.size() + unculled_.size();
+    }
+
+private:
+    struct Entry: public SpatialHashEntry {
+        StageNode* node = nullptr;
+    };
+
+    bool on_create(Params) override {
+        return true;
+    }
+
+    void do_generate_renderables(batcher::RenderQueue* render_queue,
+                                 const Camera*, const Viewport* viewport,
+                                 const DetailLevel detail_level, Light** lights,
+                                 const std::size_t light_count) override;
+
+    void apply_staged_write(const StagedWrite& write) override;
+
+    void remove_node(StageNode* node);
+
+    SpatialHash hash_;
+    std::unordered_map<StageNode*, std::unique_ptr<Entry>> entries_;
+
+    /* Nodes which aren't cullable, or which generate renderables for their
+     * own descendents (e.g. nested partitioners) are always rendered */
+    std::unordered_set<StageNode*> unculled_;
+};
+
+} // namespace smlt
@@ -1,6 +1,7 @@
 #include "../application.h"
 #include "../asset_manager.h"
 #include "../nodes/prefab_instance.h"
+#include "../partitioner.h"
 #include "../stage.h"
 #include "../window.h"
 #include "camera.h"
@@ -17,6 +18,51 @@ AABB StageNode::recursive_aabb() const {
     return ret;
 }
 
+const AABB& StageNode::subtree_aabb() const {
+    if(subtree_aabb_dirty_) {
+        recalc_subtree_aabb();
+    }
+
+    return subtree_aabb_;
+}
+
+bool StageNode::is_subtree_cullable() const {
+    if(subtree_aabb_dirty_) {
+        recalc_subtree_aabb();
+    }
+
+    return subtree_cullable_;
+}
+
+void StageNode::recalc_subtree_aabb() const {
+    auto bounds = transformed_aabb();
+    auto min = bounds.min();
+    auto max = bounds.max();
+    bool cullable = cullable_;
+
+    /* Only the dirty branches are walked, everything else is cached */
+    for(auto child = first_child_; child; child = child->next_) {
+        if(child->subtree_aabb_dirty_) {
+            child->recalc_subtree_aabb();
+        }
+
+        min = Vec3::min(min, child->subtree_aabb_.min());
+        max = Vec3::max(max, child->subtree_aabb_.max());
+        cullable = cullable && child->subtree_cullable_;
+    }
+
+    /* Not encapsulate(), which treats flat boxes as empty */
+    subtree_aabb_.set_min_max(min, max);
+    subtree_cullable_ = cullable;
+    subtree_aabb_dirty_ = false;
+}
+
+void StageNode::mark_subtree_aabb_dirty() {
+    for(auto node = this; node && !node->subtree_aabb_dirty_; node = node->parent_) {
+        node->subtree_aabb_dirty_ = true;
+    }
+}
+
 StageNode* StageNode::load_tree(const Path& path, const TreeLoadOptions& opts) {
     auto app = get_app();
     if(!app) {
@@ -187,6 +233,8 @@ void StageNode::remove_from_parent() {
     if(next_) next_->prev_ = prev_;
     if(prev_) prev_->next_ = next_;
 
+    parent_->mark_subtree_aabb_dirty();
+
     parent_ = nullptr;
     next_ = prev_ = nullptr;
 
@@ -225,6 +273,13 @@ void StageNode::set_parent(StageNode* new_parent, TransformRetainMode transform_
         return;
     }
 
+    if(owner_ && owner_->updating_concurrently_) {
+        owner_->defer_structural_change([=]() {
+            set_parent(new_parent, transform_retain);
+        });
+        return;
+    }
+
     auto old_path = node_path();
     auto old_parent = parent_;
 
@@ -257,6 +312,10 @@ void StageNode::set_parent(StageNode* new_parent, TransformRetainMode transform_
         prev_ = nullptr;
     }
 
+    if(parent_) {
+        parent_->mark_subtree_aabb_dirty();
+    }
+
     assert(first_child_ != this);
     assert(last_child_ != this);
     assert(next_ != this);
@@ -312,6 +371,11 @@ std::size_t StageNode::generate_renderables(batcher::RenderQueue* render_queue,
  * that this node needs proper destroying
  */
 void StageNode::finalize_destroy() {
+    if(owner_ && owner_->updating_concurrently_) {
+        owner_->defer_structural_change([this]() { finalize_destroy(); });
+        return;
+    }
+
     if(owner_) {
         // Go through the mixins and make sure they're destroyed
         auto mixins = mixins_; // Avoid removal inside a loop
@@ -370,6 +434,11 @@ void StageNode::recalc_visibility() {
 }
 
 void StageNode::finalize_destroy_immediately() {
+    if(owner_ && owner_->updating_concurrently_) {
+        owner_->defer_structural_change([this]() { finalize_destroy_immediately(); });
+        return;
+    }
+
     if(owner_) {
         std::vector<StageNode*> to_destroy;
 
@@ -468,7 +537,16 @@ StageNode *StageNode::find_descendent_with_name(const std::string &name) {
 }
 
 void StageNode::set_cullable(bool v) {
+    if(cullable_ == v) {
+        return;
+    }
+
     cullable_ = v;
+    mark_subtree_aabb_dirty();
+
+    /* The partitioner needs to know, non-cullable nodes are
+     * handled separately */
+    stage_partitioner_update();
 }
 
 bool StageNode::is_cullable() const {
@@ -484,20 +562,21 @@ int16_t StageNode::precedence() const {
 }
 
 void StageNode::on_transformation_changed() {
+    /* Children are notified by their own transforms, which were marked
+     * dirty along with ours */
     mark_transformed_aabb_dirty();
-
-    /* If this node's transform changes in some way, we need
-     * to trigger updates on child transforms too */
-    for(auto& child: each_child()) {
-        child.transform->signal_change();
-    }
 }
 
 void StageNode::recalc_bounds_if_necessary() const {
-    if(!transformed_aabb_dirty_) {
+    /* Transform changes are delivered once a frame, so check the version
+     * to catch any moves since then */
+    auto version = transform->version();
+    if(!transformed_aabb_dirty_ && version == transformed_aabb_version_) {
         return;
     }
 
+    transformed_aabb_version_ = version;
+
     auto newb = calculate_transformed_aabb();
     if(newb.min() != transformed_aabb_.min() || newb.max() != transformed_aabb_.max()) {
         transformed_aabb_ = newb;
@@ -509,6 +588,64 @@ void StageNode::recalc_bounds_if_necessary() const {
 
 void StageNode::mark_transformed_aabb_dirty() {
     transformed_aabb_dirty_ = true;
+    mark_subtree_aabb_dirty();
+
+    if(!partitioner_dirty_) {
+        stage_partitioner_update();
+    }
+}
+
+void StageNode::stage_partitioner_update() {
+    if(!partitioner_) {
+        return;
+    }
+
+    /* The new bounds are calculated when the write is applied, that
+     * way any number of transform changes only stage a single write */
+    partitioner_dirty_ = true;
+    partitioner_->update_stage_node(this, transformed_aabb_);
+}
+
+void StageNode::update_partitioner() {
+    Partitioner* partitioner = nullptr;
+
+    if(parent_ && parent_->is_partitioner_) {
+        auto p = static_cast<Partitioner*>(parent_);
+        partitioner = (p->tracks_stage_nodes()) ? p : nullptr;
+    } else if(parent_) {
+        partitioner = parent_->partitioner_;
+    }
+
+    set_partitioner(partitioner);
+}
+
+void StageNode::set_partitioner(Partitioner* partitioner) {
+    if(partitioner_ == partitioner) {
+        /* Nothing changed, so nothing changed for our children either */
+        return;
+    }
+
+    if(partitioner_) {
+        partitioner_->remove_stage_node(this);
+    }
+
+    partitioner_ = partitioner;
+    partitioner_dirty_ = false;
+
+    if(partitioner_) {
+        /* Adding implies an update */
+        partitioner_dirty_ = true;
+        partitioner_->add_stage_node(this);
+    }
+
+    /* Partitioners are responsible for their own children */
+    if(is_partitioner_) {
+        return;
+    }
+
+    for(auto& child: each_child()) {
+        child.set_partitioner(partitioner);
+    }
 }
 
 void StageNode::update(float dt) {
@@ -516,6 +653,13 @@ void StageNode::update(float dt) {
         return;
     }
 
+    /* The scene sets aside subtrees which can be updated concurrently while
+     * it walks the tree, then updates them all together at the end */
+    const bool is_scene = (owner_ && owner_ == this);
+    if(is_scene) {
+        owner_->collecting_concurrent_updates_ = true;
+    }
+
     Updateable::update(dt);
 
     for(auto& mixin: mixins_) {
@@ -523,7 +667,17 @@ void StageNode::update(float dt) {
     }
 
     for(auto& child: each_child()) {
-        child.update(dt);
+        if(child.update_concurrency_ == UPDATE_CONCURRENCY_PARALLEL &&
+           owner_ && owner_->collecting_concurrent_updates_) {
+            owner_->concurrent_updates_.push_back(&child);
+        } else {
+            child.update(dt);
+        }
+    }
+
+    if(is_scene) {
+        owner_->collecting_concurrent_updates_ = false;
+        owner_->run_concurrent_updates(dt);
     }
 }
 
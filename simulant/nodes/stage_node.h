@@ -53,6 +53,13 @@ class ChildIteratorPair;
 typedef sig::signal<void(AABB)> BoundsUpdatedSignal;
 typedef sig::signal<void()> CleanedUpSignal;
 
+/* Whether a node's subtree can be updated alongside other subtrees, see
+ * StageNode::set_update_concurrency */
+enum UpdateConcurrency {
+    UPDATE_CONCURRENCY_SERIAL,
+    UPDATE_CONCURRENCY_PARALLEL
+};
+
 /* Used for multiple levels of detail when rendering stage nodes */
 
 enum DetailLevel {
@@ -526,12 +533,21 @@ private:
 
     std::unordered_map<StageNodeType, MixinInfo> mixins_;
 
+    /* The partitioner responsible for culling this node (the nearest
+     * ancestor partitioner, if it tracks its nodes). Bounds changes are
+     * staged as writes to it, partitioner_dirty_ is set while an update
+     * is pending */
+    Partitioner* partitioner_ = nullptr;
     bool partitioner_dirty_ = false;
-    bool partitioner_added_ = false;
+    bool is_partitioner_ = false;
 
     Scene* owner_ = nullptr;
     StageNodeType node_type_ = 0;
 
+    /* Position of this node in the manager's nodes_by_type list, so it
+     * can be swapped out when the node is erased */
+    std::size_t type_index_ = 0;
+
     generic::DataCarrier data_;
 
     /* How many pipelines is this node the root of? */
@@ -544,6 +560,13 @@ private:
      * calculation until access */
     mutable AABB transformed_aabb_;
     mutable bool transformed_aabb_dirty_ = false;
+    mutable uint32_t transformed_aabb_version_ = 0;
+
+    /* Cached bounds of the whole subtree. If a node is dirty then so are
+     * all of its ancestors */
+    mutable AABB subtree_aabb_;
+    mutable bool subtree_aabb_dirty_ = true;
+    mutable bool subtree_cullable_ = true;
 
     // By default, always cast and receive shadows
     ShadowCast shadow_cast_ = SHADOW_CAST_ALWAYS;
@@ -559,12 +582,21 @@ private:
 
     int16_t precedence_ = 0;
 
+    UpdateConcurrency update_concurrency_ = UPDATE_CONCURRENCY_SERIAL;
+
 private:
     void recalc_visibility();
 
     AABB calculate_transformed_aabb() const;
     void add_mixin(StageNode* mixin);
 
+    void mark_subtree_aabb_dirty();
+    void recalc_subtree_aabb() const;
+
+    void update_partitioner();
+    void set_partitioner(Partitioner* partitioner);
+    void stage_partitioner_update();
+
     // NVI idiom
     bool _create(const Params& params) {
         params_ = params;
@@ -605,6 +637,7 @@ private:
         }
 
         recalc_visibility();
+        update_partitioner();
 
         on_parent_set(oldp, newp);
     }
@@ -856,6 +889,16 @@ public:
     }
 
     AABB recursive_aabb() const;
+
+    /* The world space bounds of this node and all of its descendents. This
+     * is cached, and only recalculated when something in the subtree moves,
+     * changes bounds or is reparented. Moves are picked up when transform
+     * changes are delivered, see Scene::flush_transform_changes() */
+    const AABB& subtree_aabb() const;
+
+    /* False if anything in the subtree isn't cullable, in which case the
+     * subtree can't be culled as a whole */
+    bool is_subtree_cullable() const;
     /* Control shading on the stage node (behaviour depends on the type of node)
      */
     ShadowCast shadow_cast() const {
@@ -879,6 +922,22 @@ public:
 
     void set_precedence(int16_t precedence);
 
+    /** Marks this node and its descendents as safe to update alongside
+     *  other parallel subtrees. The scene updates these on the job system
+     *  once the rest of the tree is done, and waits for them all before
+     *  late_update.
+     *
+     *  While that happens a node should only change its own subtree.
+     *  Creating, destroying and reparenting nodes is allowed, but takes
+     *  effect when the parallel update finishes. */
+    void set_update_concurrency(UpdateConcurrency concurrency) {
+        update_concurrency_ = concurrency;
+    }
+
+    UpdateConcurrency update_concurrency() const {
+        return update_concurrency_;
+    }
+
     int16_t precedence() const;
 
     virtual const char* node_type_name() const = 0;
@@ -19,8 +19,8 @@ bool StageNodeManager::clean_up_node(StageNode* node) {
         return false;
     }
 
-    auto node_data_it = all_nodes_.find(node->id());
-    if(node_data_it == all_nodes_.end()) {
+    auto slot = find_slot(node->id());
+    if(!slot) {
         S_ERROR("Unable to find node data for {0}", node->id());
         return false;
     }
@@ -33,17 +33,69 @@ bool StageNodeManager::clean_up_node(StageNode* node) {
 
     on_stage_node_erased(node);
 
-    void* alloc_base = node_data_it->second.alloc_base;
+    void* alloc_base = slot->alloc_base;
+    release_slot(node->id());
     it->second.destructor(node);
-    all_nodes_.erase(node_data_it);
-    node_storage_.deallocate(alloc_base);
+    node_storage_.deallocate(alloc_base, it->second.size_in_bytes);
 
     S_DEBUG("Destroyed node with type {0} at address {1}", type, node);
     return true;
 }
 
+static StageNodeStorage make_node_storage() {
+    auto app = get_app();
+    if(!app) {
+        return StageNodeStorage();
+    }
+
+    auto& general = app->config->general;
+    return StageNodeStorage(general.stage_node_pool_size,
+                            general.stage_node_spare_slabs);
+}
+
+StageNodeManager::StageNodeManager(Scene* scene) :
+    node_storage_(make_node_storage()),
+    scene_(scene) {}
+
 StageNodeManager::~StageNodeManager() {}
 
+bool StageNodeManager::acquire_slot(StageNode* node, void* alloc_base) {
+    uint32_t slot;
+
+    /* Slots are reused oldest first, so that a slot's generation goes
+     * round as slowly as possible */
+    if(!free_node_slots_.empty()) {
+        slot = free_node_slots_.front();
+        free_node_slots_.pop_front();
+    } else if(node_slots_.size() < STAGE_NODE_ID_MAX_SLOTS) {
+        slot = (uint32_t)node_slots_.size();
+        node_slots_.emplace_back();
+    } else {
+        S_ERROR("Unable to create more than {0} stage nodes",
+                STAGE_NODE_ID_MAX_SLOTS);
+        return false;
+    }
+
+    auto& node_slot = node_slots_[slot];
+    node_slot.alloc_base = alloc_base;
+    node_slot.ptr = node;
+    node->set_id(make_stage_node_id(slot, node_slot.generation));
+    return true;
+}
+
+void StageNodeManager::release_slot(StageNodeID id) {
+    auto slot = stage_node_id_slot(id);
+    auto& node_slot = node_slots_[slot];
+
+    node_slot.alloc_base = nullptr;
+    node_slot.ptr = nullptr;
+    node_slot.generation = (node_slot.generation == STAGE_NODE_ID_MAX_GENERATION)
+                               ? 1
+                               : node_slot.generation + 1;
+
+    free_node_slots_.push_back(slot);
+}
+
 StageNode* StageNodeManager::create_node(const std::string& node_type_name,
                                          const Params& params,
                                          StageNode* base) {
@@ -245,6 +297,19 @@ bool StageNodeManager::register_stage_node_from_lua_state(lua_State* L,
 StageNode* StageNodeManager::create_node(StageNodeType type,
                                          const Params& params,
                                          StageNode* base) {
+    /* Nodes can be created from parallel updates, they're created straight
+     * away but one at a time. Attaching them to the tree is deferred. */
+    if(scene_ && scene_->is_updating_concurrently()) {
+        thread::Lock<thread::RecursiveMutex> lock(create_mutex_);
+        return do_create_node(type, params, base);
+    }
+
+    return do_create_node(type, params, base);
+}
+
+StageNode* StageNodeManager::do_create_node(StageNodeType type,
+                                            const Params& params,
+                                            StageNode* base) {
     auto info = registered_nodes_.find(type);
     if(info == registered_nodes_.end()) {
         S_ERROR("Unable to find registered node: {0}", type);
@@ -260,10 +325,17 @@ StageNode* StageNodeManager::create_node(StageNodeType type,
     void* mem = (size) ? node_storage_.allocate(size, alignment) : nullptr;
     StageNode* node = constructor(mem);
 
+    if(!acquire_slot(node, mem)) {
+        destructor(node);
+        node_storage_.deallocate(mem, size);
+        return nullptr;
+    }
+
     if(!node->init()) {
         S_ERROR("Failed to initialize node");
+        release_slot(node->id());
         destructor(node);
-        aligned_free(node);
+        node_storage_.deallocate(mem, size);
         return nullptr;
     }
 
@@ -274,14 +346,14 @@ StageNode* StageNodeManager::create_node(StageNodeType type,
     if(!node->_create(params)) {
         S_ERROR("Failed to create the node");
         node->clean_up();
+        release_slot(node->id());
         info->second.destructor(node);
-        aligned_free(node);
+        node_storage_.deallocate(mem, size);
         return nullptr;
     }
 
     S_DEBUG("Created new node of type {0} at address {1}", node->node_type(),
             node);
-    all_nodes_.insert(std::make_pair(node->id(), NodeData(mem, node)));
     on_stage_node_inserted(node);
 
     return node;
@@ -4,11 +4,14 @@ extern "C" {
     struct lua_State;
 }
 
+#include "../threads/mutex.h"
 #include "../utils/params.h"
 #include "helpers.h"
 #include "stage_node.h"
 #include "stage_node_storage.h"
+#include <deque>
 #include <functional>
+#include <stdexcept>
 
 namespace smlt {
 
@@ -58,52 +61,96 @@ private:
         to_delete->~T();
     }
 
-    struct NodeData {
-        void* alloc_base;
-        StageNode* ptr;
-
-        NodeData(void* alloc_base, StageNode* ptr) :
-            alloc_base(alloc_base), ptr(ptr) {}
+    /* A slot in the node table. The generation is bumped each time the
+     * slot is freed, so old IDs stop matching */
+    struct NodeSlot {
+        void* alloc_base = nullptr;
+        StageNode* ptr = nullptr;
+        uint32_t generation = 1;
     };
 
     std::unordered_map<StageNodeType, StageNodeTypeInfo> registered_nodes_;
-    std::unordered_map<StageNodeID, NodeData> all_nodes_;
+
+    std::vector<NodeSlot> node_slots_;
+    std::deque<uint32_t> free_node_slots_;
 
     StageNodeStorage node_storage_;
     std::unordered_map<StageNodeType, std::vector<StageNode*>> nodes_by_type_;
 
+    const NodeSlot* find_slot(StageNodeID id) const {
+        if(!stage_node_id_is_slotted(id)) {
+            return nullptr;
+        }
+
+        auto slot = stage_node_id_slot(id);
+        if(slot >= node_slots_.size()) {
+            return nullptr;
+        }
+
+        auto& node_slot = node_slots_[slot];
+        if(!node_slot.ptr ||
+           node_slot.generation != stage_node_id_generation(id)) {
+            return nullptr;
+        }
+
+        return &node_slot;
+    }
+
+    bool acquire_slot(StageNode* node, void* alloc_base);
+    void release_slot(StageNodeID id);
+
+    thread::RecursiveMutex create_mutex_;
+
+    StageNode* do_create_node(StageNodeType type, const Params& params,
+                              StageNode* base);
+
 protected:
     bool clean_up_node(StageNode* node);
 
     Scene* scene_;
 
+    /* Nodes of each type are kept densely packed, each node knows its
+     * position so that erasing is a swap with the last one */
     virtual void on_stage_node_inserted(StageNode* node) {
-        nodes_by_type_[node->node_type()].push_back(node);
+        auto& arr = nodes_by_type_[node->node_type()];
+        node->type_index_ = arr.size();
+        arr.push_back(node);
     }
 
     virtual void on_stage_node_erased(StageNode* node) {
         auto& arr = nodes_by_type_[node->node_type()];
-        arr.erase(std::remove(arr.begin(), arr.end(), node), arr.end());
+        auto i = node->type_index_;
+        assert(i < arr.size() && arr[i] == node);
+
+        arr[i] = arr.back();
+        arr[i]->type_index_ = i;
+        arr.pop_back();
     }
 
 public:
-    StageNodeManager(Scene* scene) :
-        scene_(scene) {}
+    StageNodeManager(Scene* scene);
 
     virtual ~StageNodeManager();
 
+    /* The nodes of a type, in no particular order */
     const std::vector<StageNode*>& nodes_by_type(StageNodeType type) {
         return nodes_by_type_[type];
     }
 
-    /* Constant-time node lookup by ID */
+    /* Constant-time node lookup by ID, throws std::out_of_range if there's
+     * no such node */
     StageNode* get_node(StageNodeID id) const {
-        return all_nodes_.at(id).ptr;
+        auto slot = find_slot(id);
+        if(!slot) {
+            throw std::out_of_range("No stage node with that ID");
+        }
+
+        return slot->ptr;
     }
 
     /* Constant-time node existence check */
     bool has_node(StageNodeID id) const {
-        return all_nodes_.count(id) > 0;
+        return find_slot(id) != nullptr;
     }
 
     /* Non-template API does the work for easier binding with other languages */
@@ -1,171 +1,436 @@
 #pragma once
 
-#include "../core/aligned_vector.h"
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../core/memory.h"
+#include "../logging.h"
 
 namespace smlt {
 
 /**
  * @class SlabArray
  * @brief A memory pool allocator using slab allocation with bitmap tracking.
- * 
+ *
  * Manages allocation and deallocation of fixed-size memory blocks organized into
- * slabs. Each slab contains 16 blocks (one bit per block in a uint16_t bitmap).
- * When a slab becomes fully deallocated, it is freed back to the system.
- * 
+ * slabs. Each slab is a power-of-two sized allocation, aligned to its own size,
+ * which starts with a header holding a two-level bitmap of its free blocks.
+ *
+ * - Slabs with free blocks are kept on an intrusive list, so allocate() never
+ *   has to look at full slabs, and the free block is found with two
+ *   find-first-set operations.
+ * - The slab owning a block is found by masking the block's address, so
+ *   deallocate() doesn't search either.
+ * - Up to `spare_slabs` empty slabs are kept back rather than being freed, so
+ *   that creating and destroying a node on the boundary of a slab doesn't
+ *   allocate and free a slab each time.
+ *
  * @tparam alignment The byte alignment requirement for allocated memory blocks.
  *                   Must be satisfied by aligned_alloc().
- * 
+ *
  * @note This class is move-only (copy constructor and assignment are deleted).
  * @note Non-thread-safe. External synchronization required for concurrent access.
  */
 template<int alignment>
 class SlabArray {
 public:
+    /// @brief The most blocks a slab can hold (64 words of 64 bits).
+    constexpr static std::size_t max_blocks_per_slab = 64 * 64;
+
+#if defined(__DREAMCAST__) || defined(__PSP__)
+    /* Memory is tight, so keep slabs small and give empty ones back */
+    constexpr static std::size_t default_blocks_per_slab = 16;
+    constexpr static std::size_t default_spare_slabs = 0;
+#else
+    constexpr static std::size_t default_blocks_per_slab = 64;
+    constexpr static std::size_t default_spare_slabs = 1;
+#endif
+
     /**
      * @brief Constructs a SlabArray with the specified block size.
-     * 
-     * @param block_size The size in bytes of each memory block. Multiple blocks
-     *                   are packed into each slab.
+     *
+     * @param block_size The size in bytes of each memory block. Rounded up to
+     *                   a multiple of the alignment.
+     * @param blocks_per_slab The minimum number of blocks in each slab. Slabs
+     *                   are rounded up to a power of two in size, and any
+     *                   room left by that is used for more blocks.
+     * @param spare_slabs The number of empty slabs to keep for reuse before
+     *                   releasing them back to the system.
      */
-    SlabArray(std::size_t block_size) :
-        block_size_(block_size) {}
+    SlabArray(std::size_t block_size,
+              std::size_t blocks_per_slab = default_blocks_per_slab,
+              std::size_t spare_slabs = default_spare_slabs) :
+        block_size_(round_up(block_size ? block_size : 1, alignment)),
+        spare_slabs_(spare_slabs) {
+
+        std::size_t blocks = blocks_per_slab;
+        blocks = (blocks < 1) ? 1 : blocks;
+        blocks = (blocks > max_blocks_per_slab) ? max_blocks_per_slab : blocks;
+
+        slab_size_ = header_size(blocks) + block_size_ * blocks;
+
+        std::size_t pow2 = alignment;
+        while(pow2 < slab_size_) {
+            pow2 <<= 1;
+        }
+        slab_size_ = pow2;
+
+        // Use whatever the rounding left over for more blocks
+        capacity_ = (slab_size_ - header_size(blocks)) / block_size_;
+        capacity_ = (capacity_ > max_blocks_per_slab) ? max_blocks_per_slab
+                                                      : capacity_;
+        while(header_size(capacity_) + block_size_ * capacity_ > slab_size_) {
+            --capacity_;
+        }
+
+        word_count_ = (capacity_ + 63) / 64;
+        header_size_ = header_size(capacity_);
+    }
+
+    ~SlabArray() {
+        release();
+    }
 
     SlabArray(const SlabArray& other) = delete;
     SlabArray& operator=(const SlabArray& other) = delete;
 
-    SlabArray(SlabArray&& other) noexcept = default;
-    SlabArray& operator=(SlabArray&& other) noexcept = default;
+    SlabArray(SlabArray&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SlabArray& operator=(SlabArray&& other) noexcept {
+        if(this == &other) {
+            return *this;
+        }
+
+        release();
+
+        block_size_ = other.block_size_;
+        slab_size_ = other.slab_size_;
+        capacity_ = other.capacity_;
+        word_count_ = other.word_count_;
+        header_size_ = other.header_size_;
+        spare_slabs_ = other.spare_slabs_;
+        slabs_ = std::move(other.slabs_);
+        partial_ = other.partial_;
+        empty_ = other.empty_;
+        empty_count_ = other.empty_count_;
+        allocated_ = other.allocated_;
+
+        other.slabs_.clear();
+        other.partial_ = other.empty_ = nullptr;
+        other.empty_count_ = other.allocated_ = 0;
+
+        for(auto slab: slabs_) {
+            slab->owner = this;
+        }
+
+        return *this;
+    }
 
     /**
      * @brief Allocates a single memory block from the pool.
-     * 
-     * Searches existing slabs for an available block. If no free block is found,
-     * creates a new slab with 16 blocks and returns a pointer to the first block.
-     * 
+     *
+     * Takes a block from a partially used slab if there is one, then from a
+     * spare empty slab, and only creates a new slab if neither exist.
+     *
      * @return Pointer to an aligned memory block of size block_size, or nullptr
      *         if allocation fails.
-     * 
+     *
      * @post The returned pointer remains valid until deallocate() is called on it.
      */
     uint8_t* allocate() {
-        for(auto& slab: slabs_) {
-            if(slab.used == Slab::full_mask) {
-                continue;
-            }
-
-            for(std::size_t i = 0; i < Slab::bits; ++i) {
-                if((slab.used & (1 << i)) == 0) {
-                    slab.used |= (1 << i);
-                    return slab.data + block_size_ * i;
+        Slab* slab = partial_;
+        if(!slab) {
+            if(empty_) {
+                slab = empty_;
+                unlink(empty_, slab);
+                --empty_count_;
+            } else {
+                slab = create_slab();
+                if(!slab) {
+                    S_ERROR("Unable to allocate a new slab of {0} bytes",
+                            slab_size_);
+                    return nullptr;
                 }
             }
+
+            link(partial_, slab);
         }
 
-        // Create new slab
-        uint8_t* data =
-            (uint8_t*)aligned_alloc(alignment, block_size_ * Slab::bits);
-        assert(data);
+        uint64_t* words = free_words(slab);
+        std::size_t w = find_first_set(slab->summary);
+        std::size_t b = find_first_set(words[w]);
 
-        slabs_.push_back(Slab(data));
-        slabs_.back().used |= 1;
-        return data;
+        words[w] &= ~(uint64_t(1) << b);
+        if(!words[w]) {
+            slab->summary &= ~(uint64_t(1) << w);
+        }
+
+        if(++slab->used == capacity_) {
+            unlink(partial_, slab);
+        }
+
+        ++allocated_;
+        return blocks(slab) + block_size_ * (w * 64 + b);
     }
 
     /**
      * @brief Deallocates a previously allocated memory block.
-     * 
+     *
      * Marks the block as free within its slab. If the slab becomes completely
-     * empty after deallocation, it is freed back to the system and removed from
-     * the pool.
-     * 
+     * empty it's kept as a spare, or freed back to the system if there are
+     * already enough spares.
+     *
      * @param ptr Pointer to a block previously returned by allocate(). Must not
      *            be null and must belong to this pool.
-     * 
+     *
      * @return true if the block was successfully deallocated, false if the pointer
      *         was not found in this pool or was already deallocated.
-     * 
+     *
      * @note Behavior is undefined if ptr is invalid or from a different allocator.
      */
     bool deallocate(uint8_t* ptr) {
-        for(auto& slab: slabs_) {
-            if(slab.data <= ptr && ptr < slab.data + block_size_ * Slab::bits) {
-                std::size_t offset = ptr - slab.data;
-                std::size_t index = offset / block_size_;
-                if(slab.used & (1 << index)) {
-                    slab.used &= ~(1 << index);
-                    clean_up();
-                    return true;
-                }
+        Slab* slab = slab_for(ptr);
+        if(!slab || slab->owner != this || ptr < blocks(slab)) {
+            S_ERROR("Attempted to deallocate a pointer which was not "
+                    "allocated");
+            return false;
+        }
+
+        std::size_t offset = ptr - blocks(slab);
+        std::size_t index = offset / block_size_;
+        if(offset % block_size_ || index >= capacity_) {
+            S_ERROR("Attempted to deallocate a pointer which was not "
+                    "allocated");
+            return false;
+        }
+
+        uint64_t* words = free_words(slab);
+        std::size_t w = index / 64;
+        uint64_t bit = uint64_t(1) << (index % 64);
+
+        if(words[w] & bit) {
+            S_ERROR("Attempted to deallocate a pointer which was not "
+                    "allocated");
+            return false;
+        }
+
+        words[w] |= bit;
+        slab->summary |= uint64_t(1) << w;
+
+        bool was_full = (slab->used == capacity_);
+        --slab->used;
+        --allocated_;
+
+        if(slab->used == 0) {
+            if(!was_full) {
+                unlink(partial_, slab);
             }
+
+            if(empty_count_ < spare_slabs_) {
+                link(empty_, slab);
+                ++empty_count_;
+            } else {
+                destroy_slab(slab);
+            }
+        } else if(was_full) {
+            link(partial_, slab);
         }
 
-        S_ERROR("Attempted to deallocate a pointer which was not "
-                "allocated");
-        return false;
+        return true;
     }
 
-private:
-    /**
-     * @brief Removes empty slabs from the end of the slab list.
-     * 
-     * Called after deallocation to reclaim memory. Only removes completely
-     * empty slabs from the back of the list to maintain contiguity of
-     * active allocations.
-     */
-    void clean_up() {
-        while(!slabs_.empty() && slabs_.back().used == 0) {
-            aligned_free(slabs_.back().data);
-            slabs_.pop_back();
-        }
+    std::size_t block_size() const {
+        return block_size_;
+    }
+
+    /// @brief The number of blocks in each slab, at least the number requested.
+    std::size_t blocks_per_slab() const {
+        return capacity_;
+    }
+
+    /// @brief The size in bytes (and alignment) of each slab.
+    std::size_t slab_size() const {
+        return slab_size_;
     }
 
+    /// @brief The number of slabs currently held, including spares.
+    std::size_t slab_count() const {
+        return slabs_.size();
+    }
+
+    /// @brief The number of empty slabs being kept for reuse.
+    std::size_t spare_slab_count() const {
+        return empty_count_;
+    }
+
+    /// @brief The number of blocks currently allocated.
+    std::size_t allocated_count() const {
+        return allocated_;
+    }
+
+private:
     /**
      * @struct Slab
-     * @brief Represents a single slab containing up to 16 blocks.
-     * 
-     * @var used Bitmap where each bit represents whether the corresponding block
-     *           is allocated (1) or free (0).
-     * @var data Pointer to the start of the slab's allocated memory.
-     * @var bits Number of allocatable blocks per slab (always 16 for uint16_t).
-     * @var full_mask Bitmask with all block bits set (0xFFFF).
+     * @brief The header at the start of each slab.
+     *
+     * @var owner The SlabArray the slab belongs to, used to catch pointers
+     *            which didn't come from this pool.
+     * @var prev, next Links in either the partial or the empty list. Full
+     *            slabs aren't in a list.
+     * @var index The slab's position in slabs_.
+     * @var used The number of allocated blocks.
+     * @var summary Bit n is set if word n of the free bitmap has a free block.
+     *
+     * The free bitmap (one bit per block, set when the block is free) follows
+     * the header, and the blocks follow that at header_size_.
      */
     struct Slab {
-        uint16_t used = 0;
-        uint8_t* data = nullptr;
-
-        static constexpr std::size_t bits = sizeof(used) * 8;
-        static constexpr decltype(used) full_mask = ~(decltype(used))0;
-
-        /**
-         * @brief Constructs a Slab with the given memory allocation.
-         * 
-         * @param data Pointer to pre-allocated aligned memory for this slab.
-         */
-        Slab(uint8_t* data) :
-            data(data) {}
+        SlabArray* owner;
+        Slab* prev;
+        Slab* next;
+        uint32_t index;
+        uint32_t used;
+        uint64_t summary;
     };
 
-    std::size_t block_size_;  ///< Size in bytes of each allocated block
-    std::vector<Slab> slabs_; ///< Collection of active slabs
+    static std::size_t round_up(std::size_t value, std::size_t multiple) {
+        return ((value + multiple - 1) / multiple) * multiple;
+    }
+
+    static std::size_t header_size(std::size_t capacity) {
+        return round_up(sizeof(Slab) + sizeof(uint64_t) * ((capacity + 63) / 64),
+                        alignment);
+    }
+
+    /// @brief The index of the lowest set bit, @a value must not be zero.
+    static std::size_t find_first_set(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return (std::size_t)__builtin_ctzll(value);
+#else
+        std::size_t i = 0;
+        while(!(value & 1)) {
+            value >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    uint64_t* free_words(Slab* slab) const {
+        return reinterpret_cast<uint64_t*>(slab + 1);
+    }
+
+    uint8_t* blocks(Slab* slab) const {
+        return reinterpret_cast<uint8_t*>(slab) + header_size_;
+    }
+
+    Slab* slab_for(uint8_t* ptr) const {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(ptr) &
+                                       ~(uintptr_t)(slab_size_ - 1));
+    }
+
+    static void link(Slab*& head, Slab* slab) {
+        slab->prev = nullptr;
+        slab->next = head;
+        if(head) {
+            head->prev = slab;
+        }
+        head = slab;
+    }
+
+    static void unlink(Slab*& head, Slab* slab) {
+        if(slab->prev) {
+            slab->prev->next = slab->next;
+        } else {
+            head = slab->next;
+        }
+
+        if(slab->next) {
+            slab->next->prev = slab->prev;
+        }
+
+        slab->prev = slab->next = nullptr;
+    }
+
+    Slab* create_slab() {
+        Slab* slab = (Slab*)aligned_alloc(slab_size_, slab_size_);
+        if(!slab) {
+            return nullptr;
+        }
+
+        slab->owner = this;
+        slab->prev = slab->next = nullptr;
+        slab->index = (uint32_t)slabs_.size();
+        slab->used = 0;
+        slab->summary = 0;
+
+        uint64_t* words = free_words(slab);
+        for(std::size_t w = 0; w < word_count_; ++w) {
+            std::size_t bits = capacity_ - w * 64;
+            words[w] = (bits >= 64) ? ~uint64_t(0)
+                                    : ((uint64_t(1) << bits) - 1);
+            slab->summary |= uint64_t(1) << w;
+        }
+
+        slabs_.push_back(slab);
+        return slab;
+    }
+
+    void destroy_slab(Slab* slab) {
+        Slab* last = slabs_.back();
+        slabs_[slab->index] = last;
+        last->index = slab->index;
+        slabs_.pop_back();
+
+        aligned_free(slab);
+    }
+
+    void release() {
+        for(auto slab: slabs_) {
+            aligned_free(slab);
+        }
+
+        slabs_.clear();
+        partial_ = empty_ = nullptr;
+        empty_count_ = allocated_ = 0;
+    }
+
+    std::size_t block_size_ = 0;  ///< Size in bytes of each allocated block
+    std::size_t slab_size_ = 0;   ///< Size and alignment of each slab
+    std::size_t capacity_ = 0;    ///< Blocks per slab
+    std::size_t word_count_ = 0;  ///< Words in each slab's free bitmap
+    std::size_t header_size_ = 0; ///< Offset of the first block in a slab
+    std::size_t spare_slabs_ = 0; ///< Empty slabs to keep before freeing
+
+    std::vector<Slab*> slabs_;    ///< Every slab, in no particular order
+    Slab* partial_ = nullptr;     ///< Slabs with both used and free blocks
+    Slab* empty_ = nullptr;       ///< Spare slabs with no used blocks
+    std::size_t empty_count_ = 0;
+    std::size_t allocated_ = 0;
 };
 
 /**
  * @class StageNodeStorage
  * @brief A hierarchical memory pool allocator optimized for StageNode allocation.
- * 
+ *
  * Improves cache locality when allocating StageNodes of varying sizes by:
  * - Grouping allocations by rounded-up size into separate pools
  * - Maintaining each pool with slab-based allocation
  * - Using aligned allocation (32-byte alignment) for better CPU cache performance
- * 
+ *
  * StageNodes can be arbitrary sizes (user-defined subclasses), so this allocator
  * rounds up requested sizes to multiples of 256 bytes and maintains separate
  * SlabArray pools for each size class. This balances memory locality gains
  * against memory fragmentation.
- * 
+ *
  * @note Thread-safety: Not thread-safe. Requires external synchronization for
  *       concurrent allocation/deallocation.
- * 
+ *
  * @see SlabArray
  */
 class StageNodeStorage {
@@ -177,25 +442,37 @@ public:
     ///        of this value (256 bytes). Must be a multiple of node_alignment.
     constexpr static std::size_t round_up_bytes = 256;
 
+    typedef SlabArray<node_alignment> Pool;
+
+    /**
+     * @brief Constructs the storage.
+     *
+     * @param blocks_per_slab The minimum number of nodes in each slab of each
+     *                        size class.
+     * @param spare_slabs The number of empty slabs each size class keeps
+     *                    before releasing them.
+     */
+    StageNodeStorage(std::size_t blocks_per_slab = Pool::default_blocks_per_slab,
+                     std::size_t spare_slabs = Pool::default_spare_slabs) :
+        blocks_per_slab_(blocks_per_slab), spare_slabs_(spare_slabs) {}
+
     /**
      * @brief Allocates a block of memory with the specified size and alignment.
-     * 
+     *
      * The requested size is rounded up to the nearest multiple of round_up_bytes,
      * and the allocation is drawn from the pool for that size class. If no pool
      * exists for that size, one is created.
-     * 
+     *
      * @param size The minimum number of bytes to allocate.
      * @param alignment The required byte alignment. Must be a divisor of node_alignment
      *                  (i.e., alignment % node_alignment must equal 0).
-     * 
+     *
      * @return A pointer to allocated memory of at least @a size bytes with the
      *         requested alignment, or nullptr if the alignment requirement cannot
      *         be satisfied.
-     * 
+     *
      * @post The returned pointer must be deallocated with deallocate() on this
-     *       same StageNodeStorage instance.
-     * 
-     * @note Allocations are tracked internally by pointer address.
+     *       same StageNodeStorage instance, passing the same size.
      */
     void* allocate(std::size_t size, std::size_t alignment) {
         if(alignment % node_alignment != 0) {
@@ -203,55 +480,80 @@ public:
             return nullptr;
         }
 
-        // Round the size up to the nearest `round_up_bytes`
-        std::size_t rounded_size =
-            ((size + round_up_bytes - 1) / round_up_bytes) * round_up_bytes;
-
-        if(!buffers_.count(rounded_size)) {
-            buffers_.insert(std::make_pair(
-                rounded_size, SlabArray<node_alignment>(rounded_size)));
-        }
-
-        void* ptr = buffers_.at(rounded_size).allocate();
-        used_allocations_[ptr] = rounded_size;
-        return ptr;
+        return pool(rounded_size(size)).allocate();
     }
 
     /**
      * @brief Deallocates a previously allocated memory block.
-     * 
-     * Returns the block to its size-class pool and cleans up empty slabs.
-     * 
+     *
+     * Returns the block to its size-class pool. The pool finds the block's
+     * slab from its address, so this doesn't search.
+     *
      * @param ptr Pointer previously returned by allocate() on this instance.
      *            Must not be null.
-     * 
+     * @param size The size that was passed to allocate().
+     *
      * @pre @a ptr must have been returned by a previous call to allocate() on
      *      this same StageNodeStorage instance and not already deallocated.
-     * 
+     *
      * @note Behavior is undefined if @a ptr is invalid or from a different allocator.
-     * 
+     *
      * @see allocate()
      */
-    void deallocate(void* ptr) {
-        auto it = used_allocations_.find(ptr);
-        if(it == used_allocations_.end()) {
+    void deallocate(void* ptr, std::size_t size) {
+        auto it = buffers_.find(rounded_size(size));
+        if(it == buffers_.end()) {
             S_ERROR("Attempted to deallocate unknown pointer");
             return;
         }
 
-        if(!buffers_.at(it->second).deallocate((uint8_t*)ptr)) {
-            return;
+        it->second.deallocate((uint8_t*)ptr);
+    }
+
+    /// @brief The number of blocks allocated across all size classes.
+    std::size_t allocated_count() const {
+        std::size_t count = 0;
+        for(auto& p: buffers_) {
+            count += p.second.allocated_count();
         }
+        return count;
+    }
 
-        used_allocations_.erase(it);
+    /// @brief The number of slabs held across all size classes.
+    std::size_t slab_count() const {
+        std::size_t count = 0;
+        for(auto& p: buffers_) {
+            count += p.second.slab_count();
+        }
+        return count;
     }
 
 private:
-    /// @brief Maps allocated pointers to their size class for O(1) lookup during deallocation.
-    std::unordered_map<void*, std::size_t> used_allocations_;
-    
+    static std::size_t rounded_size(std::size_t size) {
+        return ((size + round_up_bytes - 1) / round_up_bytes) * round_up_bytes;
+    }
+
+    Pool& pool(std::size_t rounded_size) {
+        auto it = buffers_.find(rounded_size);
+        if(it == buffers_.end()) {
+            it = buffers_
+                     .emplace(std::piecewise_construct,
+                              std::forward_as_tuple(rounded_size),
+                              std::forward_as_tuple(rounded_size,
+                                                    blocks_per_slab_,
+                                                    spare_slabs_))
+                     .first;
+        }
+
+        return it->second;
+    }
+
+    std::size_t blocks_per_slab_;
+    std::size_t spare_slabs_;
+
     /// @brief Maps size classes (in bytes) to their respective slab allocation pools.
-    std::unordered_map<std::size_t, SlabArray<32>> buffers_;
+    /// Pools are never moved once inserted, so slabs can point back to them.
+    std::unordered_map<std::size_t, Pool> buffers_;
 };
 
 } // namespace smlt
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../frustum.h"
 #include "stage_node.h"
 #include "stage_node_iterators.h"
 
@@ -43,4 +44,108 @@ private:
     std::size_t head_ = 0;
 };
 
+/* Walks the visible nodes inside a frustum, depth first, calling the callback
+ * for each one. Whole subtrees are skipped using their cached subtree_aabb(),
+ * and once a subtree is found to be completely inside a plane, nothing in it
+ * is tested against that plane again. If the callback returns false, the
+ * node's children aren't visited. */
+class StageNodeVisitorFrustum {
+public:
+    template<typename Func>
+    StageNodeVisitorFrustum(StageNode* start, const Frustum& frustum, Func&& callback) :
+        start_(start),
+        frustum_(frustum),
+        callback_(callback) {}
+
+    void run() {
+        tests_ = 0;
+        rejected_ = 0;
+
+        stack_.clear();
+        stack_.push_back(Entry{start_, FRUSTUM_PLANE_MASK_ALL});
+
+        while(!stack_.empty()) {
+            auto entry = stack_.back();
+            stack_.pop_back();
+
+            /* Invisible nodes hide their descendents too */
+            StageNode* node = entry.node;
+            if(!node->is_visible()) {
+                continue;
+            }
+
+            uint8_t mask = entry.plane_mask;
+            bool self_test = false;
+
+            if(mask && node->is_subtree_cullable()) {
+                ++tests_;
+                if(frustum_.classify_aabb(node->subtree_aabb(), mask) == FRUSTUM_CONTAINS_NONE) {
+                    ++rejected_;
+                    continue;
+                }
+
+                /* A leaf's subtree is just itself, so it's already been
+                 * tested */
+                self_test = bool(node->first_child());
+            } else if(mask && node->is_cullable()) {
+                /* Something below can't be culled, so only this node can be */
+                self_test = true;
+            }
+
+            bool inside = true;
+            if(self_test && mask && has_own_bounds(node)) {
+                uint8_t self_mask = mask;
+                ++tests_;
+                inside = frustum_.classify_aabb(node->transformed_aabb(), self_mask) != FRUSTUM_CONTAINS_NONE;
+            }
+
+            bool descend = true;
+            if(inside && !node->is_destroyed()) {
+                descend = callback_(node);
+            }
+
+            if(descend) {
+                for(auto child = node->first_child(); child; child = child->next_sibling()) {
+                    stack_.push_back(Entry{child, mask});
+                }
+            }
+        }
+    }
+
+    /* The number of bounds tested, and subtrees skipped, by the last run() */
+    std::size_t tests() const {
+        return tests_;
+    }
+
+    std::size_t rejected() const {
+        return rejected_;
+    }
+
+private:
+    struct Entry {
+        StageNode* node;
+        uint8_t plane_mask;
+    };
+
+    /* Partitioners decide what's visible below them, and groups (stages,
+     * empty nodes) have no volume of their own, only their subtree bounds
+     * mean anything for those */
+    static bool has_own_bounds(const StageNode* node) {
+        if(node->generates_renderables_for_descendents()) {
+            return false;
+        }
+
+        const AABB& bounds = node->aabb();
+        return bounds.min() != bounds.max();
+    }
+
+    StageNode* start_ = nullptr;
+    const Frustum& frustum_;
+    std::function<bool (StageNode*)> callback_;
+
+    std::vector<Entry> stack_;
+    std::size_t tests_ = 0;
+    std::size_t rejected_ = 0;
+};
+
 } // namespace smlt
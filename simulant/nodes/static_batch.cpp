@@ -0,0 +1,318 @@
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+#include "static_batch.h"
+#include "../assets/material.h"
+#include "../frustum.h"
+#include "../renderers/batching/render_queue.h"
+#include "../renderers/batching/renderable.h"
+#include "../stage.h"
+#include "actor.h"
+#include "camera.h"
+
+namespace smlt {
+
+StaticBatch::StaticBatch(Scene* owner) :
+    StageNode(owner, Meta::node_type) {}
+
+bool StaticBatch::on_create(Params params) {
+    if(!clean_params<StaticBatch>(params)) {
+        return false;
+    }
+
+    cluster_size_ = params.get<float>("cluster_size").value_or(32.0f);
+    if(cluster_size_ <= 0.0f) {
+        S_ERROR("StaticBatch cluster_size must be greater than zero");
+        return false;
+    }
+
+    return StageNode::on_create(params);
+}
+
+bool StaticBatch::add_actor(Actor* actor) {
+    if(!actor || !actor->has_any_mesh()) {
+        return false;
+    }
+
+    return add_mesh(actor->base_mesh(), actor->transform->world_space_matrix(),
+                    actor->active_material_slot());
+}
+
+std::size_t StaticBatch::add_actors(const std::vector<Actor*>& actors) {
+    std::size_t added = 0;
+    for(auto actor: actors) {
+        added += add_actor(actor);
+    }
+
+    return added;
+}
+
+uint64_t StaticBatch::cluster_key(const Vec3& point) const {
+    /* 21 bits per axis is plenty of cells either side of the origin */
+    const int64_t mask = (1 << 21) - 1;
+
+    int64_t x = (int64_t)std::floor(point.x / cluster_size_) & mask;
+    int64_t y = (int64_t)std::floor(point.y / cluster_size_) & mask;
+    int64_t z = (int64_t)std::floor(point.z / cluster_size_) & mask;
+
+    return (uint64_t(x) << 42) | (uint64_t(y) << 21) | uint64_t(z);
+}
+
+StaticBatch::Chunk* StaticBatch::new_chunk(Cluster& cluster,
+                                           const MaterialPtr& material,
+                                           const VertexSpecification& spec) {
+    cluster.chunks.push_back(Chunk());
+
+    auto& chunk = cluster.chunks.back();
+    chunk.material = material;
+    chunk.vertices.reset(new VertexData(spec));
+    chunk.indexes.reset(new IndexData(INDEX_TYPE_16_BIT));
+    return &chunk;
+}
+
+StaticBatch::Chunk* StaticBatch::chunk_for(Cluster& cluster,
+                                           const MaterialPtr& material,
+                                           const VertexSpecification& spec) {
+    /* The last matching chunk is the only one which might have room */
+    for(auto it = cluster.chunks.rbegin(); it != cluster.chunks.rend(); ++it) {
+        if(it->material == material &&
+           it->vertices->vertex_specification() == spec) {
+            return &(*it);
+        }
+    }
+
+    return new_chunk(cluster, material, spec);
+}
+
+bool StaticBatch::add_mesh(const MeshPtr& mesh, const Mat4& transform,
+                           MaterialSlot slot) {
+    if(!mesh || !mesh->vertex_data) {
+        return false;
+    }
+
+    if(mesh->is_animated()) {
+        S_WARN("Animated meshes can't be added to a StaticBatch");
+        return false;
+    }
+
+    const auto& spec = mesh->vertex_data->vertex_specification();
+    VertexAttribute position_attribute = spec.position_attribute;
+    if(position_attribute != VERTEX_ATTRIBUTE_2F &&
+       position_attribute != VERTEX_ATTRIBUTE_3F &&
+       position_attribute != VERTEX_ATTRIBUTE_4F) {
+        S_WARN("Only meshes with float positions can be added to a StaticBatch");
+        return false;
+    }
+
+    /* Normals are decoded, transformed and written back in their own
+     * format, which only works for the formats VertexData can read back
+     * as a Vec3 */
+    VertexAttribute normal_attribute = spec.normal_attribute;
+    if(normal_attribute != VERTEX_ATTRIBUTE_NONE &&
+       normal_attribute != VERTEX_ATTRIBUTE_3F &&
+       normal_attribute != VERTEX_ATTRIBUTE_2B_OCTAHEDRAL &&
+       normal_attribute != VERTEX_ATTRIBUTE_2S_OCTAHEDRAL &&
+       normal_attribute != VERTEX_ATTRIBUTE_PACKED_VEC4_1I) {
+        S_WARN("Meshes with this normal format can't be added to a StaticBatch");
+        return false;
+    }
+
+    /* Move the vertices into the batch's space */
+    Mat4 to_local = this->transform->world_space_matrix().inversed() * transform;
+
+    VertexData vertices(spec);
+    mesh->vertex_data->clone_into(vertices);
+    vertices.transform_by(to_local);
+
+    if(spec.normal_attribute != VERTEX_ATTRIBUTE_NONE) {
+        /* Normals need the inverse-transpose, otherwise non-uniform
+         * scaling leaves them skewed off the surface */
+        Mat3 normal_matrix = Mat3(to_local).inversed().transposed();
+
+        for(uint32_t i = 0; i < vertices.count(); ++i) {
+            /* Copied straight away, packed normals are decoded into
+             * storage which the next normal_at() call reuses */
+            Vec3 n = *vertices.normal_at<Vec3>(i);
+
+            vertices.move_to(i);
+            vertices.normal(normal_matrix.transform_vector(n).normalized());
+        }
+    }
+
+    const uint32_t max_vertices = std::numeric_limits<uint16_t>::max();
+
+    /* Maps (chunk, source index) to the index of the copied vertex, so that
+     * shared vertices stay shared within a chunk */
+    std::unordered_map<Chunk*, std::unordered_map<uint32_t, uint32_t>> remap;
+
+    auto copy_vertex = [&](Chunk* chunk, uint32_t idx) -> uint32_t {
+        auto& chunk_map = remap[chunk];
+        auto it = chunk_map.find(idx);
+        if(it != chunk_map.end()) {
+            return it->second;
+        }
+
+        auto out = vertices.copy_vertex_to_another(*chunk->vertices, idx);
+        chunk_map.insert(std::make_pair(idx, out));
+        return out;
+    };
+
+    std::unordered_set<Chunk*> touched;
+
+    for(auto submesh: mesh->each_submesh()) {
+        auto arrangement = submesh->arrangement();
+        if(arrangement != MESH_ARRANGEMENT_TRIANGLES &&
+           arrangement != MESH_ARRANGEMENT_TRIANGLE_STRIP &&
+           arrangement != MESH_ARRANGEMENT_TRIANGLE_FAN) {
+            S_WARN("Skipping submesh {0}, only triangles can be batched",
+                   submesh->name());
+            continue;
+        }
+
+        auto material = submesh->material_at_slot(slot, true);
+
+        submesh->each_triangle([&](uint32_t a, uint32_t b, uint32_t c) {
+            Vec3 corners[3] = {
+                vertices.position_nd_at(a).xyz(),
+                vertices.position_nd_at(b).xyz(),
+                vertices.position_nd_at(c).xyz()
+            };
+
+            auto centroid = (corners[0] + corners[1] + corners[2]) / 3.0f;
+            auto key = cluster_key(centroid);
+
+            auto it = cluster_lookup_.find(key);
+            if(it == cluster_lookup_.end()) {
+                it = cluster_lookup_.insert(
+                    std::make_pair(key, clusters_.size())).first;
+
+                clusters_.push_back(Cluster());
+                clusters_.back().min = corners[0];
+                clusters_.back().max = corners[0];
+            }
+
+            auto& cluster = clusters_[it->second];
+            for(auto& corner: corners) {
+                cluster.min = Vec3::min(cluster.min, corner);
+                cluster.max = Vec3::max(cluster.max, corner);
+            }
+
+            auto chunk = chunk_for(cluster, material, spec);
+            if(chunk->vertices->count() + 3 > max_vertices) {
+                chunk = new_chunk(cluster, material, spec);
+            }
+
+            chunk->indexes->index(copy_vertex(chunk, a));
+            chunk->indexes->index(copy_vertex(chunk, b));
+            chunk->indexes->index(copy_vertex(chunk, c));
+
+            touched.insert(chunk);
+        });
+    }
+
+    if(touched.empty()) {
+        return false;
+    }
+
+    for(auto chunk: touched) {
+        chunk->vertices->done();
+        chunk->indexes->done();
+    }
+
+    Vec3 min = clusters_.front().min;
+    Vec3 max = clusters_.front().max;
+    for(auto& cluster: clusters_) {
+        min = Vec3::min(min, cluster.min);
+        max = Vec3::max(max, cluster.max);
+    }
+
+    aabb_.set_min_max(min, max);
+    mark_transformed_aabb_dirty();
+    return true;
+}
+
+void StaticBatch::clear() {
+    clusters_.clear();
+    cluster_lookup_.clear();
+    aabb_ = AABB();
+    mark_transformed_aabb_dirty();
+}
+
+std::size_t StaticBatch::chunk_count() const {
+    std::size_t count = 0;
+    for(auto& cluster: clusters_) {
+        count += cluster.chunks.size();
+    }
+
+    return count;
+}
+
+std::size_t StaticBatch::vertex_count() const {
+    std::size_t count = 0;
+    for(auto& cluster: clusters_) {
+        for(auto& chunk: cluster.chunks) {
+            count += chunk.vertices->count();
+        }
+    }
+
+    return count;
+}
+
+const AABB& StaticBatch::aabb() const {
+    return aabb_;
+}
+
+void StaticBatch::do_generate_renderables(batcher::RenderQueue* render_queue,
+                                          const Camera* camera,
+                                          const Viewport*,
+                                          const DetailLevel detail_level,
+                                          Light** lights,
+                                          const std::size_t light_count) {
+    _S_UNUSED(detail_level);
+
+    if(!is_visible()) {
+        return;
+    }
+
+    auto mat = transform->world_space_matrix();
+    auto rp = render_priority();
+    const auto& frustum = camera->frustum();
+
+    for(auto& cluster: clusters_) {
+        auto corners = AABB(
+            (cluster.min + cluster.max) * 0.5f, (cluster.max - cluster.min) * 0.5f
+        ).corners();
+        for(auto& corner: corners) {
+            corner = corner.transformed_by(mat);
+        }
+
+        AABB bounds(corners.data(), corners.size());
+        if(!frustum.intersects_aabb(bounds)) {
+            continue;
+        }
+
+        for(auto& chunk: cluster.chunks) {
+            Renderable new_renderable;
+            new_renderable.arrangement = MESH_ARRANGEMENT_TRIANGLES;
+            new_renderable.final_transformation = mat;
+            new_renderable.render_priority = rp;
+            new_renderable.is_visible = true;
+            new_renderable.vertex_data = chunk.vertices.get();
+            new_renderable.index_data = chunk.indexes.get();
+            new_renderable.index_element_count = chunk.indexes->count();
+            new_renderable.material = chunk.material.get();
+            new_renderable.center = bounds.center();
+            new_renderable.precedence = float(precedence());
+
+            new_renderable.light_count = light_count;
+            for(auto i = 0u; i < light_count; ++i) {
+                new_renderable.lights_affecting_this_frame[i] = lights[i];
+            }
+
+            render_queue->insert_renderable(std::move(new_renderable));
+        }
+    }
+}
+
+} // namespace smlt
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../interfaces.h"
+#include "../meshes/mesh.h"
+#include "stage_node.h"
+
+namespace smlt {
+
+class Actor;
+
+/**
+ * @brief The StaticBatch class
+ *
+ * A StaticBatch bakes lots of small pieces of static geometry (usually
+ * Actors which never move) into a few shared vertex and index buffers so
+ * that they can be drawn with far fewer draw calls. It's the same idea as
+ * a Geom, but for many meshes rather than one.
+ *
+ * Triangles are grouped into clusters by position (a grid of cells
+ * cluster_size wide), and within each cluster by material. Clusters are
+ * frustum culled as a whole, and each material in a visible cluster is a
+ * single draw.
+ *
+ * Vertices are transformed into the batch's space as they're added, so
+ * moving the source Actors afterwards has no effect on the batch. The
+ * source Actors are left alone, destroy or hide them once they've been
+ * added. The batch itself can still be moved as a whole.
+ *
+ * Animated meshes, and meshes with packed position formats, can't be
+ * batched. Octahedral and 10-10-10-2 normals are re-encoded in their own
+ * format after being transformed, other non-float normals are rejected.
+ */
+class StaticBatch:
+    public StageNode,
+    public virtual Boundable,
+    public HasMutableRenderPriority,
+    public ChainNameable<StaticBatch> {
+
+public:
+    S_DEFINE_STAGE_NODE_META("static_batch");
+    S_DEFINE_STAGE_NODE_PARAM(StaticBatch, "cluster_size", float, 32.0f,
+                              "The width of the cells geometry is clustered into");
+
+    StaticBatch(Scene* owner);
+
+    /**
+     * Adds the actor's base mesh, using its current world transform and
+     * active material slot. Returns false if the mesh can't be batched.
+     */
+    bool add_actor(Actor* actor);
+
+    /** Adds each of the actors, returns the number which were added */
+    std::size_t add_actors(const std::vector<Actor*>& actors);
+
+    /**
+     * Adds a mesh with the given world transform. Returns false if the
+     * mesh can't be batched.
+     */
+    bool add_mesh(const MeshPtr& mesh, const Mat4& transform,
+                  MaterialSlot slot = MATERIAL_SLOT0);
+
+    /** Removes everything from the batch */
+    void clear();
+
+    float cluster_size() const {
+        return cluster_size_;
+    }
+
+    std::size_t cluster_count() const {
+        return clusters_.size();
+    }
+
+    /** The number of draws needed if every cluster is visible */
+    std::size_t chunk_count() const;
+
+    std::size_t vertex_count() const;
+
+    const AABB& aabb() const override;
+
+    void do_generate_renderables(batcher::RenderQueue* render_queue,
+                                 const Camera* camera, const Viewport* viewport,
+                                 const DetailLevel detail_level, Light** lights,
+                                 const std::size_t light_count) override;
+
+    bool on_create(Params params) override;
+
+private:
+    /* The vertices and triangles of one material (and vertex format) in a
+     * cluster. Chunks are split before their indexes outgrow 16 bits. */
+    struct Chunk {
+        MaterialPtr material;
+        std::unique_ptr<VertexData> vertices;
+        std::unique_ptr<IndexData> indexes;
+    };
+
+    /* Chunks and clusters live in deques so that pointers to them stay
+     * valid while geometry is being added */
+    struct Cluster {
+        Vec3 min;
+        Vec3 max;
+        std::deque<Chunk> chunks;
+    };
+
+    Chunk* new_chunk(Cluster& cluster, const MaterialPtr& material,
+                     const VertexSpecification& spec);
+    Chunk* chunk_for(Cluster& cluster, const MaterialPtr& material,
+                     const VertexSpecification& spec);
+
+    uint64_t cluster_key(const Vec3& point) const;
+
+    float cluster_size_ = 32.0f;
+
+    std::deque<Cluster> clusters_;
+    std::unordered_map<uint64_t, std::size_t> cluster_lookup_;
+
+    AABB aabb_;
+};
+
+} // namespace smlt
@@ -11,6 +11,11 @@ namespace smlt {
 void Partitioner::_apply_writes() {
     for(auto& p: staged_writes_) {
         for(auto& sw: p.second) {
+            if(sw.operation != WRITE_OPERATION_REMOVE) {
+                /* Any further changes will need a new write */
+                sw.node->partitioner_dirty_ = false;
+            }
+
             apply_staged_write(sw);
         }
     }
@@ -27,6 +32,26 @@ void Partitioner::stage_write(StageNode* node, const StagedWrite& op) {
 
     auto& list = staged_writes_.at(node);
 
+    if(op.operation == WRITE_OPERATION_REMOVE) {
+        /* Pending updates are pointless if the node is going away, and
+         * the node may have been freed by the time writes are applied */
+        while(!list.empty() && list.back().operation == WRITE_OPERATION_UPDATE) {
+            list.pop_back();
+            write_count_--;
+        }
+
+        /* If the add never happened, then neither does the remove */
+        if(!list.empty() && list.back().operation == WRITE_OPERATION_ADD) {
+            list.pop_back();
+            write_count_--;
+            return;
+        }
+    } else if(op.operation == WRITE_OPERATION_UPDATE && !list.empty() &&
+              list.back().operation == WRITE_OPERATION_ADD) {
+        /* The add will pick up the latest bounds */
+        return;
+    }
+
     /* If someone sends a list of updates, we only store the last one
      * (we update the existing entry), otherwise we add to the queue */
     if(!list.empty() && list.back().operation == op.operation) {
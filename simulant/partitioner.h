@@ -63,7 +63,17 @@ public:
     };
 
     Partitioner(Scene* owner, StageNodeType node_type):
-        StageNode(owner, node_type) {}
+        StageNode(owner, node_type) {
+        is_partitioner_ = true;
+    }
+
+    /* If this returns true, descendents stage writes to this partitioner
+     * when they are added, removed, or their bounds change. Partitioners
+     * that don't maintain a spatial structure should return false to avoid
+     * the bookkeeping. */
+    virtual bool tracks_stage_nodes() const {
+        return true;
+    }
 
     void add_stage_node(StageNode* node) {
         StagedWrite write;
@@ -72,6 +82,8 @@ public:
         stage_write(node, write);
     }
 
+    /* Nodes stage updates lazily, so the bounds passed here may be stale;
+     * use node->transformed_aabb() when the write is applied */
     void update_stage_node(StageNode* node, const AABB& bounds) {
         StagedWrite write;
         write.operation = WRITE_OPERATION_UPDATE;
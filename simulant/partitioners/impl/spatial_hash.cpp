@@ -49,28 +49,21 @@ void SpatialHash::update_object_for_box(const AABB& new_box, SpatialHashEntry* o
         new_keys.insert(key);
     }
 
-    KeyList keys_to_add, keys_to_remove;
-
-    std::set_difference(
-        new_keys.begin(), new_keys.end(), old_keys.begin(), old_keys.end(),
-        std::inserter(keys_to_add, keys_to_add.end())
-    );
-
-    std::set_difference(
-        old_keys.begin(), old_keys.end(), new_keys.begin(), new_keys.end(),
-        std::inserter(keys_to_remove, keys_to_remove.end())
-    );
-
     if(new_keys.empty() && old_keys.empty()) {
         return;
     }
 
-    for(auto& key: keys_to_remove) {
-        erase_object_from_key(key, object);
+    /* KeyLists are unordered, so std::set_difference can't be used here */
+    for(auto& key: old_keys) {
+        if(!new_keys.count(key)) {
+            erase_object_from_key(key, object);
+        }
     }
 
-    for(auto& key: keys_to_add) {
-        insert_object_for_key(key, object);
+    for(auto& key: new_keys) {
+        if(!old_keys.count(key)) {
+            insert_object_for_key(key, object);
+        }
     }
 
     object->set_hash_aabb(new_box);
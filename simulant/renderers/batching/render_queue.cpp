@@ -59,10 +59,16 @@ RenderGroupKey generate_render_group_key(
     return key;
 }
 
-RenderQueue::RenderQueue() {
+RenderQueue::RenderQueue(RenderQueueMode mode):
+    mode_(mode) {
 
 }
 
+void RenderQueue::set_mode(RenderQueueMode mode) {
+    clear();
+    mode_ = mode;
+}
+
 void RenderQueue::reset(StageNode* stage, RenderGroupFactory* factory, CameraPtr camera) {
     stage_node_ = stage;
     render_group_factory_ = factory;
@@ -101,6 +107,10 @@ void RenderQueue::insert_renderable(Renderable&& renderable) {
     auto renderable_dist_to_camera = plane.distance_to(pos);
     auto priority = renderable.render_priority;
 
+    if(mode_ == RENDER_QUEUE_MODE_FLAT) {
+        flat_renderables_.push_back(std::move(renderable));
+    }
+
     auto pass_count = material->pass_count();
     for(auto i = 0u; i < pass_count; ++i) {
         MaterialPass* pass = material->pass(i);
@@ -115,13 +125,80 @@ void RenderQueue::insert_renderable(Renderable&& renderable) {
                 ? material->base_color_map()->_renderer_specific_id()
                 : 0);
 
-        render_queue_.insert(group, std::move(renderable));
+        if(mode_ == RENDER_QUEUE_MODE_FLAT) {
+            /* Renderables are stored once, and referenced by each pass */
+            FlatEntry entry;
+            entry.group = group;
+            entry.index = flat_renderables_.size() - 1;
+            flat_queue_.push_back(entry);
+            flat_queue_sorted_ = false;
+        } else {
+            render_queue_.insert(group, std::move(renderable));
+        }
     }
 }
 
+void RenderQueue::sort_flat_queue() const {
+    if(flat_queue_sorted_) {
+        return;
+    }
+
+    /* LSD radix sort over the 32bit key, a byte at a time. This is stable
+     * so renderables with the same key keep their insertion order, which
+     * matches the behaviour of the tree */
+    const std::size_t count = flat_queue_.size();
+    flat_scratch_.resize(count);
+
+    FlatEntry* src = flat_queue_.data();
+    FlatEntry* dst = flat_scratch_.data();
+
+    uint32_t histogram[4][256] = {{0}};
+    for(std::size_t i = 0; i < count; ++i) {
+        const uint32_t key = src[i].group.sort_key.i;
+        histogram[0][key & 0xFF]++;
+        histogram[1][(key >> 8) & 0xFF]++;
+        histogram[2][(key >> 16) & 0xFF]++;
+        histogram[3][(key >> 24) & 0xFF]++;
+    }
+
+    for(uint32_t b = 0; b < 4; ++b) {
+        const uint32_t shift = b * 8;
+        uint32_t* h = histogram[b];
+
+        /* If every key has the same byte, this pass would do nothing */
+        if(count && h[(src[0].group.sort_key.i >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for(uint32_t j = 0; j < 256; ++j) {
+            uint32_t c = h[j];
+            h[j] = offset;
+            offset += c;
+        }
+
+        for(std::size_t i = 0; i < count; ++i) {
+            dst[h[(src[i].group.sort_key.i >> shift) & 0xFF]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if(src != flat_queue_.data()) {
+        flat_queue_.swap(flat_scratch_);
+    }
+
+    flat_queue_sorted_ = true;
+}
+
 void RenderQueue::clear() {
     thread::Lock<thread::Mutex> lock(queue_lock_);
     render_queue_.clear();
+
+    /* These keep their capacity, so a steady scene doesn't allocate */
+    flat_renderables_.clear();
+    flat_queue_.clear();
+    flat_queue_sorted_ = true;
 }
 
 void RenderQueue::traverse(RenderQueueVisitor* visitor, uint64_t frame_id) const {
@@ -134,10 +211,7 @@ void RenderQueue::traverse(RenderQueueVisitor* visitor, uint64_t frame_id) const
 
     const RenderGroup* last_group = nullptr;
 
-    for(auto& p: render_queue_) {
-        const RenderGroup* current_group = &p.first;
-        const Renderable* renderable = &p.second;
-
+    auto visit = [&](const RenderGroup* current_group, const Renderable* renderable) {
         /* We do this here so that we don't change render group unless something
          * in the new group is visible */
         if(!last_group || *current_group != *last_group) {
@@ -186,12 +260,32 @@ void RenderQueue::traverse(RenderQueueVisitor* visitor, uint64_t frame_id) const
         }
 
         last_group = current_group;
+    };
+
+    if(mode_ == RENDER_QUEUE_MODE_FLAT) {
+        sort_flat_queue();
+
+        for(auto& entry: flat_queue_) {
+            visit(&entry.group, &flat_renderables_[entry.index]);
+        }
+    } else {
+        for(auto& p: render_queue_) {
+            visit(&p.first, &p.second);
+        }
     }
 
     visitor->end_traversal(*this, stage_node_);
 }
 
 Renderable* RenderQueue::renderable(std::size_t idx) {
+    if(mode_ == RENDER_QUEUE_MODE_FLAT) {
+        thread::Lock<thread::Mutex> lock(queue_lock_);
+        sort_flat_queue();
+
+        return (idx < flat_queue_.size()) ?
+            &flat_renderables_[flat_queue_[idx].index] : nullptr;
+    }
+
     std::size_t i = 0;
     for(auto& r: render_queue_) {
         if(i == idx) {
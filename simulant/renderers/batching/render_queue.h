@@ -20,6 +20,7 @@
 
 #include <list>
 #include <set>
+#include <vector>
 
 #include "../../generic/containers/contiguous_map.h"
 
@@ -166,21 +167,37 @@ private:
 };
 
 
+enum RenderQueueMode {
+    /* Each material pass of a renderable is inserted into a sorted
+     * tree as it's added */
+    RENDER_QUEUE_MODE_TREE,
+
+    /* Renderables are appended to a flat array alongside a (key, index)
+     * pair per pass. The pairs are radix sorted once before traversal. */
+    RENDER_QUEUE_MODE_FLAT
+};
+
 class RenderQueue {
 public:
     typedef std::function<void (bool, const RenderGroup*, Renderable*, MaterialPass*, Light*, Iteration)> TraverseCallback;
 
-    RenderQueue();
+    RenderQueue(RenderQueueMode mode=RENDER_QUEUE_MODE_FLAT);
 
     void reset(StageNode* stage, RenderGroupFactory* render_group_factory, CameraPtr camera);
 
+    /* Changing the mode clears the queue */
+    void set_mode(RenderQueueMode mode);
+    RenderQueueMode mode() const {
+        return mode_;
+    }
+
     void insert_renderable(Renderable&& renderable); // IMPORTANT, must update RenderGroups if they exist already
     void clear();
 
     void traverse(RenderQueueVisitor* callback, uint64_t frame_id) const;
 
     std::size_t renderable_count() const {
-        return render_queue_.size();
+        return (mode_ == RENDER_QUEUE_MODE_FLAT) ? flat_queue_.size() : render_queue_.size();
     }
 
     Renderable* renderable(std::size_t idx);
@@ -198,6 +215,23 @@ private:
 
     SortedRenderables render_queue_;
 
+    struct FlatEntry {
+        RenderGroup group;
+        uint32_t index;
+    };
+
+    RenderQueueMode mode_;
+
+    std::vector<Renderable, aligned_allocator<Renderable, 32>> flat_renderables_;
+
+    /* Sorted lazily, hence mutable. The scratch buffer is kept around
+     * to avoid reallocating it each frame */
+    mutable std::vector<FlatEntry> flat_queue_;
+    mutable std::vector<FlatEntry> flat_scratch_;
+    mutable bool flat_queue_sorted_ = true;
+
+    void sort_flat_queue() const;
+
     void clean_empty_batches();
 
     mutable thread::Mutex queue_lock_;
@@ -71,6 +71,10 @@ struct alignas(8) Renderable final {
     const IndexData* index_data = nullptr;
     std::size_t index_element_count = 0;
 
+    /* The first of the index_element_count indexes to draw, so that
+     * several renderables can draw ranges of one IndexData */
+    std::size_t index_offset = 0;
+
     const VertexRange* vertex_ranges = nullptr;
     std::size_t vertex_range_count = 0;
 
@@ -84,6 +88,26 @@ struct alignas(8) Renderable final {
 
     smlt::Vec3 center;
     float precedence = 0.0f;
+
+    /* If instance_count is non-zero the geometry is drawn once for each
+     * of the instance_transformations, each of which is relative to
+     * final_transformation. The array must outlive the render queue
+     * traversal. Only renderers which return true from
+     * supports_instancing() will be given instanced renderables. */
+    const Mat4* instance_transformations = nullptr;
+    uint32_t instance_count = 0;
+
+    /* Used instead of instance_transformations. One vertex of this is
+     * read for each instance rather than for each vertex, and its
+     * attributes are given to the shader's s_instance_* attributes. It
+     * must have at least instance_count vertices. Only renderers which
+     * return true from supports_instance_attributes() will be given it. */
+    const VertexData* instance_data = nullptr;
+
+    /* Set for meshes which are skinned in the vertex shader. The palette
+     * is owned by the Mesh and is relative to final_transformation. */
+    const Mat4* joint_palette = nullptr;
+    uint16_t joint_count = 0;
 };
 
 typedef std::shared_ptr<Renderable> RenderablePtr;
@@ -599,7 +599,9 @@ void GL1RenderQueueVisitor::do_visit(const Renderable* renderable,
 
     if(element_count) {
         /* Indexed renderable */
-        const auto index_data = renderable->index_data->data();
+        const auto index_data =
+            renderable->index_data->data() +
+            renderable->index_offset * renderable->index_data->stride();
         auto index_type =
             convert_index_type(renderable->index_data->index_type());
 
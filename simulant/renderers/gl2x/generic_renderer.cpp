@@ -17,9 +17,13 @@
 //     along with Simulant.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <cstring>
+
 #include "generic_renderer.h"
 
 #include "../../asset_manager.h"
+#include "../../material_constants.h"
+#include "../../assets/materials/core/core_material.h"
 #include "../../nodes/actor.h"
 #include "../../nodes/camera.h"
 #include "../../nodes/light.h"
@@ -96,22 +100,72 @@ batcher::RenderGroupKey GenericRenderer::prepare_render_group(
         renderable->precedence, texture_id);
 }
 
+/* Uniform name hashes, so that finding a uniform doesn't involve any
+ * strings. Material properties use the same hash, so the hashes in
+ * core_material.h can be used directly. */
+static constexpr UniformNameHash LIGHT_POSITION_HASH = uniform_name_hash(LIGHT_POSITION_PROPERTY);
+static constexpr UniformNameHash LIGHT_COLOR_HASH = uniform_name_hash(LIGHT_COLOR_PROPERTY);
+static constexpr UniformNameHash LIGHT_INTENSITY_HASH = uniform_name_hash(LIGHT_INTENSITY_PROPERTY);
+static constexpr UniformNameHash LIGHT_RANGE_HASH = uniform_name_hash(LIGHT_RANGE_PROPERTY);
+static constexpr UniformNameHash LIGHT_COUNT_HASH = uniform_name_hash(LIGHT_COUNT_PROPERTY);
+static constexpr UniformNameHash VIEW_MATRIX_HASH = uniform_name_hash(VIEW_MATRIX_PROPERTY);
+static constexpr UniformNameHash MODELVIEW_PROJECTION_MATRIX_HASH = uniform_name_hash(MODELVIEW_PROJECTION_MATRIX_PROPERTY);
+static constexpr UniformNameHash PROJECTION_MATRIX_HASH = uniform_name_hash(PROJECTION_MATRIX_PROPERTY);
+static constexpr UniformNameHash MODELVIEW_MATRIX_HASH = uniform_name_hash(MODELVIEW_MATRIX_PROPERTY);
+static constexpr UniformNameHash INVERSE_TRANSPOSE_MODELVIEW_MATRIX_HASH = uniform_name_hash(INVERSE_TRANSPOSE_MODELVIEW_MATRIX_PROPERTY);
+static constexpr UniformNameHash JOINT_PALETTE_HASH = uniform_name_hash(JOINT_PALETTE_PROPERTY);
+static constexpr UniformNameHash GLOBAL_AMBIENT_HASH = uniform_name_hash("s_global_ambient");
+static constexpr UniformNameHash POSITION_SCALE_HASH = uniform_name_hash(POSITION_SCALE_PROPERTY);
+static constexpr UniformNameHash POSITION_OFFSET_HASH = uniform_name_hash(POSITION_OFFSET_PROPERTY);
+static constexpr UniformNameHash OCTAHEDRAL_NORMALS_HASH = uniform_name_hash(OCTAHEDRAL_NORMALS_PROPERTY);
+
+struct LightUniformHashes {
+    UniformNameHash position;
+    UniformNameHash color;
+    UniformNameHash intensity;
+    UniformNameHash range;
+};
+
+/* The hashes of "s_light_position[i]" etc. for each light */
+static const LightUniformHashes& light_uniform_hashes(uint8_t light_id) {
+    static const std::vector<LightUniformHashes> hashes = []() {
+        std::vector<LightUniformHashes> ret;
+        for(uint32_t i = 0; i < MAX_LIGHTS_PER_RENDERABLE; ++i) {
+            ret.push_back({
+                uniform_element_hash(LIGHT_POSITION_HASH, i),
+                uniform_element_hash(LIGHT_COLOR_HASH, i),
+                uniform_element_hash(LIGHT_INTENSITY_HASH, i),
+                uniform_element_hash(LIGHT_RANGE_HASH, i)
+            });
+        }
+        return ret;
+    }();
+
+    assert(light_id < hashes.size());
+    return hashes[light_id];
+}
+
 void GenericRenderer::set_light_uniforms(const MaterialPass* pass,
                                          GPUProgram* program, uint8_t light_id,
                                          const LightPtr light) {
     _S_UNUSED(pass);
 
-    LimitedVector<std::string, 2> suffixes;
-    suffixes.push_back(_F("[{0}]").format(light_id));
+    static const LightUniformHashes bare = {
+        LIGHT_POSITION_HASH, LIGHT_COLOR_HASH, LIGHT_INTENSITY_HASH,
+        LIGHT_RANGE_HASH
+    };
+
+    /* The first light can also be accessed without an index, for shaders
+     * which only handle a single light */
+    LimitedVector<const LightUniformHashes*, 2> names;
+    names.push_back(&light_uniform_hashes(light_id));
     if(light_id == 0) {
-        suffixes.push_back("");
+        names.push_back(&bare);
     }
 
-    for(std::size_t i = 0; i < suffixes.size(); ++i) {
-        auto sfx = suffixes[i];
-        auto pos_loc =
-            program->locate_uniform(LIGHT_POSITION_PROPERTY + sfx, true);
-        if(pos_loc > -1) {
+    for(std::size_t i = 0; i < names.size(); ++i) {
+        auto pos_slot = program->uniform_slot(names[i]->position);
+        if(pos_slot.is_valid()) {
             auto pos = (light) ? light->transform->position() : Vec3();
             if(light && light->light_type() == LIGHT_TYPE_DIRECTIONAL) {
                 pos = light->direction();
@@ -122,28 +176,25 @@ void GenericRenderer::set_light_uniforms(const MaterialPass* pass,
                                     ? 0.0
                                     : 1.0)
                     : Vec4();
-            program->set_uniform_vec4(pos_loc, vec);
+            program->set_uniform_vec4(pos_slot, vec);
         }
 
-        auto amb_loc =
-            program->locate_uniform(LIGHT_COLOR_PROPERTY + sfx, true);
-        if(amb_loc > -1) {
-            program->set_uniform_color(amb_loc, (light) ? light->color()
-                                                        : Color::none());
+        auto amb_slot = program->uniform_slot(names[i]->color);
+        if(amb_slot.is_valid()) {
+            program->set_uniform_color(amb_slot, (light) ? light->color()
+                                                         : Color::none());
         }
 
-        auto intensity_loc =
-            program->locate_uniform(LIGHT_INTENSITY_PROPERTY + sfx, true);
-        if(intensity_loc > -1) {
+        auto intensity_slot = program->uniform_slot(names[i]->intensity);
+        if(intensity_slot.is_valid()) {
             auto att = (light) ? light->intensity() : 0;
-            program->set_uniform_float(intensity_loc, att);
+            program->set_uniform_float(intensity_slot, att);
         }
 
-        auto range_loc =
-            program->locate_uniform(LIGHT_RANGE_PROPERTY + sfx, true);
-        if(range_loc > -1) {
+        auto range_slot = program->uniform_slot(names[i]->range);
+        if(range_slot.is_valid()) {
             auto att = (light) ? light->range() : 0;
-            program->set_uniform_float(range_loc, att);
+            program->set_uniform_float(range_slot, att);
         }
     }
 }
@@ -152,35 +203,34 @@ void GenericRenderer::set_material_uniforms(const MaterialPass* pass,
                                             GPUProgram* program) {
     auto mat = pass->material();
 
-    auto r_loc = program->locate_uniform(ROUGHNESS_PROPERTY_NAME, true);
-    if(r_loc > -1) {
-        program->set_uniform_float(r_loc, pass->roughness());
+    auto r_slot = program->uniform_slot(ROUGHNESS_PROPERTY_HASH);
+    if(r_slot.is_valid()) {
+        program->set_uniform_float(r_slot, pass->roughness());
     }
 
-    auto m_loc = program->locate_uniform(METALLIC_PROPERTY_NAME, true);
-    if(m_loc > -1) {
-        program->set_uniform_float(m_loc, pass->metallic());
+    auto m_slot = program->uniform_slot(METALLIC_PROPERTY_HASH);
+    if(m_slot.is_valid()) {
+        program->set_uniform_float(m_slot, pass->metallic());
     }
 
-    auto diff_loc = program->locate_uniform(BASE_COLOR_PROPERTY_NAME, true);
-    if(diff_loc > -1) {
-        program->set_uniform_color(diff_loc, pass->base_color());
+    auto diff_slot = program->uniform_slot(BASE_COLOR_PROPERTY_HASH);
+    if(diff_slot.is_valid()) {
+        program->set_uniform_color(diff_slot, pass->base_color());
     }
 
-    auto spec_loc = program->locate_uniform(SPECULAR_COLOR_PROPERTY_NAME, true);
-    if(spec_loc > -1) {
-        program->set_uniform_color(spec_loc, pass->specular_color());
+    auto spec_slot = program->uniform_slot(SPECULAR_COLOR_PROPERTY_HASH);
+    if(spec_slot.is_valid()) {
+        program->set_uniform_color(spec_slot, pass->specular_color());
     }
 
-    auto shin_loc = program->locate_uniform(SPECULAR_PROPERTY_NAME, true);
-    if(shin_loc > -1) {
-        program->set_uniform_float(shin_loc, pass->specular());
+    auto shin_slot = program->uniform_slot(SPECULAR_PROPERTY_HASH);
+    if(shin_slot.is_valid()) {
+        program->set_uniform_float(shin_slot, pass->specular());
     }
 
-    auto ps_loc = program->locate_uniform(POINT_SIZE_PROPERTY_NAME, true);
-    if(ps_loc > -1) {
-        program->set_uniform_float(POINT_SIZE_PROPERTY_NAME,
-                                   pass->point_size());
+    auto ps_slot = program->uniform_slot(POINT_SIZE_PROPERTY_HASH);
+    if(ps_slot.is_valid()) {
+        program->set_uniform_float(ps_slot, pass->point_size());
     }
 
     /* Each texture property has a counterpart matrix, this passes those down if
@@ -190,18 +240,18 @@ void GenericRenderer::set_material_uniforms(const MaterialPass* pass,
     for(auto& tex_prop: texture_props) {
         auto& info = tex_prop.second;
 
-        auto tloc = program->locate_uniform(info.texture_property_name, true);
+        auto tslot = program->uniform_slot(info.texture_property_name_hash);
 
-        if(tloc > -1) {
+        if(tslot.is_valid()) {
             // This texture is being used
-            program->set_uniform_int(tloc, texture_unit++);
+            program->set_uniform_int(tslot, texture_unit++);
         }
 
-        auto loc = program->locate_uniform(info.matrix_property_name, true);
-        if(loc > -1) {
+        auto slot = program->uniform_slot(info.matrix_property_name_hash);
+        if(slot.is_valid()) {
             const Mat4* mat;
             if(pass->property_value(info.matrix_property_name_hash, mat)) {
-                program->set_uniform_mat4x4(loc, *mat);
+                program->set_uniform_mat4x4(slot, *mat);
             }
         }
     }
@@ -212,19 +262,26 @@ void GenericRenderer::set_stage_uniforms(const MaterialPass* pass,
                                          const Color& global_ambient) {
     _S_UNUSED(pass);
 
-    auto varname = "s_global_ambient";
-    auto loc = program->locate_uniform(varname, true);
+    auto slot = program->uniform_slot(GLOBAL_AMBIENT_HASH);
 
-    if(loc > -1) {
-        program->set_uniform_color(loc, global_ambient);
+    if(slot.is_valid()) {
+        program->set_uniform_color(slot, global_ambient);
     }
 }
 
 /* Shadows GL state to avoid unnecessary GL calls */
-static uint8_t enabled_vertex_attributes_ = 0;
+static uint32_t enabled_vertex_attributes_ = 0;
+
+/* The constant value of each attribute location, used while its array is
+ * disabled. A bit is only set while the value is known, drawing with the
+ * array enabled leaves the value undefined. */
+static uint32_t known_attribute_values_ = 0;
+static float attribute_values_[32][4];
 
 void enable_vertex_attribute(uint8_t i) {
-    uint8_t v = 1 << i;
+    uint32_t v = 1u << i;
+    known_attribute_values_ &= ~v;
+
     if((enabled_vertex_attributes_ & v) == v) {
         return;
     }
@@ -235,7 +292,7 @@ void enable_vertex_attribute(uint8_t i) {
 }
 
 void disable_vertex_attribute(uint8_t i) {
-    uint8_t v = 1 << i;
+    uint32_t v = 1u << i;
 
     if((enabled_vertex_attributes_ & v) != v) {
         return;
@@ -246,11 +303,38 @@ void disable_vertex_attribute(uint8_t i) {
     enabled_vertex_attributes_ ^= v;
 }
 
+/* Disables the array at `i` and sets its constant value, unless it
+ * already has that value */
+static void set_constant_attribute(uint8_t i, const float* value) {
+    disable_vertex_attribute(i);
+
+    uint32_t v = 1u << i;
+    if((known_attribute_values_ & v) &&
+       std::memcmp(attribute_values_[i], value, sizeof(attribute_values_[i])) == 0) {
+        return;
+    }
+
+    GLCheck(glVertexAttrib4fv, i, value);
+    std::memcpy(attribute_values_[i], value, sizeof(attribute_values_[i]));
+    known_attribute_values_ |= v;
+}
+
+/* Not in the GL 2.1 headers. Core in GL 3.0 (and ARB_half_float_vertex),
+ * OES_vertex_half_float uses a different value on ES */
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+
 template<typename EnabledMethod, typename OffsetMethod>
 void send_attribute(int32_t loc, VertexAttributeType attr,
                     const VertexSpecification& vertex_spec,
                     EnabledMethod exists_on_data_predicate,
-                    OffsetMethod offset_func, uint32_t global_offset) {
+                    OffsetMethod offset_func, uint32_t global_offset,
+                    GLenum half_float_type) {
 
     if(loc > -1 && (vertex_spec.*exists_on_data_predicate)()) {
         auto offset = (vertex_spec.*offset_func)(false);
@@ -261,21 +345,45 @@ void send_attribute(int32_t loc, VertexAttributeType attr,
         auto attr_size = vertex_attribute_size(attr_for_type);
         auto stride = vertex_spec.stride();
 
+        /* Joint indices (4UB/4US) arrive in the shader as un-normalized
+         * floats, GLSL 1.x has no integer attributes */
         auto type = (attr_for_type == VERTEX_ATTRIBUTE_4UB_RGBA ||
-                     attr_for_type == VERTEX_ATTRIBUTE_4UB_BGRA)
+                     attr_for_type == VERTEX_ATTRIBUTE_4UB_BGRA ||
+                     attr_for_type == VERTEX_ATTRIBUTE_4UB)
                         ? GL_UNSIGNED_BYTE
+                    : (attr_for_type == VERTEX_ATTRIBUTE_4US)
+                        ? GL_UNSIGNED_SHORT
                     : (attr_for_type == VERTEX_ATTRIBUTE_PACKED_VEC4_1I)
                         ? GL_UNSIGNED_INT_2_10_10_10_REV
+                    : (attr_for_type == VERTEX_ATTRIBUTE_3S_NORMALIZED ||
+                       attr_for_type == VERTEX_ATTRIBUTE_2S_OCTAHEDRAL)
+                        ? GL_SHORT
+                    : (attr_for_type == VERTEX_ATTRIBUTE_2B_OCTAHEDRAL)
+                        ? GL_BYTE
+                    : (attr_for_type == VERTEX_ATTRIBUTE_2H)
+                        ? half_float_type
                         : GL_FLOAT;
 
         auto size = (attr_for_type == VERTEX_ATTRIBUTE_4UB_BGRA) ? GL_BGRA
                     : (attr_for_type == VERTEX_ATTRIBUTE_PACKED_VEC4_1I ||
-                       attr_for_type == VERTEX_ATTRIBUTE_4UB_RGBA)
+                       attr_for_type == VERTEX_ATTRIBUTE_4UB_RGBA ||
+                       attr_for_type == VERTEX_ATTRIBUTE_4UB ||
+                       attr_for_type == VERTEX_ATTRIBUTE_4US)
                         ? 4
+                    : (attr_for_type == VERTEX_ATTRIBUTE_3S_NORMALIZED)
+                        ? 3
+                    : (attr_for_type == VERTEX_ATTRIBUTE_2S_OCTAHEDRAL ||
+                       attr_for_type == VERTEX_ATTRIBUTE_2B_OCTAHEDRAL ||
+                       attr_for_type == VERTEX_ATTRIBUTE_2H)
+                        ? 2
                         : attr_size / sizeof(float);
 
+        /* Quantized positions and normals arrive in the shader as -1..1 */
         auto normalized = (attr_for_type == VERTEX_ATTRIBUTE_4UB_RGBA ||
-                           attr_for_type == VERTEX_ATTRIBUTE_4UB_BGRA)
+                           attr_for_type == VERTEX_ATTRIBUTE_4UB_BGRA ||
+                           attr_for_type == VERTEX_ATTRIBUTE_3S_NORMALIZED ||
+                           attr_for_type == VERTEX_ATTRIBUTE_2S_OCTAHEDRAL ||
+                           attr_for_type == VERTEX_ATTRIBUTE_2B_OCTAHEDRAL)
                               ? GL_TRUE
                               : GL_FALSE;
 
@@ -300,37 +408,156 @@ void GenericRenderer::set_auto_attributes_on_shader(
     const VertexSpecification& vertex_spec =
         renderable->vertex_data->vertex_specification();
     auto offset = buffers->vertex_vbo->byte_offset(buffers->vertex_vbo_slot);
+    auto half_float = (use_es_) ? GL_HALF_FLOAT_OES : GL_HALF_FLOAT;
 
     send_attribute(program->locate_attribute("s_position", true),
                    VERTEX_ATTRIBUTE_TYPE_POSITION, vertex_spec,
                    &VertexSpecification::has_positions,
-                   &VertexSpecification::position_offset, offset);
+                   &VertexSpecification::position_offset, offset,
+                   half_float);
 
     send_attribute(program->locate_attribute("s_color", true),
                    VERTEX_ATTRIBUTE_TYPE_COLOR, vertex_spec,
                    &VertexSpecification::has_color,
-                   &VertexSpecification::color_offset, offset);
+                   &VertexSpecification::color_offset, offset,
+                   half_float);
 
     send_attribute(program->locate_attribute("s_texcoord0", true),
                    VERTEX_ATTRIBUTE_TYPE_TEXCOORD0, vertex_spec,
                    &VertexSpecification::has_texcoord0,
-                   &VertexSpecification::texcoord0_offset, offset);
+                   &VertexSpecification::texcoord0_offset, offset,
+                   half_float);
     send_attribute(program->locate_attribute("s_texcoord1", true),
                    VERTEX_ATTRIBUTE_TYPE_TEXCOORD1, vertex_spec,
                    &VertexSpecification::has_texcoord1,
-                   &VertexSpecification::texcoord1_offset, offset);
+                   &VertexSpecification::texcoord1_offset, offset,
+                   half_float);
     send_attribute(program->locate_attribute("s_texcoord2", true),
                    VERTEX_ATTRIBUTE_TYPE_TEXCOORD2, vertex_spec,
                    &VertexSpecification::has_texcoord2,
-                   &VertexSpecification::texcoord2_offset, offset);
+                   &VertexSpecification::texcoord2_offset, offset,
+                   half_float);
     send_attribute(program->locate_attribute("s_texcoord3", true),
                    VERTEX_ATTRIBUTE_TYPE_TEXCOORD3, vertex_spec,
                    &VertexSpecification::has_texcoord3,
-                   &VertexSpecification::texcoord3_offset, offset);
+                   &VertexSpecification::texcoord3_offset, offset,
+                   half_float);
     send_attribute(program->locate_attribute("s_normal", true),
                    VERTEX_ATTRIBUTE_TYPE_NORMAL, vertex_spec,
                    &VertexSpecification::has_normals,
-                   &VertexSpecification::normal_offset, offset);
+                   &VertexSpecification::normal_offset, offset,
+                   half_float);
+    send_attribute(program->locate_attribute(JOINTS_ATTRIBUTE, true),
+                   VERTEX_ATTRIBUTE_TYPE_JOINTS, vertex_spec,
+                   &VertexSpecification::has_joints,
+                   &VertexSpecification::joint_offset, offset,
+                   half_float);
+    send_attribute(program->locate_attribute(WEIGHTS_ATTRIBUTE, true),
+                   VERTEX_ATTRIBUTE_TYPE_WEIGHTS, vertex_spec,
+                   &VertexSpecification::has_weights,
+                   &VertexSpecification::weight_offset, offset,
+                   half_float);
+
+    /* Shaders which support instancing see neutral instance attributes
+     * unless send_instanced_geometry says otherwise. The values are only
+     * uploaded if an instanced draw changed them. */
+    const auto& instance = program->instance_attributes();
+    if(instance.transformation > -1) {
+        set_instance_attribute(instance.transformation, Mat4());
+    }
+
+    static const float position_default[] = {0, 0, 0, 1};
+    static const float texcoord0_default[] = {1, 1, 0, 1};
+    static const float color_default[] = {1, 1, 1, 1};
+
+    if(instance.position > -1) {
+        set_constant_attribute(instance.position, position_default);
+    }
+
+    if(instance.texcoord0 > -1) {
+        set_constant_attribute(instance.texcoord0, texcoord0_default);
+    }
+
+    if(instance.color > -1) {
+        set_constant_attribute(instance.color, color_default);
+    }
+
+    set_vertex_decode_uniforms(program, renderable->vertex_data);
+}
+
+void GenericRenderer::set_vertex_decode_uniforms(GPUProgram* program,
+                                                 const VertexData* vertex_data) {
+    const VertexSpecification& vertex_spec = vertex_data->vertex_specification();
+
+    bool quantized_positions =
+        vertex_spec.position_attribute == VERTEX_ATTRIBUTE_3S_NORMALIZED;
+    bool octahedral_normals =
+        vertex_spec.normal_attribute == VERTEX_ATTRIBUTE_2B_OCTAHEDRAL ||
+        vertex_spec.normal_attribute == VERTEX_ATTRIBUTE_2S_OCTAHEDRAL;
+
+    auto scale_slot = program->uniform_slot(POSITION_SCALE_HASH);
+    auto offset_slot = program->uniform_slot(POSITION_OFFSET_HASH);
+
+    if(scale_slot.is_valid() && offset_slot.is_valid()) {
+        if(quantized_positions) {
+            program->set_uniform_vec4(scale_slot, Vec4(vertex_data->position_scale(), 1.0f));
+            program->set_uniform_vec4(offset_slot, Vec4(vertex_data->position_offset(), 0.0f));
+        } else {
+            program->set_uniform_vec4(scale_slot, Vec4(1, 1, 1, 1));
+            program->set_uniform_vec4(offset_slot, Vec4(0, 0, 0, 0));
+        }
+    } else if(quantized_positions) {
+        S_WARN_ONCE("Shader doesn't declare {0}, quantized positions will be wrong",
+                    POSITION_SCALE_PROPERTY);
+    }
+
+    auto normals_slot = program->uniform_slot(OCTAHEDRAL_NORMALS_HASH);
+    if(normals_slot.is_valid()) {
+        program->set_uniform_float(normals_slot, (octahedral_normals) ? 1.0f : 0.0f);
+    } else if(octahedral_normals && program->locate_attribute("s_normal", true) > -1) {
+        S_WARN_ONCE("Shader doesn't declare {0}, normals will be wrong",
+                    OCTAHEDRAL_NORMALS_PROPERTY);
+    }
+
+    if(!half_float_vertices_) {
+        for(uint8_t i = 0; i < 4; ++i) {
+            if(vertex_spec.texcoordX_attribute(i) == VERTEX_ATTRIBUTE_2H) {
+                S_WARN_ONCE("Half float texture coordinates aren't supported by this driver");
+            }
+        }
+    }
+}
+
+void GenericRenderer::set_instance_attribute(int32_t loc,
+                                             const Mat4& transformation) {
+    /* A mat4 attribute occupies 4 consecutive locations, one per column.
+     * With the arrays disabled GL uses the "current" value for each */
+    const float* data = transformation.data();
+    for(int32_t i = 0; i < 4; ++i) {
+        set_constant_attribute(loc + i, data + (i * 4));
+    }
+}
+
+void GenericRenderer::set_joint_palette_uniform(GPUProgram* program,
+                                                const Renderable* renderable) {
+    auto slot = program->uniform_slot(JOINT_PALETTE_HASH);
+    if(!slot.is_valid()) {
+        return;
+    }
+
+    if(renderable->joint_palette && renderable->joint_count) {
+        auto count = std::min<uint32_t>(renderable->joint_count,
+                                        max_gpu_skinning_joints());
+        program->set_uniform_mat4x4_array(slot, renderable->joint_palette,
+                                          count);
+    } else {
+        /* Not skinned (or skinned on the CPU). Whatever the joints say,
+         * blending identities leaves the vertices alone */
+        static const std::vector<Mat4> identities(64);
+        program->set_uniform_mat4x4_array(
+            slot, &identities[0],
+            std::min<uint32_t>(identities.size(), max_gpu_skinning_joints()));
+    }
 }
 
 void GenericRenderer::set_blending_mode(BlendType type, float alpha) {
@@ -437,9 +664,9 @@ void GL2RenderQueueVisitor::apply_lights(const LightPtr* lights,
         renderer_->set_light_uniforms(pass_, program_, i, lights[i]);
     }
 
-    auto m_loc = program_->locate_uniform(LIGHT_COUNT_PROPERTY, true);
-    if(m_loc > -1) {
-        program_->set_uniform_int(m_loc, count);
+    auto slot = program_->uniform_slot(LIGHT_COUNT_HASH);
+    if(slot.is_valid()) {
+        program_->set_uniform_int(slot, count);
     }
 }
 
@@ -486,15 +713,15 @@ void GL2RenderQueueVisitor::change_material_pass(const MaterialPass* prev,
 
         const TexturePtr tex = *tex_prop;
 
-        auto loc = program_->locate_uniform(
-            defined_property.second.texture_property_name, true);
-        if(loc > -1 && (texture_unit + 1u) < _S_GL_MAX_TEXTURE_UNITS) {
+        auto slot = program_->uniform_slot(
+            defined_property.second.texture_property_name_hash);
+        if(slot.is_valid() && (texture_unit + 1u) < _S_GL_MAX_TEXTURE_UNITS) {
             GLCheck(glActiveTexture, GL_TEXTURE0 + texture_unit);
             GLCheck(glBindTexture, GL_TEXTURE_2D,
                     (tex)
                         ? tex->_renderer_specific_id()
                         : renderer_->default_texture_->_renderer_specific_id());
-            program_->set_uniform_int(loc, texture_unit);
+            program_->set_uniform_int(slot, texture_unit);
             texture_unit++;
         }
     }
@@ -582,19 +809,20 @@ void GL2RenderQueueVisitor::change_material_pass(const MaterialPass* prev,
     renderer_->set_material_uniforms(next, program_);
 
     for(auto& prop: mat->custom_properties()) {
+        /* Property names are hashed the same way as uniform names */
+        auto slot = program_->uniform_slot(prop.first);
+
         switch(prop.second.type) {
             case MATERIAL_PROPERTY_TYPE_INT:
                 const int* i;
-                if(pass_->property_value(prop.first, i)) {
-                    program_->set_uniform_int(prop.second.property_name, *i,
-                                              /* fail_silently= */ true);
+                if(slot.is_valid() && pass_->property_value(prop.first, i)) {
+                    program_->set_uniform_int(slot, *i);
                 }
                 break;
             case MATERIAL_PROPERTY_TYPE_FLOAT:
                 const float* f;
-                if(pass_->property_value(prop.first, f)) {
-                    program_->set_uniform_float(prop.second.property_name, *f,
-                                                /* fail_silently= */ true);
+                if(slot.is_valid() && pass_->property_value(prop.first, f)) {
+                    program_->set_uniform_float(slot, *f);
                 }
                 break;
             case MATERIAL_PROPERTY_TYPE_TEXTURE:
@@ -610,50 +838,46 @@ void GL2RenderQueueVisitor::change_material_pass(const MaterialPass* prev,
 
 void GenericRenderer::set_renderable_uniforms(const MaterialPass* pass,
                                               GPUProgram* program,
-                                              const Renderable* renderable,
+                                              const Mat4& model,
                                               Camera* camera) {
     _S_UNUSED(pass);
 
     // Calculate the modelview-projection matrix
-    const Mat4 model = renderable->final_transformation;
     const Mat4& view = camera->view_matrix();
     const Mat4& projection = camera->projection_matrix();
 
     Mat4 modelview = view * model;
     Mat4 modelview_projection = projection * modelview;
 
-    auto v_loc = program->locate_uniform(VIEW_MATRIX_PROPERTY, true);
-    if(v_loc > -1) {
-        program->set_uniform_mat4x4(VIEW_MATRIX_PROPERTY, view);
+    auto v_slot = program->uniform_slot(VIEW_MATRIX_HASH);
+    if(v_slot.is_valid()) {
+        program->set_uniform_mat4x4(v_slot, view);
     }
 
-    auto mvp_loc =
-        program->locate_uniform(MODELVIEW_PROJECTION_MATRIX_PROPERTY, true);
-    if(mvp_loc > -1) {
-        program->set_uniform_mat4x4(MODELVIEW_PROJECTION_MATRIX_PROPERTY,
-                                    modelview_projection);
+    auto mvp_slot = program->uniform_slot(MODELVIEW_PROJECTION_MATRIX_HASH);
+    if(mvp_slot.is_valid()) {
+        program->set_uniform_mat4x4(mvp_slot, modelview_projection);
     }
 
-    auto mv_loc = program->locate_uniform(MODELVIEW_MATRIX_PROPERTY, true);
-    if(mv_loc > -1) {
-        program->set_uniform_mat4x4(MODELVIEW_MATRIX_PROPERTY, modelview);
+    auto mv_slot = program->uniform_slot(MODELVIEW_MATRIX_HASH);
+    if(mv_slot.is_valid()) {
+        program->set_uniform_mat4x4(mv_slot, modelview);
     }
 
-    auto p_loc = program->locate_uniform(PROJECTION_MATRIX_PROPERTY, true);
-    if(p_loc > -1) {
-        program->set_uniform_mat4x4(PROJECTION_MATRIX_PROPERTY, projection);
+    auto p_slot = program->uniform_slot(PROJECTION_MATRIX_HASH);
+    if(p_slot.is_valid()) {
+        program->set_uniform_mat4x4(p_slot, projection);
     }
 
-    auto itmv_loc = program->locate_uniform(
-        INVERSE_TRANSPOSE_MODELVIEW_MATRIX_PROPERTY, true);
-    if(itmv_loc > -1) {
+    auto itmv_slot =
+        program->uniform_slot(INVERSE_TRANSPOSE_MODELVIEW_MATRIX_HASH);
+    if(itmv_slot.is_valid()) {
         // PERF: Recalculating every frame will be costly!
         Mat3 inverse_transpose_modelview(modelview);
         inverse_transpose_modelview.inverse();
         inverse_transpose_modelview.transpose();
 
-        program->set_uniform_mat3x3(INVERSE_TRANSPOSE_MODELVIEW_MATRIX_PROPERTY,
-                                    inverse_transpose_modelview);
+        program->set_uniform_mat3x3(itmv_slot, inverse_transpose_modelview);
     }
 }
 
@@ -692,8 +916,20 @@ void GL2RenderQueueVisitor::do_visit(const Renderable* renderable,
                                      batcher::Iteration iteration) {
     _S_UNUSED(iteration);
 
-    renderer_->set_renderable_uniforms(material_pass, program_, renderable,
-                                       camera_);
+    if(renderable->instance_count) {
+        renderer_->prepare_to_render(renderable);
+        renderer_->set_joint_palette_uniform(program_, renderable);
+        renderer_->set_auto_attributes_on_shader(
+            program_, renderable, renderer_->buffer_stash_.get());
+        renderer_->send_instanced_geometry(material_pass, program_, renderable,
+                                           renderer_->buffer_stash_.get(),
+                                           camera_);
+        return;
+    }
+
+    renderer_->set_renderable_uniforms(
+        material_pass, program_, renderable->final_transformation, camera_);
+    renderer_->set_joint_palette_uniform(program_, renderable);
     renderer_->prepare_to_render(renderable);
     renderer_->set_auto_attributes_on_shader(program_, renderable,
                                              renderer_->buffer_stash_.get());
@@ -749,17 +985,30 @@ GPUProgramPtr GenericRenderer::current_gpu_program() const {
 }
 
 void GenericRenderer::send_geometry(const Renderable* renderable,
-                                    GPUBuffer* buffers) {
+                                    GPUBuffer* buffers,
+                                    uint32_t instance_count) {
     auto element_count = renderable->index_element_count;
     auto arrangement = convert_arrangement(renderable->arrangement);
+    auto multiplier = std::max(instance_count, 1u);
 
     if(element_count) {
         auto index_type = convert_id_type(renderable->index_data->index_type());
-        auto offset = buffers->index_vbo->byte_offset(buffers->index_vbo_slot);
-        GLCheck(glDrawElements, arrangement, element_count, index_type,
-                BUFFER_OFFSET(offset));
-        get_app()->stats->increment_polygons_rendered(renderable->arrangement,
-                                                      element_count);
+        auto offset = buffers->index_vbo->byte_offset(buffers->index_vbo_slot) +
+                      renderable->index_offset * renderable->index_data->stride();
+
+        if(!instance_count) {
+            GLCheck(glDrawElements, arrangement, element_count, index_type,
+                    BUFFER_OFFSET(offset));
+        } else if(use_es_) {
+            GLCheck(glDrawElementsInstancedEXT, arrangement, element_count,
+                    index_type, BUFFER_OFFSET(offset), instance_count);
+        } else {
+            GLCheck(glDrawElementsInstancedARB, arrangement, element_count,
+                    index_type, BUFFER_OFFSET(offset), instance_count);
+        }
+
+        get_app()->stats->increment_polygons_rendered(
+            renderable->arrangement, element_count * multiplier);
     } else if(renderable->vertex_range_count) {
         assert(renderable->vertex_ranges);
 
@@ -767,13 +1016,159 @@ void GenericRenderer::send_geometry(const Renderable* renderable,
         auto total = 0;
         for(std::size_t i = 0; i < renderable->vertex_range_count;
             ++i, ++range) {
-            GLCheck(glDrawArrays, arrangement, range->start, range->count);
+            if(!instance_count) {
+                GLCheck(glDrawArrays, arrangement, range->start, range->count);
+            } else if(use_es_) {
+                GLCheck(glDrawArraysInstancedEXT, arrangement, range->start,
+                        range->count, instance_count);
+            } else {
+                GLCheck(glDrawArraysInstancedARB, arrangement, range->start,
+                        range->count, instance_count);
+            }
 
             total += range->count;
         }
 
         get_app()->stats->increment_polygons_rendered(renderable->arrangement,
-                                                      total);
+                                                      total * multiplier);
+    }
+}
+
+static void set_vertex_attribute_divisor(bool use_es, GLuint loc,
+                                         GLuint divisor) {
+    if(use_es) {
+        GLCheck(glVertexAttribDivisorEXT, loc, divisor);
+    } else {
+        GLCheck(glVertexAttribDivisorARB, loc, divisor);
+    }
+}
+
+void GenericRenderer::send_instanced_geometry(const MaterialPass* pass,
+                                              GPUProgram* program,
+                                              const Renderable* renderable,
+                                              GPUBuffer* buffers,
+                                              Camera* camera) {
+    if(renderable->instance_data) {
+        /* Only hardware instancing can read the attributes per instance */
+        if(!hardware_instancing_) {
+            S_WARN_ONCE("Instance data given to a renderer without hardware instancing");
+            return;
+        }
+
+        set_renderable_uniforms(pass, program, renderable->final_transformation,
+                                camera);
+        send_instance_data_geometry(renderable, program, buffers);
+        return;
+    }
+
+    const auto count = renderable->instance_count;
+    const Mat4* instances = renderable->instance_transformations;
+    assert(instances);
+
+    auto loc = program->instance_attributes().transformation;
+
+    if(loc > -1 && hardware_instancing_) {
+        /* The shader applies the instance transformation, so the uniforms
+         * are calculated once from the shared transformation */
+        set_renderable_uniforms(pass, program, renderable->final_transformation,
+                                camera);
+
+        if(!instance_vbo_) {
+            GLCheck(glGenBuffers, 1, &instance_vbo_);
+        }
+
+        const auto size = sizeof(Mat4) * count;
+
+        GLCheck(glBindBuffer, GL_ARRAY_BUFFER, instance_vbo_);
+
+        /* Orphan the old storage so we don't wait on a draw that's still
+         * reading from it */
+        GLCheck(glBufferData, GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        GLCheck(glBufferSubData, GL_ARRAY_BUFFER, 0, size, instances);
+
+        for(int32_t i = 0; i < 4; ++i) {
+            enable_vertex_attribute(loc + i);
+            GLCheck(glVertexAttribPointer, loc + i, 4, GL_FLOAT, GL_FALSE,
+                    sizeof(Mat4), BUFFER_OFFSET(sizeof(float) * 4 * i));
+            set_vertex_attribute_divisor(use_es_, loc + i, 1);
+        }
+
+        send_geometry(renderable, buffers, count);
+
+        for(int32_t i = 0; i < 4; ++i) {
+            set_vertex_attribute_divisor(use_es_, loc + i, 0);
+            disable_vertex_attribute(loc + i);
+        }
+    } else if(loc > -1) {
+        /* No driver support, but we can still avoid recalculating the
+         * uniforms by feeding the shader's attribute per draw */
+        set_renderable_uniforms(pass, program, renderable->final_transformation,
+                                camera);
+
+        for(uint32_t i = 0; i < count; ++i) {
+            set_instance_attribute(loc, instances[i]);
+            send_geometry(renderable, buffers);
+        }
+    } else {
+        for(uint32_t i = 0; i < count; ++i) {
+            set_renderable_uniforms(
+                pass, program, renderable->final_transformation * instances[i],
+                camera);
+            send_geometry(renderable, buffers);
+        }
+    }
+}
+
+void GenericRenderer::send_instance_data_geometry(const Renderable* renderable,
+                                                  GPUProgram* program,
+                                                  GPUBuffer* buffers) {
+    const auto count = renderable->instance_count;
+    const VertexData* data = renderable->instance_data;
+    const auto& spec = data->vertex_specification();
+    assert(data->count() >= count);
+
+    if(!instance_vbo_) {
+        GLCheck(glGenBuffers, 1, &instance_vbo_);
+    }
+
+    const auto size = spec.stride() * count;
+
+    GLCheck(glBindBuffer, GL_ARRAY_BUFFER, instance_vbo_);
+    GLCheck(glBufferData, GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    GLCheck(glBufferSubData, GL_ARRAY_BUFFER, 0, size, data->data());
+
+    auto half_float = (use_es_) ? GL_HALF_FLOAT_OES : GL_HALF_FLOAT;
+
+    const auto& instance = program->instance_attributes();
+    int32_t locs[] = {
+        instance.position,
+        instance.texcoord0,
+        instance.color
+    };
+
+    send_attribute(locs[0], VERTEX_ATTRIBUTE_TYPE_POSITION, spec,
+                   &VertexSpecification::has_positions,
+                   &VertexSpecification::position_offset, 0, half_float);
+    send_attribute(locs[1], VERTEX_ATTRIBUTE_TYPE_TEXCOORD0, spec,
+                   &VertexSpecification::has_texcoord0,
+                   &VertexSpecification::texcoord0_offset, 0, half_float);
+    send_attribute(locs[2], VERTEX_ATTRIBUTE_TYPE_COLOR, spec,
+                   &VertexSpecification::has_color,
+                   &VertexSpecification::color_offset, 0, half_float);
+
+    for(auto loc: locs) {
+        if(loc > -1) {
+            set_vertex_attribute_divisor(use_es_, loc, 1);
+        }
+    }
+
+    send_geometry(renderable, buffers, count);
+
+    for(auto loc: locs) {
+        if(loc > -1) {
+            set_vertex_attribute_divisor(use_es_, loc, 0);
+            disable_vertex_attribute(loc);
+        }
     }
 }
 
@@ -826,6 +1221,29 @@ void GenericRenderer::init_context() {
     GLCheck(glDepthFunc, GL_LEQUAL);
     GLCheck(glEnable, GL_CULL_FACE);
 
+    hardware_instancing_ =
+        (use_es_) ? GLAD_GL_EXT_instanced_arrays
+                  : (GLAD_GL_ARB_draw_instanced && GLAD_GL_ARB_instanced_arrays);
+
+    S_DEBUG("Hardware instancing: {0}", hardware_instancing_);
+
+    auto has_extension = [GL_extensions](const char* name) -> bool {
+        return GL_extensions && strstr((const char*) GL_extensions, name);
+    };
+
+    half_float_vertices_ =
+        (use_es_) ? has_extension("GL_OES_vertex_half_float")
+                  : (has_extension("GL_ARB_half_float_vertex") ||
+                     (GL_version && GL_version[0] >= '3'));
+
+    S_DEBUG("Half float vertices: {0}", half_float_vertices_);
+
+    /* Desktop GL always has 32 bit indices, ES 2.0 needs the extension */
+    element_index_uint_ =
+        !use_es_ || has_extension("GL_OES_element_index_uint");
+
+    S_DEBUG("32 bit indices: {0}", element_index_uint_);
+
     if(!default_gpu_program_) {
         S_DEBUG("Creating GPU program");
         default_gpu_program_ = new_or_existing_gpu_program(
@@ -93,6 +93,19 @@ public:
     GPUProgramPtr gpu_program(const GPUProgramID& program_id) const override;
     GPUProgramPtr current_gpu_program() const override;
     bool supports_gpu_programs() const override { return true; }
+    bool supports_instancing() const override { return true; }
+    bool supports_instance_attributes() const override {
+        return hardware_instancing_;
+    }
+
+    /* Conservative, so the palette fits in the minimum number of vertex
+     * uniform vectors each API guarantees (128 for ES 2.0) */
+    uint32_t max_gpu_skinning_joints() const override {
+        return (use_es_) ? 24 : 64;
+    }
+    bool supports_gpu_billboards() const override {
+        return hardware_instancing_ || element_index_uint_;
+    }
     GPUProgramPtr default_gpu_program() const override;
 
     std::string name() const override {
@@ -102,6 +115,15 @@ public:
     void prepare_to_render(const Renderable* renderable) override;
 
     bool is_gles() const { return use_es_; }
+
+    /* True if the driver exposes instanced draw calls and attribute
+     * divisors. When false, instanced renderables are still accepted
+     * but drawn with one call per instance. */
+    bool has_hardware_instancing() const { return hardware_instancing_; }
+
+    /* True if half float vertex attributes (VERTEX_ATTRIBUTE_2H) can be
+     * read. That's GL 3.0, or an extension before that */
+    bool has_half_float_vertices() const { return half_float_vertices_; }
 private:
     GPUProgramManager program_manager_;
     GPUProgramPtr default_gpu_program_ = 0;
@@ -114,12 +136,26 @@ private:
     void set_light_uniforms(const MaterialPass* pass, GPUProgram* program,
                             uint8_t light_id, const LightPtr light);
     void set_material_uniforms(const MaterialPass *pass, GPUProgram* program);
-    void set_renderable_uniforms(const MaterialPass* pass, GPUProgram* program, const Renderable* renderable, Camera* camera);
+    void set_renderable_uniforms(const MaterialPass* pass, GPUProgram* program, const Mat4& model, Camera* camera);
     void set_stage_uniforms(const MaterialPass* pass, GPUProgram* program, const Color& global_ambient);
 
     void set_auto_attributes_on_shader(GPUProgram *program, const Renderable* buffer, GPUBuffer* buffers);
+    void set_vertex_decode_uniforms(GPUProgram* program, const VertexData* vertex_data);
     void set_blending_mode(BlendType type, float alpha);
-    void send_geometry(const Renderable* renderable, GPUBuffer* buffers);
+    void send_geometry(const Renderable* renderable, GPUBuffer* buffers, uint32_t instance_count=0);
+
+    void send_instanced_geometry(const MaterialPass* pass, GPUProgram* program, const Renderable* renderable, GPUBuffer* buffers, Camera* camera);
+    void set_instance_attribute(int32_t loc, const Mat4& transformation);
+    void send_instance_data_geometry(const Renderable* renderable, GPUProgram* program, GPUBuffer* buffers);
+    void set_joint_palette_uniform(GPUProgram* program, const Renderable* renderable);
+
+    bool hardware_instancing_ = false;
+    bool half_float_vertices_ = false;
+    bool element_index_uint_ = false;
+
+    /* Streamed each draw with the instance transformations (or instance
+     * data) of the renderable being drawn */
+    uint32_t instance_vbo_ = 0;
 
     /* Stashed here in prepare_to_render and used later for that renderable */
     std::shared_ptr<GPUBuffer> buffer_stash_;
@@ -22,8 +22,13 @@
 #include "../../utils/hash/md5.h"
 #include "gpu_program.h"
 #include "../renderer.h"
+#include "../gl_renderer.h"
 #include "../../generic/raii.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 namespace smlt {
 
 
@@ -88,43 +93,188 @@ GLint GPUProgram::locate_uniform(const std::string& uniform_name, bool fail_sile
     return location;
 }
 
+UniformNameHash uniform_element_hash(UniformNameHash name_hash, uint32_t index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "[%u]", (unsigned) index);
+    return fnv1<uint32_t>::hash(suffix, name_hash);
+}
+
+UniformSlot GPUProgram::uniform_slot(UniformNameHash hash) const {
+    auto it = std::lower_bound(
+        uniform_slot_hashes_.begin(), uniform_slot_hashes_.end(), hash,
+        [](const std::pair<UniformNameHash, int16_t>& lhs, UniformNameHash rhs) {
+            return lhs.first < rhs;
+        }
+    );
+
+    UniformSlot slot;
+    if(it != uniform_slot_hashes_.end() && it->first == hash) {
+        slot.index = it->second;
+    }
+
+    return slot;
+}
+
+void GPUProgram::invalidate_uniform_values() {
+    for(auto& info: uniform_slots_) {
+        info.value_size = 0;
+    }
+}
+
+void GPUProgram::invalidate_uniform_value(GLint location) {
+    auto it = std::lower_bound(
+        uniform_slots_.begin(), uniform_slots_.end(), location,
+        [](const UniformSlotInfo& lhs, GLint rhs) {
+            return lhs.location < rhs;
+        }
+    );
+
+    if(it != uniform_slots_.end() && it->location == location) {
+        it->value_size = 0;
+    }
+}
+
+bool GPUProgram::update_uniform_value(UniformSlot slot, const float* values, uint8_t count) {
+    assert(slot.is_valid());
+    assert(count <= 16);
+
+    auto& info = uniform_slots_[slot.index];
+    if(info.value_size == count &&
+       std::memcmp(info.value, values, sizeof(float) * count) == 0) {
+        return false;
+    }
+
+    std::memcpy(info.value, values, sizeof(float) * count);
+    info.value_size = count;
+    return true;
+}
+
+void GPUProgram::set_uniform_int(UniformSlot slot, const int32_t value) {
+    float bits;
+    std::memcpy(&bits, &value, sizeof(float));
+
+    if(update_uniform_value(slot, &bits, 1)) {
+        GLCheck(glUniform1i, uniform_slots_[slot.index].location, value);
+    }
+}
+
+void GPUProgram::set_uniform_float(UniformSlot slot, const float value) {
+    if(update_uniform_value(slot, &value, 1)) {
+        GLCheck(glUniform1f, uniform_slots_[slot.index].location, value);
+    }
+}
+
+void GPUProgram::set_uniform_vec4(UniformSlot slot, const Vec4& values) {
+    const float data[] = {values.x, values.y, values.z, values.w};
+    if(update_uniform_value(slot, data, 4)) {
+        GLCheck(glUniform4fv, uniform_slots_[slot.index].location, 1, data);
+    }
+}
+
+void GPUProgram::set_uniform_color(UniformSlot slot, const Color& values) {
+    set_uniform_vec4(slot, Vec4(values.r, values.g, values.b, values.a));
+}
+
+void GPUProgram::set_uniform_mat3x3(UniformSlot slot, const Mat3& matrix) {
+    if(update_uniform_value(slot, matrix.data(), 9)) {
+        GLCheck(glUniformMatrix3fv, uniform_slots_[slot.index].location, 1, false, (GLfloat*) matrix.data());
+    }
+}
+
+void GPUProgram::set_uniform_mat4x4(UniformSlot slot, const Mat4& matrix) {
+    if(update_uniform_value(slot, matrix.data(), 16)) {
+        GLCheck(glUniformMatrix4fv, uniform_slots_[slot.index].location, 1, false, (GLfloat*) matrix.data());
+    }
+}
+
+void GPUProgram::set_uniform_mat4x4_array(UniformSlot slot, const Mat4* matrices, uint32_t count) {
+    assert(slot.is_valid());
+    set_uniform_mat4x4_array(uniform_slots_[slot.index].location, matrices, count);
+}
+
 void GPUProgram::set_uniform_int(const int32_t loc, const int32_t value) {
     assert(loc >= 0);
+    invalidate_uniform_value(loc);
     GLCheck(glUniform1i, loc, value);
 }
 
 void GPUProgram::set_uniform_int(const std::string& uniform_name, const int32_t value, bool fail_silently) {
+    auto slot = uniform_slot(uniform_name_hash(uniform_name.c_str()));
+    if(slot.is_valid()) {
+        set_uniform_int(slot, value);
+        return;
+    }
+
     GLint loc = locate_uniform(uniform_name, fail_silently);
     if(loc > -1) {
-        GLCheck(glUniform1i, loc, value);
+        set_uniform_int(loc, value);
     }
 }
 
 void GPUProgram::set_uniform_float(const int32_t loc, const float value) {
     assert(loc >= 0);
+    invalidate_uniform_value(loc);
     GLCheck(glUniform1f, loc, value);
 }
 
 void GPUProgram::set_uniform_float(const std::string& uniform_name, const float value, bool fail_silently) {
+    auto slot = uniform_slot(uniform_name_hash(uniform_name.c_str()));
+    if(slot.is_valid()) {
+        set_uniform_float(slot, value);
+        return;
+    }
+
     int32_t loc = locate_uniform(uniform_name, fail_silently);
     if(loc > -1) {
-        GLCheck(glUniform1f, loc, value);
+        set_uniform_float(loc, value);
     }
 }
 
 void GPUProgram::set_uniform_mat4x4(const int32_t loc, const Mat4& matrix) {
     assert(loc >= 0);
+    invalidate_uniform_value(loc);
     GLCheck(glUniformMatrix4fv, loc, 1, false, (GLfloat*)matrix.data());
 }
 
+void GPUProgram::set_uniform_mat4x4_array(const int32_t loc, const Mat4* matrices, uint32_t count) {
+    assert(loc >= 0);
+
+    /* Array elements are registered as slots too. Their locations are
+     * consecutive in practice, so forget anything in that range */
+    auto it = std::lower_bound(
+        uniform_slots_.begin(), uniform_slots_.end(), loc,
+        [](const UniformSlotInfo& lhs, GLint rhs) {
+            return lhs.location < rhs;
+        }
+    );
+
+    for(; it != uniform_slots_.end() && it->location < GLint(loc + count); ++it) {
+        it->value_size = 0;
+    }
+
+    GLCheck(glUniformMatrix4fv, loc, count, false, (GLfloat*) matrices[0].data());
+}
+
 void GPUProgram::set_uniform_mat4x4(const std::string& uniform_name, const Mat4& matrix) {
+    auto slot = uniform_slot(uniform_name_hash(uniform_name.c_str()));
+    if(slot.is_valid()) {
+        set_uniform_mat4x4(slot, matrix);
+        return;
+    }
+
     int32_t loc = locate_uniform(uniform_name);
     if(loc > -1) {
-        GLCheck(glUniformMatrix4fv, loc, 1, false, (GLfloat*)matrix.data());
+        set_uniform_mat4x4(loc, matrix);
     }
 }
 
 void GPUProgram::set_uniform_mat3x3(const std::string& uniform_name, const Mat3& matrix) {
+    auto slot = uniform_slot(uniform_name_hash(uniform_name.c_str()));
+    if(slot.is_valid()) {
+        set_uniform_mat3x3(slot, matrix);
+        return;
+    }
+
     int32_t loc = locate_uniform(uniform_name);
     if(loc > -1) {
         GLCheck(glUniformMatrix3fv, loc, 1, false, (GLfloat*)matrix.data());
@@ -134,19 +284,27 @@ void GPUProgram::set_uniform_mat3x3(const std::string& uniform_name, const Mat3&
 void GPUProgram::set_uniform_vec3(const std::string& uniform_name, const Vec3& values) {
     int32_t loc = locate_uniform(uniform_name);
     if(loc > -1) {
+        invalidate_uniform_value(loc);
         GLCheck(glUniform3fv, loc, 1, (GLfloat*) &values);
     }
 }
 
 void GPUProgram::set_uniform_vec4(const int32_t loc, const Vec4& values) {
     assert(loc >= 0);
+    invalidate_uniform_value(loc);
     GLCheck(glUniform4fv, loc, 1, (GLfloat*) &values);
 }
 
 void GPUProgram::set_uniform_vec4(const std::string& uniform_name, const Vec4& values) {
+    auto slot = uniform_slot(uniform_name_hash(uniform_name.c_str()));
+    if(slot.is_valid()) {
+        set_uniform_vec4(slot, values);
+        return;
+    }
+
     int32_t loc = locate_uniform(uniform_name);
     if(loc > -1) {
-        GLCheck(glUniform4fv, loc, 1, (GLfloat*) &values);
+        set_uniform_vec4(loc, values);
     }
 }
 
@@ -161,7 +319,90 @@ void GPUProgram::set_uniform_color(const std::string& uniform_name, const Color&
 
 void GPUProgram::set_uniform_mat4x4_array(const std::string& uniform_name, const std::vector<Mat4>& matrices) {
     int32_t loc = locate_uniform(uniform_name);
-    GLCheck(glUniformMatrix4fv, loc, matrices.size(), false, (GLfloat*) &matrices[0]);
+    if(loc > -1 && !matrices.empty()) {
+        set_uniform_mat4x4_array(loc, &matrices[0], matrices.size());
+    }
+}
+
+void GPUProgram::rebuild_uniform_slots() {
+    uniform_slots_.clear();
+    uniform_slot_hashes_.clear();
+
+    std::vector<std::pair<UniformNameHash, GLint>> locations;
+
+    auto add_uniform = [&](const std::string& name, UniformNameHash hash, GLenum type) {
+        GLint location = glGetUniformLocation(program_object_, name.c_str());
+        if(location < 0) {
+            return;
+        }
+
+        UniformSlotInfo info;
+        info.location = location;
+        info.type = type;
+        uniform_slots_.push_back(info);
+        locations.push_back(std::make_pair(hash, location));
+    };
+
+    for(auto& p: uniform_info_) {
+        const std::string name = p.first.encode();
+        const UniformInfo& info = p.second;
+
+        /* Drivers don't agree on whether active arrays are reported with
+         * a "[0]" suffix, so anything with more than one element is an
+         * array either way */
+        const std::string array_suffix = "[0]";
+        bool has_suffix = name.size() > array_suffix.size() &&
+            name.compare(name.size() - array_suffix.size(), array_suffix.size(), array_suffix) == 0;
+
+        if(!has_suffix && info.size <= 1) {
+            add_uniform(name, uniform_name_hash(name.c_str()), info.type);
+            continue;
+        }
+
+        const std::string base = (has_suffix) ?
+            name.substr(0, name.size() - array_suffix.size()) : name;
+        const UniformNameHash base_hash = uniform_name_hash(base.c_str());
+
+        for(GLsizei i = 0; i < info.size; ++i) {
+            add_uniform(
+                _F("{0}[{1}]").format(base, i),
+                uniform_element_hash(base_hash, i), info.type
+            );
+        }
+
+        /* The bare name refers to the first element */
+        GLint first = glGetUniformLocation(program_object_, base.c_str());
+        if(first > -1) {
+            locations.push_back(std::make_pair(base_hash, first));
+        }
+    }
+
+    std::sort(uniform_slots_.begin(), uniform_slots_.end(),
+        [](const UniformSlotInfo& lhs, const UniformSlotInfo& rhs) {
+            return lhs.location < rhs.location;
+        }
+    );
+
+    std::sort(locations.begin(), locations.end());
+
+    for(auto& p: locations) {
+        if(!uniform_slot_hashes_.empty() && uniform_slot_hashes_.back().first == p.first) {
+            S_WARN("Uniform name hash collision in program {0}, some uniforms will be set by name", program_object_);
+            continue;
+        }
+
+        auto it = std::lower_bound(
+            uniform_slots_.begin(), uniform_slots_.end(), p.second,
+            [](const UniformSlotInfo& lhs, GLint rhs) {
+                return lhs.location < rhs;
+            }
+        );
+
+        assert(it != uniform_slots_.end() && it->location == p.second);
+        uniform_slot_hashes_.push_back(
+            std::make_pair(p.first, int16_t(it - uniform_slots_.begin()))
+        );
+    }
 }
 
 void GPUProgram::rebuild_uniform_info() {
@@ -423,6 +664,12 @@ void GPUProgram::link(bool force) {
     assert(shaders_.at(SHADER_TYPE_VERTEX).is_compiled);
     assert(shaders_.at(SHADER_TYPE_FRAGMENT).is_compiled);
 
+    /* Desktop compatibility contexts won't draw unless attribute 0 is an
+     * enabled array. Keep it for the position rather than letting the
+     * linker hand it to something like s_instance_transformation which
+     * is usually a constant value */
+    GLCheck(glBindAttribLocation, program_object_, 0, "s_position");
+
     //Link the program
     GLCheck(glLinkProgram, program_object_);
 
@@ -451,6 +698,19 @@ void GPUProgram::link(bool force) {
     rebuild_uniform_info();
     uniform_cache_.clear();
 
+    /* Linking resets the uniform values, and may move them */
+    rebuild_uniform_slots();
+
+    /* These are checked on every draw, so don't go through the cache */
+    auto attribute = [this](const char* name) -> GLint {
+        return _GLCheck<GLint>("link", glGetAttribLocation, program_object_, name);
+    };
+
+    instance_attributes_.transformation = attribute(INSTANCE_TRANSFORMATION_ATTRIBUTE);
+    instance_attributes_.position = attribute(INSTANCE_POSITION_ATTRIBUTE);
+    instance_attributes_.texcoord0 = attribute(INSTANCE_TEXCOORD0_ATTRIBUTE);
+    instance_attributes_.color = attribute(INSTANCE_COLOR_ATTRIBUTE);
+
     is_linked_ = true;
     needs_relink_ = false;
     signal_linked_();
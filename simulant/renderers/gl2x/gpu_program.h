@@ -30,6 +30,7 @@
 #include "../../utils/gl_thread_check.h"
 #include "../../generic/identifiable.h"
 #include "../../vertex_data.h"
+#include "../../utils/hash/fnv1.h"
 
 #include "../glad/glad/glad.h"
 
@@ -63,6 +64,28 @@ struct UniformInfo {
     GLsizei size;
 };
 
+/* Uniforms can be looked up by the FNV-1 hash of their name, which is the
+ * same hash used for material property names. Elements of uniform arrays
+ * are registered under "name[i]", the bare name refers to element 0. */
+typedef uint32_t UniformNameHash;
+
+constexpr UniformNameHash uniform_name_hash(const char* name) {
+    return fnv1<uint32_t>::hash(name);
+}
+
+/* Hashes name + "[index]" without building the string */
+UniformNameHash uniform_element_hash(UniformNameHash name_hash, uint32_t index);
+
+/* Identifies an active uniform of a linked program. Slots are resolved when
+ * the program links and are only meaningful for the program they came from. */
+struct UniformSlot {
+    int16_t index = -1;
+
+    bool is_valid() const {
+        return index > -1;
+    }
+};
+
 
 class GPUProgram:
     public RefCounted<GPUProgram>,
@@ -107,12 +130,46 @@ public:
 
     UniformInfo uniform_info(const std::string& uniform_name);
 
+    /* Locations of the optional per-instance attributes, looked up once
+     * when the program links. -1 if the shader doesn't declare them. */
+    struct InstanceAttributes {
+        GLint transformation = -1;
+        GLint position = -1;
+        GLint texcoord0 = -1;
+        GLint color = -1;
+    };
+
+    const InstanceAttributes& instance_attributes() const {
+        return instance_attributes_;
+    }
+
     void clear_cache() {
         uniform_cache_.clear();
+        invalidate_uniform_values();
     }
 
+    /* Returns an invalid slot if the program has no active uniform with
+     * this name. This doesn't allocate, or touch GL. */
+    UniformSlot uniform_slot(UniformNameHash hash) const;
+
+    /* The setters which take a slot remember the last value sent to each
+     * uniform and skip the GL call if it hasn't changed. Arrays are always
+     * uploaded. */
+    void set_uniform_int(UniformSlot slot, const int32_t value);
+    void set_uniform_float(UniformSlot slot, const float value);
+    void set_uniform_vec4(UniformSlot slot, const Vec4& values);
+    void set_uniform_color(UniformSlot slot, const Color& values);
+    void set_uniform_mat3x3(UniformSlot slot, const Mat3& values);
+    void set_uniform_mat4x4(UniformSlot slot, const Mat4& values);
+    void set_uniform_mat4x4_array(UniformSlot slot, const Mat4* matrices, uint32_t count);
+
+    /* Forget the uploaded values, e.g. after changing uniforms without
+     * going through this class */
+    void invalidate_uniform_values();
+
     void set_uniform_int(const int32_t loc, const int32_t value);
     void set_uniform_mat4x4(const int32_t loc, const Mat4& values);
+    void set_uniform_mat4x4_array(const int32_t loc, const Mat4* matrices, uint32_t count);
     void set_uniform_color(const int32_t loc, const Color& values);
     void set_uniform_vec4(const int32_t loc, const Vec4& values);
     void set_uniform_float(const int32_t loc, const float value);
@@ -169,8 +226,30 @@ private:
     std::string md5_shader_hash_;
 
     std::unordered_map<std::string, GLint> uniform_cache_;
+
+    struct UniformSlotInfo {
+        GLint location = -1;
+        GLenum type = 0;
+
+        /* The last value uploaded, value_size is 0 if unknown */
+        uint8_t value_size = 0;
+        float value[16];
+    };
+
+    /* Sorted by location, so set-by-location can find and invalidate the
+     * cached value */
+    std::vector<UniformSlotInfo> uniform_slots_;
+
+    /* Sorted by hash for uniform_slot() */
+    std::vector<std::pair<UniformNameHash, int16_t>> uniform_slot_hashes_;
+
+    void rebuild_uniform_slots();
+    void invalidate_uniform_value(GLint location);
+    bool update_uniform_value(UniformSlot slot, const float* values, uint8_t count);
     std::unordered_map<std::string, int32_t> attribute_cache_;
 
+    InstanceAttributes instance_attributes_;
+
     void link(bool force=false);
 
     uint32_t renderer_id_ = 0;
@@ -20,6 +20,34 @@ constexpr const char* const PROJECTION_MATRIX_PROPERTY = "s_projection";
 constexpr const char* const MODELVIEW_MATRIX_PROPERTY = "s_modelview";
 constexpr const char* const INVERSE_TRANSPOSE_MODELVIEW_MATRIX_PROPERTY = "s_inverse_transpose_modelview";
 
+/* Optional mat4 vertex attribute. Shaders which declare it should multiply
+ * s_position by it before applying the usual matrices. It's fed from an
+ * instance buffer when drawing instanced renderables, and is the identity
+ * otherwise. */
+constexpr const char* const INSTANCE_TRANSFORMATION_ATTRIBUTE = "s_instance_transformation";
+
+/* Optional per-instance attributes, fed from Renderable::instance_data
+ * (its position, first texture coordinate and color). Otherwise they're
+ * (0, 0, 0), (1, 1) and (1, 1, 1, 1), so shaders which add the position
+ * and multiply by the others see no change. */
+constexpr const char* const INSTANCE_POSITION_ATTRIBUTE = "s_instance_position";
+constexpr const char* const INSTANCE_TEXCOORD0_ATTRIBUTE = "s_instance_texcoord0";
+constexpr const char* const INSTANCE_COLOR_ATTRIBUTE = "s_instance_color";
+
+/* Used by skinning shaders. The palette is a mat4 array uniform, one
+ * per joint, and the joints/weights are vec4 attributes */
+constexpr const char* const JOINT_PALETTE_PROPERTY = "s_joint_palette";
+constexpr const char* const JOINTS_ATTRIBUTE = "s_joints";
+constexpr const char* const WEIGHTS_ATTRIBUTE = "s_weights";
+
+/* Decoding for the compact vertex formats. Shaders should use
+ * (s_position * s_position_scale.xyz) + s_position_offset.xyz, and when
+ * s_octahedral_normals is non-zero s_normal.xy holds an octahedral encoded
+ * normal. For float vertex data they're set so nothing changes */
+constexpr const char* const POSITION_SCALE_PROPERTY = "s_position_scale";
+constexpr const char* const POSITION_OFFSET_PROPERTY = "s_position_offset";
+constexpr const char* const OCTAHEDRAL_NORMALS_PROPERTY = "s_octahedral_normals";
+
 #ifdef __DREAMCAST__
 // The Dreamcast only supports 2 multitexture units
 #define _S_GL_MAX_TEXTURE_UNITS 1
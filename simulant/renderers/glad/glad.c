@@ -7,8 +7,11 @@
     APIs: gl=2.1, gles2=2.0
     Profile: compatibility
     Extensions:
+        GL_ARB_draw_instanced,
         GL_ARB_framebuffer_object,
+        GL_ARB_instanced_arrays,
         GL_EXT_framebuffer_object,
+        GL_EXT_instanced_arrays,
         GL_OES_compressed_paletted_texture
     Loader: True
     Local files: False
@@ -16,9 +19,9 @@
     Reproducible: False
 
     Commandline:
-        --profile="compatibility" --api="gl=2.1,gles2=2.0" --generator="c" --spec="gl" --extensions="GL_ARB_framebuffer_object,GL_EXT_framebuffer_object,GL_OES_compressed_paletted_texture"
+        --profile="compatibility" --api="gl=2.1,gles2=2.0" --generator="c" --spec="gl" --extensions="GL_ARB_draw_instanced,GL_ARB_framebuffer_object,GL_ARB_instanced_arrays,GL_EXT_framebuffer_object,GL_EXT_instanced_arrays,GL_OES_compressed_paletted_texture"
     Online:
-        https://glad.dav1d.de/#profile=compatibility&language=c&specification=gl&loader=on&api=gl%3D2.1&api=gles2%3D2.0&extensions=GL_ARB_framebuffer_object&extensions=GL_EXT_framebuffer_object&extensions=GL_OES_compressed_paletted_texture
+        https://glad.dav1d.de/#profile=compatibility&language=c&specification=gl&loader=on&api=gl%3D2.1&api=gles2%3D2.0&extensions=GL_ARB_draw_instanced&extensions=GL_ARB_framebuffer_object&extensions=GL_ARB_instanced_arrays&extensions=GL_EXT_framebuffer_object&extensions=GL_EXT_instanced_arrays&extensions=GL_OES_compressed_paletted_texture
 */
 
 #include <stdio.h>
@@ -837,14 +840,20 @@ PFNGLWINDOWPOS3IPROC glad_glWindowPos3i = NULL;
 PFNGLWINDOWPOS3IVPROC glad_glWindowPos3iv = NULL;
 PFNGLWINDOWPOS3SPROC glad_glWindowPos3s = NULL;
 PFNGLWINDOWPOS3SVPROC glad_glWindowPos3sv = NULL;
+int GLAD_GL_ARB_draw_instanced = 0;
 int GLAD_GL_ARB_framebuffer_object = 0;
+int GLAD_GL_ARB_instanced_arrays = 0;
 int GLAD_GL_EXT_framebuffer_object = 0;
+int GLAD_GL_EXT_instanced_arrays = 0;
 int GLAD_GL_OES_compressed_paletted_texture = 0;
+PFNGLDRAWARRAYSINSTANCEDARBPROC glad_glDrawArraysInstancedARB = NULL;
+PFNGLDRAWELEMENTSINSTANCEDARBPROC glad_glDrawElementsInstancedARB = NULL;
 PFNGLFRAMEBUFFERTEXTURE1DPROC glad_glFramebufferTexture1D = NULL;
 PFNGLFRAMEBUFFERTEXTURE3DPROC glad_glFramebufferTexture3D = NULL;
 PFNGLBLITFRAMEBUFFERPROC glad_glBlitFramebuffer = NULL;
 PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC glad_glRenderbufferStorageMultisample = NULL;
 PFNGLFRAMEBUFFERTEXTURELAYERPROC glad_glFramebufferTextureLayer = NULL;
+PFNGLVERTEXATTRIBDIVISORARBPROC glad_glVertexAttribDivisorARB = NULL;
 PFNGLISRENDERBUFFEREXTPROC glad_glIsRenderbufferEXT = NULL;
 PFNGLBINDRENDERBUFFEREXTPROC glad_glBindRenderbufferEXT = NULL;
 PFNGLDELETERENDERBUFFERSEXTPROC glad_glDeleteRenderbuffersEXT = NULL;
@@ -862,6 +871,9 @@ PFNGLFRAMEBUFFERTEXTURE3DEXTPROC glad_glFramebufferTexture3DEXT = NULL;
 PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC glad_glFramebufferRenderbufferEXT = NULL;
 PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVEXTPROC glad_glGetFramebufferAttachmentParameterivEXT = NULL;
 PFNGLGENERATEMIPMAPEXTPROC glad_glGenerateMipmapEXT = NULL;
+PFNGLDRAWARRAYSINSTANCEDEXTPROC glad_glDrawArraysInstancedEXT = NULL;
+PFNGLDRAWELEMENTSINSTANCEDEXTPROC glad_glDrawElementsInstancedEXT = NULL;
+PFNGLVERTEXATTRIBDIVISOREXTPROC glad_glVertexAttribDivisorEXT = NULL;
 static void load_GL_VERSION_1_0(GLADloadproc load) {
     if(!GLAD_GL_VERSION_1_0) return;
     glad_glCullFace = (PFNGLCULLFACEPROC)load("glCullFace");
@@ -1437,6 +1449,11 @@ static void load_GL_VERSION_2_1(GLADloadproc load) {
     glad_glUniformMatrix3x4fv = (PFNGLUNIFORMMATRIX3X4FVPROC)load("glUniformMatrix3x4fv");
     glad_glUniformMatrix4x3fv = (PFNGLUNIFORMMATRIX4X3FVPROC)load("glUniformMatrix4x3fv");
 }
+static void load_GL_ARB_draw_instanced(GLADloadproc load) {
+    if(!GLAD_GL_ARB_draw_instanced) return;
+    glad_glDrawArraysInstancedARB = (PFNGLDRAWARRAYSINSTANCEDARBPROC)load("glDrawArraysInstancedARB");
+    glad_glDrawElementsInstancedARB = (PFNGLDRAWELEMENTSINSTANCEDARBPROC)load("glDrawElementsInstancedARB");
+}
 static void load_GL_ARB_framebuffer_object(GLADloadproc load) {
     if(!GLAD_GL_ARB_framebuffer_object) return;
     glad_glIsRenderbuffer = (PFNGLISRENDERBUFFERPROC)load("glIsRenderbuffer");
@@ -1460,6 +1477,10 @@ static void load_GL_ARB_framebuffer_object(GLADloadproc load) {
     glad_glRenderbufferStorageMultisample = (PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC)load("glRenderbufferStorageMultisample");
     glad_glFramebufferTextureLayer = (PFNGLFRAMEBUFFERTEXTURELAYERPROC)load("glFramebufferTextureLayer");
 }
+static void load_GL_ARB_instanced_arrays(GLADloadproc load) {
+    if(!GLAD_GL_ARB_instanced_arrays) return;
+    glad_glVertexAttribDivisorARB = (PFNGLVERTEXATTRIBDIVISORARBPROC)load("glVertexAttribDivisorARB");
+}
 static void load_GL_EXT_framebuffer_object(GLADloadproc load) {
     if(!GLAD_GL_EXT_framebuffer_object) return;
     glad_glIsRenderbufferEXT = (PFNGLISRENDERBUFFEREXTPROC)load("glIsRenderbufferEXT");
@@ -1482,7 +1503,9 @@ static void load_GL_EXT_framebuffer_object(GLADloadproc load) {
 }
 static int find_extensionsGL(void) {
     if (!get_exts()) return 0;
+    GLAD_GL_ARB_draw_instanced = has_ext("GL_ARB_draw_instanced");
     GLAD_GL_ARB_framebuffer_object = has_ext("GL_ARB_framebuffer_object");
+    GLAD_GL_ARB_instanced_arrays = has_ext("GL_ARB_instanced_arrays");
     GLAD_GL_EXT_framebuffer_object = has_ext("GL_EXT_framebuffer_object");
     GLAD_GL_OES_compressed_paletted_texture = has_ext("GL_OES_compressed_paletted_texture");
     free_exts();
@@ -1555,7 +1578,9 @@ int gladLoadGLLoader(GLADloadproc load) {
     load_GL_VERSION_2_1(load);
 
     if (!find_extensionsGL()) return 0;
+    load_GL_ARB_draw_instanced(load);
     load_GL_ARB_framebuffer_object(load);
+    load_GL_ARB_instanced_arrays(load);
     load_GL_EXT_framebuffer_object(load);
     return GLVersion.major != 0 || GLVersion.minor != 0;
 }
@@ -1705,8 +1730,15 @@ static void load_GL_ES_VERSION_2_0(GLADloadproc load) {
     glad_glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)load("glVertexAttribPointer");
     glad_glViewport = (PFNGLVIEWPORTPROC)load("glViewport");
 }
+static void load_GL_EXT_instanced_arrays(GLADloadproc load) {
+    if(!GLAD_GL_EXT_instanced_arrays) return;
+    glad_glDrawArraysInstancedEXT = (PFNGLDRAWARRAYSINSTANCEDEXTPROC)load("glDrawArraysInstancedEXT");
+    glad_glDrawElementsInstancedEXT = (PFNGLDRAWELEMENTSINSTANCEDEXTPROC)load("glDrawElementsInstancedEXT");
+    glad_glVertexAttribDivisorEXT = (PFNGLVERTEXATTRIBDIVISOREXTPROC)load("glVertexAttribDivisorEXT");
+}
 static int find_extensionsGLES2(void) {
     if (!get_exts()) return 0;
+    GLAD_GL_EXT_instanced_arrays = has_ext("GL_EXT_instanced_arrays");
     GLAD_GL_OES_compressed_paletted_texture = has_ext("GL_OES_compressed_paletted_texture");
     free_exts();
     return 1;
@@ -1764,5 +1796,6 @@ int gladLoadGLES2Loader(GLADloadproc load) {
     load_GL_ES_VERSION_2_0(load);
 
     if (!find_extensionsGLES2()) return 0;
+    load_GL_EXT_instanced_arrays(load);
     return GLVersion.major != 0 || GLVersion.minor != 0;
 }
@@ -439,7 +439,7 @@ void PSPRenderQueueVisitor::do_visit(const Renderable* renderable, const Materia
         uint8_t* dst = &buffer[0];
 
         for(std::size_t i = 0; i < renderable->index_element_count; ++i) {
-            auto idx = renderable->index_data->at(i);
+            auto idx = renderable->index_data->at(renderable->index_offset + i);
             auto offset = idx * stride;
             std::memcpy(dst, renderable->vertex_data->data() + offset, stride);
             dst += stride;
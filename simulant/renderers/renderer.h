@@ -117,6 +117,23 @@ public:
     // Render support flags
     virtual bool supports_gpu_programs() const { return false; }
 
+    /* If true, a single Renderable with an instance_count may be
+     * submitted in place of one renderable per instance */
+    virtual bool supports_instancing() const { return false; }
+
+    /* If true, Renderable::instance_data is read by the GPU once per
+     * instance, rather than the renderable being replayed per instance */
+    virtual bool supports_instance_attributes() const { return false; }
+
+    /* The largest joint palette the renderer can skin in a vertex shader,
+     * 0 if GPU skinning isn't supported */
+    virtual uint32_t max_gpu_skinning_joints() const { return 0; }
+
+    /* True if particle systems can leave billboard expansion to the
+     * vertex shader (see Material::BuiltIns::PARTICLE) and draw all their
+     * particles with 32 bit indices */
+    virtual bool supports_gpu_billboards() const { return false; }
+
     /*
      * Returns true if the texture has been allocated, false otherwise.
      */
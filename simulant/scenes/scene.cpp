@@ -30,7 +30,9 @@
 #include "../nodes/debug.h"
 #include "../nodes/fly_controller.h"
 #include "../nodes/frustum_culler.h"
+#include "../nodes/spatial_hash_partitioner.h"
 #include "../nodes/geom.h"
+#include "../nodes/static_batch.h"
 #include "../nodes/light.h"
 #include "../nodes/mesh_instancer.h"
 #include "../nodes/particle_system.h"
@@ -52,6 +54,7 @@
 #include "../nodes/ui/text_entry.h"
 #include "../nodes/ui/ui_manager.h"
 #include "../platform.h"
+#include "../services/job_system.h"
 #include "../services/service.h"
 #include "../stage.h"
 #include "../window.h"
@@ -68,6 +71,9 @@ Scene::Scene(Window* window) :
     assets_(std::make_unique<AssetManager>(window->app->shared_assets.get())) {
 
     register_builtin_nodes();
+
+    /* Everything attached to the scene shares this queue */
+    transform->set_change_queue(&transform_changes_);
 }
 
 Scene::~Scene() {
@@ -80,12 +86,16 @@ Scene::~Scene() {
     }
 
     clean_up_destroyed_objects();
+
+    transform->set_change_queue(nullptr);
+    transform_changes_.clear();
 }
 
 void Scene::register_builtin_nodes() {
     register_stage_node<Stage>();
     register_stage_node<Actor>();
     register_stage_node<Geom>();
+    register_stage_node<StaticBatch>();
     register_stage_node<Camera>();
     register_stage_node<Camera2D>();
     register_stage_node<Camera3D>();
@@ -94,6 +104,7 @@ void Scene::register_builtin_nodes() {
     register_stage_node<PointLight>();
     register_stage_node<MeshInstancer>();
     register_stage_node<FrustumCuller>();
+    register_stage_node<SpatialHashPartitioner>();
     register_stage_node<CylindricalBillboard>();
     register_stage_node<SphericalBillboard>();
     register_stage_node<ParticleSystem>();
@@ -248,6 +259,45 @@ void Scene::on_fixed_update(float step) {
     StageNode::on_fixed_update(step);
 }
 
+void Scene::run_concurrent_updates(float dt) {
+    if(concurrent_updates_.empty()) {
+        return;
+    }
+
+    /* Parallel subtrees read the transforms above them, and sometimes
+     * each other's, so work out everything that's dirty now rather than
+     * have several threads resolve them at once. Anything moved during the
+     * update is resolved under the queue's lock. */
+    transform->resolve_subtree();
+    transform_changes_.set_concurrent(true);
+    updating_concurrently_ = true;
+
+    auto& nodes = concurrent_updates_;
+    app_->jobs->parallel_for(0, nodes.size(), [&nodes, dt](uint32_t first, uint32_t last) {
+        for(uint32_t i = first; i < last; ++i) {
+            nodes[i]->update(dt);
+        }
+    }, 0, "scene_update");
+
+    updating_concurrently_ = false;
+    transform_changes_.set_concurrent(false);
+    nodes.clear();
+
+    /* This is the barrier, nothing is deferred from here on so any
+     * changes these cause (e.g. destroying children) happen immediately */
+    std::vector<std::function<void ()>> changes;
+    std::swap(changes, deferred_changes_);
+
+    for(auto& change: changes) {
+        change();
+    }
+}
+
+void Scene::defer_structural_change(std::function<void ()> change) {
+    thread::Lock<thread::Mutex> lock(deferred_changes_mutex_);
+    deferred_changes_.push_back(std::move(change));
+}
+
 void Scene::on_update(float step) {
     /* Update services, before moving onto the scene tree */
     for(auto& service: services_) {
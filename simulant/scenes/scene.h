@@ -181,6 +181,19 @@ public:
         return stray_nodes_;
     }
 
+    /* True while the subtrees marked UPDATE_CONCURRENCY_PARALLEL are being
+     * updated on the job system */
+    bool is_updating_concurrently() const {
+        return updating_concurrently_;
+    }
+
+    /* Moving a node doesn't notify anything straight away, the changes
+     * are queued and delivered once per frame after late_update. Call this
+     * if something needs to see them sooner. */
+    void flush_transform_changes() {
+        transform_changes_.flush();
+    }
+
     const char* node_type_name() const override {
         return "Scene";
     }
@@ -236,6 +249,20 @@ private:
     std::list<StageNode*> queued_for_clean_up_;
     std::set<StageNode*> stray_nodes_;
 
+    TransformChangeQueue transform_changes_;
+
+    /* Parallel subtrees found during the update pass, and the structural
+     * changes they asked for while being updated */
+    bool collecting_concurrent_updates_ = false;
+    bool updating_concurrently_ = false;
+    std::vector<StageNode*> concurrent_updates_;
+
+    thread::Mutex deferred_changes_mutex_;
+    std::vector<std::function<void ()>> deferred_changes_;
+
+    void run_concurrent_updates(float dt);
+    void defer_structural_change(std::function<void ()> change);
+
     LightingSettings lighting_;
 
     /* Don't allow overriding on_create in subclasses, currently
@@ -60,6 +60,10 @@ void SceneManager::late_update(float dt) {
     if(active_scene()) {
         active_scene()->late_update(dt);
 
+        /* Notify anything listening for transform changes once, however
+         * many times things moved this frame */
+        active_scene()->flush_transform_changes();
+
         /* Anything destroyed must now be *really* destroyed */
         active_scene()->clean_up_destroyed_objects();
     }
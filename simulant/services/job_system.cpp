@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#if !defined(__DREAMCAST__) && !defined(__PSP__)
+#include <thread>
+#endif
+
+#include "../logging.h"
+#include "../time_keeper.h"
+#include "job_system.h"
+
+namespace smlt {
+
+/* More workers than this just fight over the queues */
+static const uint32_t MAX_DEFAULT_WORKERS = 7;
+
+struct Job {
+    JobFunction func;
+    const char* name = nullptr;
+    JobCounterPtr counter;
+};
+
+bool JobCounter::is_done() const {
+    thread::Lock<thread::Mutex> lock(mutex_);
+    return pending_ == 0;
+}
+
+uint32_t JobCounter::pending() const {
+    thread::Lock<thread::Mutex> lock(mutex_);
+    return pending_;
+}
+
+uint32_t JobSystem::default_worker_count() {
+#if defined(__DREAMCAST__) || defined(__PSP__)
+    return 0;
+#else
+    uint32_t cores = std::thread::hardware_concurrency();
+    return std::min((cores) ? cores - 1 : 0, MAX_DEFAULT_WORKERS);
+#endif
+}
+
+JobSystem::JobSystem(uint32_t worker_count) {
+    set_name("Job System");
+
+    for(uint32_t i = 0; i < worker_count; ++i) {
+        workers_.push_back(std::make_shared<Worker>());
+    }
+
+    for(uint32_t i = 0; i < worker_count; ++i) {
+        workers_[i]->thread = std::make_shared<thread::Thread>(&JobSystem::run_worker, this, i);
+    }
+
+    /* Workers record their own thread IDs, wait for them so that
+     * worker_index() works from here on */
+    thread::Lock<thread::Mutex> lock(mutex_);
+    while(started_ < worker_count) {
+        wake_.wait(mutex_);
+    }
+
+    S_DEBUG("Started the job system with {0} workers", worker_count);
+}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::stop() {
+    if(workers_.empty()) {
+        return;
+    }
+
+    {
+        thread::Lock<thread::Mutex> lock(mutex_);
+        stopping_ = true;
+        wake_.notify_all();
+    }
+
+    for(auto& worker: workers_) {
+        worker->thread->join();
+    }
+
+    workers_.clear();
+}
+
+JobCounterPtr JobSystem::run(JobFunction func, const char* name, const JobCounterPtr& after) {
+    auto counter = std::make_shared<JobCounter>();
+    run(counter, std::move(func), name, after);
+    return counter;
+}
+
+void JobSystem::run(const JobCounterPtr& counter, JobFunction func, const char* name, const JobCounterPtr& after) {
+    assert(counter);
+
+    {
+        thread::Lock<thread::Mutex> lock(counter->mutex_);
+        counter->pending_++;
+    }
+
+    Job* job = new Job();
+    job->func = std::move(func);
+    job->name = name;
+    job->counter = counter;
+
+    if(after) {
+        thread::Lock<thread::Mutex> lock(after->mutex_);
+        if(after->pending_) {
+            after->waiting_.push_back(job);
+            return;
+        }
+    }
+
+    enqueue(job);
+}
+
+void JobSystem::wait(const JobCounterPtr& counter) {
+    if(!counter) {
+        return;
+    }
+
+    if(workers_.empty()) {
+        /* Everything runs as it's submitted, so this can only happen if
+         * the counter is waiting on something that waits on it */
+        assert(counter->is_done() && "Job dependency cycle");
+    } else {
+        auto index = worker_index();
+
+        while(!counter->is_done()) {
+            if(Job* job = take_job(index)) {
+                execute(job);
+                continue;
+            }
+
+            sleep(counter);
+        }
+    }
+
+    std::exception_ptr exception;
+    {
+        thread::Lock<thread::Mutex> lock(counter->mutex_);
+        exception = counter->exception_;
+    }
+
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::parallel_for(uint32_t begin, uint32_t end, const std::function<void (uint32_t, uint32_t)>& func, uint32_t batch_size, const char* name) {
+    if(end <= begin) {
+        return;
+    }
+
+    const uint32_t count = end - begin;
+
+    if(!batch_size) {
+        batch_size = std::max(count / ((worker_count() + 1) * 4), 1u);
+    }
+
+    if(workers_.empty() || count <= batch_size) {
+        auto start = TimeKeeper::now_in_us();
+        func(begin, end);
+        record(name, TimeKeeper::now_in_us() - start);
+        return;
+    }
+
+    auto counter = std::make_shared<JobCounter>();
+
+    uint32_t last = 0;
+    for(uint32_t first = begin; first < end; first = last) {
+        last = (end - first > batch_size) ? first + batch_size : end;
+        run(counter, [&func, first, last]() { func(first, last); }, name);
+    }
+
+    wait(counter);
+}
+
+std::map<std::string, JobStats> JobSystem::stats() const {
+    /* The same name can come from different literals, and from different
+     * workers */
+    std::map<std::string, JobStats> result;
+
+    auto merge = [&result](const std::unordered_map<const char*, JobStats>& stats) {
+        for(auto& p: stats) {
+            auto& s = result[p.first];
+            s.count += p.second.count;
+            s.total_us += p.second.total_us;
+            s.max_us = std::max(s.max_us, p.second.max_us);
+        }
+    };
+
+    {
+        thread::Lock<thread::Mutex> lock(stats_mutex_);
+        merge(stats_);
+    }
+
+    for(auto& worker: workers_) {
+        thread::Lock<thread::Mutex> lock(worker->stats_mutex);
+        merge(worker->stats);
+    }
+
+    return result;
+}
+
+void JobSystem::reset_stats() {
+    {
+        thread::Lock<thread::Mutex> lock(stats_mutex_);
+        stats_.clear();
+    }
+
+    for(auto& worker: workers_) {
+        thread::Lock<thread::Mutex> lock(worker->stats_mutex);
+        worker->stats.clear();
+    }
+}
+
+int32_t JobSystem::worker_index() const {
+    auto id = thread::this_thread_id();
+    for(std::size_t i = 0; i < workers_.size(); ++i) {
+        if(workers_[i]->id == id) {
+            return (int32_t) i;
+        }
+    }
+
+    return -1;
+}
+
+void JobSystem::enqueue(Job* job) {
+    if(workers_.empty()) {
+        execute(job);
+        return;
+    }
+
+    /* Workers queue onto their own deque, anyone else shares the jobs out */
+    auto index = worker_index();
+    if(index < 0) {
+        thread::Lock<thread::Mutex> lock(submit_mutex_);
+        index = next_queue_++ % workers_.size();
+    }
+
+    bool wake = false;
+
+    auto& worker = workers_[index];
+    {
+        thread::Lock<thread::Mutex> lock(worker->mutex);
+        worker->queue.push_back(job);
+
+        wake = worker->wake_on_push;
+        worker->wake_on_push = false;
+    }
+
+    if(wake) {
+        wake_sleepers();
+    }
+}
+
+Job* JobSystem::take_job(int32_t worker) {
+    Job* job = nullptr;
+
+    /* Newest first from our own queue, it's the most likely to be cached */
+    if(worker >= 0) {
+        auto& own = workers_[worker];
+        thread::Lock<thread::Mutex> lock(own->mutex);
+        if(!own->queue.empty()) {
+            job = own->queue.back();
+            own->queue.pop_back();
+        }
+    }
+
+    /* Then the oldest from everyone else */
+    const std::size_t count = workers_.size();
+    for(std::size_t i = 0; !job && i < count; ++i) {
+        auto v = (std::size_t(worker + 1) + i) % count;
+        if(int32_t(v) == worker) {
+            continue;
+        }
+
+        auto& victim = workers_[v];
+
+        thread::Lock<thread::Mutex> lock(victim->mutex);
+        if(!victim->queue.empty()) {
+            job = victim->queue.front();
+            victim->queue.pop_front();
+        }
+    }
+
+    return job;
+}
+
+void JobSystem::execute(Job* job) {
+    auto start = TimeKeeper::now_in_us();
+
+    /* Kept for wait() to rethrow, so that callers see the same failure
+     * they would if the work had run on their own thread */
+    std::exception_ptr exception;
+    try {
+        job->func();
+    } catch(...) {
+        exception = std::current_exception();
+    }
+
+    record(job->name, TimeKeeper::now_in_us() - start);
+
+    auto counter = job->counter;
+    delete job;
+
+    std::vector<Job*> released;
+    bool wake = false;
+    {
+        thread::Lock<thread::Mutex> lock(counter->mutex_);
+        if(exception && !counter->exception_) {
+            counter->exception_ = exception;
+        }
+
+        if(--counter->pending_ == 0) {
+            std::swap(released, counter->waiting_);
+            wake = counter->waiters_ > 0;
+        }
+    }
+
+    for(auto waiting: released) {
+        enqueue(waiting);
+    }
+
+    if(wake) {
+        wake_sleepers();
+    }
+}
+
+void JobSystem::record(const char* name, uint64_t elapsed_us) {
+    auto index = worker_index();
+
+    auto& mutex = (index < 0) ? stats_mutex_ : workers_[index]->stats_mutex;
+    auto& stats = (index < 0) ? stats_ : workers_[index]->stats;
+
+    thread::Lock<thread::Mutex> lock(mutex);
+    auto& s = stats[name];
+    s.count++;
+    s.total_us += elapsed_us;
+    s.max_us = std::max(s.max_us, elapsed_us);
+}
+
+bool JobSystem::sleep(const JobCounterPtr& counter) {
+    thread::Lock<thread::Mutex> lock(mutex_);
+
+    /* Ask every queue to wake us on its next push. A push that sees the
+     * flag has to take mutex_ to wake us, so it can't get in between
+     * this check and the wait below. */
+    for(auto& worker: workers_) {
+        thread::Lock<thread::Mutex> queue_lock(worker->mutex);
+        if(!worker->queue.empty()) {
+            return true;
+        }
+
+        worker->wake_on_push = true;
+    }
+
+    if(counter) {
+        thread::Lock<thread::Mutex> counter_lock(counter->mutex_);
+        if(!counter->pending_) {
+            return true;
+        }
+
+        ++counter->waiters_;
+    } else if(stopping_) {
+        return false;
+    }
+
+    wake_.wait(mutex_);
+
+    if(counter) {
+        thread::Lock<thread::Mutex> counter_lock(counter->mutex_);
+        --counter->waiters_;
+    }
+
+    return true;
+}
+
+void JobSystem::wake_sleepers() {
+    thread::Lock<thread::Mutex> lock(mutex_);
+    wake_.notify_all();
+}
+
+void JobSystem::run_worker(uint32_t index) {
+    {
+        thread::Lock<thread::Mutex> lock(mutex_);
+        workers_[index]->id = thread::this_thread_id();
+        ++started_;
+        wake_.notify_all();
+    }
+
+    while(true) {
+        if(Job* job = take_job(index)) {
+            execute(job);
+            continue;
+        }
+
+        if(!sleep(JobCounterPtr())) {
+            return;
+        }
+    }
+}
+
+}
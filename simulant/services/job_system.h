@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../threads/condition.h"
+#include "../threads/mutex.h"
+#include "../threads/thread.h"
+#include "service.h"
+
+namespace smlt {
+
+class JobSystem;
+
+typedef std::function<void ()> JobFunction;
+
+struct Job;
+
+/*
+ * Tracks a group of jobs. A counter is done once every job run against it
+ * has finished, and other jobs can be told to wait for it before they
+ * start.
+ *
+ * If a job throws, the first exception is kept and rethrown by
+ * JobSystem::wait() on the counter.
+ */
+class JobCounter {
+public:
+    bool is_done() const;
+    uint32_t pending() const;
+
+private:
+    friend class JobSystem;
+
+    mutable thread::Mutex mutex_;
+    uint32_t pending_ = 0;
+
+    /* Threads asleep in wait() until this is done */
+    uint32_t waiters_ = 0;
+    std::exception_ptr exception_;
+
+    /* Jobs which can't start until this counter is done */
+    std::vector<Job*> waiting_;
+};
+
+typedef std::shared_ptr<JobCounter> JobCounterPtr;
+
+struct JobStats {
+    uint32_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+
+    float average_us() const {
+        return (count) ? float(total_us) / float(count) : 0.0f;
+    }
+};
+
+/*
+ * Runs jobs across a fixed set of worker threads. Each worker has its own
+ * queue, it takes the newest job from its own queue and steals the oldest
+ * from the others when it runs dry.
+ *
+ * Threads which wait() on a counter run queued jobs while they wait, so
+ * jobs can safely fan out more work and wait for it.
+ *
+ * With no workers, jobs run inline on the thread that submits them (or
+ * that finishes the last job they depend on). This is what happens on
+ * single core platforms.
+ *
+ * The application owns one of these, configured by
+ * AppConfig::general::job_worker_count and available as `app->jobs`.
+ */
+class JobSystem:
+    public Service {
+
+public:
+    /* A sensible number of workers for this machine, one per spare core */
+    static uint32_t default_worker_count();
+
+    JobSystem(uint32_t worker_count=0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t worker_count() const {
+        return (uint32_t) workers_.size();
+    }
+
+    /* Queues `func`, which won't start until `after` (if any) is done.
+     * The returned counter is done when the job is.
+     *
+     * `name` groups the job in the timing stats, it must outlive the job
+     * so pass a string literal. */
+    JobCounterPtr run(
+        JobFunction func,
+        const char* name="job",
+        const JobCounterPtr& after=JobCounterPtr()
+    );
+
+    /* As above, but adds the job to an existing counter so a batch of jobs
+     * can be waited on (or depended on) together */
+    void run(
+        const JobCounterPtr& counter,
+        JobFunction func,
+        const char* name="job",
+        const JobCounterPtr& after=JobCounterPtr()
+    );
+
+    /* Blocks until the counter is done, running queued jobs meanwhile.
+     * Rethrows the first exception thrown by any of the counter's jobs. */
+    void wait(const JobCounterPtr& counter);
+
+    /* Splits [begin, end) into batches of `batch_size` and calls `func`
+     * with the bounds of each batch across the workers, returning once
+     * they've all finished. The calling thread takes part. A batch size of
+     * zero picks one that gives each thread a few batches. */
+    void parallel_for(
+        uint32_t begin, uint32_t end,
+        const std::function<void (uint32_t, uint32_t)>& func,
+        uint32_t batch_size=0,
+        const char* name="parallel_for"
+    );
+
+    /* Finishes everything that's queued and joins the workers. Jobs run
+     * after this are run inline. */
+    void stop();
+
+    /* Run count and timings of the jobs run so far, by name */
+    std::map<std::string, JobStats> stats() const;
+    void reset_stats();
+
+private:
+    struct Worker {
+        thread::Mutex mutex;
+        std::deque<Job*> queue;
+
+        /* Set by threads going to sleep, so that the next push to this
+         * queue knows it has to wake them */
+        bool wake_on_push = false;
+
+        std::shared_ptr<thread::Thread> thread;
+        thread::ThreadID id = 0;
+
+        /* Timings of the jobs this worker ran, merged by stats() */
+        mutable thread::Mutex stats_mutex;
+        std::unordered_map<const char*, JobStats> stats;
+    };
+
+    std::vector<std::shared_ptr<Worker>> workers_;
+
+    /* Only taken to go to sleep and to wake sleepers. Pushing, taking and
+     * finishing jobs lock just the queues and counters involved. */
+    thread::Mutex mutex_;
+    thread::Condition wake_;
+    uint32_t started_ = 0;
+    bool stopping_ = false;
+
+    /* Round robin over the queues for threads which aren't workers */
+    thread::Mutex submit_mutex_;
+    uint32_t next_queue_ = 0;
+
+    /* Timings of jobs run by threads which aren't workers */
+    mutable thread::Mutex stats_mutex_;
+    std::unordered_map<const char*, JobStats> stats_;
+
+    int32_t worker_index() const;
+
+    void enqueue(Job* job);
+    Job* take_job(int32_t worker);
+    void execute(Job* job);
+    void record(const char* name, uint64_t elapsed_us);
+
+    /* Blocks until a job might be waiting, or `counter` (if any) is done.
+     * Returns false if the system is stopping and every queue is empty. */
+    bool sleep(const JobCounterPtr& counter);
+    void wake_sleepers();
+
+    void run_worker(uint32_t index);
+};
+
+}
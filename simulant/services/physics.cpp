@@ -643,6 +643,12 @@ void PhysicsService::add_mesh_collider(PhysicsBody* self, const MeshPtr& mesh,
 }
 
 void PhysicsService::on_fixed_update(float step) {
+    /* Transform changes are only delivered once a frame, make sure
+     * the bodies are where they've been moved to before stepping */
+    for(b3Body* b = pimpl_->scene_->GetBodyList(); b; b = b->GetNext()) {
+        static_cast<PhysicsBody*>(b->GetUserData())->push_transform_to_body();
+    }
+
     uint32_t velocity_iterations = 8;
     uint32_t position_iterations = 2;
     pimpl_->scene_->Step(step, velocity_iterations, position_iterations);
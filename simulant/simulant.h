@@ -42,10 +42,12 @@
 #include "frustum.h"
 #include "nodes/actor.h"
 #include "nodes/geom.h"
+#include "nodes/static_batch.h"
 #include "nodes/mesh_instancer.h"
 #include "nodes/physics/dynamic_body.h"
 #include "nodes/physics/joints.h"
 #include "nodes/physics/kinematic_body.h"
+#include "services/job_system.h"
 #include "services/physics.h"
 #include "stage.h"
 #include "time_keeper.h"
@@ -26,6 +26,7 @@
 #include "application.h"
 #include "time_keeper.h"
 #include "threads/thread.h"
+#include "streams/file_ifstream.h"
 
 namespace smlt {
 
@@ -38,6 +39,14 @@ Sound::Sound(AssetID id, AssetManager *asset_manager, SoundDriver *sound_driver)
 
 }
 
+std::size_t Sound::memory_usage() const {
+    if(!sound_data_ || std::dynamic_pointer_cast<FileIfstream>(sound_data_)) {
+        return 0;
+    }
+
+    return stream_length_;
+}
+
 std::size_t Sound::buffer_size() const {
     /* We try to determine the optimum buffer size depending on the
      * frequency, number of channels and format. Testing shows that you need
@@ -34,6 +34,7 @@
 #include "loadable.h"
 
 #include "types.h"
+#include "threads/mutex.h"
 
 namespace smlt {
 
@@ -77,6 +78,10 @@ public:
         return stream_length_;
     }
 
+    /* The decoded data if it's held in memory. Sounds which stream from a
+     * file don't count. */
+    std::size_t memory_usage() const override;
+
     template<typename Func>
     void set_playing_sound_init_function(Func&& func) {
         init_playing_sound_ = func;
@@ -84,6 +89,10 @@ public:
 
     SoundDriver* _driver() const { return driver_; }
 
+    /* Held while reading or decoding from the input stream, which is
+     * shared between every PlayingSound of this Sound */
+    thread::Mutex& _stream_mutex() const { return stream_mutex_; }
+
 private:
     void init_source(PlayingSound& source);
 
@@ -91,6 +100,7 @@ private:
 
     SoundDriver* driver_ = nullptr;
     std::shared_ptr<std::istream> sound_data_;
+    mutable thread::Mutex stream_mutex_;
 
     uint32_t sample_rate_ = 0;
     AudioDataFormat format_;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace smlt {
+
+/* A fixed ring of equally sized chunks of decoded PCM data. Chunks are
+ * written (decoded) at the back and read (uploaded) from the front.
+ * This does no locking of its own. */
+class DecodeRing {
+public:
+    DecodeRing() = default;
+
+    void reset(std::size_t chunk_count, std::size_t chunk_size) {
+        chunk_size_ = chunk_size;
+        data_.assign(chunk_count * chunk_size, 0);
+        sizes_.assign(chunk_count, 0);
+        clear();
+    }
+
+    void clear() {
+        head_ = 0;
+        count_ = 0;
+    }
+
+    std::size_t chunk_size() const { return chunk_size_; }
+    std::size_t capacity() const { return sizes_.size(); }
+    std::size_t size() const { return count_; }
+
+    bool empty() const { return count_ == 0; }
+    bool full() const { return count_ == sizes_.size(); }
+
+    /* The chunk to decode into next, only valid if !full() */
+    uint8_t* back() {
+        return &data_[((head_ + count_) % sizes_.size()) * chunk_size_];
+    }
+
+    /* Makes the chunk returned by back() readable */
+    void push_back(std::size_t bytes) {
+        sizes_[(head_ + count_) % sizes_.size()] = bytes;
+        ++count_;
+    }
+
+    /* The oldest decoded chunk, only valid if !empty() */
+    const uint8_t* front(std::size_t* bytes) const {
+        *bytes = sizes_[head_];
+        return &data_[head_ * chunk_size_];
+    }
+
+    void pop_front() {
+        head_ = (head_ + 1) % sizes_.size();
+        --count_;
+    }
+
+private:
+    std::vector<uint8_t> data_;
+    std::vector<std::size_t> sizes_;
+    std::size_t chunk_size_ = 0;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+};
+
+}
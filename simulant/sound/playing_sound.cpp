@@ -4,11 +4,15 @@
 #include "../application.h"
 #include "../nodes/stage_node.h"
 #include "../nodes/audio_source.h"
+#include "../stats_recorder.h"
 
 namespace smlt {
 
 const static int BUFFER_COUNT = 4;
 
+/* How many buffers worth of data we keep decoded ahead of playback */
+const static int DECODE_AHEAD_COUNT = 2;
+
 PlayingAssetID PlayingSound::counter_ = 0;
 
 PlayingSound::PlayingSound(AudioSource* parent, std::weak_ptr<Sound> sound, AudioRepeat loop_stream, DistanceModel model):
@@ -40,8 +44,79 @@ PlayingSound::~PlayingSound() {
     }
 }
 
+void PlayingSound::set_decode_func(DecodeFunc func) {
+    thread::Lock<thread::Mutex> lock(decode_mutex_);
+
+    decode_func_ = func;
+    decode_finished_ = false;
+    decode_result_ = 0;
+
+    auto sound = sound_.lock();
+    if(sound && decoded_.chunk_size() != sound->buffer_size()) {
+        decoded_.reset(DECODE_AHEAD_COUNT, sound->buffer_size());
+    } else {
+        decoded_.clear();
+    }
+}
+
+void PlayingSound::decode_chunk() {
+    if(decode_finished_ || !decode_func_ || decoded_.full()) {
+        return;
+    }
+
+    int32_t bytes = decode_func_(decoded_.back(), decoded_.chunk_size());
+    if(bytes <= 0) {
+        decode_finished_ = true;
+        decode_result_ = bytes;
+    } else {
+        decoded_.push_back(bytes);
+    }
+}
+
+void PlayingSound::decode_ahead() {
+    thread::Lock<thread::Mutex> lock(decode_mutex_);
+
+    while(!is_dead_ && !decode_finished_ && !decoded_.full()) {
+        decode_chunk();
+    }
+}
+
+int32_t PlayingSound::refill_buffer(AudioBufferID buffer) {
+    if(stream_func_) {
+        return stream_func_(buffer);
+    }
+
+    thread::Lock<thread::Mutex> lock(decode_mutex_);
+
+    /* Nothing decoded yet (we've just started, or decode_ahead didn't
+     * get to us in time) so decode here */
+    if(decoded_.empty()) {
+        decode_chunk();
+    }
+
+    if(decoded_.empty()) {
+        return decode_result_;
+    }
+
+    auto sound = sound_.lock();
+    if(!sound) {
+        return -1;
+    }
+
+    std::size_t bytes = 0;
+    const uint8_t* data = decoded_.front(&bytes);
+
+    sound->_driver()->upload_buffer_data(
+        buffer, sound->format(), data, bytes, sound->sample_rate()
+    );
+
+    decoded_.pop_front();
+
+    return bytes;
+}
+
 void PlayingSound::start() {
-    if(!stream_func_) {
+    if(!stream_func_ && !decode_func_) {
         S_WARN("Not playing sound as no stream func was set");
         return;
     }
@@ -49,7 +124,7 @@ void PlayingSound::start() {
     SoundDriver* driver = smlt::get_app()->sound_driver.get();
 
     for(int i = 0; i < BUFFER_COUNT; ++i) {
-        auto bs = stream_func_(buffers_[i]);
+        auto bs = refill_buffer(buffers_[i]);
         if(bs < 0) {
             /* Sound was destroyed immediately */
             is_dead_ = true;
@@ -71,6 +146,9 @@ void PlayingSound::start() {
 }
 
 void PlayingSound::do_stop() {
+    /* Don't let the audio thread restart a looping sound we've stopped */
+    thread::Lock<thread::Mutex> lock(update_mutex_);
+
     auto app = smlt::get_app();
     SoundDriver* driver = (app) ? app->sound_driver.get() : nullptr;
 
@@ -101,6 +179,14 @@ void PlayingSound::set_reference_distance(float dist) {
 }
 
 void PlayingSound::update(float dt) {
+    update_position(dt);
+
+    if(update_buffers()) {
+        parent_->signal_stream_finished_();
+    }
+}
+
+void PlayingSound::update_position(float dt) {
     SoundDriver* driver = smlt::get_app()->sound_driver.get();
 
     // Update the position of the source if this is attached to a stagenode
@@ -122,6 +208,16 @@ void PlayingSound::update(float dt) {
         // funny
         first_update_ = false;
     }
+}
+
+bool PlayingSound::update_buffers() {
+    thread::Lock<thread::Mutex> lock(update_mutex_);
+
+    if(is_dead_) {
+        return false;
+    }
+
+    SoundDriver* driver = smlt::get_app()->sound_driver.get();
 
     int32_t processed = driver->source_buffers_processed_count(source_);
 
@@ -132,10 +228,12 @@ void PlayingSound::update(float dt) {
      * source instance */
     auto sound = sound_.lock();    
 
+    bool queued = false;
+
     while(processed--) {
         AudioBufferID buffer = driver->unqueue_buffers_from_source(source_, 1).front();
 
-        int32_t bytes = stream_func_(buffer);
+        int32_t bytes = refill_buffer(buffer);
 
         if(!finished) {
             if(bytes <= 0) {
@@ -144,13 +242,22 @@ void PlayingSound::update(float dt) {
                 finished = driver->source_state(source_) == AUDIO_SOURCE_STATE_STOPPED;
             } else {
                 driver->queue_buffers_to_source(source_, 1, {buffer});
+                queued = true;
             }
         }
     }
 
-    if(finished) {
-        parent_->signal_stream_finished_();
+    if(queued && driver->source_state(source_) == AUDIO_SOURCE_STATE_STOPPED) {
+        /* Every buffer played before we could refill them. The source
+         * won't restart by itself */
+        driver->play_source(source_);
+
+        if(auto app = smlt::get_app()) {
+            app->stats->increment_audio_underruns();
+        }
+    }
 
+    if(finished) {
         /* Make sure we're totally stopped! */
         driver->stop_source(source_);
 
@@ -173,6 +280,8 @@ void PlayingSound::update(float dt) {
             is_dead_ = true;
         }
     }
+
+    return finished;
 }
 
 void PlayingSound::stop() {
@@ -8,6 +8,9 @@
 #include "../generic/range_value.h"
 
 #include "../math/vec3.h"
+#include "../threads/mutex.h"
+
+#include "decode_ring.h"
 
 namespace smlt {
 
@@ -19,6 +22,11 @@ typedef uint32_t AudioSourceID;
 
 typedef std::function<int32_t (AudioBufferID)> StreamFunc;
 
+/* Decodes up to max_bytes of PCM data into the output, returning the
+ * number of bytes written, 0 at the end of the stream or -1 if the sound
+ * was destroyed */
+typedef std::function<int32_t (uint8_t*, std::size_t)> DecodeFunc;
+
 typedef std::size_t PlayingAssetID;
 
 enum AudioRepeat {
@@ -49,9 +57,24 @@ private:
     std::weak_ptr<Sound> sound_;
     StreamFunc stream_func_;
 
+    /* Decoding happens ahead of playback into decoded_, so that refilling
+     * a buffer is usually just an upload */
+    mutable thread::Mutex decode_mutex_;
+    DecodeFunc decode_func_;
+    DecodeRing decoded_;
+    bool decode_finished_ = false;
+    int32_t decode_result_ = 0;
+
+    int32_t refill_buffer(AudioBufferID buffer);
+    void decode_chunk();
+
     AudioRepeat loop_stream_;
     bool is_dead_;
 
+    /* Held while the buffers are refilled and while stopping, never while
+     * the source is locked */
+    thread::Mutex update_mutex_;
+
     /* This is used to calculate the velocity */
     smlt::Vec3 previous_position_;
     bool first_update_ = true;
@@ -70,12 +93,29 @@ public:
     void update(float dt);
     void stop();
 
+    /* update() in two halves. The audio thread calls update_position()
+     * with the source locked, and update_buffers() without, so destroying
+     * the source never waits for buffers to be refilled.
+     * update_buffers() returns true if the stream finished, and it's up
+     * to the caller to signal the source. */
+    void update_position(float dt);
+    bool update_buffers();
+
     bool is_playing() const;
 
     /* Set the stream function for filling buffers. A -1 return
      * means the sound has been destroyed */
     void set_stream_func(StreamFunc func) { stream_func_ = func; }
 
+    /* Set the decode function. This is preferred over a stream func, as
+     * decoding can then happen ahead of time on the audio thread. If both
+     * are set the stream func is used */
+    void set_decode_func(DecodeFunc func);
+
+    /* Decodes until the decode-ahead buffer is full, or the stream
+     * ends. Called by the audio thread without any source locks held */
+    void decode_ahead();
+
     bool is_dead() const { return is_dead_; }
 
     void set_gain(NormalizedFloat gain);
@@ -3,6 +3,7 @@
 #include <cstdint>
 
 #include "generic/managed.h"
+#include "threads/mutex.h"
 #include "types.h"
 
 namespace smlt {
@@ -49,6 +50,18 @@ public:
         return polygons_rendered_;
     }
 
+    /* The number of times a streaming sound ran out of queued audio before
+     * more could be decoded. Incremented from the audio thread. */
+    uint32_t audio_underruns() const {
+        thread::Lock<thread::Mutex> lock(audio_mutex_);
+        return audio_underruns_;
+    }
+
+    void increment_audio_underruns() {
+        thread::Lock<thread::Mutex> lock(audio_mutex_);
+        audio_underruns_++;
+    }
+
 private:
     float frame_time_ = 0;
     uint32_t subactors_renderered_ = 0;
@@ -59,6 +72,9 @@ private:
     uint64_t frames_run_ = 0;
 
     uint32_t polygons_rendered_ = 0;
+
+    mutable thread::Mutex audio_mutex_;
+    uint32_t audio_underruns_ = 0;
 };
 
 
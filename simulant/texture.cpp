@@ -575,6 +575,10 @@ bool Texture::has_data() const {
     return bool(data_);
 }
 
+std::size_t Texture::memory_usage() const {
+    return (data_) ? data_size_ : required_data_size(format_, width_, height_);
+}
+
 void Texture::flush() {
     /* If in a coroutine: yield, run this code in the main thread, then resume */
     cr_run_main([this]() {
@@ -258,6 +258,10 @@ public:
     /** Returns true if the data array isn't empty */
     bool has_data() const;
 
+    /** The size of the data if it's still in ram, otherwise the size
+     *  it takes up once uploaded */
+    std::size_t memory_usage() const override;
+
     /**
      * Flushes texture data / properties to the renderer immediately. This
      * will free ram if the free data mode is set to
@@ -1,4 +1,11 @@
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+
+#if !defined(__PSP__) && !defined(__DREAMCAST__) && !defined(_MSC_VER)
+#include <sys/time.h>
+#endif
+
 #include "condition.h"
 #include "../compat.h"
 #include "../macros.h"
@@ -78,6 +85,62 @@ void Condition::wait(Mutex& mutex) {
 #endif
 }
 
+bool Condition::wait_for(Mutex& mutex, uint32_t timeout_us) {
+#ifdef __PSP__
+    {
+        Lock<Mutex> lock(lock_);
+        ++waiting_;
+    }
+
+    mutex.unlock();
+
+    SceUInt timeout = timeout_us;
+    bool signalled = sceKernelWaitSema(wait_sem_, 1, &timeout) >= 0;
+
+    {
+        Lock<Mutex> lock(lock_);
+
+        /* A notify may have counted us as waiting just as we timed out,
+         * if so take the signal so the notifier isn't left hanging */
+        if(!signalled && signals_ > 0) {
+            signalled = sceKernelPollSema(wait_sem_, 1) >= 0;
+        }
+
+        if(signalled && signals_ > 0) {
+            sceKernelSignalSema(wait_done_, 1);
+            --signals_;
+        }
+
+        --waiting_;
+    }
+
+    mutex.lock();
+    return signalled;
+#elif defined(__DREAMCAST__)
+    /* A timeout of zero would wait forever */
+    int timeout_ms = std::max(1, int(timeout_us / 1000));
+    int err = cond_wait_timed(&cond_, &mutex.mutex_, timeout_ms);
+    return err == 0;
+#elif defined(_MSC_VER)
+    return SleepConditionVariableCS(&cond_, &mutex.mutex_, timeout_us / 1000);
+#else
+    assert(!mutex.try_lock());  /* Mutex should've been locked by this thread */
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    uint64_t usec = uint64_t(now.tv_usec) + timeout_us;
+
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec + (usec / 1000000);
+    deadline.tv_nsec = (usec % 1000000) * 1000;
+
+    int err = pthread_cond_timedwait(&cond_, &mutex.mutex_, &deadline);
+    assert(!err || err == ETIMEDOUT);
+    return err == 0;
+#endif
+}
+
 void Condition::notify_one() {
 #ifdef __PSP__
     lock_.lock();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "mutex.h"
 
 #ifdef __DREAMCAST__
@@ -17,6 +19,11 @@ public:
     ~Condition();
 
     void wait(Mutex& mutex);
+
+    /* Waits until notified or until timeout_us microseconds have
+     * passed. Returns false if the wait timed out. As with wait() the
+     * caller should re-check whatever it's waiting for either way. */
+    bool wait_for(Mutex& mutex, uint32_t timeout_us);
     void notify_one();
     void notify_all();
 
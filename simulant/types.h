@@ -96,6 +96,12 @@ enum VertexAttribute {
     VERTEX_ATTRIBUTE_4UB_BGRA,
     VERTEX_ATTRIBUTE_PACKED_VEC4_1I, // Packed 10, 10, 10, 2 vector
 
+    /* Compact formats for static geometry (see utils::convert_vertex_data) */
+    VERTEX_ATTRIBUTE_3S_NORMALIZED, // Signed 16-bit, scaled by the VertexData position range
+    VERTEX_ATTRIBUTE_2B_OCTAHEDRAL, // Unit vector, octahedral encoded in 2 signed bytes
+    VERTEX_ATTRIBUTE_2S_OCTAHEDRAL, // Unit vector, octahedral encoded in 2 signed shorts
+    VERTEX_ATTRIBUTE_2H, // Half floats
+
     VERTEX_ATTRIBUTE_4UB_RGBA = VERTEX_ATTRIBUTE_4UB
 };
 
@@ -562,8 +568,17 @@ constexpr uint16_t vertex_attribute_size(VertexAttribute attr) {
                           : (attr == VERTEX_ATTRIBUTE_4UB_RGBA ||
                              attr == VERTEX_ATTRIBUTE_4UB_BGRA)
                               ? sizeof(uint8_t) * 4
+                          : (attr == VERTEX_ATTRIBUTE_4US)
+                              ? sizeof(uint16_t) * 4
                           : (attr == VERTEX_ATTRIBUTE_PACKED_VEC4_1I)
                               ? sizeof(uint32_t)
+                          : (attr == VERTEX_ATTRIBUTE_3S_NORMALIZED)
+                              ? sizeof(int16_t) * 3
+                          : (attr == VERTEX_ATTRIBUTE_2B_OCTAHEDRAL)
+                              ? sizeof(int8_t) * 2
+                          : (attr == VERTEX_ATTRIBUTE_2S_OCTAHEDRAL ||
+                             attr == VERTEX_ATTRIBUTE_2H)
+                              ? sizeof(uint16_t) * 2
                               : 0,
                           BUFFER_ATTRIBUTE_ALIGNMENT);
 }
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <type_traits>
 
 #include "../compat.h"
 
@@ -22,7 +27,170 @@ public:
         return _format(fmt_, 0, std::forward<Args>(args)...);
     }
 
+    /* Formats straight into buffer without building any intermediate
+     * strings, truncating if the result doesn't fit. The buffer is always
+     * null terminated, and the length written (without the terminator) is
+     * returned. Numbers and strings are written directly, anything else
+     * goes through its operator<< */
+    template<typename... Args>
+    static std::size_t format_into(char* buffer, std::size_t size,
+                                   const char* fmt, const Args&... args) {
+        const Argument arguments[] = {Argument(args)..., Argument()};
+        return _format_into(buffer, size, fmt, arguments, sizeof...(Args));
+    }
+
+    template<typename... Args>
+    static std::size_t format_into(char* buffer, std::size_t size,
+                                   const std::string& fmt, const Args&... args) {
+        return format_into(buffer, size, fmt.c_str(), args...);
+    }
+
 private:
+    struct Output {
+        char* buffer;
+        std::size_t size;
+        std::size_t length;
+
+        void append(const char* str, std::size_t count) {
+            count = std::min(count, size - 1 - length);
+            std::memcpy(buffer + length, str, count);
+            length += count;
+        }
+    };
+
+    struct Argument {
+        typedef void (*WriteFunc)(Output&, const void*, int);
+
+        Argument() = default;
+
+        template<typename T>
+        Argument(const T& value):
+            value(&value),
+            write(&Argument::write_value<T>) {}
+
+        const void* value = nullptr;
+        WriteFunc write = nullptr;
+
+    private:
+        template<typename T>
+        static void write_value(Output& out, const void* value, int precision) {
+            Formatter::write(out, *static_cast<const T*>(value), precision);
+        }
+    };
+
+    template<typename T>
+    using is_number = std::integral_constant<
+        bool,
+        std::is_arithmetic<T>::value &&
+        !std::is_same<T, bool>::value &&
+        !std::is_same<T, char>::value &&
+        !std::is_same<T, unsigned char>::value
+    >;
+
+    static void write(Output& out, const std::string& value, int) {
+        out.append(value.c_str(), value.size());
+    }
+
+    static void write(Output& out, const char* value, int) {
+        if(value) {
+            out.append(value, std::strlen(value));
+        }
+    }
+
+    template<typename T>
+    static typename std::enable_if<is_number<T>::value && std::is_integral<T>::value>::type
+    write(Output& out, const T& value, int) {
+        char tmp[24];
+        int n = (std::is_signed<T>::value) ?
+            snprintf(tmp, sizeof(tmp), "%lld", (long long) value) :
+            snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long) value);
+        out.append(tmp, std::max(n, 0));
+    }
+
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    write(Output& out, const T& value, int precision) {
+        /* Matches the stream defaults used by format() */
+        char tmp[32];
+        int n = snprintf(tmp, sizeof(tmp), "%.*g",
+                         (precision < 0) ? 6 : precision, (double) value);
+        out.append(tmp, std::min<std::size_t>(std::max(n, 0), sizeof(tmp) - 1));
+    }
+
+    template<typename T>
+    static typename std::enable_if<!is_number<T>::value>::type
+    write(Output& out, const T& value, int precision) {
+        std::stringstream ss;
+        if(precision >= 0) {
+            ss << std::setprecision(precision);
+        }
+
+        ss << value;
+        write(out, ss.str(), precision);
+    }
+
+    static std::size_t _format_into(char* buffer, std::size_t size,
+                                    const char* fmt, const Argument* args,
+                                    std::size_t arg_count) {
+        if(!size) {
+            return 0;
+        }
+
+        Output out = {buffer, size, 0};
+        const int max_token_size = 7;
+
+        const char* c = fmt;
+        while(*c && out.length < size - 1) {
+            if(*c != '{') {
+                /* Copy everything up to the next placeholder in one go */
+                const char* next = std::strchr(c, '{');
+                std::size_t count = (next) ? std::size_t(next - c) : std::strlen(c);
+                out.append(c, count);
+                c += count;
+                continue;
+            }
+
+            /* Same rules as format(), an index of up to a few digits and
+             * an optional :.N precision */
+            char id[max_token_size] = {0};
+            char spec[max_token_size] = {0};
+            char* t = id;
+            std::size_t t_len = 0;
+            int j = 1;
+            for(; j < max_token_size; ++j) {
+                char ch = c[j];
+                if(!ch || ch == '}') {
+                    break;
+                } else if(ch == ':') {
+                    t = spec;
+                    t_len = 0;
+                } else if(is_int(ch) || (t == spec && ch == '.')) {
+                    t[t_len++] = ch;
+                } else {
+                    break;
+                }
+            }
+
+            std::size_t index = std::size_t(std::atoi(id));
+            if(c[j] != '}' || index >= arg_count) {
+                out.append(c, 1);
+                ++c;
+                continue;
+            }
+
+            int precision = -1;
+            if(spec[0] == '.' && spec[1]) {
+                precision = std::atoi(spec + 1);
+            }
+
+            args[index].write(out, args[index].value, precision);
+            c += j + 1;
+        }
+
+        buffer[out.length] = '\0';
+        return out.length;
+    }
+
     std::string _format(std::string str, int) {
         return str;
     }
@@ -0,0 +1,682 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <iterator>
+
+#include "json_reader.h"
+#include "../logging.h"
+
+namespace smlt {
+
+namespace {
+
+/* Deeper than this and something is probably wrong with the file */
+const std::size_t MAX_JSON_DEPTH = 512;
+
+class JSONSAXParser {
+public:
+    JSONSAXParser(const char* data, std::size_t size, JSONReaderHandler* handler):
+        begin_(data),
+        p_(data),
+        end_(data + size),
+        handler_(handler) {}
+
+    bool run(JSONReadError* error);
+
+private:
+    enum State {
+        STATE_VALUE,
+        STATE_ARRAY_VALUE_OR_END,
+        STATE_OBJECT_KEY_OR_END,
+        STATE_OBJECT_KEY,
+        STATE_COLON,
+        STATE_COMMA_OR_END,
+        STATE_DONE
+    };
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    JSONReaderHandler* handler_;
+
+    std::vector<char> stack_;
+    std::string scratch_;
+    std::string error_;
+
+    void skip_whitespace() {
+        while(p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    bool fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+
+    State after_value() const {
+        return (stack_.empty()) ? STATE_DONE : STATE_COMMA_OR_END;
+    }
+
+    bool read_string(std::string_view* out);
+    bool read_number(double* value, bool* is_float);
+    bool read_literal(const char* literal);
+    bool read_value(State* state);
+};
+
+static int hex_value(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void append_utf8(std::string& out, uint32_t cp) {
+    if(cp < 0x80) {
+        out += char(cp);
+    } else if(cp < 0x800) {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    } else if(cp < 0x10000) {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    } else {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+bool JSONSAXParser::read_string(std::string_view* out) {
+    /* p_ is just past the opening quote. The common case is a string
+     * without escapes, which we can hand out in place */
+    const char* start = p_;
+    while(p_ < end_ && *p_ != '"' && *p_ != '\\') {
+        ++p_;
+    }
+
+    if(p_ >= end_) {
+        return fail("Unterminated string");
+    }
+
+    if(*p_ == '"') {
+        *out = std::string_view(start, p_ - start);
+        ++p_;
+        return true;
+    }
+
+    scratch_.assign(start, p_);
+
+    auto read_hex4 = [this](uint32_t* cp) -> bool {
+        if(end_ - p_ < 4) {
+            return false;
+        }
+
+        uint32_t v = 0;
+        for(int i = 0; i < 4; ++i) {
+            int h = hex_value(p_[i]);
+            if(h < 0) {
+                return false;
+            }
+            v = (v << 4) | uint32_t(h);
+        }
+
+        p_ += 4;
+        *cp = v;
+        return true;
+    };
+
+    while(p_ < end_) {
+        char c = *p_++;
+        if(c == '"') {
+            *out = std::string_view(scratch_);
+            return true;
+        } else if(c != '\\') {
+            scratch_ += c;
+            continue;
+        }
+
+        if(p_ >= end_) {
+            break;
+        }
+
+        c = *p_++;
+        switch(c) {
+            case '"': scratch_ += '"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/': scratch_ += '/'; break;
+            case 'b': scratch_ += '\b'; break;
+            case 'f': scratch_ += '\f'; break;
+            case 'n': scratch_ += '\n'; break;
+            case 'r': scratch_ += '\r'; break;
+            case 't': scratch_ += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if(!read_hex4(&cp)) {
+                    return fail("Invalid unicode escape");
+                }
+
+                /* Surrogate pair */
+                if(cp >= 0xD800 && cp <= 0xDBFF && end_ - p_ >= 6 &&
+                   p_[0] == '\\' && p_[1] == 'u') {
+                    p_ += 2;
+                    uint32_t low;
+                    if(!read_hex4(&low) || low < 0xDC00 || low > 0xDFFF) {
+                        return fail("Invalid unicode surrogate pair");
+                    }
+
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+
+                append_utf8(scratch_, cp);
+            } break;
+            default:
+                return fail("Invalid escape sequence");
+        }
+    }
+
+    return fail("Unterminated string");
+}
+
+bool JSONSAXParser::read_number(double* value, bool* is_float) {
+    const char* start = p_;
+    bool fraction = false;
+
+    while(p_ < end_) {
+        char c = *p_;
+        if((c >= '0' && c <= '9') || c == '-' || c == '+') {
+            ++p_;
+        } else if(c == '.' || c == 'e' || c == 'E') {
+            fraction = true;
+            ++p_;
+        } else {
+            break;
+        }
+    }
+
+    /* The buffer isn't necessarily null terminated */
+    char buffer[64];
+    std::size_t length = p_ - start;
+    if(length == 0 || length >= sizeof(buffer)) {
+        return fail("Invalid number");
+    }
+
+    std::memcpy(buffer, start, length);
+    buffer[length] = '\0';
+
+    char* parsed_end = nullptr;
+    *value = std::strtod(buffer, &parsed_end);
+    if(parsed_end != buffer + length) {
+        return fail("Invalid number");
+    }
+
+    *is_float = fraction;
+    return true;
+}
+
+bool JSONSAXParser::read_literal(const char* literal) {
+    std::size_t length = std::strlen(literal);
+    if(std::size_t(end_ - p_) < length || std::strncmp(p_, literal, length) != 0) {
+        return fail("Invalid literal");
+    }
+
+    p_ += length;
+    return true;
+}
+
+bool JSONSAXParser::read_value(State* state) {
+    char c = *p_;
+
+    switch(c) {
+        case '{':
+            ++p_;
+            if(stack_.size() == MAX_JSON_DEPTH) {
+                return fail("JSON is nested too deeply");
+            }
+            stack_.push_back('{');
+            *state = STATE_OBJECT_KEY_OR_END;
+            return handler_->on_object_start();
+        case '[':
+            ++p_;
+            if(stack_.size() == MAX_JSON_DEPTH) {
+                return fail("JSON is nested too deeply");
+            }
+            stack_.push_back('[');
+            *state = STATE_ARRAY_VALUE_OR_END;
+            return handler_->on_array_start();
+        case '"': {
+            ++p_;
+            std::string_view str;
+            if(!read_string(&str)) {
+                return false;
+            }
+            *state = after_value();
+            return handler_->on_string(str);
+        }
+        case 't':
+            *state = after_value();
+            return read_literal("true") && handler_->on_bool(true);
+        case 'f':
+            *state = after_value();
+            return read_literal("false") && handler_->on_bool(false);
+        case 'n':
+            *state = after_value();
+            return read_literal("null") && handler_->on_null();
+        default: {
+            if(c != '-' && (c < '0' || c > '9')) {
+                return fail("Unexpected character");
+            }
+
+            double value;
+            bool is_float;
+            if(!read_number(&value, &is_float)) {
+                return false;
+            }
+            *state = after_value();
+            return handler_->on_number(value, is_float);
+        }
+    }
+}
+
+bool JSONSAXParser::run(JSONReadError* error) {
+    State state = STATE_VALUE;
+    bool ok = true;
+
+    while(ok && state != STATE_DONE) {
+        skip_whitespace();
+
+        if(p_ >= end_) {
+            ok = fail("Unexpected end of data");
+            break;
+        }
+
+        char c = *p_;
+
+        switch(state) {
+            case STATE_ARRAY_VALUE_OR_END:
+                if(c == ']') {
+                    ++p_;
+                    stack_.pop_back();
+                    state = after_value();
+                    ok = handler_->on_array_end();
+                    break;
+                }
+                ok = read_value(&state);
+                break;
+            case STATE_VALUE:
+                ok = read_value(&state);
+                break;
+            case STATE_OBJECT_KEY_OR_END:
+                if(c == '}') {
+                    ++p_;
+                    stack_.pop_back();
+                    state = after_value();
+                    ok = handler_->on_object_end();
+                    break;
+                }
+                /* Fall through */
+            case STATE_OBJECT_KEY: {
+                if(c != '"') {
+                    ok = fail("Expected a key");
+                    break;
+                }
+
+                ++p_;
+                std::string_view key;
+                ok = read_string(&key) && handler_->on_key(key);
+                state = STATE_COLON;
+            } break;
+            case STATE_COLON:
+                if(c != ':') {
+                    ok = fail("Expected ':'");
+                    break;
+                }
+                ++p_;
+                state = STATE_VALUE;
+                break;
+            case STATE_COMMA_OR_END: {
+                char open = stack_.back();
+                if(c == ',') {
+                    ++p_;
+                    state = (open == '{') ? STATE_OBJECT_KEY : STATE_VALUE;
+                } else if(open == '{' && c == '}') {
+                    ++p_;
+                    stack_.pop_back();
+                    state = after_value();
+                    ok = handler_->on_object_end();
+                } else if(open == '[' && c == ']') {
+                    ++p_;
+                    stack_.pop_back();
+                    state = after_value();
+                    ok = handler_->on_array_end();
+                } else {
+                    ok = fail("Expected ',' or the end of a container");
+                }
+            } break;
+            default:
+                break;
+        }
+    }
+
+    if(!ok && error) {
+        error->message = (error_.empty()) ? "Stopped by handler" : error_;
+        error->offset = p_ - begin_;
+    }
+
+    return ok;
+}
+
+}
+
+bool json_sax_parse(const char* data, std::size_t size,
+                    JSONReaderHandler* handler, JSONReadError* error) {
+    JSONSAXParser parser(data, size, handler);
+    return parser.run(error);
+}
+
+/* Builds the nodes of a JSONDocument from reader events. The children of
+ * each container are gathered on a stack and copied to a contiguous range
+ * when it closes, so indexing an array is O(1) */
+class JSONDocumentBuilder : public JSONReaderHandler {
+public:
+    JSONDocumentBuilder(JSONDocument* document):
+        document_(document) {}
+
+    bool on_object_start() override {
+        open(JSON_OBJECT);
+        return true;
+    }
+
+    bool on_object_end() override {
+        close();
+        return true;
+    }
+
+    bool on_array_start() override {
+        open(JSON_ARRAY);
+        return true;
+    }
+
+    bool on_array_end() override {
+        close();
+        return true;
+    }
+
+    bool on_key(std::string_view key) override {
+        key_ = stable(key);
+        return true;
+    }
+
+    bool on_string(std::string_view value) override {
+        add(JSON_STRING).str = stable(value);
+        return true;
+    }
+
+    bool on_number(double value, bool is_float) override {
+        auto& node = add(JSON_NUMBER);
+        node.number = value;
+        node.is_float = is_float;
+        return true;
+    }
+
+    bool on_bool(bool value) override {
+        add((value) ? JSON_TRUE : JSON_FALSE);
+        return true;
+    }
+
+    bool on_null() override {
+        add(JSON_NULL);
+        return true;
+    }
+
+private:
+    JSONDocument* document_;
+
+    std::string_view key_;
+
+    /* Node index, and where its children start in pending_ */
+    std::vector<std::pair<uint32_t, std::size_t>> open_;
+    std::vector<uint32_t> pending_;
+
+    std::string_view stable(std::string_view str) {
+        /* Views into the source can be kept as they are, anything else was
+         * unescaped into the reader's scratch space */
+        const char* begin = document_->source_.data();
+        const char* end = begin + document_->source_.size();
+        if(str.empty() || (str.data() >= begin && str.data() + str.size() <= end)) {
+            return str;
+        }
+
+        document_->unescaped_.push_back(std::string(str));
+        return std::string_view(document_->unescaped_.back());
+    }
+
+    JSONDocument::Node& add(JSONNodeType type) {
+        uint32_t index = document_->nodes_.size();
+        document_->nodes_.push_back(JSONDocument::Node());
+
+        auto& node = document_->nodes_.back();
+        node.type = type;
+
+        if(!open_.empty()) {
+            if(document_->nodes_[open_.back().first].type == JSON_OBJECT) {
+                node.key = key_;
+            }
+
+            pending_.push_back(index);
+        }
+
+        return node;
+    }
+
+    void open(JSONNodeType type) {
+        add(type);
+        open_.push_back(
+            std::make_pair(uint32_t(document_->nodes_.size() - 1), pending_.size())
+        );
+    }
+
+    void close() {
+        auto top = open_.back();
+        open_.pop_back();
+
+        auto& node = document_->nodes_[top.first];
+        node.first_child = document_->children_.size();
+        node.child_count = pending_.size() - top.second;
+
+        document_->children_.insert(
+            document_->children_.end(), pending_.begin() + top.second, pending_.end()
+        );
+
+        pending_.resize(top.second);
+    }
+};
+
+bool JSONDocument::build() {
+    /* A rough guess to avoid most of the reallocations */
+    nodes_.reserve(source_.size() / 16);
+    children_.reserve(source_.size() / 16);
+
+    JSONDocumentBuilder builder(this);
+    if(!json_sax_parse(source_.data(), source_.size(), &builder, &error_)) {
+        S_ERROR("Error parsing JSON at offset {0}: {1}", error_.offset, error_.message);
+        nodes_.clear();
+        children_.clear();
+        unescaped_.clear();
+        return false;
+    }
+
+    nodes_.shrink_to_fit();
+    children_.shrink_to_fit();
+    return true;
+}
+
+JSONDocument::ptr JSONDocument::parse(std::string data) {
+    auto document = std::make_shared<JSONDocument>();
+    document->source_ = std::move(data);
+    document->build();
+    return document;
+}
+
+JSONDocument::ptr JSONDocument::read(std::istream& stream) {
+    std::string content{
+        std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()
+    };
+
+    return parse(std::move(content));
+}
+
+JSONDocument::ptr JSONDocument::load(const Path& path) {
+    std::ifstream stream(path.str(), std::ios::binary);
+    if(!stream) {
+        S_ERROR("Unable to open JSON file: {0}", path);
+        return std::make_shared<JSONDocument>();
+    }
+
+    return read(stream);
+}
+
+JSONValue JSONDocument::root() const {
+    if(nodes_.empty()) {
+        return JSONValue();
+    }
+
+    return JSONValue(this, 0);
+}
+
+bool JSONValue::is_valid() const {
+    return document_ && index_ < document_->nodes_.size();
+}
+
+JSONNodeType JSONValue::type() const {
+    return (is_valid()) ? document_->nodes_[index_].type : JSON_NULL;
+}
+
+bool JSONValue::is_float() const {
+    return is_number() && document_->nodes_[index_].is_float;
+}
+
+std::size_t JSONValue::size() const {
+    if(!is_object() && !is_array()) {
+        return 0;
+    }
+
+    return document_->nodes_[index_].child_count;
+}
+
+std::string_view JSONValue::key() const {
+    return (is_valid()) ? document_->nodes_[index_].key : std::string_view();
+}
+
+JSONValue JSONValue::operator[](std::string_view key) const {
+    if(!is_object()) {
+        return JSONValue();
+    }
+
+    auto& node = document_->nodes_[index_];
+    const uint32_t* children = document_->children_.data() + node.first_child;
+    for(uint32_t i = 0; i < node.child_count; ++i) {
+        if(document_->nodes_[children[i]].key == key) {
+            return JSONValue(document_, children[i]);
+        }
+    }
+
+    return JSONValue();
+}
+
+JSONValue JSONValue::operator[](std::size_t i) const {
+    if(!is_array() || i >= size()) {
+        return JSONValue();
+    }
+
+    auto& node = document_->nodes_[index_];
+    return JSONValue(document_, document_->children_[node.first_child + i]);
+}
+
+bool JSONValue::has_key(std::string_view key) const {
+    return (*this)[key].is_valid();
+}
+
+std::vector<std::string_view> JSONValue::keys() const {
+    std::vector<std::string_view> ret;
+    if(is_object()) {
+        for(auto child: *this) {
+            ret.push_back(child.key());
+        }
+    }
+
+    return ret;
+}
+
+optional<std::string> JSONValue::to_str() const {
+    if(!is_str()) {
+        return no_value;
+    }
+
+    return std::string(document_->nodes_[index_].str);
+}
+
+std::string_view JSONValue::str_view() const {
+    return (is_str()) ? document_->nodes_[index_].str : std::string_view();
+}
+
+optional<int64_t> JSONValue::to_int() const {
+    if(!is_number()) {
+        return optional<int64_t>();
+    }
+
+    return int64_t(document_->nodes_[index_].number);
+}
+
+optional<float> JSONValue::to_float() const {
+    if(!is_number()) {
+        return optional<float>();
+    }
+
+    return float(document_->nodes_[index_].number);
+}
+
+optional<double> JSONValue::to_double() const {
+    if(!is_number()) {
+        return optional<double>();
+    }
+
+    return document_->nodes_[index_].number;
+}
+
+optional<bool> JSONValue::to_bool() const {
+    switch(type()) {
+        case JSON_TRUE:
+            return optional<bool>(true);
+        case JSON_FALSE:
+        case JSON_NULL:
+            return (is_valid()) ? optional<bool>(false) : optional<bool>();
+        default:
+            return optional<bool>();
+    }
+}
+
+JSONValue::const_iterator JSONValue::begin() const {
+    if(size() == 0) {
+        return const_iterator();
+    }
+
+    auto& node = document_->nodes_[index_];
+    return const_iterator(document_, document_->children_.data() + node.first_child);
+}
+
+JSONValue::const_iterator JSONValue::end() const {
+    if(size() == 0) {
+        return const_iterator();
+    }
+
+    auto& node = document_->nodes_[index_];
+    return const_iterator(
+        document_, document_->children_.data() + node.first_child + node.child_count
+    );
+}
+
+}
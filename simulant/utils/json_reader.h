@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../generic/optional.h"
+#include "../path.h"
+#include "json.h"
+
+namespace smlt {
+
+/*
+ * A streaming (SAX style) JSON reader, and a document built on top of it.
+ *
+ * Unlike json_parse() this works over a contiguous buffer, doesn't build a
+ * tree of shared_ptrs and doesn't copy strings out of the source unless they
+ * contain escapes. Use it for large files, like glTF.
+ */
+
+class JSONReaderHandler {
+public:
+    virtual ~JSONReaderHandler() {}
+
+    /* Return false from any of these to stop reading. Strings are only
+     * valid for the duration of the call, they point into the source
+     * buffer unless they had to be unescaped. */
+    virtual bool on_object_start() = 0;
+    virtual bool on_object_end() = 0;
+    virtual bool on_array_start() = 0;
+    virtual bool on_array_end() = 0;
+    virtual bool on_key(std::string_view key) = 0;
+    virtual bool on_string(std::string_view value) = 0;
+    virtual bool on_number(double value, bool is_float) = 0;
+    virtual bool on_bool(bool value) = 0;
+    virtual bool on_null() = 0;
+};
+
+struct JSONReadError {
+    std::string message;
+    std::size_t offset = 0;
+};
+
+/* Reads a single JSON value from the buffer, anything after it is ignored.
+ * Returns false if the JSON was malformed or the handler stopped early. */
+bool json_sax_parse(const char* data, std::size_t size,
+                    JSONReaderHandler* handler, JSONReadError* error=nullptr);
+
+class JSONDocument;
+
+/* A lightweight handle to a value in a JSONDocument. Looking up a missing
+ * key or index returns an invalid value rather than throwing, so lookups
+ * can be chained. Only valid while the document is alive. */
+class JSONValue {
+public:
+    class const_iterator {
+    public:
+        typedef JSONValue value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const JSONValue* pointer;
+        typedef JSONValue reference;
+        typedef std::forward_iterator_tag iterator_category;
+
+        const_iterator() = default;
+
+        JSONValue operator*() const {
+            return JSONValue(document_, *index_);
+        }
+
+        const_iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        bool operator==(const const_iterator& rhs) const {
+            return index_ == rhs.index_;
+        }
+
+        bool operator!=(const const_iterator& rhs) const {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        friend class JSONValue;
+
+        const_iterator(const JSONDocument* document, const uint32_t* index):
+            document_(document), index_(index) {}
+
+        const JSONDocument* document_ = nullptr;
+        const uint32_t* index_ = nullptr;
+    };
+
+    JSONValue() = default;
+
+    bool is_valid() const;
+
+    explicit operator bool() const {
+        return is_valid();
+    }
+
+    /* Invalid values report JSON_NULL */
+    JSONNodeType type() const;
+
+    bool is_object() const { return type() == JSON_OBJECT; }
+    bool is_array() const { return type() == JSON_ARRAY; }
+    bool is_str() const { return type() == JSON_STRING; }
+    bool is_number() const { return type() == JSON_NUMBER; }
+    bool is_bool() const { return type() == JSON_TRUE || type() == JSON_FALSE; }
+    bool is_null() const { return type() == JSON_NULL; }
+
+    /* True if the number was written with a fraction or exponent */
+    bool is_float() const;
+
+    /* Number of items in an array, or members in an object */
+    std::size_t size() const;
+
+    bool has_key(std::string_view key) const;
+    std::vector<std::string_view> keys() const;
+
+    /* If this value is a member of an object, its key */
+    std::string_view key() const;
+
+    JSONValue operator[](std::string_view key) const;
+    JSONValue operator[](std::size_t i) const;
+
+    optional<std::string> to_str() const;
+    optional<int64_t> to_int() const;
+    optional<float> to_float() const;
+    optional<double> to_double() const;
+
+    /* As with JSONNode, null converts to false */
+    optional<bool> to_bool() const;
+
+    /* The string without copying it, empty if this isn't a string */
+    std::string_view str_view() const;
+
+    /* Iterates the items of an array, or the member values of an object */
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    friend class JSONDocument;
+
+    JSONValue(const JSONDocument* document, uint32_t index):
+        document_(document), index_(index) {}
+
+    const JSONDocument* document_ = nullptr;
+    uint32_t index_ = ~0u;
+};
+
+class JSONDocument {
+public:
+    typedef std::shared_ptr<JSONDocument> ptr;
+
+    JSONDocument() = default;
+    JSONDocument(const JSONDocument&) = delete;
+    JSONDocument& operator=(const JSONDocument&) = delete;
+
+    /* These return an empty (invalid) document on error, which is logged */
+    static JSONDocument::ptr parse(std::string data);
+    static JSONDocument::ptr read(std::istream& stream);
+    static JSONDocument::ptr load(const Path& path);
+
+    bool is_valid() const {
+        return !nodes_.empty();
+    }
+
+    const JSONReadError& error() const {
+        return error_;
+    }
+
+    JSONValue root() const;
+
+    std::size_t node_count() const {
+        return nodes_.size();
+    }
+
+private:
+    friend class JSONValue;
+    friend class JSONDocumentBuilder;
+
+    struct Node {
+        JSONNodeType type = JSON_NULL;
+        bool is_float = false;
+
+        /* Range in children_ for arrays and objects */
+        uint32_t first_child = 0;
+        uint32_t child_count = 0;
+
+        std::string_view key;
+        std::string_view str;
+        double number = 0.0;
+    };
+
+    bool build();
+
+    std::string source_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> children_;
+
+    /* Storage for strings which had escapes, so couldn't point into
+     * the source */
+    std::deque<std::string> unescaped_;
+
+    JSONReadError error_;
+};
+
+template<typename T>
+optional<T> json_auto_cast(JSONValue value);
+
+template<>
+inline optional<int> json_auto_cast<int>(JSONValue value) {
+    auto v = value.to_int();
+    return (v) ? optional<int>(int(v.value())) : optional<int>();
+}
+
+template<>
+inline optional<float> json_auto_cast<float>(JSONValue value) {
+    return value.to_float();
+}
+
+template<>
+inline optional<bool> json_auto_cast<bool>(JSONValue value) {
+    return value.to_bool();
+}
+
+template<>
+inline optional<std::string> json_auto_cast<std::string>(JSONValue value) {
+    return value.to_str();
+}
+
+}
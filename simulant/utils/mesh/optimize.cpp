@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include "../../vertex_data.h"
+#include "optimize.h"
+
+namespace smlt {
+namespace utils {
+
+namespace {
+
+/* A FIFO cache which is cheap to query: a vertex is cached if it was
+ * added within the last `size` insertions */
+class CacheSimulator {
+public:
+    CacheSimulator(uint32_t vertex_count, uint32_t size):
+        timestamps_(vertex_count, 0),
+        size_(size),
+        time_(size + 1) {}
+
+    /* Returns true on a miss */
+    bool access(uint32_t v) {
+        if(time_ - timestamps_[v] > size_) {
+            timestamps_[v] = time_++;
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    std::vector<uint32_t> timestamps_;
+    uint32_t size_;
+    uint32_t time_;
+};
+
+/* Triangles using each vertex, as offsets into one array */
+struct TriangleAdjacency {
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    TriangleAdjacency(const uint32_t* indices, std::size_t index_count, uint32_t vertex_count):
+        counts(vertex_count, 0),
+        offsets(vertex_count, 0),
+        triangles(index_count) {
+
+        for(std::size_t i = 0; i < index_count; ++i) {
+            counts[indices[i]]++;
+        }
+
+        uint32_t offset = 0;
+        for(uint32_t v = 0; v < vertex_count; ++v) {
+            offsets[v] = offset;
+            offset += counts[v];
+        }
+
+        std::vector<uint32_t> fill = offsets;
+        for(std::size_t i = 0; i < index_count; ++i) {
+            triangles[fill[indices[i]]++] = i / 3;
+        }
+    }
+};
+
+}
+
+float calculate_acmr(const uint32_t* indices, std::size_t index_count, uint32_t vertex_count, uint32_t cache_size) {
+    if(index_count < 3) {
+        return 0.0f;
+    }
+
+    CacheSimulator cache(vertex_count, cache_size);
+
+    std::size_t misses = 0;
+    for(std::size_t i = 0; i < index_count; ++i) {
+        misses += cache.access(indices[i]);
+    }
+
+    return float(misses) / float(index_count / 3);
+}
+
+void optimize_vertex_cache(uint32_t* indices, std::size_t index_count, uint32_t vertex_count, uint32_t cache_size) {
+    const std::size_t triangle_count = index_count / 3;
+    if(!triangle_count || !vertex_count) {
+        return;
+    }
+
+    TriangleAdjacency adjacency(indices, triangle_count * 3, vertex_count);
+
+    /* Triangles still to be emitted which use each vertex */
+    std::vector<uint32_t> live = adjacency.counts;
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+
+    std::vector<uint32_t> dead_ends;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(triangle_count * 3);
+
+    uint32_t time = cache_size + 1;
+    uint32_t cursor = 0;
+    int64_t fanning = 0;
+
+    while(fanning >= 0) {
+        const uint32_t f = uint32_t(fanning);
+        candidates.clear();
+
+        /* Emit every remaining triangle around the fanning vertex */
+        auto first = adjacency.triangles.begin() + adjacency.offsets[f];
+        auto last = first + adjacency.counts[f];
+        for(auto it = first; it != last; ++it) {
+            auto t = *it;
+            if(emitted[t]) {
+                continue;
+            }
+
+            for(int j = 0; j < 3; ++j) {
+                auto v = indices[t * 3 + j];
+                output.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+
+                if(time - timestamps[v] > cache_size) {
+                    timestamps[v] = time++;
+                }
+            }
+
+            emitted[t] = true;
+        }
+
+        /* Next, the candidate which will still be in the cache after its
+         * remaining triangles are emitted, and which entered it earliest */
+        fanning = -1;
+        int64_t best_priority = -1;
+        for(auto v: candidates) {
+            if(!live[v]) {
+                continue;
+            }
+
+            int64_t priority = 0;
+            if(time - timestamps[v] + 2 * live[v] <= cache_size) {
+                priority = time - timestamps[v];
+            }
+
+            if(priority > best_priority) {
+                best_priority = priority;
+                fanning = v;
+            }
+        }
+
+        if(fanning >= 0) {
+            continue;
+        }
+
+        /* Dead end, try recently used vertices, then anything left */
+        while(!dead_ends.empty()) {
+            auto v = dead_ends.back();
+            dead_ends.pop_back();
+
+            if(live[v]) {
+                fanning = v;
+                break;
+            }
+        }
+
+        while(fanning < 0 && cursor < vertex_count) {
+            if(live[cursor]) {
+                fanning = cursor;
+            }
+
+            ++cursor;
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimize_overdraw(uint32_t* indices, std::size_t index_count, const VertexData& vertex_data, uint32_t cache_size) {
+    const std::size_t triangle_count = index_count / 3;
+    if(triangle_count < 2) {
+        return;
+    }
+
+    /* A triangle which misses on all three vertices starts from a cold
+     * cache, so reordering clusters at those points costs (almost) nothing */
+    std::vector<std::size_t> cluster_starts;
+    CacheSimulator cache(vertex_data.count(), cache_size);
+
+    for(std::size_t t = 0; t < triangle_count; ++t) {
+        int misses = 0;
+        for(int j = 0; j < 3; ++j) {
+            misses += cache.access(indices[t * 3 + j]);
+        }
+
+        if(t == 0 || misses == 3) {
+            cluster_starts.push_back(t);
+        }
+    }
+
+    if(cluster_starts.size() < 2) {
+        return;
+    }
+
+    cluster_starts.push_back(triangle_count);
+
+    struct Cluster {
+        std::size_t start;
+        std::size_t end;
+        Vec3 centroid;
+        Vec3 normal;
+        float sort_key;
+    };
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(cluster_starts.size() - 1);
+
+    Vec3 mesh_centroid;
+    float mesh_area = 0.0f;
+
+    for(std::size_t i = 0; i + 1 < cluster_starts.size(); ++i) {
+        Cluster c;
+        c.start = cluster_starts[i];
+        c.end = cluster_starts[i + 1];
+        c.sort_key = 0.0f;
+
+        float area = 0.0f;
+        for(std::size_t t = c.start; t < c.end; ++t) {
+            auto a = vertex_data.position_nd_at(indices[t * 3]).xyz();
+            auto b = vertex_data.position_nd_at(indices[t * 3 + 1]).xyz();
+            auto d = vertex_data.position_nd_at(indices[t * 3 + 2]).xyz();
+
+            auto n = (b - a).cross(d - a);
+            float triangle_area = n.length() * 0.5f;
+
+            c.normal += n;
+            c.centroid += (a + b + d) * (triangle_area / 3.0f);
+            area += triangle_area;
+        }
+
+        if(area > 0.0f) {
+            mesh_centroid += c.centroid;
+            mesh_area += area;
+            c.centroid /= area;
+        }
+
+        if(c.normal.length_squared() > 0.0f) {
+            c.normal.normalize();
+        }
+
+        clusters.push_back(c);
+    }
+
+    if(mesh_area > 0.0f) {
+        mesh_centroid /= mesh_area;
+    }
+
+    for(auto& c: clusters) {
+        c.sort_key = (c.centroid - mesh_centroid).dot(c.normal);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) {
+        return lhs.sort_key > rhs.sort_key;
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(triangle_count * 3);
+
+    for(auto& c: clusters) {
+        output.insert(output.end(), indices + c.start * 3, indices + c.end * 3);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+std::vector<uint32_t> build_vertex_fetch_remap(const std::vector<std::vector<uint32_t>>& index_lists, uint32_t vertex_count, uint32_t* used_count) {
+    std::vector<uint32_t> remap(vertex_count, ~0u);
+
+    uint32_t next = 0;
+    for(auto& list: index_lists) {
+        for(auto i: list) {
+            if(i < vertex_count && remap[i] == ~0u) {
+                remap[i] = next++;
+            }
+        }
+    }
+
+    if(used_count) {
+        *used_count = next;
+    }
+
+    for(auto& r: remap) {
+        if(r == ~0u) {
+            r = next++;
+        }
+    }
+
+    return remap;
+}
+
+void remap_vertex_data(VertexData& vertex_data, const std::vector<uint32_t>& remap) {
+    const uint32_t count = vertex_data.count();
+    const uint32_t stride = vertex_data.stride();
+
+    assert(remap.size() == count);
+
+    if(!count) {
+        return;
+    }
+
+    uint8_t* data = vertex_data.data();
+    std::vector<uint8_t> source(data, data + std::size_t(count) * stride);
+
+    for(uint32_t i = 0; i < count; ++i) {
+        std::memcpy(data + std::size_t(remap[i]) * stride, &source[std::size_t(i) * stride], stride);
+    }
+}
+
+std::vector<uint32_t> build_weld_remap(const VertexData& vertex_data) {
+    const uint32_t count = vertex_data.count();
+    const uint32_t stride = vertex_data.stride();
+    const char* data = (const char*) vertex_data.data();
+
+    std::vector<uint32_t> remap(count);
+    std::unordered_map<std::string_view, uint32_t> first;
+    first.reserve(count);
+
+    for(uint32_t i = 0; i < count; ++i) {
+        std::string_view key(data + std::size_t(i) * stride, stride);
+        remap[i] = first.emplace(key, i).first->second;
+    }
+
+    return remap;
+}
+
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace smlt {
+
+class VertexData;
+
+namespace utils {
+
+/* Most GPUs we target have a post-transform cache at least this big, and
+ * a larger guess than the hardware has does more harm than a smaller one */
+const uint32_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+/*
+ * The average cache miss ratio of a triangle list: the number of vertices
+ * transformed per triangle with a FIFO post-transform cache of
+ * `cache_size` entries. 3.0 is the worst case, ~0.5 the best for a
+ * regular grid.
+ */
+float calculate_acmr(
+    const uint32_t* indices, std::size_t index_count, uint32_t vertex_count,
+    uint32_t cache_size=DEFAULT_VERTEX_CACHE_SIZE
+);
+
+/*
+ * Reorders the triangles in a triangle list so that vertices are reused
+ * while they're still in the post-transform cache (Tipsify, Sander et al.
+ * 2007). The winding of each triangle is left as it was.
+ */
+void optimize_vertex_cache(
+    uint32_t* indices, std::size_t index_count, uint32_t vertex_count,
+    uint32_t cache_size=DEFAULT_VERTEX_CACHE_SIZE
+);
+
+/*
+ * Splits a cache optimized triangle list into clusters where the cache
+ * starts cold anyway, then draws the clusters facing away from the centre
+ * of the mesh first, so they tend to occlude the rest. This barely changes
+ * the ACMR, so run it after optimize_vertex_cache().
+ */
+void optimize_overdraw(
+    uint32_t* indices, std::size_t index_count, const VertexData& vertex_data,
+    uint32_t cache_size=DEFAULT_VERTEX_CACHE_SIZE
+);
+
+/*
+ * Builds an old -> new vertex index table which puts vertices in the order
+ * they're first used by `index_lists`, so vertex fetches walk memory
+ * forwards. Unused vertices keep their relative order at the end, after
+ * the first `used_count`.
+ */
+std::vector<uint32_t> build_vertex_fetch_remap(
+    const std::vector<std::vector<uint32_t>>& index_lists, uint32_t vertex_count,
+    uint32_t* used_count=nullptr
+);
+
+/* Moves every vertex in `vertex_data` to its position in `remap`. As with
+ * any other change, call done() on the vertex data afterwards */
+void remap_vertex_data(VertexData& vertex_data, const std::vector<uint32_t>& remap);
+
+/* Maps each vertex to the first vertex with identical contents, so
+ * triangle soups can be indexed */
+std::vector<uint32_t> build_weld_remap(const VertexData& vertex_data);
+
+}
+}
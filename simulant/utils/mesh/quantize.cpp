@@ -0,0 +1,194 @@
+#include <cstring>
+
+#include "../../vertex_data.h"
+#include "../packed_types.h"
+#include "quantize.h"
+
+namespace smlt {
+namespace utils {
+
+namespace {
+
+typedef AttributeOffset (VertexSpecification::*OffsetMethod)(bool) const;
+
+struct AttributeEntry {
+    VertexAttributeType type;
+    OffsetMethod offset;
+};
+
+const AttributeEntry ATTRIBUTES[] = {
+    {VERTEX_ATTRIBUTE_TYPE_POSITION, &VertexSpecification::position_offset},
+    {VERTEX_ATTRIBUTE_TYPE_NORMAL, &VertexSpecification::normal_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD0, &VertexSpecification::texcoord0_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD1, &VertexSpecification::texcoord1_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD2, &VertexSpecification::texcoord2_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD3, &VertexSpecification::texcoord3_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD4, &VertexSpecification::texcoord4_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD5, &VertexSpecification::texcoord5_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD6, &VertexSpecification::texcoord6_offset},
+    {VERTEX_ATTRIBUTE_TYPE_TEXCOORD7, &VertexSpecification::texcoord7_offset},
+    {VERTEX_ATTRIBUTE_TYPE_COLOR, &VertexSpecification::color_offset},
+    {VERTEX_ATTRIBUTE_TYPE_SPECULAR, &VertexSpecification::specular_offset},
+    {VERTEX_ATTRIBUTE_TYPE_JOINTS, &VertexSpecification::joint_offset},
+    {VERTEX_ATTRIBUTE_TYPE_WEIGHTS, &VertexSpecification::weight_offset},
+};
+
+bool is_position_format(VertexAttribute attr) {
+    return attr == VERTEX_ATTRIBUTE_2F || attr == VERTEX_ATTRIBUTE_3F ||
+           attr == VERTEX_ATTRIBUTE_4F || attr == VERTEX_ATTRIBUTE_3S_NORMALIZED;
+}
+
+bool is_normal_format(VertexAttribute attr) {
+    return attr == VERTEX_ATTRIBUTE_3F || attr == VERTEX_ATTRIBUTE_PACKED_VEC4_1I ||
+           attr == VERTEX_ATTRIBUTE_2B_OCTAHEDRAL || attr == VERTEX_ATTRIBUTE_2S_OCTAHEDRAL;
+}
+
+bool is_texcoord_format(VertexAttribute attr) {
+    return attr == VERTEX_ATTRIBUTE_2F || attr == VERTEX_ATTRIBUTE_2H;
+}
+
+bool can_convert(VertexAttributeType type, VertexAttribute from, VertexAttribute to) {
+    if(from == to) {
+        return true;
+    }
+
+    switch(type) {
+    case VERTEX_ATTRIBUTE_TYPE_POSITION:
+        return is_position_format(from) && is_position_format(to);
+    case VERTEX_ATTRIBUTE_TYPE_NORMAL:
+        return is_normal_format(from) && is_normal_format(to);
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD0:
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD1:
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD2:
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD3:
+        return is_texcoord_format(from) && is_texcoord_format(to);
+    default:
+        return false;
+    }
+}
+
+Vec2 read_texcoord(const uint8_t* ptr, VertexAttribute attr) {
+    if(attr == VERTEX_ATTRIBUTE_2H) {
+        return *(const HalfVec2*) ptr;
+    }
+
+    return *(const Vec2*) ptr;
+}
+
+void write_texcoord(VertexData& data, VertexAttributeType type, const Vec2& uv) {
+    switch(type) {
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD0: data.tex_coord0(uv); break;
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD1: data.tex_coord1(uv); break;
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD2: data.tex_coord2(uv); break;
+    case VERTEX_ATTRIBUTE_TYPE_TEXCOORD3: data.tex_coord3(uv); break;
+    default:
+        assert(0 && "Not a converted texture coordinate");
+    }
+}
+
+}
+
+VertexSpecification quantized_vertex_specification(const VertexSpecification& spec, bool byte_normals) {
+    VertexSpecification ret = spec;
+
+    if(spec.position_attribute == VERTEX_ATTRIBUTE_3F) {
+        ret.position_attribute = VERTEX_ATTRIBUTE_3S_NORMALIZED;
+    }
+
+    if(spec.normal_attribute == VERTEX_ATTRIBUTE_3F) {
+        ret.normal_attribute = (byte_normals) ?
+            VERTEX_ATTRIBUTE_2B_OCTAHEDRAL : VERTEX_ATTRIBUTE_2S_OCTAHEDRAL;
+    }
+
+    if(spec.texcoord0_attribute == VERTEX_ATTRIBUTE_2F) ret.texcoord0_attribute = VERTEX_ATTRIBUTE_2H;
+    if(spec.texcoord1_attribute == VERTEX_ATTRIBUTE_2F) ret.texcoord1_attribute = VERTEX_ATTRIBUTE_2H;
+    if(spec.texcoord2_attribute == VERTEX_ATTRIBUTE_2F) ret.texcoord2_attribute = VERTEX_ATTRIBUTE_2H;
+    if(spec.texcoord3_attribute == VERTEX_ATTRIBUTE_2F) ret.texcoord3_attribute = VERTEX_ATTRIBUTE_2H;
+
+    return ret;
+}
+
+bool convert_vertex_data(VertexData& vertex_data, const VertexSpecification& target) {
+    const VertexSpecification source_spec = vertex_data.vertex_specification();
+
+    for(auto& entry: ATTRIBUTES) {
+        auto from = attribute_for_type(entry.type, source_spec);
+        auto to = attribute_for_type(entry.type, target);
+
+        if(!from && !to) {
+            continue;
+        }
+
+        if(!from || !to || !can_convert(entry.type, from, to)) {
+            S_ERROR("Unable to convert vertex attribute {0} from {1} to {2}", (int) entry.type, (int) from, (int) to);
+            return false;
+        }
+    }
+
+    if(source_spec == target) {
+        return true;
+    }
+
+    VertexData source(source_spec);
+    vertex_data.clone_into(source);
+
+    const uint32_t count = source.count();
+
+    vertex_data.reset(target);
+
+    if(target.position_attribute == VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+        AABB bounds(source);
+        vertex_data.set_position_range(bounds.min(), bounds.max());
+    }
+
+    vertex_data.resize(count);
+
+    const uint8_t* in = source.data();
+    uint8_t* out = vertex_data.data();
+    const uint32_t in_stride = source_spec.stride();
+    const uint32_t out_stride = target.stride();
+
+    for(uint32_t i = 0; i < count; ++i) {
+        vertex_data.move_to(i);
+
+        for(auto& entry: ATTRIBUTES) {
+            auto from = attribute_for_type(entry.type, source_spec);
+            auto to = attribute_for_type(entry.type, target);
+
+            if(!from) {
+                continue;
+            }
+
+            auto in_ptr = in + (i * in_stride) + (source_spec.*entry.offset)(false);
+
+            /* Quantized positions are refitted to the new range */
+            if(from == to && from != VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+                auto out_ptr = out + (i * out_stride) + (target.*entry.offset)(false);
+                std::memcpy(out_ptr, in_ptr, vertex_attribute_size(from));
+                continue;
+            }
+
+            if(entry.type == VERTEX_ATTRIBUTE_TYPE_POSITION) {
+                auto p = source.position_nd_at(i);
+                if(to == VERTEX_ATTRIBUTE_2F) {
+                    vertex_data.position(p.x, p.y);
+                } else if(to == VERTEX_ATTRIBUTE_4F) {
+                    vertex_data.position(p);
+                } else {
+                    vertex_data.position(p.x, p.y, p.z);
+                }
+            } else if(entry.type == VERTEX_ATTRIBUTE_TYPE_NORMAL) {
+                vertex_data.normal(*source.normal_at<Vec3>(i));
+            } else {
+                write_texcoord(vertex_data, entry.type, read_texcoord(in_ptr, from));
+            }
+        }
+    }
+
+    vertex_data.move_to_start();
+
+    return true;
+}
+
+}
+}
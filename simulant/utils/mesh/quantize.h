@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../types.h"
+
+namespace smlt {
+
+class VertexData;
+
+namespace utils {
+
+/*
+ * Returns `spec` with its float positions, normals and 2D texture
+ * coordinates swapped for the compact formats: 16-bit positions,
+ * octahedral normals (2 x 16 bits, or 2 x 8 bits if `byte_normals` is
+ * set) and half float texture coordinates. Everything else is kept.
+ *
+ * Colors, joints and weights aren't touched. Quantized positions can't be
+ * skinned, so this is meant for static geometry.
+ */
+VertexSpecification quantized_vertex_specification(
+    const VertexSpecification& spec, bool byte_normals=false
+);
+
+/*
+ * Rewrites `vertex_data` in the formats of `target`, keeping the vertex
+ * order. Quantized positions are fitted to the bounds of the data.
+ *
+ * Only positions, normals and the first four texture coordinates can
+ * change format. If anything else differs, this returns false and leaves
+ * the data alone. As with any other change, call done() on the vertex data
+ * afterwards.
+ */
+bool convert_vertex_data(VertexData& vertex_data, const VertexSpecification& target);
+
+}
+}
@@ -0,0 +1,613 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string_view>
+#include <unordered_map>
+
+#include "../../vertex_data.h"
+#include "simplify.h"
+
+namespace smlt {
+namespace utils {
+
+namespace {
+
+/* Boundary planes are weighted this much more heavily than faces, so open
+ * edges keep their shape */
+const double BORDER_WEIGHT = 10.0;
+
+/* Collapses which rotate a remaining triangle by more than ~75 degrees are
+ * rejected, which also catches flips */
+const double MIN_NORMAL_DOT = 0.25;
+
+const uint32_t NO_GROUP = ~0u;
+const uint32_t MULTIPLE_GROUPS = ~0u - 1;
+
+struct Point {
+    double x = 0, y = 0, z = 0;
+
+    Point() = default;
+    Point(double x, double y, double z):
+        x(x), y(y), z(z) {}
+
+    Point operator-(const Point& rhs) const {
+        return Point(x - rhs.x, y - rhs.y, z - rhs.z);
+    }
+
+    double dot(const Point& rhs) const {
+        return x * rhs.x + y * rhs.y + z * rhs.z;
+    }
+
+    Point cross(const Point& rhs) const {
+        return Point(
+            y * rhs.z - z * rhs.y,
+            z * rhs.x - x * rhs.z,
+            x * rhs.y - y * rhs.x
+        );
+    }
+
+    double length() const {
+        return std::sqrt(dot(*this));
+    }
+};
+
+/* The symmetric 4x4 matrix of the summed plane equations, plus the total
+ * weight so the error can be turned back into a distance */
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double w = 0;
+
+    void add_plane(const Point& n, double d, double weight) {
+        a2 += n.x * n.x * weight;
+        ab += n.x * n.y * weight;
+        ac += n.x * n.z * weight;
+        ad += n.x * d * weight;
+        b2 += n.y * n.y * weight;
+        bc += n.y * n.z * weight;
+        bd += n.y * d * weight;
+        c2 += n.z * n.z * weight;
+        cd += n.z * d * weight;
+        d2 += d * d * weight;
+        w += weight;
+    }
+
+    Quadric& operator+=(const Quadric& rhs) {
+        a2 += rhs.a2; ab += rhs.ab; ac += rhs.ac; ad += rhs.ad;
+        b2 += rhs.b2; bc += rhs.bc; bd += rhs.bd;
+        c2 += rhs.c2; cd += rhs.cd;
+        d2 += rhs.d2;
+        w += rhs.w;
+        return *this;
+    }
+
+    double error(const Point& p) const {
+        double e =
+            a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x +
+            b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y +
+            c2 * p.z * p.z + 2 * cd * p.z +
+            d2;
+
+        return (e > 0) ? e : 0;
+    }
+};
+
+/* Positions are matched on their exact float bits */
+struct PositionKey {
+    uint32_t bits[3];
+
+    bool operator==(const PositionKey& rhs) const {
+        return bits[0] == rhs.bits[0] && bits[1] == rhs.bits[1] && bits[2] == rhs.bits[2];
+    }
+};
+
+struct PositionKeyHash {
+    std::size_t operator()(const PositionKey& key) const {
+        return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+    }
+};
+
+struct Triangle {
+    uint32_t v[3];
+    uint32_t group;
+    bool alive;
+};
+
+struct Candidate {
+    float error;
+    uint32_t from;
+    uint32_t to;
+    uint32_t stamp;
+
+    bool operator>(const Candidate& rhs) const {
+        return error > rhs.error;
+    }
+};
+
+class Simplifier {
+public:
+    Simplifier(const VertexData& vertex_data, std::vector<std::vector<uint32_t>>& triangles):
+        vertex_data_(vertex_data),
+        groups_(triangles) {}
+
+    float run(std::size_t target_triangle_count, float max_error);
+
+private:
+    const VertexData& vertex_data_;
+    std::vector<std::vector<uint32_t>>& groups_;
+
+    std::vector<Point> positions_;
+
+    /* Vertices with the same position share a representative, which
+     * holds the quadric, the border flag and the triangle list for all
+     * of them */
+    std::vector<uint32_t> rep_;
+    std::vector<Quadric> quadrics_;
+    std::vector<bool> border_;
+    std::vector<bool> locked_;
+    std::vector<bool> dead_;
+    std::vector<uint32_t> stamps_;
+
+    std::vector<Triangle> triangles_;
+    std::vector<std::vector<uint32_t>> vertex_triangles_;
+    std::size_t live_triangles_ = 0;
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap_;
+
+    void build();
+    void compute_quadrics();
+
+    bool has_rep(const Triangle& t, uint32_t rep) const {
+        return rep_[t.v[0]] == rep || rep_[t.v[1]] == rep || rep_[t.v[2]] == rep;
+    }
+
+    void neighbours(uint32_t v, std::vector<uint32_t>& out);
+    void link(uint32_t rep, uint32_t other, std::vector<uint32_t>& out);
+    bool is_valid_collapse(uint32_t v, uint32_t u);
+    bool find_candidate(uint32_t v, bool validate, Candidate* out);
+    void push_candidate(uint32_t v, bool validate);
+    void collapse(uint32_t v, uint32_t u);
+
+    std::vector<uint32_t> around_, affected_, link_v_, link_u_, common_;
+    std::vector<std::pair<float, uint32_t>> options_;
+};
+
+void Simplifier::build() {
+    const uint32_t count = vertex_data_.count();
+    const uint32_t stride = vertex_data_.stride();
+    const uint8_t* data = vertex_data_.data();
+
+    /* Soups (like OBJ files) repeat identical vertices for every face, so
+     * weld those first, otherwise everything looks like a seam */
+    std::vector<uint32_t> canonical(count, ~0u);
+    std::unordered_map<std::string_view, uint32_t> by_contents;
+
+    positions_.resize(count);
+    rep_.assign(count, ~0u);
+
+    std::vector<uint32_t> rep_size(count, 0);
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> by_position;
+
+    by_contents.reserve(count);
+    by_position.reserve(count);
+
+    for(auto& group: groups_) {
+        for(auto& i: group) {
+            if(i >= count) {
+                continue;
+            }
+
+            if(canonical[i] == ~0u) {
+                std::string_view key((const char*) data + (i * stride), stride);
+                auto it = by_contents.emplace(key, i);
+                canonical[i] = it.first->second;
+            }
+
+            uint32_t c = canonical[i];
+            if(rep_[c] == ~0u) {
+                auto p = vertex_data_.position_nd_at(c);
+                positions_[c] = Point(p.x, p.y, p.z);
+
+                PositionKey key;
+                float xyz[3] = {p.x, p.y, p.z};
+                std::memcpy(key.bits, xyz, sizeof(xyz));
+
+                auto it = by_position.emplace(key, c);
+                rep_[c] = it.first->second;
+                rep_size[rep_[c]]++;
+            }
+        }
+    }
+
+    locked_.assign(count, false);
+    dead_.assign(count, false);
+    stamps_.assign(count, 0);
+    vertex_triangles_.resize(count);
+
+    std::vector<uint32_t> owner(count, NO_GROUP);
+
+    for(uint32_t g = 0; g < groups_.size(); ++g) {
+        auto& group = groups_[g];
+        for(std::size_t i = 0; i + 2 < group.size(); i += 3) {
+            if(group[i] >= count || group[i + 1] >= count || group[i + 2] >= count) {
+                continue;
+            }
+
+            Triangle t;
+            t.v[0] = canonical[group[i]];
+            t.v[1] = canonical[group[i + 1]];
+            t.v[2] = canonical[group[i + 2]];
+            t.group = g;
+            t.alive = true;
+
+            /* Triangles which are already degenerate aren't visible, so
+             * drop them rather than letting them pin vertices */
+            auto r0 = rep_[t.v[0]], r1 = rep_[t.v[1]], r2 = rep_[t.v[2]];
+            if(r0 == r1 || r1 == r2 || r0 == r2) {
+                continue;
+            }
+
+            uint32_t index = triangles_.size();
+            triangles_.push_back(t);
+
+            for(auto v: t.v) {
+                vertex_triangles_[rep_[v]].push_back(index);
+                owner[v] = (owner[v] == NO_GROUP || owner[v] == g) ? g : MULTIPLE_GROUPS;
+            }
+        }
+    }
+
+    live_triangles_ = triangles_.size();
+
+    for(uint32_t v = 0; v < count; ++v) {
+        if(rep_[v] == ~0u) {
+            continue;
+        }
+
+        /* Several different vertices at this position means a seam, and
+         * vertices shared between groups are on a material boundary.
+         * Neither can move without tearing the other side */
+        locked_[v] = rep_size[rep_[v]] > 1 || owner[v] == MULTIPLE_GROUPS;
+    }
+}
+
+void Simplifier::compute_quadrics() {
+    const uint32_t count = vertex_data_.count();
+
+    quadrics_.assign(count, Quadric());
+    border_.assign(count, false);
+
+    std::unordered_map<uint64_t, uint32_t> edge_counts;
+    edge_counts.reserve(triangles_.size() * 2);
+
+    auto edge_key = [](uint32_t a, uint32_t b) -> uint64_t {
+        return (a < b) ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    };
+
+    for(auto& t: triangles_) {
+        for(int i = 0; i < 3; ++i) {
+            edge_counts[edge_key(rep_[t.v[i]], rep_[t.v[(i + 1) % 3]])]++;
+        }
+    }
+
+    for(auto& t: triangles_) {
+        auto& p0 = positions_[t.v[0]];
+        auto& p1 = positions_[t.v[1]];
+        auto& p2 = positions_[t.v[2]];
+
+        Point n = (p1 - p0).cross(p2 - p0);
+        double length = n.length();
+        if(length == 0.0) {
+            continue;
+        }
+
+        n = Point(n.x / length, n.y / length, n.z / length);
+
+        Quadric q;
+        q.add_plane(n, -n.dot(p0), length * 0.5);
+
+        for(auto v: t.v) {
+            quadrics_[rep_[v]] += q;
+        }
+
+        for(int i = 0; i < 3; ++i) {
+            uint32_t a = rep_[t.v[i]];
+            uint32_t b = rep_[t.v[(i + 1) % 3]];
+
+            if(edge_counts[edge_key(a, b)] != 1) {
+                continue;
+            }
+
+            border_[a] = border_[b] = true;
+
+            /* A plane through the edge, perpendicular to the face, stops
+             * the border being pulled inwards */
+            Point edge = positions_[b] - positions_[a];
+            double edge_length = edge.length();
+            Point bn = edge.cross(n);
+            double bn_length = bn.length();
+            if(bn_length == 0.0) {
+                continue;
+            }
+
+            bn = Point(bn.x / bn_length, bn.y / bn_length, bn.z / bn_length);
+
+            Quadric bq;
+            bq.add_plane(bn, -bn.dot(positions_[a]), edge_length * edge_length * BORDER_WEIGHT);
+            quadrics_[a] += bq;
+            quadrics_[b] += bq;
+        }
+    }
+}
+
+void Simplifier::neighbours(uint32_t v, std::vector<uint32_t>& out) {
+    out.clear();
+
+    const uint32_t rv = rep_[v];
+    auto& tris = vertex_triangles_[rv];
+
+    /* Drop dead triangles while we're here so the lists don't grow
+     * without bound */
+    tris.erase(
+        std::remove_if(tris.begin(), tris.end(), [this](uint32_t t) {
+            return !triangles_[t].alive;
+        }),
+        tris.end()
+    );
+
+    for(auto t: tris) {
+        for(auto w: triangles_[t].v) {
+            if(rep_[w] != rv) {
+                out.push_back(w);
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void Simplifier::link(uint32_t rep, uint32_t other, std::vector<uint32_t>& out) {
+    out.clear();
+    for(auto t: vertex_triangles_[rep]) {
+        if(!triangles_[t].alive) {
+            continue;
+        }
+
+        for(auto w: triangles_[t].v) {
+            auto r = rep_[w];
+            if(r != rep && r != other) {
+                out.push_back(r);
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+bool Simplifier::is_valid_collapse(uint32_t v, uint32_t u) {
+    const uint32_t ru = rep_[u];
+    const uint32_t rv = rep_[v];
+
+    uint32_t shared = 0;
+    for(auto t: vertex_triangles_[rv]) {
+        if(triangles_[t].alive && has_rep(triangles_[t], ru)) {
+            ++shared;
+        }
+    }
+
+    if(!shared) {
+        return false;
+    }
+
+    if(border_[rv] && shared != 1) {
+        /* Border vertices may only slide along the border */
+        return false;
+    }
+
+    /* Link condition: the only positions adjacent to both ends of the edge
+     * must be the ones opposite it, otherwise the collapse would pinch
+     * the surface */
+    link(rv, ru, link_v_);
+    link(ru, rv, link_u_);
+
+    common_.clear();
+    std::set_intersection(
+        link_v_.begin(), link_v_.end(),
+        link_u_.begin(), link_u_.end(),
+        std::back_inserter(common_)
+    );
+
+    if(common_.size() != shared) {
+        return false;
+    }
+
+    /* Moving v onto u mustn't flip or crush the triangles which survive */
+    const Point& target = positions_[u];
+
+    for(auto t: vertex_triangles_[rv]) {
+        auto& tri = triangles_[t];
+        if(!tri.alive || has_rep(tri, ru)) {
+            continue;
+        }
+
+        Point p[3], q[3];
+        for(int i = 0; i < 3; ++i) {
+            p[i] = positions_[tri.v[i]];
+            q[i] = (tri.v[i] == v) ? target : p[i];
+        }
+
+        Point n0 = (p[1] - p[0]).cross(p[2] - p[0]);
+        Point n1 = (q[1] - q[0]).cross(q[2] - q[0]);
+
+        double l0 = n0.length();
+        double l1 = n1.length();
+
+        if(l1 <= l0 * 1e-6) {
+            return false;
+        }
+
+        if(n0.dot(n1) < MIN_NORMAL_DOT * l0 * l1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Simplifier::find_candidate(uint32_t v, bool validate, Candidate* out) {
+    if(locked_[v] || dead_[v]) {
+        return false;
+    }
+
+    neighbours(v, around_);
+
+    const Quadric& qv = quadrics_[rep_[v]];
+
+    options_.clear();
+    for(auto u: around_) {
+        Quadric q = qv;
+        q += quadrics_[rep_[u]];
+
+        double e = q.error(positions_[u]);
+        float error = (q.w > 0) ? float(std::sqrt(e / q.w)) : 0.0f;
+        options_.push_back(std::make_pair(error, u));
+    }
+
+    /* Validating is the expensive part, so only do it until the cheapest
+     * valid collapse turns up, or not at all and leave it to run() */
+    std::sort(options_.begin(), options_.end());
+
+    for(auto& option: options_) {
+        if(!validate || is_valid_collapse(v, option.second)) {
+            out->error = option.first;
+            out->from = v;
+            out->to = option.second;
+            out->stamp = stamps_[v];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Simplifier::push_candidate(uint32_t v, bool validate) {
+    ++stamps_[v];
+
+    Candidate c;
+    if(find_candidate(v, validate, &c)) {
+        heap_.push(c);
+    }
+}
+
+void Simplifier::collapse(uint32_t v, uint32_t u) {
+    /* v isn't locked, so it's the only vertex at its position */
+    const uint32_t ru = rep_[u];
+
+    for(auto t: vertex_triangles_[v]) {
+        auto& tri = triangles_[t];
+        if(!tri.alive) {
+            continue;
+        }
+
+        if(has_rep(tri, ru)) {
+            tri.alive = false;
+            --live_triangles_;
+            continue;
+        }
+
+        for(auto& w: tri.v) {
+            if(w == v) {
+                w = u;
+            }
+        }
+
+        vertex_triangles_[ru].push_back(t);
+    }
+
+    vertex_triangles_[v].clear();
+    dead_[v] = true;
+
+    quadrics_[ru] += quadrics_[rep_[v]];
+
+    neighbours(u, affected_);
+
+    push_candidate(u, false);
+    for(auto w: affected_) {
+        push_candidate(w, false);
+    }
+}
+
+float Simplifier::run(std::size_t target_triangle_count, float max_error) {
+    build();
+    compute_quadrics();
+
+    for(uint32_t v = 0; v < rep_.size(); ++v) {
+        if(rep_[v] != ~0u && !vertex_triangles_[rep_[v]].empty()) {
+            push_candidate(v, false);
+        }
+    }
+
+    float result = 0.0f;
+
+    while(live_triangles_ > target_triangle_count && !heap_.empty()) {
+        Candidate c = heap_.top();
+        heap_.pop();
+
+        if(dead_[c.from] || c.stamp != stamps_[c.from]) {
+            continue;
+        }
+
+        if(c.error > max_error) {
+            /* Everything left in the heap costs at least this much */
+            break;
+        }
+
+        /* Candidates are queued on cost alone, anything that changes the
+         * cost requeues them. If this one turns out to be invalid, fall
+         * back to the cheapest valid one */
+        if(dead_[c.to] || !is_valid_collapse(c.from, c.to)) {
+            push_candidate(c.from, true);
+            continue;
+        }
+
+        collapse(c.from, c.to);
+        result = std::max(result, c.error);
+    }
+
+    for(auto& group: groups_) {
+        group.clear();
+    }
+
+    for(auto& t: triangles_) {
+        if(t.alive) {
+            groups_[t.group].insert(groups_[t.group].end(), t.v, t.v + 3);
+        }
+    }
+
+    return result;
+}
+
+}
+
+float simplify_triangles(
+    const VertexData& vertex_data,
+    std::vector<std::vector<uint32_t>>& triangles,
+    std::size_t target_triangle_count,
+    float max_error) {
+
+    if(!vertex_data.count()) {
+        return 0.0f;
+    }
+
+    Simplifier simplifier(vertex_data, triangles);
+    return simplifier.run(target_triangle_count, max_error);
+}
+
+}
+}
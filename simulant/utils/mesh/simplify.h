@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace smlt {
+
+class VertexData;
+
+namespace utils {
+
+/*
+ * Simplifies triangle lists by repeatedly collapsing the edge which adds the
+ * least quadric error (Garland & Heckbert), until `target_triangle_count`
+ * triangles remain or the next collapse would add more than `max_error`.
+ *
+ * `triangles` holds one triangle list per group (e.g. per submesh), all
+ * indexing `vertex_data`. The groups are simplified together, so they stay
+ * joined, and each list is rewritten in place.
+ *
+ * Only the indices change. Collapses always move a vertex onto one of its
+ * neighbours, so the result can share the original vertex data. Vertices on
+ * UV/normal seams, or shared between groups, are never removed, so seams and
+ * material boundaries are kept exactly, and open borders only collapse along
+ * themselves.
+ *
+ * Returns the largest error introduced, as a distance in model space.
+ */
+float simplify_triangles(
+    const VertexData& vertex_data,
+    std::vector<std::vector<uint32_t>>& triangles,
+    std::size_t target_triangle_count,
+    float max_error=std::numeric_limits<float>::max()
+);
+
+}
+}
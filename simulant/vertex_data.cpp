@@ -18,8 +18,11 @@
 //     along with Simulant.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 #include "vertex_data.h"
+#include "utils/packed_types.h"
 #include "window.h"
 #include "time_keeper.h"
 #include "utils/gl_thread_check.h"
@@ -63,6 +66,44 @@ _S_FORCE_INLINE Vec3 unpack_vertex_attribute_vec3_1i(uint32_t p) {
     return ret;
 }
 
+/* Signed normalized values, as GL ES 3 and GL 4.2 read them. GL 2 maps
+ * them slightly differently, but the difference is under half a step */
+_S_FORCE_INLINE int16_t pack_snorm16(float v) {
+    return (int16_t) std::round(clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+_S_FORCE_INLINE int8_t pack_snorm8(float v) {
+    return (int8_t) std::round(clamp(v, -1.0f, 1.0f) * 127.0f);
+}
+
+/* Projects a unit vector onto an octahedron, and then unfolds the lower
+ * half of that over the upper half */
+_S_FORCE_INLINE Vec2 octahedral_encode(float x, float y, float z) {
+    float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+    if(l1 == 0.0f) {
+        return Vec2(0, 0);
+    }
+
+    Vec2 ret(x / l1, y / l1);
+    if(z < 0.0f) {
+        float ox = ret.x;
+        ret.x = (1.0f - std::abs(ret.y)) * ((ox >= 0.0f) ? 1.0f : -1.0f);
+        ret.y = (1.0f - std::abs(ox)) * ((ret.y >= 0.0f) ? 1.0f : -1.0f);
+    }
+
+    return ret;
+}
+
+_S_FORCE_INLINE Vec3 octahedral_decode(float x, float y) {
+    Vec3 ret(x, y, 1.0f - std::abs(x) - std::abs(y));
+    if(ret.z < 0.0f) {
+        ret.x = (1.0f - std::abs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+        ret.y = (1.0f - std::abs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+    }
+
+    return ret.normalized();
+}
+
 const VertexSpecification VertexSpecification::DEFAULT = VertexSpecification{
     VERTEX_ATTRIBUTE_3F,  // Position
     VERTEX_ATTRIBUTE_3F,
@@ -178,7 +219,8 @@ void VertexData::position(float x, float y, float z) {
     position_checks();
 
     assert(vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_3F ||
-           vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_4F);
+           vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_4F ||
+           vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_3S_NORMALIZED);
 
     float* out = (float*) &data_[cursor_offset()];
     switch(vertex_specification_.position_attribute_) {
@@ -190,6 +232,12 @@ void VertexData::position(float x, float y, float z) {
         out[1] = y;
         out[2] = z;
     break;
+    case VERTEX_ATTRIBUTE_3S_NORMALIZED: {
+        int16_t* packed = (int16_t*) out;
+        packed[0] = pack_snorm16((x - position_offset_.x) / position_scale_.x);
+        packed[1] = pack_snorm16((y - position_offset_.y) / position_scale_.y);
+        packed[2] = pack_snorm16((z - position_offset_.z) / position_scale_.z);
+    } break;
     default:
         return;
     }
@@ -200,7 +248,13 @@ void VertexData::position(float x, float y) {
 
     assert(vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_2F ||
            vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_3F ||
-           vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_4F);
+           vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_4F ||
+           vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_3S_NORMALIZED);
+
+    if(vertex_specification_.position_attribute_ == VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+        position(x, y, 0.0f);
+        return;
+    }
 
     float* out = (float*) &data_[cursor_offset()];
     switch(vertex_specification_.position_attribute_) {
@@ -264,11 +318,23 @@ const Vec3* VertexData::normal_at<Vec3>(uint32_t idx) const {
     if(vertex_specification_.normal_attribute_ == VERTEX_ATTRIBUTE_3F) {
         return ((Vec3*) &data_[(idx * stride()) + vertex_specification_.normal_offset()]);
     } else {
-        assert(vertex_specification_.normal_attribute_ == VERTEX_ATTRIBUTE_PACKED_VEC4_1I);
-
         static Vec3 ret; // This is mega nasty, need to rethink the pointer return
-        auto data = (uint32_t*) &data_[(idx * stride()) + vertex_specification_.normal_offset()];
-        ret = unpack_vertex_attribute_vec3_1i(*data);
+        auto ptr = &data_[(idx * stride()) + vertex_specification_.normal_offset()];
+
+        switch(vertex_specification_.normal_attribute_) {
+        case VERTEX_ATTRIBUTE_2B_OCTAHEDRAL: {
+            auto packed = (const int8_t*) ptr;
+            ret = octahedral_decode(packed[0] / 127.0f, packed[1] / 127.0f);
+        } break;
+        case VERTEX_ATTRIBUTE_2S_OCTAHEDRAL: {
+            auto packed = (const int16_t*) ptr;
+            ret = octahedral_decode(packed[0] / 32767.0f, packed[1] / 32767.0f);
+        } break;
+        default:
+            assert(vertex_specification_.normal_attribute_ == VERTEX_ATTRIBUTE_PACKED_VEC4_1I);
+            ret = unpack_vertex_attribute_vec3_1i(*(const uint32_t*) ptr);
+        }
+
         return &ret;
     }
 }
@@ -281,6 +347,14 @@ Vec4 VertexData::position_nd_at(uint32_t idx, float defz, float defw) const {
     } else if(attr == VERTEX_ATTRIBUTE_3F) {
         auto v = *position_at<Vec3>(idx);
         return Vec4(v.x, v.y, v.z, defw);
+    } else if(attr == VERTEX_ATTRIBUTE_3S_NORMALIZED) {
+        auto packed = (const int16_t*) &data_[idx * stride_];
+        return Vec4(
+            (packed[0] / 32767.0f) * position_scale_.x + position_offset_.x,
+            (packed[1] / 32767.0f) * position_scale_.y + position_offset_.y,
+            (packed[2] / 32767.0f) * position_scale_.z + position_offset_.z,
+            defw
+        );
     } else {
         return *position_at<Vec4>(idx);
     }
@@ -295,14 +369,29 @@ void VertexData::normal(float x, float y, float z) {
 
     uint8_t* ptr = (uint8_t*) &data_[cursor_offset() + offset];
 
-    if(vertex_specification_.normal_attribute_ == VERTEX_ATTRIBUTE_3F) {
+    switch(vertex_specification_.normal_attribute_) {
+    case VERTEX_ATTRIBUTE_3F: {
         Vec3* out = (Vec3*) ptr;
         *out = Vec3(x, y, z);
-    } else  {
+    } break;
+    case VERTEX_ATTRIBUTE_2B_OCTAHEDRAL: {
+        auto oct = octahedral_encode(x, y, z);
+        int8_t* packed = (int8_t*) ptr;
+        packed[0] = pack_snorm8(oct.x);
+        packed[1] = pack_snorm8(oct.y);
+    } break;
+    case VERTEX_ATTRIBUTE_2S_OCTAHEDRAL: {
+        auto oct = octahedral_encode(x, y, z);
+        int16_t* packed = (int16_t*) ptr;
+        packed[0] = pack_snorm16(oct.x);
+        packed[1] = pack_snorm16(oct.y);
+    } break;
+    default: {
         assert(vertex_specification_.normal_attribute_ == VERTEX_ATTRIBUTE_PACKED_VEC4_1I);
         uint32_t* packed = (uint32_t*) ptr;
         *packed = pack_vertex_attribute_vec3_1i(x, y, z);
     }
+    }
 }
 
 void VertexData::normal(const Vec3 &n) {
@@ -316,6 +405,12 @@ void VertexData::tex_coordX(uint8_t which, float u, float v) {
         return;
     }
 
+    if(vertex_specification_.texcoordX_attribute(which) == VERTEX_ATTRIBUTE_2H) {
+        HalfVec2* out = (HalfVec2*) &data_[cursor_offset() + offset];
+        *out = HalfVec2(u, v);
+        return;
+    }
+
     Vec2* out = (Vec2*) &data_[cursor_offset() + offset];
     out->x = u;
     out->y = v;
@@ -568,9 +663,21 @@ void VertexData::reset(VertexSpecification vertex_specification) {
 
     vertex_specification_ = vertex_specification;
     stride_ = vertex_specification.stride();
+    position_scale_ = Vec3(1, 1, 1);
+    position_offset_ = Vec3();
     recalc_attributes();
 }
 
+void VertexData::set_position_range(const Vec3& min, const Vec3& max) {
+    position_offset_ = (min + max) * 0.5f;
+    position_scale_ = (max - min) * 0.5f;
+
+    /* A flat axis would divide by zero */
+    position_scale_.x = std::max(position_scale_.x, std::numeric_limits<float>::epsilon());
+    position_scale_.y = std::max(position_scale_.y, std::numeric_limits<float>::epsilon());
+    position_scale_.z = std::max(position_scale_.z, std::numeric_limits<float>::epsilon());
+}
+
 void VertexData::recalc_attributes() {
 
 }
@@ -649,6 +756,8 @@ bool VertexData::clone_into(VertexData& other) {
     other.data_ = this->data_;
     other.vertex_count_ = this->vertex_count_;
     other.stride_ = this->stride_;
+    other.position_scale_ = this->position_scale_;
+    other.position_offset_ = this->position_offset_;
     other.cursor_position_ = 0;
 
     return true;
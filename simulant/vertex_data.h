@@ -218,7 +218,9 @@ public:
     }
 
     std::size_t extend(const VertexData& other) {
-        if(vertex_specification_ != other.vertex_specification_) {
+        if(vertex_specification_ != other.vertex_specification_ ||
+           position_scale_ != other.position_scale_ ||
+           position_offset_ != other.position_offset_) {
             S_ERROR("Tried to extend vertex data with incompatible data");
             return 0;
         }
@@ -259,6 +261,13 @@ public:
 
     const VertexSpecification& vertex_specification() const { return vertex_specification_; }
 
+    /* Positions stored as VERTEX_ATTRIBUTE_3S_NORMALIZED are relative to
+     * this range, and anything outside of it is clamped, so set it before
+     * writing them. position = (stored * scale) + offset */
+    void set_position_range(const Vec3& min, const Vec3& max);
+    const Vec3& position_scale() const { return position_scale_; }
+    const Vec3& position_offset() const { return position_offset_; }
+
     /* Clones this VertexData into another. The other data must have the same
      * specification and will be wiped if it contains vertices already.
      *
@@ -277,6 +286,9 @@ private:
     int32_t cursor_position_ = 0;
     uint64_t last_updated_ = 0;
 
+    Vec3 position_scale_ = Vec3(1, 1, 1);
+    Vec3 position_offset_;
+
     void tex_coordX(uint8_t which, float u);
     void tex_coordX(uint8_t which, float u, float v);
     void tex_coordX(uint8_t which, float u, float v, float w);
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/nodes/animation_controller.h"
+
+namespace {
+
+using namespace smlt;
+
+class AnimationControllerTests : public test::SimulantTestCase {
+public:
+    static std::vector<float> make_times(std::size_t count, float step) {
+        std::vector<float> times;
+        for(std::size_t i = 0; i < count; ++i) {
+            times.push_back(float(i) * step);
+        }
+        return times;
+    }
+
+    static KeyframeIndices linear_search(const std::vector<float>& times, float t) {
+        for(std::size_t i = 1; i < times.size(); ++i) {
+            if(times[i] > t) {
+                return std::make_pair(i - 1, i);
+            }
+        }
+
+        return std::make_pair(times.size() - 2, times.size() - 1);
+    }
+
+    void test_cursor_matches_search() {
+        auto times = make_times(100, 0.1f);
+
+        RandomGenerator rgen(1234);
+
+        /* Mix of forward playback and random seeks */
+        std::size_t cursor = 0;
+        float t = 0.0f;
+        for(int i = 0; i < 1000; ++i) {
+            if(i % 50 == 0) {
+                t = rgen.float_in_range(0.0f, 10.0f);
+            } else {
+                t += 0.016f;
+            }
+
+            auto expected = linear_search(times, std::min(t, times.back()));
+            auto found = find_keyframe_indices(times, t, cursor);
+
+            assert_equal(found.first, expected.first);
+            assert_equal(found.second, expected.second);
+            assert_equal(cursor, found.first);
+        }
+    }
+
+    void test_out_of_range_times_clamp() {
+        auto times = make_times(10, 1.0f);
+
+        std::size_t cursor = 5;
+        auto found = find_keyframe_indices(times, -1.0f, cursor);
+        assert_equal(found.first, 0u);
+        assert_equal(found.second, 1u);
+
+        found = find_keyframe_indices(times, 100.0f, cursor);
+        assert_equal(found.first, 8u);
+        assert_equal(found.second, 9u);
+
+        std::vector<float> single = {0.5f};
+        found = find_keyframe_indices(single, 1.0f, cursor);
+        assert_equal(found.first, 0u);
+        assert_equal(found.second, 0u);
+    }
+
+    void test_channels_share_timelines() {
+        auto times = std::make_shared<const std::vector<float>>(make_times(10, 1.0f));
+        auto other = std::make_shared<const std::vector<float>>(make_times(5, 1.0f));
+
+        auto node = scene->create_child<Stage>();
+        auto controller = scene->create_child<AnimationController>();
+
+        Animation anim;
+        anim.name = "test";
+        for(auto& t: {times, other, times}) {
+            Channel channel;
+            channel.path = ANIMATION_PATH_TRANSLATION;
+            channel.target = FindDescendentByID(node->id(), scene);
+            channel.data = std::make_shared<AnimationData>(
+                t, std::vector<Vec3>(t->size(), Vec3(1, 2, 3)));
+            anim.channels.push_back(channel);
+        }
+
+        controller->push_animation(anim);
+
+        auto& pushed = controller->animations_.back();
+        assert_equal(pushed.timelines.size(), 2u);
+        assert_equal(pushed.channels[0].timeline, 0u);
+        assert_equal(pushed.channels[1].timeline, 1u);
+        assert_equal(pushed.channels[2].timeline, 0u);
+
+        controller->play("test");
+        controller->on_update(0.5f);
+
+        assert_equal(node->transform->position(), Vec3(1, 2, 3));
+
+        controller->destroy();
+        node->destroy();
+    }
+
+    void test_keyframe_lookup_benchmark() {
+#if defined(__DREAMCAST__) || defined(__PSP__)
+        skip_if(true, "The key data needs more RAM than the consoles have");
+#endif
+
+        typedef std::chrono::high_resolution_clock clock;
+
+        const std::size_t joints = 500;
+        const std::size_t keys = 10000;
+
+        /* glTF exporters typically key every joint at the same times */
+        auto times = std::make_shared<const std::vector<float>>(
+            make_times(keys, 1.0f / 30.0f));
+
+        auto controller = scene->create_child<AnimationController>();
+
+        Animation anim;
+        anim.name = "benchmark";
+        for(std::size_t i = 0; i < joints; ++i) {
+            auto node = scene->create_child<Stage>();
+            node->set_parent(controller);
+
+            Channel channel;
+            channel.path = ANIMATION_PATH_TRANSLATION;
+            channel.target = FindDescendentByID(node->id(), controller);
+            channel.data = std::make_shared<AnimationData>(
+                times, std::vector<Vec3>(keys, Vec3(float(i), 0, 0)));
+            anim.channels.push_back(channel);
+        }
+
+        controller->push_animation(anim);
+        controller->play("benchmark", ANIMATION_LOOP_FOREVER);
+
+        const int frames = 300;
+        const float dt = 1.0f / 60.0f;
+
+        /* What the controller used to do: a linear scan per channel */
+        float start_t = times->back() * 0.75f;
+        auto start = clock::now();
+        for(int f = 0; f < frames; ++f) {
+            float t = start_t + (f * dt);
+            for(std::size_t i = 0; i < joints; ++i) {
+                auto found = linear_search(*times, t);
+                assert_true(found.second > 0);
+            }
+        }
+        auto linear_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        controller->time_ = start_t;
+        start = clock::now();
+        for(int f = 0; f < frames; ++f) {
+            controller->on_update(dt);
+        }
+        auto update_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        std::cout << "    " << joints << " channels x " << keys << " keys, "
+                  << frames << " frames: linear scan lookup " << linear_ms
+                  << "ms, full controller update " << update_ms << "ms"
+                  << std::endl;
+
+        controller->destroy();
+    }
+};
+
+}
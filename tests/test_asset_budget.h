@@ -0,0 +1,151 @@
+#pragma once
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+
+namespace {
+
+using namespace smlt;
+
+class AssetBudgetTests : public smlt::test::SimulantTestCase {
+public:
+    void set_up() {
+        SimulantTestCase::set_up();
+
+        /* A manager of our own, so nothing else is competing for the budget */
+        assets_ = LocalAssetManager::create();
+    }
+
+    void tear_down() {
+        assets_.reset();
+        SimulantTestCase::tear_down();
+    }
+
+    AssetID load_texture() {
+        return assets_->load_texture(
+            "assets/samples/crate.png", GARBAGE_COLLECT_NEVER
+        )->id();
+    }
+
+    void test_memory_usage() {
+        auto tex = assets_->create_texture(8, 8, TEXTURE_FORMAT_RGBA_4UB_8888);
+        assert_equal(tex->memory_usage(), 8u * 8u * 4u);
+
+        auto residency = assets_->residency();
+        assert_equal(residency.textures.resident_count, 1u);
+        assert_equal(residency.textures.resident_bytes, 8u * 8u * 4u);
+        assert_equal(residency.resident_bytes(), 8u * 8u * 4u);
+    }
+
+    void test_no_eviction_without_a_budget() {
+        auto id = load_texture();
+
+        assets_->run_garbage_collection();
+
+        assert_false(assets_->is_texture_evicted(id));
+        assert_equal(assets_->residency().textures.evictions, 0u);
+    }
+
+    void test_unreferenced_assets_are_evicted_and_reloaded() {
+        auto id = load_texture();
+        assets_->texture(id)->set_name("crate");
+        auto bytes = assets_->texture(id)->memory_usage();
+
+        assets_->set_memory_budget(1);
+        assets_->run_garbage_collection();
+
+        assert_true(assets_->is_texture_evicted(id));
+        assert_true(assets_->has_texture(id));
+        assert_equal(assets_->texture_count(), 0u);
+
+        auto residency = assets_->residency();
+        assert_equal(residency.textures.evicted_count, 1u);
+        assert_equal(residency.textures.evictions, 1u);
+        assert_equal(residency.textures.resident_bytes, 0u);
+
+        auto tex = assets_->texture(id);
+        assert_true(tex);
+        assert_equal(tex->id(), id);
+        assert_equal(tex->name(), "crate");
+        assert_equal(tex->memory_usage(), bytes);
+        assert_false(assets_->is_texture_evicted(id));
+        assert_equal(assets_->residency().textures.reloads, 1u);
+    }
+
+    void test_referenced_assets_are_not_evicted() {
+        auto tex = assets_->load_texture("assets/samples/crate.png", GARBAGE_COLLECT_NEVER);
+
+        assets_->set_memory_budget(1);
+        assets_->run_garbage_collection();
+
+        assert_false(assets_->is_texture_evicted(tex->id()));
+        assert_equal(assets_->texture_count(), 1u);
+    }
+
+    void test_created_assets_are_not_evicted() {
+        auto id = assets_->create_texture(8, 8, TEXTURE_FORMAT_RGBA_4UB_8888, GARBAGE_COLLECT_NEVER)->id();
+
+        assets_->set_memory_budget(1);
+        assets_->run_garbage_collection();
+
+        assert_false(assets_->is_texture_evicted(id));
+        assert_true(assets_->texture(id));
+    }
+
+    void test_least_recently_used_is_evicted_first() {
+        auto first = load_texture();
+        assets_->run_garbage_collection();
+        auto second = load_texture();
+        assets_->run_garbage_collection();
+
+        assets_->set_memory_budget(assets_->residency().resident_bytes() - 1);
+        assets_->run_garbage_collection();
+
+        assert_true(assets_->is_texture_evicted(first));
+        assert_false(assets_->is_texture_evicted(second));
+
+        /* Using the first makes the second the oldest */
+        assert_true(assets_->texture(first));
+        assets_->run_garbage_collection();
+
+        assert_false(assets_->is_texture_evicted(first));
+        assert_true(assets_->is_texture_evicted(second));
+    }
+
+    void test_evicted_mesh_is_found_by_name() {
+        auto mesh = assets_->load_mesh("assets/samples/cube.obj");
+        mesh->set_name("cube");
+        mesh->set_garbage_collection_method(GARBAGE_COLLECT_NEVER);
+
+        auto id = mesh->id();
+        auto submeshes = mesh->submesh_count();
+        assert_true(mesh->memory_usage() > 0);
+        mesh.reset();
+
+        assets_->set_memory_budget(1);
+        assets_->run_garbage_collection();
+        assert_true(assets_->is_mesh_evicted(id));
+
+        mesh = assets_->find_mesh("cube");
+        assert_true(mesh);
+        assert_equal(mesh->id(), id);
+        assert_equal(mesh->submesh_count(), submeshes);
+    }
+
+    void test_destroyed_assets_are_forgotten() {
+        auto id = load_texture();
+        assets_->destroy_texture(id);
+        assets_->run_garbage_collection();
+
+        assets_->set_memory_budget(1);
+        assets_->run_garbage_collection();
+
+        assert_false(assets_->is_texture_evicted(id));
+        assert_false(assets_->has_texture(id));
+    }
+
+private:
+    LocalAssetManager::ptr assets_;
+};
+
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+
+namespace {
+
+using namespace smlt;
+
+class AsyncLoadingTests : public smlt::test::SimulantTestCase {
+public:
+    template<typename T>
+    bool wait_for(Promise<T>& promise) {
+        for(int i = 0; i < 2000 && !promise.is_ready(); ++i) {
+            application->shared_assets->update(0.0f);
+            thread::sleep(1);
+        }
+
+        return promise.is_ready();
+    }
+
+    void test_load_texture_async() {
+        auto assets = application->shared_assets.get();
+        auto count = assets->texture_count();
+
+        auto promise = assets->load_texture_async("assets/samples/crate.png");
+        assert_false(promise.is_ready());
+        assert_equal(assets->async_load_count(), 1u);
+
+        assert_true(wait_for(promise));
+
+        auto tex = promise.value();
+        assert_true(tex);
+        assert_true(tex->width() > 8);
+        assert_true(tex->has_data());
+        assert_equal(assets->texture_count(), count + 1);
+        assert_equal(assets->async_load_count(), 0u);
+    }
+
+    void test_load_mesh_async() {
+        auto promise = application->shared_assets->load_mesh_async(
+            "assets/samples/cube.obj"
+        );
+
+        assert_true(wait_for(promise));
+        assert_true(promise.value());
+        assert_true(promise.value()->submesh_count() > 0);
+    }
+
+    void test_load_sound_async() {
+        auto promise = application->shared_assets->load_sound_async(
+            "assets/sounds/simulant.ogg"
+        );
+
+        assert_true(wait_for(promise));
+        assert_true(promise.value());
+        assert_true(promise.value()->sample_rate() > 0);
+    }
+
+    void test_load_prefab_async() {
+        auto promise = application->shared_assets->load_prefab_async(
+            "assets/samples/BoxTextured.gltf"
+        );
+
+        assert_true(wait_for(promise));
+        assert_true(promise.value());
+    }
+
+    void test_scene_assets_are_updated_by_the_base_manager() {
+        auto promise = scene->assets->load_texture_async("assets/samples/crate.png");
+
+        /* wait_for only updates the shared assets */
+        assert_true(wait_for(promise));
+        assert_true(promise.value());
+        assert_true(scene->assets->has_texture(promise.value()->id()));
+    }
+
+    void test_missing_file_fails_immediately() {
+        auto promise = application->shared_assets->load_texture_async("does/not/exist.png");
+        assert_true(promise.is_ready());
+        assert_false(promise.value());
+    }
+
+    void test_cancel() {
+        auto assets = application->shared_assets.get();
+
+        auto keep = assets->load_texture_async("assets/samples/crate.png");
+        auto first = assets->load_texture_async("assets/textures/checkerboard.png");
+        auto second = assets->load_texture_async(
+            "assets/textures/checkerboard.png", TextureFlags(), ASSET_LOAD_PRIORITY_HIGH
+        );
+
+        assert_equal(assets->cancel_async_load("assets/textures/checkerboard.png"), 2u);
+        assert_equal(assets->async_load_count(), 1u);
+
+        assert_true(first.is_ready());
+        assert_false(first.value());
+        assert_true(second.is_ready());
+        assert_false(second.value());
+
+        assert_true(wait_for(keep));
+        assert_true(keep.value());
+    }
+
+    void test_cancel_all_waits_for_running_loads() {
+        auto assets = scene->assets.get();
+
+        auto texture = assets->load_texture_async("assets/samples/crate.png");
+        auto sound = assets->load_sound_async("assets/sounds/simulant.ogg");
+
+        /* Starts the decodes on the workers */
+        assets->update(0.0f);
+
+        assets->cancel_all_async_loads();
+        assert_equal(assets->async_load_count(), 0u);
+
+        assert_true(texture.is_ready());
+        assert_false(texture.value());
+        assert_true(sound.is_ready());
+        assert_false(sound.value());
+
+        /* Nothing is left for update() to finish */
+        assets->update(0.0f);
+        assert_equal(assets->async_load_count(), 0u);
+    }
+
+    void test_budget_finishes_one_load_per_update_when_exhausted() {
+        auto assets = application->shared_assets.get();
+        auto budget = assets->async_load_budget();
+        assets->set_async_load_budget(0);
+
+        std::vector<Promise<TexturePtr>> promises;
+        for(int i = 0; i < 4; ++i) {
+            promises.push_back(assets->load_texture_async(
+                "assets/samples/crate.png", TextureFlags(),
+                (i == 3) ? ASSET_LOAD_PRIORITY_HIGH : ASSET_LOAD_PRIORITY_LOW
+            ));
+        }
+
+        std::size_t ready = 0;
+        for(int i = 0; i < 2000 && ready < promises.size(); ++i) {
+            assets->update(0.0f);
+
+            std::size_t now_ready = 0;
+            for(auto& p: promises) {
+                now_ready += p.is_ready();
+            }
+
+            assert_true(now_ready - ready <= 1);
+            ready = now_ready;
+            thread::sleep(1);
+        }
+
+        assets->set_async_load_budget(budget);
+
+        assert_equal(ready, promises.size());
+        for(auto& p: promises) {
+            assert_true(p.value());
+        }
+    }
+};
+
+}
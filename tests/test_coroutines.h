@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <stdexcept>
 #include "simulant/test.h"
 
 namespace {
@@ -120,6 +122,107 @@ public:
         application->stop_all_coroutines();
         sig.disconnect();
     }
+
+    void test_stop_unwinds_coroutine() {
+        struct Guard {
+            bool* flag;
+            ~Guard() { *flag = true; }
+        };
+
+        bool unwound = false;
+        cr_async([&]() {
+            Guard guard{&unwound};
+            while(true) {
+                cr_yield();
+            }
+        });
+
+        application->update_coroutines();
+        assert_false(unwound);
+
+        application->stop_all_coroutines();
+        assert_true(unwound);
+    }
+
+    void test_stop_gives_up_on_coroutine_which_ignores_it() {
+#ifndef SIMULANT_COROUTINES_USE_FIBERS
+        skip_if(true, "Coroutines are thread-backed on this platform");
+#endif
+        int yields = 0;
+        cr_async([&]() {
+            while(true) {
+                try {
+                    ++yields;
+                    cr_yield();
+                } catch(...) {}
+            }
+        });
+
+        application->update_coroutines();
+        assert_equal(yields, 1);
+
+        /* Returns, rather than resuming the coroutine forever */
+        application->stop_all_coroutines();
+        assert_true(yields > 1);
+    }
+
+    void test_stop_cleans_up_when_coroutine_throws() {
+#ifndef SIMULANT_COROUTINES_USE_FIBERS
+        skip_if(true, "Coroutines are thread-backed on this platform");
+#endif
+        cr_async([&]() {
+            try {
+                while(true) {
+                    cr_yield();
+                }
+            } catch(...) {
+                throw std::runtime_error("failed while stopping");
+            }
+        });
+
+        application->update_coroutines();
+        assert_raises(std::runtime_error, [&]() { application->stop_all_coroutines(); });
+
+        /* The context went with it, stopping again is a no-op */
+        application->stop_all_coroutines();
+    }
+
+    void test_resume_10k_coroutines_benchmark() {
+#ifndef SIMULANT_COROUTINES_USE_FIBERS
+        skip_if(true, "Coroutines are thread-backed on this platform");
+#endif
+        const int coroutine_count = 10000;
+        const int frame_count = 10;
+
+        bool done = false;
+        int resumes = 0;
+
+        for(int i = 0; i < coroutine_count; ++i) {
+            cr_async([&]() {
+                while(!done) {
+                    ++resumes;
+                    cr_yield();
+                }
+            });
+        }
+
+        typedef std::chrono::high_resolution_clock clock;
+        auto start = clock::now();
+        for(int i = 0; i < frame_count; ++i) {
+            application->update_coroutines();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            clock::now() - start
+        ).count();
+
+        std::cout << "    " << coroutine_count << " coroutines: "
+                  << (float(elapsed) / frame_count) / 1000.0f << "ms per frame" << std::endl;
+
+        assert_equal(resumes, coroutine_count * frame_count);
+
+        done = true;
+        application->stop_all_coroutines();
+    }
 };
 
 }
@@ -130,6 +130,30 @@ public:
 
         assert_close(frustum.depth(), 99.0f, 0.001f);
     }
+
+    void test_classify_aabb() {
+        Frustum frustum;
+
+        /* Looking down -Z, the edges are ~4.14 from the center at z = -10 */
+        Mat4 projection = Mat4::as_projection(Degrees(45.0), 1.0, 1.0, 100.0);
+        frustum.build(&projection);
+
+        uint8_t mask = FRUSTUM_PLANE_MASK_ALL;
+        assert_equal(frustum.classify_aabb(AABB(Vec3(0, 0, -10), 1.0f), mask), FRUSTUM_CONTAINS_ALL);
+        assert_equal(mask, 0u);
+
+        mask = FRUSTUM_PLANE_MASK_ALL;
+        assert_equal(frustum.classify_aabb(AABB(Vec3(0, 0, 10), 1.0f), mask), FRUSTUM_CONTAINS_NONE);
+
+        /* Only the right plane needs testing again */
+        mask = FRUSTUM_PLANE_MASK_ALL;
+        assert_equal(frustum.classify_aabb(AABB(Vec3(4.14f, 0, -10), 1.0f), mask), FRUSTUM_CONTAINS_PARTIAL);
+        assert_equal(mask, (1u << FRUSTUM_PLANE_RIGHT));
+
+        /* Masked planes are ignored, this is beyond the far plane */
+        mask = FRUSTUM_PLANE_MASK_ALL & ~(1 << FRUSTUM_PLANE_FAR);
+        assert_equal(frustum.classify_aabb(AABB(Vec3(0, 0, -200), 1.0f), mask), FRUSTUM_CONTAINS_ALL);
+    }
 };
 
 #endif // TEST_FRUSTUM_H
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/services/job_system.h"
+
+namespace {
+
+using namespace smlt;
+
+class JobSystemTest : public smlt::test::SimulantTestCase {
+public:
+    void test_inline_jobs_run_immediately() {
+        JobSystem jobs(0);
+
+        bool ran = false;
+        auto counter = jobs.run([&]() { ran = true; });
+
+        assert_true(ran);
+        assert_true(counter->is_done());
+        assert_equal(jobs.worker_count(), 0u);
+    }
+
+    void test_jobs_run_on_workers() {
+        JobSystem jobs(3);
+
+        thread::Mutex mutex;
+        uint32_t total = 0;
+
+        auto counter = std::make_shared<JobCounter>();
+        for(uint32_t i = 0; i < 100; ++i) {
+            jobs.run(counter, [&, i]() {
+                thread::Lock<thread::Mutex> lock(mutex);
+                total += i;
+            });
+        }
+
+        jobs.wait(counter);
+
+        assert_true(counter->is_done());
+        assert_equal(total, 4950u);
+    }
+
+    void test_dependencies_run_in_order() {
+        for(uint32_t workers: {0u, 2u}) {
+            JobSystem jobs(workers);
+
+            thread::Mutex mutex;
+            std::vector<int> order;
+
+            auto append = [&](int v) {
+                return [&, v]() {
+                    thread::Lock<thread::Mutex> lock(mutex);
+                    order.push_back(v);
+                };
+            };
+
+            auto first = jobs.run([&]() {
+                thread::sleep(5);
+                append(1)();
+            });
+
+            auto second = jobs.run(append(2), "job", first);
+            auto third = jobs.run(append(3), "job", second);
+
+            jobs.wait(third);
+
+            assert_equal(order.size(), 3u);
+            assert_equal(order[0], 1);
+            assert_equal(order[1], 2);
+            assert_equal(order[2], 3);
+        }
+    }
+
+    void test_jobs_can_wait_on_nested_jobs() {
+        JobSystem jobs(2);
+
+        thread::Mutex mutex;
+        uint32_t count = 0;
+
+        /* More outer jobs than workers, so waiting must help out */
+        auto outer = std::make_shared<JobCounter>();
+        for(int i = 0; i < 8; ++i) {
+            jobs.run(outer, [&]() {
+                auto inner = std::make_shared<JobCounter>();
+                for(int j = 0; j < 8; ++j) {
+                    jobs.run(inner, [&]() {
+                        thread::Lock<thread::Mutex> lock(mutex);
+                        ++count;
+                    });
+                }
+
+                jobs.wait(inner);
+            });
+        }
+
+        jobs.wait(outer);
+        assert_equal(count, 64u);
+    }
+
+    void test_parallel_for_covers_range() {
+        for(uint32_t workers: {0u, 3u}) {
+            JobSystem jobs(workers);
+
+            std::vector<int> hits(10000, 0);
+            jobs.parallel_for(0, hits.size(), [&](uint32_t first, uint32_t last) {
+                for(uint32_t i = first; i < last; ++i) {
+                    hits[i]++;
+                }
+            }, 64);
+
+            for(auto h: hits) {
+                assert_equal(h, 1);
+            }
+        }
+    }
+
+    void test_wait_rethrows_job_exceptions() {
+        for(uint32_t workers: {0u, 2u}) {
+            JobSystem jobs(workers);
+
+            auto counter = std::make_shared<JobCounter>();
+            for(int i = 0; i < 10; ++i) {
+                jobs.run(counter, [i]() {
+                    if(i == 3) {
+                        throw std::runtime_error("three");
+                    }
+                });
+            }
+
+            bool thrown = false;
+            try {
+                jobs.wait(counter);
+            } catch(std::runtime_error& e) {
+                thrown = std::string(e.what()) == "three";
+            }
+
+            assert_true(thrown);
+            assert_true(counter->is_done());
+
+            /* Not only std::exceptions */
+            thrown = false;
+            try {
+                jobs.wait(jobs.run([]() { throw 1; }));
+            } catch(int) {
+                thrown = true;
+            }
+
+            assert_true(thrown);
+        }
+    }
+
+    void test_stats_are_recorded() {
+        JobSystem jobs(2);
+
+        auto counter = std::make_shared<JobCounter>();
+        for(int i = 0; i < 5; ++i) {
+            jobs.run(counter, []() { thread::sleep(1); }, "sleepy");
+        }
+
+        jobs.wait(counter);
+
+        auto stats = jobs.stats();
+        assert_equal(stats["sleepy"].count, 5u);
+        assert_true(stats["sleepy"].total_us >= stats["sleepy"].max_us);
+        assert_true(stats["sleepy"].max_us > 0u);
+
+        jobs.reset_stats();
+        assert_true(jobs.stats().empty());
+    }
+
+    void test_stop_runs_remaining_jobs() {
+        JobSystem jobs(2);
+
+        thread::Mutex mutex;
+        uint32_t count = 0;
+
+        for(int i = 0; i < 20; ++i) {
+            jobs.run([&]() {
+                thread::Lock<thread::Mutex> lock(mutex);
+                ++count;
+            });
+        }
+
+        jobs.stop();
+
+        assert_equal(count, 20u);
+        assert_equal(jobs.worker_count(), 0u);
+    }
+
+    void test_application_has_jobs() {
+        assert_true(application->jobs.get());
+    }
+};
+
+}
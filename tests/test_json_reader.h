@@ -0,0 +1,272 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/utils/json_reader.h"
+
+namespace {
+
+using namespace smlt;
+
+class EventRecorder : public JSONReaderHandler {
+public:
+    std::string events;
+
+    bool on_object_start() override { events += "{"; return true; }
+    bool on_object_end() override { events += "}"; return true; }
+    bool on_array_start() override { events += "["; return true; }
+    bool on_array_end() override { events += "]"; return true; }
+
+    bool on_key(std::string_view key) override {
+        events += std::string(key) + ":";
+        return true;
+    }
+
+    bool on_string(std::string_view value) override {
+        events += "'" + std::string(value) + "',";
+        return true;
+    }
+
+    bool on_number(double value, bool is_float) override {
+        events += (is_float) ? _F("f{0},").format(value) : _F("i{0},").format(int(value));
+        return true;
+    }
+
+    bool on_bool(bool value) override {
+        events += (value) ? "true," : "false,";
+        return true;
+    }
+
+    bool on_null() override {
+        events += "null,";
+        return true;
+    }
+};
+
+class JSONReaderTests : public test::SimulantTestCase {
+public:
+    void test_basic_usage() {
+        auto document = JSONDocument::parse(fixture("json_reader_basic.json"));
+
+        assert_true(document->is_valid());
+
+        auto root = document->root();
+        assert_equal(root.type(), JSON_OBJECT);
+        assert_equal(root.size(), 2u);
+
+        auto array = root["array"];
+        assert_equal(array.size(), 6u);
+        assert_equal(array[0].to_int().value_or(0), 1);
+        assert_false(array[0].is_float());
+        assert_close(array[1].to_float().value_or(0.0f), 2.5f, 0.0001f);
+        assert_true(array[1].is_float());
+        assert_equal(array[2].to_int().value_or(0), -300);
+        assert_true(array[3].to_bool().value_or(false));
+        assert_false(array[4].to_bool().value_or(true));
+        assert_true(array[5].is_null());
+        assert_false(array[6].is_valid());
+
+        auto object = root["object"];
+        assert_equal(object.size(), 4u);
+        assert_true(object.has_key("two"));
+        assert_false(object.has_key("three"));
+        assert_equal(object["two"].to_str().value_or(""), "2");
+        assert_false(object["two"].to_int());
+        assert_true(object["empty"].is_object());
+        assert_equal(object["none"].size(), 0u);
+
+        auto keys = object.keys();
+        assert_equal(keys.size(), 4u);
+        assert_equal(std::string(keys[0]), "one");
+        assert_equal(std::string(keys[3]), "none");
+
+        /* Missing lookups chain without throwing */
+        assert_false(root["missing"]["deeper"][3].is_valid());
+        assert_true(root["missing"]["deeper"].is_null());
+    }
+
+    void test_iteration() {
+        auto document = JSONDocument::parse(fixture("json_reader_iteration.json"));
+        auto root = document->root();
+
+        int total = 0;
+        for(auto value: root["a"]) {
+            total += value.to_int().value_or(0);
+        }
+        assert_equal(total, 6);
+
+        std::string keys;
+        for(auto value: root["b"]) {
+            keys += std::string(value.key());
+        }
+        assert_equal(keys, "xy");
+
+        int count = 0;
+        for(auto value: root["missing"]) {
+            _S_UNUSED(value);
+            ++count;
+        }
+        assert_equal(count, 0);
+    }
+
+    void test_strings() {
+        auto document = JSONDocument::parse(fixture("json_reader_strings.json"));
+        auto root = document->root();
+
+        assert_equal(root[0].to_str().value(), "plain");
+        assert_equal(root[1].to_str().value(), "tab\there");
+        assert_equal(root[2].to_str().value(), "quote\"");
+        assert_equal(root[3].to_str().value(), "\xc3\xa9\xf0\x9f\x98\x80");
+    }
+
+    void test_strings_point_into_source() {
+        std::string source = R"({"key": "value"})";
+        auto document = JSONDocument::parse(source);
+
+        /* The document keeps its own copy of the source, and unescaped
+         * strings are views into it */
+        auto view = document->root()["key"].str_view();
+        auto& copy = document->source_;
+        assert_equal(std::string(view), "value");
+        assert_true(view.data() >= copy.data() && view.data() < copy.data() + copy.size());
+        assert_equal(document->node_count(), 2u);
+    }
+
+    void test_errors() {
+        const char* bad[] = {
+            "", "{", "[1,]", "{\"a\" 1}", "tru", "[1 2]", "\"abc", "{1: 2}"
+        };
+
+        for(auto data: bad) {
+            auto document = JSONDocument::parse(data);
+            assert_false(document->is_valid());
+            assert_false(document->root().is_valid());
+            assert_false(document->error().message.empty());
+        }
+    }
+
+    void test_sax_events() {
+        const std::string data = fixture("json_reader_events.json");
+
+        EventRecorder recorder;
+        assert_true(json_sax_parse(data.c_str(), data.size(), &recorder));
+        assert_equal(recorder.events, "{a:[i1,f1.5,'s',]b:{c:null,d:true,}}");
+    }
+
+    void test_matches_json_parse() {
+        auto path = get_app()->vfs->locate_file("assets/samples/level1.json");
+        std::ifstream t(path.value().str());
+        assert_true(t.good());
+
+        auto document = JSONDocument::read(t);
+        assert_true(document->is_valid());
+        assert_equal(document->root()["geoms"].size(), 2u);
+    }
+
+    void test_gltf_load_benchmark() {
+        typedef std::chrono::high_resolution_clock clock;
+
+        const char* samples[] = {
+            "assets/samples/BoxTextured.gltf",
+            "assets/samples/AnimatedCube.gltf",
+            "assets/samples/character-a.glb",
+            "assets/samples/khronos/RiggedSimple.glb",
+        };
+
+        const int iterations = 200;
+
+        for(auto sample: samples) {
+            auto path = get_app()->vfs->locate_file(sample);
+            assert_true(path.has_value());
+
+            auto start = clock::now();
+            auto prefab = application->shared_assets->load_prefab(path.value());
+            auto load_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+            assert_true(prefab);
+
+            std::cout << "    " << sample << ": load_prefab " << load_ms << "ms";
+
+            if(path.value().ext() == ".gltf") {
+                std::ifstream t(path.value().str());
+                std::string data((std::istreambuf_iterator<char>(t)),
+                                 std::istreambuf_iterator<char>());
+
+                start = clock::now();
+                for(int i = 0; i < iterations; ++i) {
+                    auto json = json_parse(data);
+                    assert_true(json.is_valid());
+                }
+                auto old_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+                start = clock::now();
+                for(int i = 0; i < iterations; ++i) {
+                    auto document = JSONDocument::parse(data);
+                    assert_true(document->is_valid());
+                }
+                auto new_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+                std::cout << ", " << iterations << " parses: json_parse "
+                          << old_ms << "ms, JSONDocument " << new_ms << "ms";
+            }
+
+            std::cout << std::endl;
+        }
+    }
+
+    void test_large_accessor_table_benchmark() {
+        typedef std::chrono::high_resolution_clock clock;
+
+        /* The samples are tiny, so parse and walk something the size of a
+         * real scene's accessor table too, the way the glTF loader walks it */
+        std::string data = "{\"accessors\": [";
+        const int accessors = 20000;
+        for(int i = 0; i < accessors; ++i) {
+            data += (i) ? "," : "";
+            data += _F("{{\"bufferView\": {0}, \"componentType\": 5126, \"count\": 24, "
+                       "\"type\": \"VEC3\", \"max\": [1.0, 1.0, 1.0]}}").format(i);
+        }
+        data += "]}";
+
+        int64_t expected = int64_t(accessors - 1) * accessors / 2;
+
+        auto start = clock::now();
+        auto json = json_parse(data);
+        int64_t total = 0;
+        for(auto& node: json["accessors"]) {
+            total += node.to_iterator()["bufferView"]->to_int().value_or(0);
+        }
+        auto old_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+        assert_equal(total, expected);
+
+        start = clock::now();
+        auto document = JSONDocument::parse(data);
+        total = 0;
+        for(auto accessor: document->root()["accessors"]) {
+            total += accessor["bufferView"].to_int().value_or(0);
+        }
+        auto new_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        assert_equal(document->root()["accessors"].size(), std::size_t(accessors));
+        assert_equal(total, expected);
+        assert_equal(document->root()["accessors"][accessors - 1]["bufferView"].to_int().value_or(0),
+                     accessors - 1);
+
+        std::cout << "    " << accessors << " accessors, parse and walk: json_parse "
+                  << old_ms << "ms, JSONDocument " << new_ms << "ms" << std::endl;
+    }
+
+private:
+    /* Fixtures live in tests/data and are copied next to the test binary */
+    std::string fixture(const std::string& name) {
+        auto stream = get_app()->vfs->read_file("tests/" + name);
+        assert_true(bool(stream));
+        return stream->str();
+    }
+};
+
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/logging.h"
+
+namespace {
+
+using namespace smlt;
+
+struct FormatCounter {
+    int* count;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const FormatCounter& counter) {
+    ++(*counter.count);
+    return os << "counted";
+}
+
+class RecordingHandler : public Handler {
+public:
+    std::vector<std::string> messages() {
+        thread::Lock<thread::Mutex> g(lock_);
+        return messages_;
+    }
+
+    /* Holds up the writer until release() is called */
+    void block() {
+        thread::Lock<thread::Mutex> g(lock_);
+        blocked_ = true;
+    }
+
+    void release() {
+        {
+            thread::Lock<thread::Mutex> g(lock_);
+            blocked_ = false;
+        }
+
+        released_.notify_all();
+    }
+
+private:
+    void do_write_message(Logger*, const DateTime&, const char* level,
+                          const char* message, std::size_t length) override {
+        thread::Lock<thread::Mutex> g(lock_);
+        while(blocked_) {
+            released_.wait(lock_);
+        }
+
+        messages_.push_back(std::string(level) + " " + std::string(message, length));
+    }
+
+    thread::Mutex lock_;
+    thread::Condition released_;
+    std::vector<std::string> messages_;
+    bool blocked_ = false;
+};
+
+class LoggingTests : public test::SimulantTestCase {
+public:
+    void test_disabled_levels_skip_formatting() {
+        auto logger = get_logger("/");
+        auto level = logger->level();
+
+        int count = 0;
+        FormatCounter counter = {&count};
+
+        logger->set_level(LOG_LEVEL_ERROR);
+        S_INFO("{0}", counter);
+        S_WARN("{0}", counter);
+        assert_equal(count, 0);
+
+        logger->set_level(LOG_LEVEL_NONE);
+        S_ERROR("{0}", counter);
+        assert_equal(count, 0);
+
+        logger->set_level(level);
+    }
+
+    void test_long_messages_are_truncated() {
+        auto handler = std::make_shared<RecordingHandler>();
+        Logger logger("truncated");
+        logger.add_handler(handler);
+
+        logger.debug(std::string(LOG_MESSAGE_MAX * 2, 'x'));
+
+        auto messages = handler->messages();
+        assert_equal(messages.size(), 1u);
+        /* The text fills everything after the space kept for the prefix */
+        auto& message = messages[0];
+        assert_true(message.size() <= std::string("DEBUG ").size() + LOG_MESSAGE_MAX - 1);
+        assert_equal(
+            std::size_t(std::count(message.begin(), message.end(), 'x')),
+            LOG_MESSAGE_MAX - LOG_PREFIX_MAX - 1
+        );
+    }
+
+    void test_truncation_keeps_colour_reset() {
+        auto handler = std::make_shared<RecordingHandler>();
+        Logger logger("truncated_colour");
+        logger.add_handler(handler);
+
+        std::string text(LOG_MESSAGE_MAX * 2, 'x');
+        logger.log(LOG_LEVEL_WARN, text.c_str(), text.size(), "file.cpp", 10);
+
+        auto messages = handler->messages();
+        assert_equal(messages.size(), 1u);
+
+        const std::string suffix = "\x1b[0m (file.cpp:10)";
+        auto& message = messages[0];
+        assert_true(message.size() <= std::string("WARN ").size() + LOG_MESSAGE_MAX - 1);
+        assert_equal(message.substr(message.size() - suffix.size()), suffix);
+    }
+
+    void test_async_handler_writes_in_order() {
+        auto target = std::make_shared<RecordingHandler>();
+        auto handler = std::make_shared<AsyncHandler>(target, 8);
+
+        Logger logger("async");
+        logger.add_handler(handler);
+
+        for(int i = 0; i < 100; ++i) {
+            logger.info(_F("{0}").format(i));
+            if(i % 8 == 7) {
+                handler->flush();
+            }
+        }
+
+        handler->flush();
+
+        auto messages = target->messages();
+        assert_equal(messages.size(), 100u);
+        assert_equal(handler->dropped_count(), 0u);
+
+        for(int i = 0; i < 100; ++i) {
+            assert_true(messages[i].find(_F("\x1b[36m{0}\x1b[0m").format(i)) != std::string::npos);
+            assert_equal(messages[i].substr(0, 5), "INFO ");
+        }
+    }
+
+    void test_async_handler_drops_when_full() {
+        auto target = std::make_shared<RecordingHandler>();
+        auto handler = std::make_shared<AsyncHandler>(target, 4);
+
+        Logger logger("async_full");
+        logger.add_handler(handler);
+
+        target->block();
+
+        for(int i = 0; i < 10; ++i) {
+            logger.warn("message");
+        }
+
+        /* At most one message can have left the queue */
+        auto dropped = handler->dropped_count();
+        assert_true(dropped >= 5u);
+
+        target->release();
+        handler->flush();
+
+        auto messages = target->messages();
+        assert_equal(messages.size(), 10 - dropped + 1);
+
+        bool reported = false;
+        for(auto& message: messages) {
+            if(message.find(_F("{0} log messages were dropped").format(dropped)) != std::string::npos) {
+                reported = true;
+            }
+        }
+
+        assert_true(reported);
+    }
+};
+
+}
@@ -792,8 +792,10 @@ ReportParamNode.params = {
         auto node = scene->create_child("transform_change_node");
         assert_is_not_null(node);
 
-        // Trigger a transformation change from C++.
+        // Trigger a transformation change from C++. Changes are delivered
+        // once a frame, so flush them rather than waiting.
         node->transform->set_translation(smlt::Vec3(1, 2, 3));
+        scene->flush_transform_changes();
 
         // If on_transformation_changed was forwarded, the scale should have
         // been set to (2, 2, 2) by the Lua callback (only once, due to the
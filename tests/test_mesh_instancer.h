@@ -87,11 +87,79 @@ public:
         assert_equal(queue.renderable_count(), mesh_->submesh_count());
         queue.clear();
 
-        instancer->create_mesh_instance(smlt::Vec3(100));
+        instancer->create_mesh_instance(smlt::Vec3(0, 0, -10));
         instancer->generate_renderables(&queue, camera, &viewport,
                                         DETAIL_LEVEL_NEAREST, nullptr, 0);
 
-        assert_equal(queue.renderable_count(), mesh_->submesh_count() * 2);
+        /* With instancing, each submesh is submitted once for all
+         * instances */
+        auto expected = (window->renderer->supports_instancing())
+                            ? mesh_->submesh_count()
+                            : mesh_->submesh_count() * 2;
+
+        assert_equal(queue.renderable_count(), expected);
+    }
+
+    void test_instances_outside_frustum_are_culled() {
+        Viewport viewport;
+        auto instancer = scene->create_child<MeshInstancer>(mesh_);
+
+        auto camera = scene->create_child<smlt::Camera3D>();
+        batcher::RenderQueue queue;
+        queue.reset(stage_, window->renderer.get(), camera);
+
+        /* Behind the camera */
+        instancer->create_mesh_instance(smlt::Vec3(0, 0, 100));
+        instancer->generate_renderables(&queue, camera, &viewport,
+                                        DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        assert_equal(queue.renderable_count(), 0u);
+
+        /* Turning the camera around brings it into view */
+        camera->transform->set_rotation(
+            smlt::Quaternion(smlt::Vec3::up(), smlt::Degrees(180)));
+        instancer->generate_renderables(&queue, camera, &viewport,
+                                        DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        assert_equal(queue.renderable_count(), mesh_->submesh_count());
+    }
+
+    void test_instanced_renderable_contains_visible_instances() {
+        skip_if(!window->renderer->supports_instancing(),
+                "Renderer doesn't support instancing");
+
+        Viewport viewport;
+        auto instancer = scene->create_child<MeshInstancer>(mesh_);
+        instancer->transform->set_translation(Vec3(0, 0, -10));
+
+        auto camera = scene->create_child<smlt::Camera3D>();
+        batcher::RenderQueue queue;
+        queue.reset(stage_, window->renderer.get(), camera);
+
+        instancer->create_mesh_instance(Vec3(-1, 0, 0));
+        auto hidden = instancer->create_mesh_instance(Vec3(0, 0, 0));
+        instancer->create_mesh_instance(Vec3(1, 0, 0));
+        instancer->create_mesh_instance(Vec3(0, 0, 1000)); // Culled
+
+        instancer->hide_mesh_instance(hidden);
+
+        instancer->generate_renderables(&queue, camera, &viewport,
+                                        DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        assert_equal(queue.renderable_count(), mesh_->submesh_count());
+
+        auto renderable = queue.renderable(0);
+        assert_equal(renderable->instance_count, 2u);
+        assert_true(renderable->instance_transformations);
+
+        /* Instance transformations are relative to the instancer */
+        assert_close(renderable->final_transformation[14], -10.0f, 0.0001f);
+
+        float xs = renderable->instance_transformations[0][12] +
+                   renderable->instance_transformations[1][12];
+        assert_close(xs, 0.0f, 0.0001f);
+        assert_close(std::abs(renderable->instance_transformations[0][12]),
+                     1.0f, 0.0001f);
     }
 
     void test_hidden_instances_arent_in_renderables() {
@@ -179,13 +247,17 @@ public:
         instancer->transform->set_translation(Vec3(10, 0, 0));
         assert_equal(instancer->transformed_aabb().center(), smlt::Vec3(10, 0, 0));
 
+        /* Keep the instance in view */
         auto camera = scene->create_child<smlt::Camera3D>();
+        camera->transform->set_translation(Vec3(10, 0, 10));
+
         batcher::RenderQueue queue;
         queue.reset(stage_, window->renderer.get(), camera);
 
         instancer->generate_renderables(&queue, camera, &viewport,
                                         DETAIL_LEVEL_NEAREST, nullptr, 0);
 
+        assert_equal(queue.renderable_count(), mesh_->submesh_count());
         assert_close(queue.renderable(0)->final_transformation[12], 10.0f, 0.0001f);
     }
 
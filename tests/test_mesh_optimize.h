@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/utils/mesh/optimize.h"
+
+namespace {
+
+using namespace smlt;
+
+typedef std::array<float, 9> Triangle;
+
+class MeshOptimizeTest : public smlt::test::SimulantTestCase {
+public:
+    /* An N x N grid of quads, with the quads in a random order */
+    std::vector<uint32_t> build_grid(VertexData& data, int n) {
+        for(int y = 0; y <= n; ++y) {
+            for(int x = 0; x <= n; ++x) {
+                data.position(x, y, 0);
+                data.tex_coord0(x / float(n), y / float(n));
+                data.move_next();
+            }
+        }
+
+        data.done();
+
+        std::vector<std::array<uint32_t, 6>> quads;
+        for(int y = 0; y < n; ++y) {
+            for(int x = 0; x < n; ++x) {
+                uint32_t a = (y * (n + 1)) + x, b = a + 1;
+                uint32_t d = a + (n + 1), c = d + 1;
+                quads.push_back({a, b, c, a, c, d});
+            }
+        }
+
+        std::mt19937 rng(1);
+        std::shuffle(quads.begin(), quads.end(), rng);
+
+        std::vector<uint32_t> indices;
+        for(auto& q: quads) {
+            indices.insert(indices.end(), q.begin(), q.end());
+        }
+
+        return indices;
+    }
+
+    /* Every triangle by position, each rotated so that the winding is kept
+     * but the smallest corner comes first, so they can be compared whatever
+     * the vertex or triangle order */
+    std::vector<Triangle> triangles(const MeshPtr& mesh) {
+        auto data = mesh->vertex_data.get();
+
+        std::vector<Triangle> result;
+        for(auto& sm: mesh->each_submesh()) {
+            sm->each_triangle([&](uint32_t a, uint32_t b, uint32_t c) {
+                std::array<Vec3, 3> corners = {
+                    data->position_nd_at(a).xyz(),
+                    data->position_nd_at(b).xyz(),
+                    data->position_nd_at(c).xyz()
+                };
+
+                auto lowest = std::min_element(corners.begin(), corners.end(), [](const Vec3& lhs, const Vec3& rhs) {
+                    return std::tie(lhs.x, lhs.y, lhs.z) < std::tie(rhs.x, rhs.y, rhs.z);
+                });
+
+                std::rotate(corners.begin(), lowest, corners.end());
+
+                Triangle t;
+                for(int i = 0; i < 3; ++i) {
+                    t[i * 3] = corners[i].x;
+                    t[i * 3 + 1] = corners[i].y;
+                    t[i * 3 + 2] = corners[i].z;
+                }
+
+                result.push_back(t);
+            });
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    void test_acmr_of_a_single_triangle() {
+        uint32_t indices[] = {0, 1, 2};
+        assert_close(utils::calculate_acmr(indices, 3, 3), 3.0f, 0.0001f);
+
+        /* A second triangle sharing an edge only misses once */
+        uint32_t pair[] = {0, 1, 2, 2, 1, 3};
+        assert_close(utils::calculate_acmr(pair, 6, 4), 2.0f, 0.0001f);
+    }
+
+    void test_vertex_cache_order_keeps_triangles() {
+        VertexData data(VertexSpecification::DEFAULT);
+        auto indices = build_grid(data, 30);
+
+        auto before = utils::calculate_acmr(&indices[0], indices.size(), data.count());
+
+        auto optimized = indices;
+        utils::optimize_vertex_cache(&optimized[0], optimized.size(), data.count());
+
+        auto after = utils::calculate_acmr(&optimized[0], optimized.size(), data.count());
+        assert_true(after < before);
+        assert_true(after < 1.0f);
+
+        /* Whole triangles move, corners stay in the same order */
+        std::vector<std::array<uint32_t, 3>> lhs, rhs;
+        for(std::size_t i = 0; i < indices.size(); i += 3) {
+            lhs.push_back({indices[i], indices[i + 1], indices[i + 2]});
+            rhs.push_back({optimized[i], optimized[i + 1], optimized[i + 2]});
+        }
+
+        std::sort(lhs.begin(), lhs.end());
+        std::sort(rhs.begin(), rhs.end());
+        assert_true(lhs == rhs);
+    }
+
+    void test_optimize_indexed_mesh() {
+        auto mesh = scene->assets->create_mesh(VertexSpecification::DEFAULT);
+        auto indices = build_grid(*mesh->vertex_data.get(), 40);
+
+        auto sm = mesh->create_submesh("grid", scene->assets->create_material(), INDEX_TYPE_16_BIT);
+        sm->index_data->index(&indices[0], indices.size());
+        sm->index_data->done();
+
+        auto expected = triangles(mesh);
+
+        auto stats = mesh->optimize();
+
+        assert_true(stats.acmr_after < stats.acmr_before);
+        assert_true(stats.vertices_reordered);
+        assert_equal(mesh->vertex_data->count(), 41u * 41u);
+        assert_true(triangles(mesh) == expected);
+
+        /* The vertices are in the order they're first drawn */
+        auto optimized = sm->index_data->all();
+        uint32_t next = 0;
+        for(auto i: optimized) {
+            assert_true(i <= next);
+            if(i == next) {
+                ++next;
+            }
+        }
+    }
+
+    void test_optimize_triangle_soup() {
+        auto mesh = scene->assets->create_mesh(VertexSpecification::DEFAULT);
+
+        VertexData grid(VertexSpecification::DEFAULT);
+        auto indices = build_grid(grid, 20);
+
+        /* A vertex per corner, as the OBJ loader does */
+        auto data = mesh->vertex_data.get();
+        for(auto i: indices) {
+            auto p = grid.position_nd_at(i).xyz();
+            data->position(p);
+            data->tex_coord0(p.x / 20.0f, p.y / 20.0f);
+            data->move_next();
+        }
+        data->done();
+
+        auto sm = mesh->create_submesh("grid", scene->assets->create_material(), MESH_ARRANGEMENT_TRIANGLES);
+        sm->add_vertex_range(0, indices.size());
+
+        auto expected = triangles(mesh);
+
+        auto stats = mesh->optimize();
+
+        assert_equal(sm->type(), SUBMESH_TYPE_INDEXED);
+        assert_true(stats.acmr_after < 1.0f);
+        assert_true(stats.vertices_reordered);
+
+        /* Identical corners were welded, and the copies dropped */
+        assert_equal(mesh->vertex_data->count(), 21u * 21u);
+        assert_true(triangles(mesh) == expected);
+    }
+
+    void test_load_mesh_optimizes() {
+        auto plain = scene->assets->load_mesh("assets/samples/cave/cave.obj");
+
+        MeshLoadOptions options;
+        options.optimize = true;
+
+        auto mesh = scene->assets->load_mesh(
+            "assets/samples/cave/cave.obj", VertexSpecification::DEFAULT, options
+        );
+
+        assert_true(mesh);
+        assert_true(mesh->vertex_data->count() < plain->vertex_data->count());
+        assert_true(triangles(mesh) == triangles(plain));
+
+        for(auto& sm: mesh->each_submesh()) {
+            assert_equal(sm->type(), SUBMESH_TYPE_INDEXED);
+        }
+    }
+};
+
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cmath>
+#include <set>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/utils/mesh/simplify.h"
+
+namespace {
+
+using namespace smlt;
+
+class MeshSimplifyTest : public smlt::test::SimulantTestCase {
+public:
+    /* An N x N grid of quads, optionally bumpy. If seam is >= 0 that column
+     * of vertices is duplicated with different texture coordinates, and the
+     * quads to its right use the duplicates */
+    void build_grid(VertexData& data, std::vector<std::vector<uint32_t>>& triangles,
+                    int n, bool bumpy, int seam=-1, bool two_groups=false) {
+
+        std::vector<std::vector<uint32_t>> left(n + 1, std::vector<uint32_t>(n + 1));
+        auto right = left;
+
+        uint32_t count = 0;
+        for(int y = 0; y <= n; ++y) {
+            for(int x = 0; x <= n; ++x) {
+                float z = (bumpy) ? std::sin(x * 0.3f) * std::cos(y * 0.3f) : 0.0f;
+
+                data.position(x, y, z);
+                data.tex_coord0(x / float(n), y / float(n));
+                data.move_next();
+                left[y][x] = right[y][x] = count++;
+
+                if(x == seam) {
+                    data.position(x, y, z);
+                    data.tex_coord0(x / float(n) + 1.0f, y / float(n));
+                    data.move_next();
+                    right[y][x] = count++;
+                }
+            }
+        }
+
+        data.done();
+
+        triangles.assign((two_groups) ? 2 : 1, std::vector<uint32_t>());
+
+        for(int y = 0; y < n; ++y) {
+            for(int x = 0; x < n; ++x) {
+                auto& idx = (seam >= 0 && x >= seam) ? right : left;
+                auto& out = triangles[(two_groups && x >= n / 2) ? 1 : 0];
+
+                uint32_t a = idx[y][x], b = idx[y][x + 1];
+                uint32_t c = idx[y + 1][x + 1], d = idx[y + 1][x];
+                out.insert(out.end(), {a, b, c, a, c, d});
+            }
+        }
+    }
+
+    std::size_t triangle_count(const std::vector<std::vector<uint32_t>>& triangles) {
+        std::size_t count = 0;
+        for(auto& list: triangles) {
+            count += list.size() / 3;
+        }
+        return count;
+    }
+
+    std::size_t triangle_count(const MeshPtr& mesh) {
+        std::size_t count = 0;
+        for(auto& sm: mesh->each_submesh()) {
+            sm->each_triangle([&count](uint32_t, uint32_t, uint32_t) { ++count; });
+        }
+        return count;
+    }
+
+    void test_flat_grid_keeps_its_shape() {
+        VertexData data(VertexSpecification::DEFAULT);
+        std::vector<std::vector<uint32_t>> triangles;
+        build_grid(data, triangles, 20, false);
+
+        float error = utils::simplify_triangles(data, triangles, 10);
+
+        assert_true(triangle_count(triangles) <= 10u);
+        assert_close(error, 0.0f, 0.0001f);
+
+        /* The corners are on the border, so can't go anywhere */
+        std::set<uint32_t> used(triangles[0].begin(), triangles[0].end());
+        assert_true(used.count(0));
+        assert_true(used.count(20));
+        assert_true(used.count(21 * 20));
+        assert_true(used.count(21 * 21 - 1));
+
+        float area = 0.0f;
+        auto& list = triangles[0];
+        for(std::size_t i = 0; i < list.size(); i += 3) {
+            auto a = data.position_nd_at(list[i]).xyz();
+            auto b = data.position_nd_at(list[i + 1]).xyz();
+            auto c = data.position_nd_at(list[i + 2]).xyz();
+            area += (b - a).cross(c - a).length() * 0.5f;
+        }
+
+        assert_close(area, 400.0f, 0.01f);
+    }
+
+    void test_max_error_is_respected() {
+        VertexData data(VertexSpecification::DEFAULT);
+        std::vector<std::vector<uint32_t>> triangles;
+        build_grid(data, triangles, 20, true);
+
+        auto before = triangle_count(triangles);
+        float error = utils::simplify_triangles(data, triangles, 0, 0.01f);
+
+        assert_true(error <= 0.01f);
+        assert_true(triangle_count(triangles) < before);
+        assert_true(triangle_count(triangles) > 0u);
+    }
+
+    void test_uv_seams_are_preserved() {
+        VertexData data(VertexSpecification::DEFAULT);
+        std::vector<std::vector<uint32_t>> triangles;
+        build_grid(data, triangles, 20, true, 10);
+
+        utils::simplify_triangles(data, triangles, triangle_count(triangles) / 4);
+
+        std::set<uint32_t> used(triangles[0].begin(), triangles[0].end());
+
+        int seam_vertices = 0;
+        for(uint32_t i = 0; i < data.count(); ++i) {
+            if(data.position_nd_at(i).x == 10.0f) {
+                assert_true(used.count(i));
+                ++seam_vertices;
+            }
+        }
+
+        assert_equal(seam_vertices, 42);
+    }
+
+    void test_material_boundaries_are_preserved() {
+        VertexData data(VertexSpecification::DEFAULT);
+        std::vector<std::vector<uint32_t>> triangles;
+        build_grid(data, triangles, 20, true, -1, true);
+
+        utils::simplify_triangles(data, triangles, triangle_count(triangles) / 8);
+
+        assert_false(triangles[0].empty());
+        assert_false(triangles[1].empty());
+
+        std::set<uint32_t> left(triangles[0].begin(), triangles[0].end());
+        std::set<uint32_t> right(triangles[1].begin(), triangles[1].end());
+
+        /* Every vertex on the boundary column is still used by both sides */
+        for(int y = 0; y <= 20; ++y) {
+            uint32_t i = (y * 21) + 10;
+            assert_true(left.count(i));
+            assert_true(right.count(i));
+        }
+    }
+
+    void test_generate_lods() {
+        auto mesh = scene->assets->create_mesh(VertexSpecification::DEFAULT);
+
+        std::vector<std::vector<uint32_t>> triangles;
+        build_grid(*mesh->vertex_data.get(), triangles, 30, true);
+
+        auto sm = mesh->create_submesh("grid", scene->assets->create_material(), INDEX_TYPE_16_BIT);
+        sm->index_data->index(&triangles[0][0], triangles[0].size());
+        sm->index_data->done();
+
+        assert_false(mesh->has_lods());
+        assert_true(mesh->generate_lods() > 0u);
+        assert_true(mesh->has_lods());
+        assert_false(mesh->lod(DETAIL_LEVEL_NEAREST));
+
+        auto previous = triangle_count(mesh);
+        for(int i = DETAIL_LEVEL_NEAR; i < DETAIL_LEVEL_MAX; ++i) {
+            auto lod = mesh->lod((DetailLevel) i);
+            if(!lod) {
+                break;
+            }
+
+            /* Only the indices change */
+            assert_equal(lod->vertex_data.get(), mesh->vertex_data.get());
+            assert_equal(lod->first_submesh()->material(), sm->material());
+
+            auto count = triangle_count(lod);
+            assert_true(count < previous);
+            previous = count;
+        }
+
+        auto actor = scene->create_child<Actor>(mesh);
+        assert_equal(actor->best_mesh(DETAIL_LEVEL_NEAREST), mesh);
+        assert_equal(actor->best_mesh(DETAIL_LEVEL_NEAR), mesh->lod(DETAIL_LEVEL_NEAR));
+        assert_false(actor->has_multiple_meshes());
+
+        /* A mesh set explicitly takes priority */
+        auto other = scene->assets->create_mesh(VertexSpecification::DEFAULT);
+        actor->set_mesh(other, DETAIL_LEVEL_NEAR);
+        assert_equal(actor->best_mesh(DETAIL_LEVEL_NEAR), other);
+
+        actor->destroy();
+    }
+
+    void test_load_mesh_generates_lods() {
+        MeshLoadOptions options;
+        options.generate_lods = true;
+
+        auto mesh = scene->assets->load_mesh(
+            "assets/samples/cave/cave.obj", VertexSpecification::DEFAULT, options
+        );
+
+        assert_true(mesh);
+        assert_true(mesh->has_lods());
+        assert_true(triangle_count(mesh->lod(DETAIL_LEVEL_NEAR)) < triangle_count(mesh));
+
+        auto plain = scene->assets->load_mesh("assets/samples/cave/cave.obj");
+        assert_false(plain->has_lods());
+    }
+};
+
+}
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <iostream>
 
 #include "simulant/simulant.h"
 #include "simulant/test.h"
 #include "simulant/nodes/geoms/octree_culler.h"
+#include "simulant/nodes/geoms/quadtree_culler.h"
 #include "simulant/nodes/geom.h"
 
 namespace {
@@ -81,6 +84,102 @@ public:
         // Should be different renderables that came back
         assert_not_equal(ret1.material->id(), ret2.material->id());
     }
+
+    MeshPtr create_terrain(uint32_t size) {
+        std::vector<uint8_t> heights(size * size);
+        for(uint32_t i = 0; i < heights.size(); ++i) {
+            heights[i] = (uint8_t) ((i * 7) % 64);
+        }
+
+        auto tex = scene->assets->create_texture(size, size, TEXTURE_FORMAT_R_1UB_8);
+        tex->set_auto_upload(false);
+        tex->set_data(heights);
+
+        HeightmapSpecification spec;
+        spec.spacing = 1.0f;
+        return scene->assets->create_mesh_from_heightmap(tex, spec);
+    }
+
+    /* Returns the number of renderables and the number of indexes they draw */
+    std::pair<std::size_t, std::size_t> gather(Geom* geom, Camera* camera, batcher::RenderQueue& queue) {
+        queue.clear();
+        geom->culler->renderables_visible(camera->frustum(), &queue);
+
+        std::size_t indexes = 0;
+        for(auto i = 0u; i < queue.renderable_count(); ++i) {
+            indexes += queue.renderable(i)->index_element_count;
+        }
+
+        return std::make_pair(queue.renderable_count(), indexes);
+    }
+
+    void test_merged_index_buffers_draw_the_same_triangles() {
+        auto stage = scene->create_child<smlt::Stage>();
+        auto camera = scene->create_child<smlt::Camera3D>();
+        camera->transform->set_position(Vec3(0, 20, 0));
+        camera->transform->look_at(Vec3(10, 0, 10));
+
+        auto mesh = create_terrain(64);
+
+        batcher::RenderQueue queue;
+        queue.reset(stage, window->renderer.get(), camera);
+
+        for(auto type: {GEOM_CULLER_TYPE_OCTREE, GEOM_CULLER_TYPE_QUADTREE}) {
+            GeomCullerOptions separate;
+            separate.type = type;
+
+            GeomCullerOptions merged = separate;
+            merged.merge_index_buffers = true;
+
+            auto a = gather(scene->create_child<Geom>(mesh, separate), camera, queue);
+            auto b = gather(scene->create_child<Geom>(mesh, merged), camera, queue);
+
+            assert_true(a.second > 0);
+            assert_equal(a.second, b.second);
+            assert_true(b.first <= a.first);
+        }
+    }
+
+    void test_merged_index_buffer_benchmark() {
+        typedef std::chrono::high_resolution_clock clock;
+
+        const int frames = 100;
+
+        auto stage = scene->create_child<smlt::Stage>();
+        auto camera = scene->create_child<smlt::Camera3D>();
+        camera->transform->set_position(Vec3(0, 50, 0));
+        camera->transform->look_at(Vec3(128, 0, 128));
+
+        auto mesh = create_terrain(256);
+
+        batcher::RenderQueue queue;
+        queue.reset(stage, window->renderer.get(), camera);
+
+        for(auto type: {GEOM_CULLER_TYPE_OCTREE, GEOM_CULLER_TYPE_QUADTREE}) {
+            for(bool merge: {false, true}) {
+                GeomCullerOptions opts;
+                opts.type = type;
+                opts.octree_max_depth = 5;
+                opts.quadtree_max_depth = 6;
+                opts.merge_index_buffers = merge;
+
+                auto geom = scene->create_child<Geom>(mesh, opts);
+
+                std::pair<std::size_t, std::size_t> result;
+                auto start = clock::now();
+                for(int i = 0; i < frames; ++i) {
+                    result = gather(geom, camera, queue);
+                }
+                auto ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+                std::cout << "    " << ((type == GEOM_CULLER_TYPE_OCTREE) ? "octree" : "quadtree")
+                          << ((merge) ? " merged: " : " separate: ") << result.first
+                          << " draws, " << frames << " gathers: " << ms << "ms" << std::endl;
+
+                geom->destroy();
+            }
+        }
+    }
 };
 
 }
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <functional>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+
+namespace {
+
+using namespace smlt;
+
+class ParallelAgent : public StageNode {
+public:
+    S_DEFINE_STAGE_NODE_META("parallel_agent");
+
+    ParallelAgent(Scene* owner) :
+        StageNode(owner, Meta::node_type) {}
+
+    uint32_t updates = 0;
+    bool updated_concurrently = false;
+    std::function<void (ParallelAgent*)> think;
+
+    bool on_create(Params) override {
+        return true;
+    }
+
+    void on_update(float) override {
+        updates++;
+        updated_concurrently = scene->is_updating_concurrently();
+
+        if(think) {
+            think(this);
+        }
+    }
+
+    void do_generate_renderables(batcher::RenderQueue*, const Camera*,
+                                 const Viewport*, const DetailLevel, Light**,
+                                 const std::size_t) override {}
+
+    const AABB& aabb() const override {
+        static AABB aabb;
+        return aabb;
+    }
+};
+
+class ParallelUpdateTests : public test::SimulantTestCase {
+public:
+    void set_up() {
+        test::SimulantTestCase::set_up();
+        scene->register_stage_node<ParallelAgent>();
+    }
+
+    ParallelAgent* create_agent(StageNode* parent) {
+        auto agent = parent->create_child<ParallelAgent>();
+        agent->set_update_concurrency(UPDATE_CONCURRENCY_PARALLEL);
+        return agent;
+    }
+
+    void test_serial_by_default() {
+        auto agent = scene->create_child<ParallelAgent>();
+        assert_equal(agent->update_concurrency(), UPDATE_CONCURRENCY_SERIAL);
+
+        scene->update(0.1f);
+
+        assert_equal(agent->updates, 1u);
+        assert_false(agent->updated_concurrently);
+    }
+
+    void test_parallel_subtrees_update_once() {
+        std::vector<ParallelAgent*> agents;
+        for(int i = 0; i < 200; ++i) {
+            agents.push_back(create_agent(scene));
+        }
+
+        /* A parallel node inside a parallel subtree is part of that subtree */
+        auto nested = create_agent(agents[0]);
+
+        scene->update(0.1f);
+
+        for(auto agent: agents) {
+            assert_equal(agent->updates, 1u);
+            assert_true(agent->updated_concurrently);
+        }
+
+        assert_equal(nested->updates, 1u);
+        assert_false(scene->is_updating_concurrently());
+    }
+
+    void test_moves_are_flushed_after_update() {
+        auto parent = scene->create_child<Stage>();
+        parent->transform->set_position(Vec3(10, 0, 0));
+
+        std::vector<ParallelAgent*> agents;
+        for(int i = 0; i < 50; ++i) {
+            auto agent = create_agent(parent);
+            agent->think = [](ParallelAgent* self) {
+                self->transform->set_translation(Vec3(0, 1, 0));
+            };
+            agents.push_back(agent);
+        }
+
+        scene->update(0.1f);
+        scene->flush_transform_changes();
+
+        for(auto agent: agents) {
+            assert_close(agent->transform->position().x, 10.0f, 0.0001f);
+            assert_close(agent->transform->position().y, 1.0f, 0.0001f);
+        }
+    }
+
+    void test_parallel_nodes_read_other_dirty_subtrees() {
+        /* Moved before the update, so the whole branch is dirty going into
+         * the parallel phase */
+        auto other = scene->create_child<Stage>();
+        auto leaf = other->create_child<Stage>();
+        leaf->transform->set_translation(Vec3(0, 2, 0));
+        scene->flush_transform_changes();
+        other->transform->set_position(Vec3(5, 0, 0));
+
+        std::vector<ParallelAgent*> agents;
+        std::vector<Vec3> seen(100);
+        for(int i = 0; i < 100; ++i) {
+            auto agent = create_agent(scene);
+            agent->think = [&seen, leaf, i](ParallelAgent*) {
+                seen[i] = leaf->transform->position();
+            };
+            agents.push_back(agent);
+        }
+
+        /* Each agent moves itself while its neighbour reads it */
+        std::vector<Vec3> neighbours(agents.size());
+        for(std::size_t i = 0; i < agents.size(); ++i) {
+            auto self = agents[i];
+            auto next = agents[(i + 1) % agents.size()];
+            auto think = self->think;
+            self->think = [=, &neighbours](ParallelAgent*) {
+                think(self);
+                self->transform->set_translation(Vec3(0, 0, 1));
+                neighbours[i] = next->transform->position();
+            };
+        }
+
+        scene->update(0.1f);
+
+        for(auto& position: seen) {
+            assert_close(position.x, 5.0f, 0.0001f);
+            assert_close(position.y, 2.0f, 0.0001f);
+        }
+
+        /* Either before or after the neighbour moved, never anything else */
+        for(auto& position: neighbours) {
+            assert_close(position.x, 0.0f, 0.0001f);
+            assert_close(position.y, 0.0f, 0.0001f);
+            assert_true(position.z == 0.0f || position.z == 1.0f);
+        }
+    }
+
+    void test_structural_changes_are_deferred() {
+        auto doomed = create_agent(scene);
+        auto spawner = create_agent(scene);
+        auto mover = create_agent(scene);
+        auto target = scene->create_child<Stage>();
+
+        bool destroyed_during_update = false;
+        doomed->think = [&](ParallelAgent* self) {
+            self->destroy();
+            destroyed_during_update = self->is_destroyed();
+        };
+
+        StageNode* spawned = nullptr;
+        bool parent_during_update = true;
+        spawner->think = [&](ParallelAgent* self) {
+            spawned = self->create_child<Stage>();
+            parent_during_update = spawned->has_parent();
+        };
+
+        bool moved_during_update = true;
+        mover->think = [&](ParallelAgent* self) {
+            self->set_parent(target);
+            moved_during_update = (self->parent() == target);
+        };
+
+        scene->update(0.1f);
+
+        /* Nothing in the tree changed until the parallel update finished */
+        assert_true(destroyed_during_update);
+        assert_false(parent_during_update);
+        assert_false(moved_during_update);
+
+        assert_true(spawned);
+        assert_equal(spawned->parent(), (StageNode*) spawner);
+        assert_equal(mover->parent(), (StageNode*) target);
+        assert_true(doomed->is_destroyed());
+    }
+};
+
+}
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <iostream>
+
 #include "simulant/simulant.h"
 #include "simulant/test.h"
 #include "simulant/assets/particles/direction_manipulator.h"
+#include "simulant/nodes/particles/particle_storage.h"
 
 namespace {
 
@@ -104,6 +108,277 @@ public:
 
         assert_true(p1.position.y < p0.position.y);
     }
+
+    void test_gpu_billboarding_is_off_by_default() {
+        ParticleScriptPtr script = scene->assets->load_particle_script(
+            ParticleScript::BuiltIns::FIRE
+        );
+
+        assert_false(script->gpu_billboarding());
+    }
+
+    void test_gpu_billboards_are_one_draw() {
+        skip_if(!window->renderer->supports_gpu_billboards(),
+                "Renderer doesn't support GPU billboards");
+        skip_if(window->renderer->supports_instance_attributes(),
+                "Renderer instances GPU billboards");
+
+        ParticleScriptPtr script = scene->assets->load_particle_script(
+            ParticleScript::BuiltIns::FIRE
+        );
+
+        script->set_gpu_billboarding(true);
+        script->set_material(
+            scene->assets->load_material(Material::BuiltIns::PARTICLE));
+
+        ParticleSystemPtr system = scene->create_child<ParticleSystem>(script);
+        system->update(1.0f);
+        assert_true(system->particle_count() > 1);
+
+        auto stage = scene->create_child<Stage>();
+        auto camera = scene->create_child<Camera3D>();
+
+        batcher::RenderQueue queue;
+        queue.reset(stage, window->renderer.get(), camera);
+
+        Viewport viewport;
+        system->generate_renderables(&queue, camera, &viewport,
+                                     DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        assert_true(system->is_gpu_billboarded());
+        assert_equal(queue.renderable_count(), 1u);
+
+        auto renderable = queue.renderable(0);
+        assert_equal(renderable->arrangement, MESH_ARRANGEMENT_TRIANGLES);
+        assert_equal(renderable->vertex_range_count, 0u);
+        assert_equal(renderable->index_element_count,
+                     (uint32_t) system->particle_count() * 6);
+        assert_equal(renderable->vertex_data->count(),
+                     (uint32_t) system->particle_count() * 4);
+
+        /* Every corner carries the centre, the sign of the size says which
+         * corner it is */
+        auto p0 = system->particle(0);
+        auto vertex_data = renderable->vertex_data;
+        for(uint32_t i = 0; i < 4; ++i) {
+            auto pos = vertex_data->position_at<Vec3>(i);
+            assert_close(pos->y, p0.position.y, 0.0001f);
+        }
+
+        auto bottom_left = vertex_data->texcoord0_at<Vec2>(0);
+        auto top_right = vertex_data->texcoord0_at<Vec2>(3);
+        assert_close(bottom_left->x, -p0.dimensions.x, 0.0001f);
+        assert_close(top_right->y, p0.dimensions.y, 0.0001f);
+    }
+
+    void test_gpu_billboards_are_instanced() {
+        skip_if(!window->renderer->supports_instance_attributes(),
+                "Renderer doesn't support instance attributes");
+
+        ParticleScriptPtr script = scene->assets->load_particle_script(
+            ParticleScript::BuiltIns::FIRE
+        );
+
+        script->set_gpu_billboarding(true);
+        script->set_material(
+            scene->assets->load_material(Material::BuiltIns::PARTICLE));
+
+        ParticleSystemPtr system = scene->create_child<ParticleSystem>(script);
+        system->update(1.0f);
+        assert_true(system->particle_count() > 1);
+
+        auto stage = scene->create_child<Stage>();
+        auto camera = scene->create_child<Camera3D>();
+
+        batcher::RenderQueue queue;
+        queue.reset(stage, window->renderer.get(), camera);
+
+        Viewport viewport;
+        system->generate_renderables(&queue, camera, &viewport,
+                                     DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        assert_true(system->is_gpu_billboarded());
+        assert_equal(queue.renderable_count(), 1u);
+
+        /* A shared quad, drawn once per particle */
+        auto renderable = queue.renderable(0);
+        assert_equal(renderable->arrangement, MESH_ARRANGEMENT_TRIANGLE_STRIP);
+        assert_equal(renderable->vertex_data->count(), 4u);
+        assert_equal(renderable->index_element_count, 0u);
+        assert_equal(renderable->instance_count, (uint32_t) system->particle_count());
+
+        /* One record per particle with its centre and unsigned size */
+        auto p0 = system->particle(0);
+        auto instances = renderable->instance_data;
+        assert_true(instances);
+        assert_equal(instances->count(), (uint32_t) system->particle_count());
+        assert_close(instances->position_at<Vec3>(0)->y, p0.position.y, 0.0001f);
+        assert_close(instances->texcoord0_at<Vec2>(0)->x, p0.dimensions.x, 0.0001f);
+        assert_close(instances->texcoord0_at<Vec2>(0)->y, p0.dimensions.y, 0.0001f);
+
+        /* The quad's corners give the signs */
+        assert_close(renderable->vertex_data->texcoord0_at<Vec2>(0)->x, -1.0f, 0.0001f);
+        assert_close(renderable->vertex_data->texcoord0_at<Vec2>(3)->y, 1.0f, 0.0001f);
+    }
+
+    void test_particle_benchmark() {
+#if defined(__DREAMCAST__) || defined(__PSP__)
+        skip_if(true, "100k particles need more RAM than the consoles have");
+#endif
+
+        typedef std::chrono::high_resolution_clock clock;
+
+        const uint32_t count = 100000;
+        const int frames = 100;
+        const float dt = 1.0f / 60.0f;
+
+        ParticleScriptPtr script = scene->assets->load_particle_script(
+            ParticleScript::BuiltIns::FIRE
+        );
+
+        script->set_quota(count);
+        script->add_manipulator(std::make_shared<DirectionManipulator>(
+            script.get(), smlt::Vec3::down()));
+
+        /* Fill the quota in one go and keep them all alive for the run */
+        auto emitter = script->mutable_emitter(0);
+        emitter->emission_rate = count * 10;
+        emitter->ttl_range = std::make_pair(100.0f, 100.0f);
+
+        ParticleSystemPtr system = scene->create_child<ParticleSystem>(script);
+        system->update(0.1f);
+        assert_equal(system->particle_count(), (std::size_t) count);
+
+        auto start = clock::now();
+        for(int i = 0; i < frames; ++i) {
+            system->update(dt);
+        }
+        auto update_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        auto& spec = system->vertex_data()->vertex_specification();
+        std::vector<uint8_t> vertices(count * 4 * spec.stride());
+
+        ParticleStorage storage;
+        storage.set_capacity(count);
+        for(uint32_t i = 0; i < count; ++i) {
+            storage.push(system->particle(i));
+        }
+
+        start = clock::now();
+        for(int i = 0; i < frames; ++i) {
+            expand_billboards(storage.span(), Vec3::up(), Vec3::right(),
+                              nullptr, &vertices[0], spec.stride());
+        }
+        auto billboard_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        std::cout << "    " << frames << " x " << count << " particles, update: "
+                  << update_ms << "ms, billboards: " << billboard_ms << "ms" << std::endl;
+    }
+};
+
+class ParticleStorageTests : public test::SimulantTestCase {
+public:
+    Particle make_particle(float ttl, float x) {
+        Particle p;
+        p.position = Vec3(x, 0, 0);
+        p.velocity = Vec3(0, 1, 0);
+        p.dimensions = p.initial_dimensions = Vec2(2, 4);
+        p.ttl = p.lifetime = ttl;
+        p.color = Color::white();
+        p.emitter_index = 0;
+        return p;
+    }
+
+    void test_integrate() {
+        ParticleStorage storage;
+        storage.set_capacity(7);
+
+        /* Enough to cover both the vector and scalar paths */
+        for(int i = 0; i < 7; ++i) {
+            storage.push(make_particle(1.0f, float(i)));
+        }
+
+        storage.integrate(0.5f);
+
+        for(int i = 0; i < 7; ++i) {
+            auto p = storage.get(i);
+            assert_close(p.position.x, float(i), 0.0001f);
+            assert_close(p.position.y, 0.5f, 0.0001f);
+            assert_close(p.ttl, 0.5f, 0.0001f);
+        }
+    }
+
+    void test_compact_keeps_order() {
+        ParticleStorage storage;
+        storage.set_capacity(10);
+
+        for(int i = 0; i < 10; ++i) {
+            /* Every third particle dies first */
+            storage.push(make_particle((i % 3 == 0) ? 0.5f : 2.0f, float(i)));
+        }
+
+        storage.integrate(0.0f);
+        assert_equal(storage.compact(), 0u);
+        assert_equal(storage.size(), 10u);
+
+        storage.integrate(1.0f);
+        assert_equal(storage.compact(), 4u);
+        assert_equal(storage.size(), 6u);
+
+        const float expected[] = {1, 2, 4, 5, 7, 8};
+        for(int i = 0; i < 6; ++i) {
+            auto p = storage.get(i);
+            assert_close(p.position.x, expected[i], 0.0001f);
+            assert_close(p.ttl, 1.0f, 0.0001f);
+            assert_close(p.dimensions.y, 4.0f, 0.0001f);
+        }
+
+        storage.integrate(1.0f);
+        assert_equal(storage.compact(), 6u);
+        assert_equal(storage.size(), 0u);
+    }
+
+    void test_capacity_drops_newest() {
+        ParticleStorage storage;
+        storage.set_capacity(5);
+
+        for(int i = 0; i < 5; ++i) {
+            storage.push(make_particle(1.0f, float(i)));
+        }
+
+        storage.set_capacity(3);
+        assert_equal(storage.size(), 3u);
+        assert_close(storage.get(2).position.x, 2.0f, 0.0001f);
+    }
+
+    void test_expand_billboards() {
+        ParticleStorage storage;
+        storage.set_capacity(6);
+
+        for(int i = 0; i < 6; ++i) {
+            storage.push(make_particle(1.0f, float(i)));
+        }
+
+        /* One float of padding, to check the stride is respected */
+        const std::size_t stride = sizeof(float) * 4;
+        std::vector<uint8_t> out(6 * 4 * stride, 0);
+
+        const Vec3 offset(0, 0, 10);
+        expand_billboards(storage.span(), Vec3(0, 1, 0), Vec3(1, 0, 0),
+                          &offset, &out[0], stride);
+
+        const float corners[4][2] = {{-1, -2}, {1, -2}, {-1, 2}, {1, 2}};
+
+        for(int i = 0; i < 6; ++i) {
+            for(int c = 0; c < 4; ++c) {
+                const float* v = (const float*) &out[(i * 4 + c) * stride];
+                assert_close(v[0], float(i) + corners[c][0], 0.0001f);
+                assert_close(v[1], corners[c][1], 0.0001f);
+                assert_close(v[2], 10.0f, 0.0001f);
+                assert_close(v[3], 0.0f, 0.0001f);
+            }
+        }
+    }
 };
 
 }
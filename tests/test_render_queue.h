@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include "simulant/generic/containers/contiguous_map.h"
 #include "simulant/renderers/batching/render_queue.h"
 #include "simulant/simulant.h"
@@ -10,6 +12,26 @@ namespace {
 
 using namespace smlt;
 
+class RecordingVisitor: public batcher::RenderQueueVisitor {
+public:
+    void start_traversal(const batcher::RenderQueue&, uint64_t, StageNode*) override {}
+    void change_render_group(const batcher::RenderGroup*, const batcher::RenderGroup* next) override {
+        keys.push_back(next->sort_key.i);
+    }
+
+    void change_material_pass(const MaterialPass*, const MaterialPass*) override {}
+    void apply_lights(const LightPtr*, const uint8_t) override {}
+
+    void visit(const Renderable* renderable, const MaterialPass*, batcher::Iteration) override {
+        centers.push_back(renderable->center);
+    }
+
+    void end_traversal(const batcher::RenderQueue&, StageNode*) override {}
+
+    std::vector<uint32_t> keys;
+    std::vector<Vec3> centers;
+};
+
 class RenderQueueTests : public test::SimulantTestCase {
 public:
     void set_up() {
@@ -98,9 +120,101 @@ public:
         assert_true(pass0_blended_100_tex1 < pass1_blended_10_tex1);
     }
 
+    void fill_queue(batcher::RenderQueue& queue, std::size_t count) {
+        static const RenderPriority priorities[] = {
+            RENDER_PRIORITY_BACKGROUND, RENDER_PRIORITY_MAIN, RENDER_PRIORITY_FOREGROUND
+        };
+
+        for(std::size_t i = 0; i < count; ++i) {
+            Renderable renderable;
+            renderable.material = material_.get();
+            renderable.index_element_count = 3;
+            renderable.render_priority = priorities[i % 3];
+            renderable.center = Vec3(0, 0, -float((i * 7919) % 500));
+            queue.insert_renderable(std::move(renderable));
+        }
+    }
+
+    void test_flat_queue_matches_tree_order() {
+        material_ = application->shared_assets->create_material();
+        auto camera = scene->create_child<Camera3D>();
+
+        batcher::RenderQueue tree(batcher::RENDER_QUEUE_MODE_TREE);
+        batcher::RenderQueue flat(batcher::RENDER_QUEUE_MODE_FLAT);
+
+        tree.reset(stage_, window->renderer.get(), camera);
+        flat.reset(stage_, window->renderer.get(), camera);
+
+        fill_queue(tree, 1000);
+        fill_queue(flat, 1000);
+
+        assert_equal(tree.renderable_count(), flat.renderable_count());
+
+        RecordingVisitor tree_visitor, flat_visitor;
+        tree.traverse(&tree_visitor, 0);
+        flat.traverse(&flat_visitor, 0);
+
+        assert_true(tree_visitor.keys == flat_visitor.keys);
+        assert_true(tree_visitor.centers == flat_visitor.centers);
+
+        for(std::size_t i = 1; i < flat_visitor.keys.size(); ++i) {
+            assert_true(flat_visitor.keys[i - 1] < flat_visitor.keys[i]);
+        }
+
+        /* Clearing retains nothing */
+        flat.clear();
+        assert_equal(flat.renderable_count(), 0u);
+
+        camera->destroy();
+    }
+
+    void test_render_queue_benchmark() {
+#if defined(__DREAMCAST__) || defined(__PSP__)
+        skip_if(true, "100k renderables need more RAM than the consoles have");
+#endif
+
+        typedef std::chrono::high_resolution_clock clock;
+
+        material_ = application->shared_assets->create_material();
+        auto camera = scene->create_child<Camera3D>();
+
+        for(std::size_t count: {1000u, 10000u, 100000u}) {
+            for(auto mode: {batcher::RENDER_QUEUE_MODE_TREE, batcher::RENDER_QUEUE_MODE_FLAT}) {
+                batcher::RenderQueue queue(mode);
+                queue.reset(stage_, window->renderer.get(), camera);
+
+                /* Run twice, the second frame is representative as
+                 * buffers have been allocated */
+                float insert_ms = 0.0f, traverse_ms = 0.0f;
+                for(int frame = 0; frame < 2; ++frame) {
+                    queue.clear();
+
+                    auto start = clock::now();
+                    fill_queue(queue, count);
+                    auto inserted = clock::now();
+
+                    RecordingVisitor visitor;
+                    queue.traverse(&visitor, 0);
+                    auto traversed = clock::now();
+
+                    insert_ms = std::chrono::duration<float, std::milli>(inserted - start).count();
+                    traverse_ms = std::chrono::duration<float, std::milli>(traversed - inserted).count();
+
+                    assert_equal(visitor.centers.size(), count);
+                }
+
+                std::cout << "    " << ((mode == batcher::RENDER_QUEUE_MODE_FLAT) ? "flat" : "tree")
+                          << " " << count << " renderables: insert " << insert_ms
+                          << "ms, traverse " << traverse_ms << "ms" << std::endl;
+            }
+        }
+
+        camera->destroy();
+    }
+
 private:
     StagePtr stage_;
-
+    MaterialPtr material_;
 };
 
 }
@@ -19,6 +19,100 @@ public:
     void test_unload() {
 
     }
+
+    void test_node_lookup_by_id() {
+        auto node = scene->create_child<Stage>();
+        auto id = node->id();
+
+        assert_true(scene->has_node(id));
+        assert_equal(scene->get_node(id), (StageNode*) node);
+        assert_false(scene->has_node(scene->id()));
+
+        node->destroy();
+        application->run_frame();
+
+        assert_false(scene->has_node(id));
+    }
+
+    void test_destroyed_ids_dont_match_reused_slots() {
+        std::vector<StageNodeID> old_ids;
+        std::vector<Stage*> nodes;
+        for(int i = 0; i < 100; ++i) {
+            nodes.push_back(scene->create_child<Stage>());
+            old_ids.push_back(nodes.back()->id());
+        }
+
+        for(auto node: nodes) {
+            node->destroy();
+        }
+        application->run_frame();
+
+        /* Enough new nodes to reuse all of the freed slots */
+        for(int i = 0; i < 200; ++i) {
+            auto node = scene->create_child<Stage>();
+            assert_true(scene->has_node(node->id()));
+        }
+
+        for(auto id: old_ids) {
+            assert_false(scene->has_node(id));
+        }
+    }
+
+    void test_nodes_by_type_after_erase() {
+        auto type = Stage::Meta::node_type;
+        auto count = scene->nodes_by_type(type).size();
+
+        std::vector<Stage*> nodes;
+        for(int i = 0; i < 10; ++i) {
+            nodes.push_back(scene->create_child<Stage>());
+        }
+
+        nodes[0]->destroy();
+        nodes[5]->destroy();
+        application->run_frame();
+
+        auto& remaining = scene->nodes_by_type(type);
+        assert_equal(remaining.size(), count + 8);
+
+        for(std::size_t i = 1; i < nodes.size(); ++i) {
+            if(i == 5) {
+                continue;
+            }
+
+            auto found = std::find(remaining.begin(), remaining.end(),
+                                   (StageNode*) nodes[i]);
+            assert_true(found != remaining.end());
+        }
+    }
+
+    void test_mass_despawn() {
+        auto type = Stage::Meta::node_type;
+        auto count = scene->nodes_by_type(type).size();
+
+        std::vector<Stage*> nodes;
+        std::vector<StageNodeID> ids;
+        for(int i = 0; i < 10000; ++i) {
+            nodes.push_back(scene->create_child<Stage>());
+            ids.push_back(nodes.back()->id());
+        }
+
+        /* Every other node, so that most erases swap a live node into
+         * the hole */
+        for(std::size_t i = 0; i < nodes.size(); i += 2) {
+            nodes[i]->destroy();
+        }
+        application->run_frame();
+
+        assert_equal(scene->nodes_by_type(type).size(), count + nodes.size() / 2);
+
+        for(std::size_t i = 0; i < nodes.size(); ++i) {
+            if(i % 2) {
+                assert_equal(scene->get_node(ids[i]), (StageNode*) nodes[i]);
+            } else {
+                assert_false(scene->has_node(ids[i]));
+            }
+        }
+    }
 };
 
 class TestScene : public Scene {
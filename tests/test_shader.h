@@ -47,4 +47,118 @@ public:
 #endif
     }
 
+    void test_uniform_element_hash() {
+#ifndef _arch_dreamcast
+#ifndef PSP
+        auto base = smlt::uniform_name_hash("s_light_position");
+        assert_equal(smlt::uniform_element_hash(base, 0), smlt::uniform_name_hash("s_light_position[0]"));
+        assert_equal(smlt::uniform_element_hash(base, 12), smlt::uniform_name_hash("s_light_position[12]"));
+#endif
+#endif
+    }
+
+    void test_uniform_slots() {
+#ifndef _arch_dreamcast
+#ifndef PSP
+        smlt::GPUProgram::ptr program = smlt::GPUProgram::create(
+            smlt::GPUProgramID(2),
+            window->renderer,
+            "uniform vec4 v[2]; uniform float f; void main(){ gl_Position = v[0] + v[1] * f; }",
+            "void main(){ gl_FragColor = vec4(1.0); }"
+        );
+
+        program->build();
+        program->activate();
+
+        auto f = program->uniform_slot(smlt::uniform_name_hash("f"));
+        auto v0 = program->uniform_slot(smlt::uniform_name_hash("v[0]"));
+        auto v1 = program->uniform_slot(smlt::uniform_name_hash("v[1]"));
+        auto v = program->uniform_slot(smlt::uniform_name_hash("v"));
+
+        assert_true(f.is_valid());
+        assert_true(v0.is_valid());
+        assert_true(v1.is_valid());
+        assert_equal(v.index, v0.index);
+        assert_true(v0.index != v1.index);
+        assert_false(program->uniform_slot(smlt::uniform_name_hash("missing")).is_valid());
+
+        /* The last value is remembered, and forgotten when the uniform is
+         * set by location */
+        program->set_uniform_float(f, 2.0f);
+        assert_equal(program->uniform_slots_[f.index].value_size, 1);
+        assert_equal(program->uniform_slots_[f.index].value[0], 2.0f);
+
+        program->set_uniform_float(program->locate_uniform("f"), 3.0f);
+        assert_equal(program->uniform_slots_[f.index].value_size, 0);
+
+        program->set_uniform_vec4(v1, smlt::Vec4(1, 2, 3, 4));
+        assert_equal(program->uniform_slots_[v1.index].value_size, 4);
+        assert_equal(program->uniform_slots_[v0.index].value_size, 0);
+#endif
+#endif
+    }
+
+    void test_array_slots_without_suffix() {
+#ifndef _arch_dreamcast
+#ifndef PSP
+        smlt::GPUProgram::ptr program = smlt::GPUProgram::create(
+            smlt::GPUProgramID(3),
+            window->renderer,
+            "uniform vec4 v[3]; void main(){ gl_Position = v[0] + v[1] + v[2]; }",
+            "void main(){ gl_FragColor = vec4(1.0); }"
+        );
+
+        program->build();
+        program->activate();
+
+        /* Some drivers report active arrays without the "[0]" */
+        std::unordered_map<unicode, smlt::UniformInfo> stripped;
+        for(auto& p: program->uniform_info_) {
+            auto info = p.second;
+            auto name = info.name.encode();
+            if(name.size() > 3 && name.substr(name.size() - 3) == "[0]") {
+                info.name = name.substr(0, name.size() - 3);
+            }
+
+            stripped[info.name] = info;
+        }
+
+        std::swap(program->uniform_info_, stripped);
+        program->rebuild_uniform_slots();
+
+        auto v = program->uniform_slot(smlt::uniform_name_hash("v"));
+        auto v0 = program->uniform_slot(smlt::uniform_name_hash("v[0]"));
+        auto v2 = program->uniform_slot(smlt::uniform_name_hash("v[2]"));
+
+        assert_true(v0.is_valid());
+        assert_true(v2.is_valid());
+        assert_equal(v.index, v0.index);
+        assert_true(v0.index != v2.index);
+#endif
+#endif
+    }
+
+
+    void test_instance_attributes_are_located_on_link() {
+#ifndef _arch_dreamcast
+#ifndef PSP
+        smlt::GPUProgram::ptr program = smlt::GPUProgram::create(
+            smlt::GPUProgramID(4),
+            window->renderer,
+            "attribute vec4 s_position; attribute vec4 s_instance_color; "
+            "void main(){ gl_Position = s_position * s_instance_color; }",
+            "void main(){ gl_FragColor = vec4(1.0); }"
+        );
+
+        program->build();
+
+        auto& instance = program->instance_attributes();
+        assert_equal(instance.color, program->locate_attribute("s_instance_color"));
+        assert_true(instance.color > -1);
+        assert_equal(instance.transformation, -1);
+        assert_equal(instance.position, -1);
+        assert_equal(instance.texcoord0, -1);
+#endif
+#endif
+    }
 };
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <vector>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/meshes/skinning.h"
+
+namespace {
+
+using namespace smlt;
+
+class SkinningTests : public test::SimulantTestCase {
+public:
+    void set_up() override {
+        test::SimulantTestCase::set_up();
+
+        RandomGenerator rgen(12345);
+
+        palette_.clear();
+        for(int i = 0; i < 8; ++i) {
+            Mat4 m = Mat4::as_transform(
+                Vec3(rgen.float_in_range(-5, 5), rgen.float_in_range(-5, 5), 0),
+                Quaternion(Degrees(rgen.float_in_range(0, 90)), Degrees(0), Degrees(0)),
+                Vec3(1)
+            );
+            palette_.push_back(m);
+        }
+    }
+
+    void build_vertices(uint32_t count) {
+        RandomGenerator rgen(54321);
+
+        positions_.resize(count);
+        normals_.resize(count);
+        joints_.resize(count * 4);
+        weights_.resize(count * 4);
+
+        for(uint32_t i = 0; i < count; ++i) {
+            positions_[i] = Vec3(rgen.float_in_range(-1, 1), rgen.float_in_range(-1, 1), rgen.float_in_range(-1, 1));
+            normals_[i] = Vec3(0, 1, 0);
+
+            float total = 0.0f;
+            for(int j = 0; j < 4; ++j) {
+                joints_[i * 4 + j] = rgen.int_in_range(0, palette_.size() - 1);
+                weights_[i * 4 + j] = (j == 3) ? 1.0f - total : rgen.float_in_range(0, 0.3f);
+                total += weights_[i * 4 + j];
+            }
+        }
+    }
+
+    SkinningJob make_job(std::vector<Vec3>& positions_out, std::vector<Vec3>& normals_out) {
+        positions_out.assign(positions_.size(), Vec3());
+        normals_out.assign(normals_.size(), Vec3());
+
+        SkinningJob job;
+        job.palette = palette_.data();
+        job.rest_positions = positions_.data();
+        job.rest_normals = normals_.data();
+        job.joints = joints_.data();
+        job.weights = weights_.data();
+        job.positions_out = (uint8_t*) positions_out.data();
+        job.positions_stride = sizeof(Vec3);
+        job.normals_out = (uint8_t*) normals_out.data();
+        job.normals_stride = sizeof(Vec3);
+        job.vertex_count = positions_.size();
+        return job;
+    }
+
+    void test_kernel_matches_reference() {
+        build_vertices(100);
+
+        std::vector<Vec3> positions, normals;
+        auto job = make_job(positions, normals);
+        skin_vertex_range(job, 0, job.vertex_count);
+
+        for(uint32_t i = 0; i < job.vertex_count; ++i) {
+            Mat4 skin = Mat4::zero();
+            for(int j = 0; j < 4; ++j) {
+                const float* m = palette_[joints_[i * 4 + j]].data();
+                for(int e = 0; e < 16; ++e) {
+                    skin[e] += m[e] * weights_[i * 4 + j];
+                }
+            }
+
+            Vec3 expected_pos = positions_[i].transformed_by(skin);
+            Vec3 expected_normal = normals_[i].rotated_by(skin).normalized();
+
+            assert_close(positions[i].x, expected_pos.x, 0.0001f);
+            assert_close(positions[i].y, expected_pos.y, 0.0001f);
+            assert_close(positions[i].z, expected_pos.z, 0.0001f);
+
+            assert_close(normals[i].x, expected_normal.x, 0.001f);
+            assert_close(normals[i].y, expected_normal.y, 0.001f);
+            assert_close(normals[i].z, expected_normal.z, 0.001f);
+        }
+    }
+
+    void test_parallel_job_matches_serial() {
+        build_vertices(SKINNING_PARALLEL_THRESHOLD * 3 + 17);
+
+        std::vector<Vec3> serial_positions, serial_normals;
+        auto serial = make_job(serial_positions, serial_normals);
+        skin_vertex_range(serial, 0, serial.vertex_count);
+
+        std::vector<Vec3> positions, normals;
+        auto job = make_job(positions, normals);
+        run_skinning_job(job);
+
+        for(uint32_t i = 0; i < job.vertex_count; ++i) {
+            assert_equal(positions[i], serial_positions[i]);
+            assert_equal(normals[i], serial_normals[i]);
+        }
+    }
+
+    MeshPtr create_skinned_triangle(StageNode* joint,
+                                    VertexAttribute position_attribute=VERTEX_ATTRIBUTE_3F,
+                                    float spacing=1.0f) {
+        VertexSpecification spec(position_attribute, VERTEX_ATTRIBUTE_3F);
+        spec.joint_attribute = VERTEX_ATTRIBUTE_4UB;
+        spec.weight_attribute = VERTEX_ATTRIBUTE_4F;
+
+        auto mesh = application->shared_assets->create_mesh(spec);
+
+        for(int i = 0; i < 3; ++i) {
+            mesh->vertex_data->position(Vec3(float(i) * spacing, 0, 0));
+            mesh->vertex_data->normal(Vec3(0, 1, 0));
+            /* Joint 5 doesn't exist, it should be ignored */
+            mesh->vertex_data->joints<uint8_t>(0, 5, 0, 0);
+            mesh->vertex_data->weights<float>(1.0f, 1.0f, 0.0f, 0.0f);
+            mesh->vertex_data->move_next();
+        }
+
+        mesh->vertex_data->done();
+
+        auto skin = std::make_shared<Mesh::Skin>();
+        skin->node_indices.push_back(joint);
+        skin->inverse_bind_matrices.push_back(Mat4());
+        mesh->skin = skin;
+        mesh->is_skinned = true;
+        return mesh;
+    }
+
+    void test_mesh_skinning_uses_palette() {
+        auto joint = scene->create_child<Stage>();
+        joint->transform->set_translation(Vec3(0, 2, 0));
+
+        auto mesh = create_skinned_triangle(joint);
+        mesh->update_skinning();
+
+        assert_false(mesh->is_gpu_skinned());
+        assert_equal(mesh->joint_palette_size(), 1u);
+
+        /* The out-of-range joint's weight is dropped after normalizing,
+         * so the vertex only gets half of the joint's translation */
+        for(uint32_t i = 0; i < 3; ++i) {
+            assert_close(mesh->vertex_data->position_at<Vec3>(i)->x, float(i), 0.0001f);
+            assert_close(mesh->vertex_data->position_at<Vec3>(i)->y, 1.0f, 0.0001f);
+        }
+
+        /* Skinning again must start from the rest pose */
+        mesh->update_skinning();
+        assert_close(mesh->vertex_data->position_at<Vec3>(2)->y, 1.0f, 0.0001f);
+
+        joint->destroy();
+    }
+
+    void test_gpu_skinning_leaves_rest_pose() {
+        auto max_joints = window->renderer->max_gpu_skinning_joints();
+        skip_if(!max_joints, "Renderer doesn't support GPU skinning");
+
+        auto joint = scene->create_child<Stage>();
+        joint->transform->set_translation(Vec3(0, 2, 0));
+
+        auto mesh = create_skinned_triangle(joint);
+        mesh->update_skinning();
+        assert_close(mesh->vertex_data->position_at<Vec3>(1)->y, 1.0f, 0.0001f);
+
+        mesh->set_skinning_mode(SKINNING_MODE_GPU);
+        mesh->update_skinning();
+
+        assert_true(mesh->is_gpu_skinned());
+        assert_close(mesh->vertex_data->position_at<Vec3>(1)->y, 0.0f, 0.0001f);
+        assert_close(mesh->joint_palette()[0][13], 2.0f, 0.0001f);
+
+        joint->destroy();
+    }
+
+    void test_quantized_positions_are_skinned() {
+        auto joint = scene->create_child<Stage>();
+        joint->transform->set_translation(Vec3(0, 1, 0));
+
+        /* Quantized positions are decoded, skinned and encoded again
+         * rather than being left alone */
+        auto mesh = create_skinned_triangle(joint, VERTEX_ATTRIBUTE_3S_NORMALIZED, 0.25f);
+        mesh->update_skinning();
+
+        for(uint32_t i = 0; i < 3; ++i) {
+            auto position = mesh->vertex_data->position_nd_at(i);
+            assert_close(position.x, float(i) * 0.25f, 0.001f);
+            assert_close(position.y, 0.5f, 0.001f);
+        }
+
+        /* And back to the rest pose when the joint does */
+        joint->transform->set_translation(Vec3());
+        mesh->update_skinning();
+        assert_close(mesh->vertex_data->position_nd_at(2).y, 0.0f, 0.001f);
+
+        joint->destroy();
+    }
+
+private:
+    std::vector<Mat4, aligned_allocator<Mat4, 32>> palette_;
+    std::vector<Vec3> positions_;
+    std::vector<Vec3> normals_;
+    std::vector<uint16_t> joints_;
+    std::vector<float> weights_;
+};
+
+}
@@ -147,6 +147,64 @@ public:
         assert_false(a->is_sound_playing());
     }
 
+    void test_decode_ring() {
+        smlt::DecodeRing ring;
+        ring.reset(2, 4);
+
+        assert_true(ring.empty());
+        assert_equal(ring.capacity(), 2u);
+
+        for(uint8_t i = 0; i < 5; ++i) {
+            ring.back()[0] = i;
+            ring.push_back(1);
+
+            if(ring.full()) {
+                std::size_t bytes = 0;
+                auto data = ring.front(&bytes);
+                assert_equal(bytes, 1u);
+                assert_equal(data[0], i - 1);
+                ring.pop_front();
+            }
+        }
+
+        assert_equal(ring.size(), 1u);
+
+        ring.clear();
+        assert_true(ring.empty());
+    }
+
+    void test_no_underruns_while_playing() {
+        auto sound = application->shared_assets->load_sound("assets/sounds/simulant.ogg");
+        auto a = scene->create_child<smlt::AudioSource>();
+        auto before = application->stats->audio_underruns();
+
+        a->play_sound(sound);
+        smlt::thread::sleep(250);
+
+        assert_equal(application->stats->audio_underruns(), before);
+        a->destroy();
+    }
+
+    void test_destroying_a_source_stops_its_sounds() {
+        auto sound = application->shared_assets->load_sound("assets/sounds/simulant.ogg");
+        auto a = scene->create_child<smlt::AudioSource>();
+
+        /* A looping sound would restart if the audio thread refilled it
+         * after the destroy */
+        smlt::PlayingSoundPtr s = a->play_sound(sound, smlt::AUDIO_REPEAT_FOREVER);
+        assert_true(s);
+
+        a->destroy();
+        assert_false(a->is_sound_playing());
+
+        /* The audio thread is woken to stop and release it */
+        for(int i = 0; i < 100 && s; ++i) {
+            smlt::thread::sleep(10);
+        }
+
+        assert_false(s);
+    }
+
 private:
     smlt::CameraPtr camera_;
     smlt::StagePtr stage_;
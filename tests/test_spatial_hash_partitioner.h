@@ -0,0 +1,126 @@
+#pragma once
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/nodes/spatial_hash_partitioner.h"
+
+namespace {
+
+using namespace smlt;
+
+class SpatialHashPartitionerTests : public test::SimulantTestCase {
+public:
+    void set_up() override {
+        test::SimulantTestCase::set_up();
+
+        box_ = application->shared_assets->create_mesh_as_cube_with_submesh_per_face(1.0f);
+        partitioner_ = scene->create_child<SpatialHashPartitioner>();
+        camera_ = scene->create_child<smlt::Camera3D>();
+    }
+
+    void tear_down() override {
+        partitioner_->destroy();
+        camera_->destroy();
+
+        test::SimulantTestCase::tear_down();
+    }
+
+    std::size_t render_count() {
+        batcher::RenderQueue queue;
+        queue.reset(partitioner_, window->renderer.get(), camera_);
+
+        Viewport viewport;
+        partitioner_->generate_renderables(&queue, camera_, &viewport,
+                                           DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        return queue.renderable_count();
+    }
+
+    void test_visibility() {
+        auto a1 = scene->create_child<smlt::Actor>(box_);
+        a1->set_parent(partitioner_);
+        a1->transform->set_translation(Vec3(0, 0, -5));
+
+        assert_true(render_count() > 0);
+        assert_equal(partitioner_->tracked_node_count(), 1u);
+    }
+
+    void test_culled_until_moved_into_view() {
+        auto a1 = scene->create_child<smlt::Actor>(box_);
+        a1->set_parent(partitioner_);
+        a1->transform->set_translation(Vec3(0, 0, 100));
+
+        assert_equal(render_count(), 0u);
+
+        a1->transform->set_translation(Vec3(0, 0, -5));
+
+        assert_true(render_count() > 0);
+
+        a1->transform->set_translation(Vec3(500, 0, -5));
+
+        assert_equal(render_count(), 0u);
+    }
+
+    void test_children_of_children_are_tracked() {
+        auto stage = scene->create_child<smlt::Stage>();
+        auto a1 = scene->create_child<smlt::Actor>(box_);
+        a1->set_parent(stage);
+        stage->set_parent(partitioner_);
+
+        stage->transform->set_translation(Vec3(0, 0, 100));
+        assert_equal(render_count(), 0u);
+
+        /* Moving the parent should update the child */
+        stage->transform->set_translation(Vec3(0, 0, -5));
+        assert_true(render_count() > 0);
+
+        /* Moving out of the partitioner should remove both */
+        stage->set_parent(scene);
+        assert_equal(render_count(), 0u);
+        assert_equal(partitioner_->tracked_node_count(), 0u);
+
+        stage->destroy();
+    }
+
+    void test_nodes_returned_if_never_culled() {
+        auto a1 = scene->create_child<smlt::Actor>(box_);
+        a1->set_parent(partitioner_);
+        a1->transform->set_translation(Vec3(0, 0, 100));
+
+        assert_equal(render_count(), 0u);
+
+        a1->set_cullable(false);
+
+        assert_true(render_count() > 0);
+    }
+
+    void test_destroyed_nodes_not_returned() {
+        auto a1 = scene->create_child<smlt::Actor>(box_);
+        auto a2 = scene->create_child<smlt::Actor>(box_);
+        auto a3 = scene->create_child<smlt::Actor>(box_);
+
+        a1->transform->set_translation(Vec3(0, 0, -5));
+        a2->transform->set_translation(Vec3(0, 0, -5));
+        a3->transform->set_translation(Vec3(0, 0, -5));
+
+        partitioner_->adopt_children(a1, a2, a3);
+
+        auto all_visible_count = render_count();
+
+        a2->destroy();
+
+        assert_true(render_count() < all_visible_count);
+
+        application->run_frame();
+
+        assert_true(render_count() < all_visible_count);
+        assert_equal(partitioner_->tracked_node_count(), 2u);
+    }
+
+private:
+    MeshPtr box_;
+    SpatialHashPartitioner* partitioner_ = nullptr;
+    Camera3D* camera_ = nullptr;
+};
+
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/nodes/stage_node_storage.h"
+
+namespace {
+
+using namespace smlt;
+
+class SlabArrayTests : public test::SimulantTestCase {
+public:
+    void test_slabs_are_aligned_to_their_size() {
+        SlabArray<32> array(256, 64);
+
+        assert_true(array.blocks_per_slab() >= 64u);
+        assert_equal(array.slab_size() & (array.slab_size() - 1), 0u);
+
+        auto a = array.allocate();
+        auto b = array.allocate();
+        assert_equal(((uintptr_t) a) % 32, 0u);
+        assert_equal(b - a, 256);
+
+        assert_true(array.deallocate(a));
+        assert_true(array.deallocate(b));
+    }
+
+    void test_freed_blocks_are_reused() {
+        SlabArray<32> array(256, 16);
+
+        std::vector<uint8_t*> blocks;
+        for(std::size_t i = 0; i < array.blocks_per_slab() * 3; ++i) {
+            blocks.push_back(array.allocate());
+        }
+
+        assert_equal(array.slab_count(), 3u);
+        assert_equal(array.allocated_count(), blocks.size());
+
+        auto freed = blocks[5];
+        assert_true(array.deallocate(freed));
+        assert_equal(array.allocate(), freed);
+        assert_equal(array.slab_count(), 3u);
+
+        for(auto block: blocks) {
+            assert_true(array.deallocate(block));
+        }
+
+        assert_equal(array.allocated_count(), 0u);
+    }
+
+    void test_double_free_is_rejected() {
+        SlabArray<32> array(256);
+
+        auto a = array.allocate();
+        auto b = array.allocate();
+        assert_true(array.deallocate(a));
+        assert_false(array.deallocate(a));
+        assert_false(array.deallocate(b + 1));
+        assert_true(array.deallocate(b));
+    }
+
+    void test_spare_slabs_are_kept() {
+        SlabArray<32> array(256, 16, 1);
+        auto per_slab = array.blocks_per_slab();
+
+        std::vector<uint8_t*> blocks;
+        for(std::size_t i = 0; i < per_slab * 3; ++i) {
+            blocks.push_back(array.allocate());
+        }
+
+        for(auto block: blocks) {
+            array.deallocate(block);
+        }
+
+        /* One empty slab is kept back, the rest are released */
+        assert_equal(array.slab_count(), 1u);
+        assert_equal(array.spare_slab_count(), 1u);
+
+        /* Churning across a slab boundary doesn't create new slabs */
+        for(int i = 0; i < 10; ++i) {
+            auto block = array.allocate();
+            assert_equal(array.slab_count(), 1u);
+            array.deallocate(block);
+        }
+    }
+
+    void test_large_slabs() {
+        SlabArray<32> array(512, SlabArray<32>::max_blocks_per_slab);
+        assert_equal(array.blocks_per_slab(), SlabArray<32>::max_blocks_per_slab);
+
+        std::vector<uint8_t*> blocks;
+        for(std::size_t i = 0; i < array.blocks_per_slab(); ++i) {
+            blocks.push_back(array.allocate());
+        }
+
+        assert_equal(array.slab_count(), 1u);
+
+        std::sort(blocks.begin(), blocks.end());
+        assert_true(std::unique(blocks.begin(), blocks.end()) == blocks.end());
+
+        for(auto block: blocks) {
+            assert_true(array.deallocate(block));
+        }
+    }
+
+    void test_move_keeps_ownership() {
+        SlabArray<32> array(256);
+        auto block = array.allocate();
+
+        SlabArray<32> moved(std::move(array));
+        assert_equal(moved.allocated_count(), 1u);
+        assert_true(moved.deallocate(block));
+    }
+};
+
+class StageNodeStorageTests : public test::SimulantTestCase {
+public:
+    void test_size_classes() {
+        StageNodeStorage storage;
+
+        auto small = storage.allocate(100, 32);
+        auto large = storage.allocate(1000, 64);
+        assert_true(small);
+        assert_true(large);
+        assert_false(storage.allocate(100, 8));
+        assert_equal(storage.allocated_count(), 2u);
+
+        storage.deallocate(small, 100);
+        storage.deallocate(large, 1000);
+        assert_equal(storage.allocated_count(), 0u);
+    }
+
+    void test_node_churn_benchmark() {
+#if defined(__DREAMCAST__) || defined(__PSP__)
+        skip_if(true, "The churn needs more RAM than the consoles have");
+#endif
+
+        typedef std::chrono::high_resolution_clock clock;
+
+        const std::size_t count = 50000;
+        const int rounds = 10;
+
+        StageNodeStorage storage;
+        std::vector<void*> nodes;
+        nodes.reserve(count);
+
+        std::mt19937 rng(1234);
+
+        auto start = clock::now();
+        for(int r = 0; r < rounds; ++r) {
+            while(nodes.size() < count) {
+                nodes.push_back(storage.allocate(sizeof(Stage), alignof(Stage)));
+            }
+
+            /* Destroy half of the nodes in a random order */
+            std::shuffle(nodes.begin(), nodes.end(), rng);
+            for(std::size_t i = 0; i < count / 2; ++i) {
+                storage.deallocate(nodes.back(), sizeof(Stage));
+                nodes.pop_back();
+            }
+        }
+        auto storage_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        for(auto node: nodes) {
+            storage.deallocate(node, sizeof(Stage));
+        }
+        assert_equal(storage.allocated_count(), 0u);
+
+        std::vector<Stage*> stages;
+        start = clock::now();
+        for(int r = 0; r < rounds; ++r) {
+            while(stages.size() < count / 10) {
+                stages.push_back(scene->create_child<Stage>());
+            }
+
+            /* Destroy every other stage, they're freed on the next frame */
+            std::vector<Stage*> survivors;
+            for(std::size_t i = 0; i < stages.size(); ++i) {
+                if(i % 2) {
+                    survivors.push_back(stages[i]);
+                } else {
+                    stages[i]->destroy();
+                }
+            }
+
+            application->run_frame();
+            stages.swap(survivors);
+        }
+        auto scene_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        std::cout << "    " << rounds << " x " << count << " allocations: "
+                  << storage_ms << "ms, " << rounds << " x " << count / 10
+                  << " stages: " << scene_ms << "ms" << std::endl;
+    }
+};
+
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <chrono>
+#include <iostream>
 #include <set>
 
 #include "simulant/simulant.h"
 #include "simulant/test.h"
+#include "simulant/nodes/frustum_culler.h"
+#include "simulant/nodes/spatial_hash_partitioner.h"
 #include "simulant/nodes/stage_node_visitors.h"
 
 namespace {
@@ -198,4 +202,294 @@ public:
     }
 };
 
+class StageNodeVisitorFrustumTests : public smlt::test::SimulantTestCase {
+public:
+    void set_up() {
+        SimulantTestCase::set_up();
+
+        box_ = scene->assets->create_mesh_as_cube_with_submesh_per_face(1.0f);
+
+        /* At the origin, looking down -Z */
+        camera_ = scene->create_child<Camera3D>();
+        camera_->set_perspective_projection(Degrees(45), 1.0f, 1.0f, 100.0f);
+    }
+
+    Actor* create_box(StageNode* parent, const Vec3& translation) {
+        auto actor = scene->create_child<Actor>(box_);
+        actor->set_parent(parent);
+        actor->transform->set_translation(translation);
+        return actor;
+    }
+
+    Stage* create_group(StageNode* parent, const Vec3& translation) {
+        auto group = scene->create_child<Stage>();
+        group->set_parent(parent);
+        group->transform->set_translation(translation);
+        return group;
+    }
+
+    std::set<StageNode*> visit(StageNode* root, std::size_t* tests=nullptr,
+                               std::size_t* rejected=nullptr) {
+        std::set<StageNode*> visited;
+        StageNodeVisitorFrustum visitor(root, camera_->frustum(), [&](StageNode* node) -> bool {
+            visited.insert(node);
+            return true;
+        });
+
+        visitor.run();
+
+        if(tests) {
+            *tests = visitor.tests();
+        }
+
+        if(rejected) {
+            *rejected = visitor.rejected();
+        }
+
+        return visited;
+    }
+
+    void test_subtree_aabb_tracks_changes() {
+        auto root = scene->create_child<Stage>();
+        create_box(root, Vec3(0, 0, -10));
+        auto b = create_box(root, Vec3(5, 0, -10));
+
+        scene->flush_transform_changes();
+        assert_close(root->subtree_aabb().min().x, -0.5f, 0.0001f);
+        assert_close(root->subtree_aabb().max().x, 5.5f, 0.0001f);
+
+        /* Moving a child grows the parent's bounds */
+        b->transform->set_translation(Vec3(10, 0, -10));
+        scene->flush_transform_changes();
+        assert_close(root->subtree_aabb().max().x, 10.5f, 0.0001f);
+
+        /* Moving the parent moves everything */
+        root->transform->set_translation(Vec3(0, 20, 0));
+        scene->flush_transform_changes();
+        assert_close(root->subtree_aabb().min().y, 19.5f, 0.0001f);
+
+        /* Reparenting takes the child's bounds with it */
+        auto other = scene->create_child<Stage>();
+        b->set_parent(other);
+        scene->flush_transform_changes();
+        assert_close(root->subtree_aabb().max().x, 0.5f, 0.0001f);
+        assert_close(other->subtree_aabb().max().x, 10.5f, 0.0001f);
+    }
+
+    void test_subtree_aabb_tracks_mesh_changes() {
+        auto mesh = scene->assets->create_mesh_as_cube_with_submesh_per_face(1.0f);
+
+        auto root = scene->create_child<Stage>();
+        auto actor = scene->create_child<Actor>(mesh);
+        actor->set_parent(root);
+        assert_close(root->subtree_aabb().max().x, 0.5f, 0.0001f);
+
+        mesh->vertex_data->transform_by(Mat4::as_scale(Vec3(4, 4, 4)));
+        mesh->vertex_data->done();
+        assert_close(root->subtree_aabb().max().x, 2.0f, 0.0001f);
+    }
+
+    void test_subtrees_outside_are_skipped() {
+        auto root = scene->create_child<Stage>();
+
+        /* In front of the camera */
+        auto front = create_group(root, Vec3(0, 0, -10));
+        std::vector<StageNode*> front_boxes;
+        for(int i = 0; i < 4; ++i) {
+            front_boxes.push_back(create_box(front, Vec3(i - 2, 0, 0)));
+        }
+
+        /* Behind it, with some depth */
+        auto behind = create_group(root, Vec3(0, 0, 20));
+        std::vector<StageNode*> behind_boxes;
+        for(int i = 0; i < 4; ++i) {
+            auto box = create_box(behind, Vec3(i - 2, 0, 0));
+            behind_boxes.push_back(box);
+            behind_boxes.push_back(create_box(box, Vec3(0, 1, 0)));
+        }
+
+        scene->flush_transform_changes();
+
+        std::size_t tests = 0, rejected = 0;
+        auto visited = visit(root, &tests, &rejected);
+
+        for(auto box: front_boxes) {
+            assert_true(visited.count(box));
+        }
+
+        assert_false(visited.count(behind));
+        for(auto box: behind_boxes) {
+            assert_false(visited.count(box));
+        }
+
+        /* The back group is rejected in one test, and the front boxes are
+         * inside their group so aren't tested at all */
+        assert_equal(rejected, 1u);
+        assert_true(tests <= 5u);
+    }
+
+    void test_uncullable_nodes_are_visited() {
+        auto root = scene->create_child<Stage>();
+        auto behind = create_group(root, Vec3(0, 0, 20));
+        auto a = create_box(behind, Vec3(-2, 0, 0));
+        auto b = create_box(behind, Vec3(2, 0, 0));
+
+        b->set_cullable(false);
+        scene->flush_transform_changes();
+
+        auto visited = visit(root);
+        assert_false(visited.count(a));
+        assert_true(visited.count(b));
+
+        b->set_cullable(true);
+        visited = visit(root);
+        assert_false(visited.count(b));
+    }
+
+    void test_invisible_subtrees_are_skipped() {
+        auto root = scene->create_child<Stage>();
+        auto front = create_group(root, Vec3(0, 0, -10));
+        auto box = create_box(front, Vec3());
+        scene->flush_transform_changes();
+
+        assert_true(visit(root).count(box));
+
+        front->set_visible(false);
+        assert_false(visit(root).count(box));
+    }
+
+    void test_partitioners_are_not_culled_by_their_origin() {
+        auto root = scene->create_child<Stage>();
+
+        /* Both partitioners sit behind the camera, but their children are
+         * in front of it */
+        auto hash = scene->create_child<SpatialHashPartitioner>();
+        hash->set_parent(root);
+        hash->transform->set_translation(Vec3(0, 0, 20));
+
+        auto culler = scene->create_child<FrustumCuller>();
+        culler->set_parent(root);
+        culler->transform->set_translation(Vec3(0, 0, 20));
+
+        /* Something for each of them to be the parent of, so that their
+         * subtrees have some children */
+        auto a = create_box(hash, Vec3());
+        auto b = create_box(culler, Vec3());
+        a->transform->set_position(Vec3(-1, 0, -10));
+        b->transform->set_position(Vec3(1, 0, -10));
+        scene->flush_transform_changes();
+
+        std::set<StageNode*> visited;
+        StageNodeVisitorFrustum visitor(root, camera_->frustum(), [&](StageNode* node) -> bool {
+            visited.insert(node);
+            return !node->generates_renderables_for_descendents();
+        });
+
+        visitor.run();
+
+        /* The partitioners were handed their subtrees, and the visitor
+         * didn't walk past them */
+        assert_true(visited.count(hash));
+        assert_true(visited.count(culler));
+        assert_false(visited.count(a));
+        assert_false(visited.count(b));
+    }
+
+    void test_callback_can_stop_descent() {
+        auto root = scene->create_child<Stage>();
+        auto front = create_group(root, Vec3(0, 0, -10));
+        auto box = create_box(front, Vec3());
+        scene->flush_transform_changes();
+
+        std::set<StageNode*> visited;
+        StageNodeVisitorFrustum visitor(root, camera_->frustum(), [&](StageNode* node) -> bool {
+            visited.insert(node);
+            return node != front;
+        });
+
+        visitor.run();
+        assert_true(visited.count(front));
+        assert_false(visited.count(box));
+    }
+
+    void test_deep_hierarchy_benchmark() {
+        typedef std::chrono::high_resolution_clock clock;
+
+        auto root = scene->create_child<Stage>();
+
+        /* Props: a grid of rooms, each with shelves of boxes, each box
+         * holding a couple of items */
+        const int rooms = 16;
+        for(int z = 0; z < rooms; ++z) {
+            for(int x = 0; x < rooms; ++x) {
+                auto room = create_group(root, Vec3((x - rooms / 2) * 20.0f, 0, -z * 20.0f));
+                for(int s = 0; s < 4; ++s) {
+                    auto shelf = create_group(room, Vec3(s * 4.0f - 8.0f, 0, 0));
+                    for(int b = 0; b < 4; ++b) {
+                        auto box = create_box(shelf, Vec3(0, b * 1.5f, 0));
+                        create_box(box, Vec3(-0.25f, 0.5f, 0));
+                        create_box(box, Vec3(0.25f, 0.5f, 0));
+                    }
+                }
+            }
+        }
+
+        /* UI: panels nested inside panels, a dozen deep, spread out in front
+         * of (and beside) the camera */
+        for(int p = 0; p < 32; ++p) {
+            StageNode* parent = create_group(root, Vec3((p - 16) * 1.0f, 1.0f, -8.0f));
+            for(int depth = 0; depth < 12; ++depth) {
+                auto panel = create_box(parent, Vec3(0.1f, -0.1f, 0));
+                create_box(panel, Vec3(0, 0.2f, 0));
+                parent = panel;
+            }
+        }
+
+        scene->flush_transform_changes();
+
+        const int frames = 50;
+        const auto& frustum = camera_->frustum();
+
+        std::size_t node_count = 0;
+        std::size_t flat_visible = 0;
+        auto start = clock::now();
+        for(int f = 0; f < frames; ++f) {
+            node_count = flat_visible = 0;
+            for(auto& node: root->each_descendent()) {
+                ++node_count;
+                if(frustum.intersects_aabb(node.transformed_aabb())) {
+                    ++flat_visible;
+                }
+            }
+        }
+        auto flat_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        std::size_t visible = 0;
+        StageNodeVisitorFrustum visitor(root, frustum, [&](StageNode* node) -> bool {
+            visible += (node != root);
+            return true;
+        });
+
+        start = clock::now();
+        for(int f = 0; f < frames; ++f) {
+            visible = 0;
+            visitor.run();
+        }
+        auto hierarchical_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        /* Same answer, with fewer tests */
+        assert_equal(visible, flat_visible);
+        assert_true(visitor.tests() < node_count);
+
+        std::cout << "    " << node_count << " nodes, " << visible << " visible. Flat: "
+                  << flat_ms << "ms, hierarchical: " << hierarchical_ms << "ms ("
+                  << visitor.tests() << " tests, " << visitor.rejected()
+                  << " subtrees rejected, " << frames << " frames)" << std::endl;
+    }
+
+private:
+    MeshPtr box_;
+    Camera3D* camera_ = nullptr;
+};
+
 }
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+#include "simulant/utils/mesh/quantize.h"
+
+namespace {
+
+using namespace smlt;
+
+class StaticBatchTests : public smlt::test::SimulantTestCase {
+public:
+    void set_up() {
+        SimulantTestCase::set_up();
+
+        stage_ = scene->create_child<Stage>();
+        material_ = scene->assets->create_material();
+
+        mesh_ = scene->assets->create_mesh_as_cube_with_submesh_per_face(1.0f);
+        for(auto submesh: mesh_->each_submesh()) {
+            submesh->set_material(material_);
+        }
+    }
+
+    /* A grid of cubes, offset so that they don't straddle cluster cells */
+    std::vector<Actor*> create_actors(int rows, float spacing, float offset) {
+        std::vector<Actor*> actors;
+        for(int z = 0; z < rows; ++z) {
+            for(int x = 0; x < rows; ++x) {
+                auto actor = stage_->create_child<Actor>(mesh_);
+                actor->transform->set_position(
+                    Vec3(offset + x * spacing, offset, -(offset + z * spacing)));
+                actors.push_back(actor);
+            }
+        }
+
+        return actors;
+    }
+
+    void test_actors_are_merged() {
+        auto actors = create_actors(4, 2.0f, 1.0f);
+        auto batch = scene->create_child<StaticBatch>();
+
+        assert_equal(batch->add_actors(actors), actors.size());
+
+        /* Everything is inside one cluster, and shares a material */
+        assert_equal(batch->cluster_count(), 1u);
+        assert_equal(batch->chunk_count(), 1u);
+        assert_equal(batch->vertex_count(), mesh_->vertex_data->count() * actors.size());
+
+        assert_close(batch->aabb().min().x, 0.5f, 0.0001f);
+        assert_close(batch->aabb().max().x, 7.5f, 0.0001f);
+        assert_close(batch->aabb().min().z, -7.5f, 0.0001f);
+    }
+
+    void test_materials_are_kept_apart() {
+        auto other = scene->assets->create_mesh_as_cube_with_submesh_per_face(1.0f);
+        for(auto submesh: other->each_submesh()) {
+            submesh->set_material(scene->assets->create_material());
+        }
+
+        auto batch = scene->create_child<StaticBatch>();
+        assert_true(batch->add_mesh(mesh_, Mat4::as_translation(Vec3(1, 1, 1))));
+        assert_true(batch->add_mesh(other, Mat4::as_translation(Vec3(3, 1, 1))));
+
+        assert_equal(batch->cluster_count(), 1u);
+        assert_equal(batch->chunk_count(), 1u + other->submesh_count());
+    }
+
+    void test_geometry_is_clustered() {
+        auto actors = create_actors(4, 10.0f, 5.0f);
+        auto batch = scene->create_child<StaticBatch>(10.0f);
+
+        batch->add_actors(actors);
+        assert_equal(batch->cluster_count(), actors.size());
+        assert_equal(batch->chunk_count(), actors.size());
+    }
+
+    void test_vertices_are_transformed() {
+        auto batch = scene->create_child<StaticBatch>();
+        batch->transform->set_position(Vec3(10, 0, 0));
+
+        auto actor = stage_->create_child<Actor>(mesh_);
+        actor->transform->set_position(Vec3(10, 5, 0));
+        batch->add_actor(actor);
+
+        /* Vertices are stored relative to the batch */
+        assert_close(batch->aabb().center().x, 0.0f, 0.0001f);
+        assert_close(batch->aabb().center().y, 5.0f, 0.0001f);
+        assert_close(batch->transformed_aabb().center().x, 10.0f, 0.0001f);
+    }
+
+    void test_normals_survive_non_uniform_scale() {
+        auto batch = scene->create_child<StaticBatch>();
+
+        /* Scaling after a rotation skews the faces, so rotating the
+         * normals alone would leave them off perpendicular */
+        auto transform = Mat4::as_scale(Vec3(3, 1, 1)) *
+                         Mat4::as_rotation_z(Degrees(45));
+        assert_true(batch->add_mesh(mesh_, transform));
+
+        for(auto& cluster: batch->clusters_) {
+            for(auto& chunk: cluster.chunks) {
+                auto& vertices = *chunk.vertices;
+                auto& indexes = *chunk.indexes;
+
+                for(uint32_t i = 0; i + 2 < indexes.count(); i += 3) {
+                    auto a = vertices.position_nd_at(indexes.at(i)).xyz();
+                    auto b = vertices.position_nd_at(indexes.at(i + 1)).xyz();
+                    auto c = vertices.position_nd_at(indexes.at(i + 2)).xyz();
+                    auto n = *vertices.normal_at<Vec3>(indexes.at(i));
+
+                    assert_close(n.length(), 1.0f, 0.0001f);
+                    assert_close(n.dot((b - a).normalized()), 0.0f, 0.0001f);
+                    assert_close(n.dot((c - a).normalized()), 0.0f, 0.0001f);
+                }
+            }
+        }
+    }
+
+    void test_octahedral_normals_are_batched() {
+        auto spec = mesh_->vertex_data->vertex_specification();
+        spec.normal_attribute = VERTEX_ATTRIBUTE_2S_OCTAHEDRAL;
+        assert_true(utils::convert_vertex_data(*mesh_->vertex_data, spec));
+        mesh_->vertex_data->done();
+
+        auto batch = scene->create_child<StaticBatch>();
+        assert_true(batch->add_mesh(mesh_, Mat4::as_rotation_z(Degrees(90))));
+
+        for(auto& cluster: batch->clusters_) {
+            for(auto& chunk: cluster.chunks) {
+                auto& vertices = *chunk.vertices;
+                assert_true(vertices.vertex_specification().normal_attribute ==
+                            VERTEX_ATTRIBUTE_2S_OCTAHEDRAL);
+
+                auto& indexes = *chunk.indexes;
+                for(uint32_t i = 0; i + 2 < indexes.count(); i += 3) {
+                    auto a = vertices.position_nd_at(indexes.at(i)).xyz();
+                    auto b = vertices.position_nd_at(indexes.at(i + 1)).xyz();
+                    auto c = vertices.position_nd_at(indexes.at(i + 2)).xyz();
+                    auto n = *vertices.normal_at<Vec3>(indexes.at(i));
+
+                    /* Rotated with the faces, not re-encoded unchanged */
+                    assert_close(n.length(), 1.0f, 0.001f);
+                    assert_close(n.dot((b - a).normalized()), 0.0f, 0.001f);
+                    assert_close(n.dot((c - a).normalized()), 0.0f, 0.001f);
+                }
+            }
+        }
+    }
+
+    void test_unsupported_normals_are_rejected() {
+        VertexSpecification spec{VERTEX_ATTRIBUTE_3F, VERTEX_ATTRIBUTE_4F};
+        auto mesh = scene->assets->create_mesh(spec);
+
+        auto batch = scene->create_child<StaticBatch>();
+        assert_false(batch->add_mesh(mesh, Mat4()));
+        assert_equal(batch->vertex_count(), 0u);
+    }
+
+    void test_clusters_outside_frustum_are_culled() {
+        auto actors = create_actors(4, 10.0f, 5.0f);
+        auto batch = scene->create_child<StaticBatch>(10.0f);
+        batch->add_actors(actors);
+
+        /* Looking down -Z at the first cube, the rest are off to the side
+         * or beyond the far plane */
+        auto camera = scene->create_child<Camera3D>();
+        camera->set_perspective_projection(Degrees(45), 1.0f, 1.0f, 15.0f);
+        camera->transform->set_position(Vec3(5, 5, 5));
+
+        batcher::RenderQueue queue;
+        queue.reset(stage_, window->renderer.get(), camera);
+
+        Viewport viewport;
+        batch->generate_renderables(&queue, camera, &viewport,
+                                    DETAIL_LEVEL_NEAREST, nullptr, 0);
+
+        auto visible = queue.renderable_count();
+        assert_true(visible > 0u);
+        assert_true(visible < batch->chunk_count());
+
+        queue.clear();
+        batch->clear();
+        batch->generate_renderables(&queue, camera, &viewport,
+                                    DETAIL_LEVEL_NEAREST, nullptr, 0);
+        assert_equal(queue.renderable_count(), 0u);
+    }
+
+    void test_batch_needs_fewer_draws() {
+        const int rows = 40;
+
+        auto actors = create_actors(rows, 2.0f, 1.0f);
+
+        auto camera = scene->create_child<Camera3D>();
+        camera->transform->set_position(Vec3(rows, 20, 20));
+        camera->transform->look_at(Vec3(rows, 0, -rows));
+
+        batcher::RenderQueue queue;
+        queue.reset(stage_, window->renderer.get(), camera);
+        Viewport viewport;
+
+        auto gather = [&](StageNode* node) {
+            node->generate_renderables(&queue, camera, &viewport,
+                                       DETAIL_LEVEL_NEAREST, nullptr, 0);
+        };
+
+        for(auto actor: actors) {
+            gather(actor);
+        }
+        auto actor_draws = queue.renderable_count();
+
+        auto batch = scene->create_child<StaticBatch>();
+        batch->add_actors(actors);
+
+        queue.clear();
+        gather(batch);
+        auto batch_draws = queue.renderable_count();
+
+        assert_true(batch_draws > 0u);
+        assert_true(batch_draws < actor_draws);
+    }
+
+private:
+    Stage* stage_ = nullptr;
+    MaterialPtr material_;
+    MeshPtr mesh_;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "simulant/test.h"
 
 #include "simulant/threads/future.h"
+#include "simulant/threads/condition.h"
 
 namespace {
 
@@ -19,6 +20,43 @@ public:
         assert_equal(thread.id(), 0u);
     }
 
+    void test_condition_wait_for_times_out() {
+        thread::Mutex mutex;
+        thread::Condition cond;
+
+        thread::Lock<thread::Mutex> lock(mutex);
+        auto start = get_app()->time_keeper->now_in_us();
+        bool signalled = cond.wait_for(mutex, 20000);
+        auto elapsed = get_app()->time_keeper->now_in_us() - start;
+
+        assert_false(signalled);
+        assert_true(elapsed >= 15000);
+    }
+
+    void test_condition_wait_for_notified() {
+        thread::Mutex mutex;
+        thread::Condition cond;
+        bool ready = false;
+
+        thread::Thread notifier([&]() {
+            thread::sleep(10);
+            thread::Lock<thread::Mutex> lock(mutex);
+            ready = true;
+            cond.notify_one();
+        });
+
+        {
+            thread::Lock<thread::Mutex> lock(mutex);
+            auto start = get_app()->time_keeper->now_in_us();
+            while(!ready && get_app()->time_keeper->now_in_us() - start < 5000000) {
+                cond.wait_for(mutex, 1000000);
+            }
+        }
+
+        notifier.join();
+        assert_true(ready);
+    }
+
     void test_async() {
         auto func_argless = []() -> int {
             return 1;
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "simulant/simulant.h"
+#include "simulant/test.h"
+
+namespace {
+
+using namespace smlt;
+
+class ChangeCounter : public TransformListener {
+public:
+    int changes = 0;
+
+    void on_transformation_changed() override {
+        ++changes;
+    }
+
+    void on_transformation_change_attempted() override {}
+};
+
+class TransformTests : public test::SimulantTestCase {
+public:
+    void test_world_state_is_current_before_flush() {
+        auto parent = scene->create_child<Stage>();
+        auto child = scene->create_child<Stage>();
+        child->set_parent(parent);
+        child->transform->set_translation(Vec3(1, 0, 0));
+
+        parent->transform->set_translation(Vec3(0, 10, 0));
+        parent->transform->set_rotation(Quaternion(Vec3::up(), Degrees(90)));
+
+        auto expected = Vec3(0, 10, 0) + (Quaternion(Vec3::up(), Degrees(90)) * Vec3(1, 0, 0));
+        assert_close(child->transform->position().x, expected.x, 0.0001f);
+        assert_close(child->transform->position().y, expected.y, 0.0001f);
+        assert_close(child->transform->position().z, expected.z, 0.0001f);
+
+        parent->destroy();
+    }
+
+    void test_listeners_notified_once_per_flush() {
+        auto parent = scene->create_child<Stage>();
+        auto child = scene->create_child<Stage>();
+        child->set_parent(parent);
+        scene->flush_transform_changes();
+
+        ChangeCounter parent_counter, child_counter;
+        parent->transform->add_listener(&parent_counter);
+        child->transform->add_listener(&child_counter);
+
+        for(int i = 0; i < 10; ++i) {
+            parent->transform->translate(Vec3(1, 0, 0));
+            child->transform->translate(Vec3(0, 1, 0));
+        }
+
+        assert_equal(parent_counter.changes, 0);
+        assert_equal(child_counter.changes, 0);
+
+        scene->flush_transform_changes();
+
+        assert_equal(parent_counter.changes, 1);
+        assert_equal(child_counter.changes, 1);
+        assert_equal(child->transform->position(), Vec3(10, 10, 0));
+
+        /* Nothing moved, nothing to notify */
+        scene->flush_transform_changes();
+        assert_equal(parent_counter.changes, 1);
+
+        parent->transform->remove_listener(&parent_counter);
+        child->transform->remove_listener(&child_counter);
+        parent->destroy();
+    }
+
+    void test_version_changes_with_parent() {
+        auto parent = scene->create_child<Stage>();
+        auto child = scene->create_child<Stage>();
+        child->set_parent(parent);
+
+        auto version = child->transform->version();
+        assert_equal(child->transform->version(), version);
+
+        parent->transform->translate(Vec3(1, 0, 0));
+        assert_true(child->transform->version() != version);
+
+        parent->destroy();
+    }
+
+    void test_reparenting_follows_new_parent() {
+        auto a = scene->create_child<Stage>();
+        auto b = scene->create_child<Stage>();
+        auto child = scene->create_child<Stage>();
+
+        a->transform->set_translation(Vec3(10, 0, 0));
+        b->transform->set_translation(Vec3(0, 10, 0));
+
+        child->set_parent(a);
+        assert_equal(child->transform->position(), Vec3(10, 0, 0));
+
+        child->set_parent(b);
+        assert_equal(child->transform->position(), Vec3(0, 10, 0));
+
+        a->transform->translate(Vec3(5, 0, 0));
+        assert_equal(child->transform->position(), Vec3(0, 10, 0));
+
+        b->transform->translate(Vec3(5, 0, 0));
+        assert_equal(child->transform->position(), Vec3(5, 10, 0));
+
+        a->destroy();
+        b->destroy();
+    }
+
+    void test_destroyed_nodes_leave_the_queue() {
+        auto parent = scene->create_child<Stage>();
+        auto child = scene->create_child<Stage>();
+        child->set_parent(parent);
+
+        parent->transform->translate(Vec3(1, 0, 0));
+
+        child->destroy_immediately();
+        scene->flush_transform_changes();
+
+        assert_equal(parent->transform->position(), Vec3(1, 0, 0));
+        parent->destroy();
+    }
+
+    void test_propagation_benchmark() {
+        typedef std::chrono::high_resolution_clock clock;
+
+        const int chains = 100;
+        const int depth = 100;
+        const int moves_per_frame = 10;
+        const int frames = 10;
+
+        std::vector<StageNode*> roots;
+        std::vector<StageNode*> leaves;
+
+        for(int c = 0; c < chains; ++c) {
+            StageNode* parent = scene->create_child<Stage>();
+            roots.push_back(parent);
+
+            for(int d = 1; d < depth; ++d) {
+                auto node = scene->create_child<Stage>();
+                node->set_parent(parent);
+                node->transform->set_translation(Vec3(0, 1, 0));
+                parent = node;
+            }
+
+            leaves.push_back(parent);
+        }
+
+        scene->flush_transform_changes();
+
+        auto run = [&](bool flush_every_move) -> float {
+            auto start = clock::now();
+            for(int f = 0; f < frames; ++f) {
+                for(int m = 0; m < moves_per_frame; ++m) {
+                    for(auto root: roots) {
+                        root->transform->translate(Vec3(0.1f, 0, 0));
+                        if(flush_every_move) {
+                            scene->flush_transform_changes();
+                        }
+                    }
+                }
+
+                scene->flush_transform_changes();
+            }
+
+            return std::chrono::duration<float, std::milli>(clock::now() - start).count();
+        };
+
+        /* Flushing after every move does what the transforms used to do,
+         * a walk of the whole chain per change */
+        auto eager_ms = run(true);
+        auto deferred_ms = run(false);
+
+        float x = 0.1f * moves_per_frame * frames * 2;
+        for(auto leaf: leaves) {
+            assert_close(leaf->transform->position().x, x, 0.01f);
+            assert_close(leaf->transform->position().y, float(depth - 1), 0.01f);
+        }
+
+        std::cout << "    " << chains * depth << " nodes in " << chains << " chains of "
+                  << depth << ", " << moves_per_frame << " root moves per frame, "
+                  << frames << " frames: eager " << eager_ms << "ms, deferred "
+                  << deferred_ms << "ms" << std::endl;
+
+        for(auto root: roots) {
+            root->destroy();
+        }
+    }
+};
+
+}
@@ -71,6 +71,26 @@ public:
             "11.1 11.1 2.222 3.3"
         );
     }
+
+    void test_format_into() {
+        char buffer[32];
+
+        auto length = _F::format_into(
+            buffer, sizeof(buffer), "{0} {1:.3} {0} {2} {3}",
+            (int8_t) -1, 11.1111, std::string("x"), "{0}"
+        );
+        assert_equal(std::string(buffer, length), "-1 11.1 -1 x {0}");
+
+        /* Unknown placeholders are left alone */
+        length = _F::format_into(buffer, sizeof(buffer), "{1} {a}", 1);
+        assert_equal(std::string(buffer), "{1} {a}");
+        assert_equal(length, 7u);
+
+        /* Long results are truncated, and still terminated */
+        length = _F::format_into(buffer, 8, "{0}", "abcdefghijk");
+        assert_equal(std::string(buffer), "abcdefg");
+        assert_equal(length, 7u);
+    }
 };
 
 
@@ -3,6 +3,8 @@
 
 #include "simulant/simulant.h"
 #include "simulant/test.h"
+#include "simulant/utils/mesh/quantize.h"
+#include "simulant/utils/packed_types.h"
 
 namespace {
 
@@ -201,6 +203,116 @@ public:
         // sizeof(float) * 10 + sizeof(byte) * 8, but rounded to the nearest 16 byte boundary == 64
         assert_equal(64u, data.data_size());
     }
+
+    void test_quantized_positions() {
+        smlt::VertexSpecification spec{smlt::VERTEX_ATTRIBUTE_3S_NORMALIZED};
+
+        smlt::VertexData data(spec);
+        data.set_position_range(smlt::Vec3(-10, 0, 100), smlt::Vec3(10, 1, 300));
+
+        data.position(-10, 0, 100);
+        data.move_next();
+        data.position(3.3f, 0.25f, 123.4f);
+        data.move_next();
+        data.position(50, 50, 50); // Outside the range, clamped
+        data.move_next();
+
+        assert_equal(data.stride(), 16u);
+
+        auto a = data.position_nd_at(0);
+        assert_close(a.x, -10.0f, 0.001f);
+        assert_close(a.y, 0.0f, 0.001f);
+        assert_close(a.z, 100.0f, 0.01f);
+
+        auto b = data.position_nd_at(1);
+        assert_close(b.x, 3.3f, 0.001f);
+        assert_close(b.y, 0.25f, 0.001f);
+        assert_close(b.z, 123.4f, 0.01f);
+
+        auto c = data.position_nd_at(2);
+        assert_close(c.x, 10.0f, 0.001f);
+        assert_close(c.y, 1.0f, 0.001f);
+        assert_close(c.z, 100.0f, 0.01f);
+    }
+
+    void test_octahedral_normals() {
+        std::vector<smlt::Vec3> normals = {
+            smlt::Vec3(0, 0, 1), smlt::Vec3(0, 0, -1), smlt::Vec3(1, 0, 0),
+            smlt::Vec3(0, -1, 0), smlt::Vec3(1, 2, 3).normalized(),
+            smlt::Vec3(-3, 1, -2).normalized(), smlt::Vec3(0.1f, -0.2f, -5).normalized()
+        };
+
+        for(auto attr: {smlt::VERTEX_ATTRIBUTE_2S_OCTAHEDRAL, smlt::VERTEX_ATTRIBUTE_2B_OCTAHEDRAL}) {
+            smlt::VertexSpecification spec{smlt::VERTEX_ATTRIBUTE_3F, attr};
+            smlt::VertexData data(spec);
+
+            for(auto& n: normals) {
+                data.position(0, 0, 0);
+                data.normal(n);
+                data.move_next();
+            }
+
+            float tolerance = (attr == smlt::VERTEX_ATTRIBUTE_2S_OCTAHEDRAL) ? 0.0001f : 0.02f;
+            for(uint32_t i = 0; i < normals.size(); ++i) {
+                auto n = *data.normal_at<smlt::Vec3>(i);
+                assert_close(n.length(), 1.0f, 0.0001f);
+                assert_close(n.x, normals[i].x, tolerance);
+                assert_close(n.y, normals[i].y, tolerance);
+                assert_close(n.z, normals[i].z, tolerance);
+            }
+        }
+    }
+
+    void test_convert_vertex_data() {
+        smlt::VertexData data(smlt::VertexSpecification::DEFAULT);
+
+        for(int i = 0; i < 100; ++i) {
+            float f = float(i);
+            data.position(f, f * 0.5f, -f);
+            data.normal(smlt::Vec3(std::sin(f), std::cos(f), f / 100.0f - 0.5f).normalized());
+            data.tex_coord0(f / 100.0f, 1.0f - f / 100.0f);
+            data.color(smlt::Color(1, 0.5f, 0, 1));
+            data.move_next();
+        }
+
+        smlt::VertexData original(smlt::VertexSpecification::DEFAULT);
+        data.clone_into(original);
+
+        auto spec = smlt::utils::quantized_vertex_specification(data.vertex_specification());
+        assert_true(smlt::utils::convert_vertex_data(data, spec));
+
+        assert_equal(data.count(), 100u);
+        assert_true(data.stride() < original.stride());
+
+        for(uint32_t i = 0; i < 100; ++i) {
+            auto p = data.position_nd_at(i).xyz();
+            auto expected = original.position_nd_at(i).xyz();
+            assert_close((p - expected).length(), 0.0f, 0.01f);
+
+            auto n = *data.normal_at<smlt::Vec3>(i);
+            auto expected_normal = *original.normal_at<smlt::Vec3>(i);
+            assert_close(n.dot(expected_normal), 1.0f, 0.0001f);
+
+            auto uv = *(const smlt::HalfVec2*) (data.data() + (i * data.stride()) + spec.texcoord0_offset());
+            auto expected_uv = *original.texcoord0_at<smlt::Vec2>(i);
+            assert_close(float(uv.x), expected_uv.x, 0.001f);
+            assert_close(float(uv.y), expected_uv.y, 0.001f);
+
+            auto color = data.data() + (i * data.stride()) + spec.color_offset();
+            assert_equal(color[0], 255);
+            assert_equal(color[2], 0);
+        }
+
+        /* And back again */
+        assert_true(smlt::utils::convert_vertex_data(data, smlt::VertexSpecification::DEFAULT));
+        assert_close(data.position_at<smlt::Vec3>(50)->x, 50.0f, 0.01f);
+
+        /* Colors can't be converted */
+        auto colors = data.vertex_specification();
+        colors.color_attribute = smlt::VERTEX_ATTRIBUTE_4F;
+        assert_false(smlt::utils::convert_vertex_data(data, colors));
+        assert_true(data.vertex_specification() == smlt::VertexSpecification::DEFAULT);
+    }
 };
 
 }